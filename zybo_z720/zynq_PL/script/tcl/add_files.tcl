@@ -27,6 +27,7 @@ add_files "
 ../src/hdl/image_processor/util/stream_patch.sv
 ../src/hdl/image_processor/util/tree_adder.sv
 ../src/hdl/zynq_interface/zynq_interface.sv
+../src/hdl/zynq_interface/perf_counter.sv
 ../src/hdl/DVIClocking/DVIClocking.vhd
 ../src/hdl/DVIClocking/SyncAsync.vhd
 ../src/hdl/DVIClocking/SyncAsyncReset.vhd
@@ -0,0 +1,263 @@
+//-----------------------------------------------------------------------------
+// <pixel_stream.hpp>
+//  - Pixel-stream driver and frame capture of the Verilator harness
+//    - slab::SimTiming   : a mode of timing[] (VideoOutput.hpp)
+//    - slab::SyncToCount : vid_sync2cnt.sv, cycle by cycle
+//    - slab::PixelStream : syncs and in_data of the VDMA IP (VTC timing)
+//    - slab::FrameCapture: active pixels of a (vcnt, hcnt) stream
+//    - slab::FrameSource : input frames (PPM / PGM files, RGB24 on stdin)
+//-----------------------------------------------------------------------------
+// Model
+//  - the VTC / VDMA output runs at the position (vpos, hpos); hsync and
+//    vsync start at hpos = H_ACTIVE + H_FRONT_PORCH of their line, and
+//    in_data is the frame pixel at (vpos, hpos) (0 in the blanking)
+//  - SyncToCount turns the syncs into in_vcnt / in_hcnt exactly like
+//    vid_sync2cnt.sv (registers updated at every rising edge), so the
+//    counts follow the falling edges of the syncs: with negative polarity
+//    they equal (vpos, hpos), with positive polarity they lag the
+//    position by the sync width, as on the board
+//  - FrameCapture takes the pixels of a raster in order from (0, 0) to
+//    (V_ACTIVE - 1, H_ACTIVE - 1); a frame with a jump of the counts (e.g.
+//    before vid_sync2cnt has seen the first sync) is dropped
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 17, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 18, 2020)
+//  - Added slab::FrameSource (from sim_main.cpp, shared with sim_uio.cpp)
+//  - Added PixelStream::active() (vid_io_out_active_video)
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _SIM_PIXEL_STREAM_H_
+#define _SIM_PIXEL_STREAM_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <vector>
+
+namespace slab {
+	/* one mode of timing[] (without the BSP headers of VideoOutput.hpp) */
+	typedef struct SimTiming {
+		uint32_t h_active, h_fp, h_sync, h_bp;
+		bool     h_pos;
+		uint32_t v_active, v_fp, v_sync, v_bp;
+		bool     v_pos;
+		uint32_t pclk_freq_Hz;
+
+		uint32_t h_frame() const { return h_active + h_fp + h_sync + h_bp; }
+		uint32_t v_frame() const { return v_active + v_fp + v_sync + v_bp; }
+	} SimTiming;
+
+	/* vid_sync2cnt.sv */
+	class SyncToCount {
+		private:
+			SimTiming t_;
+			bool      prev_vsync_, prev_hsync_;
+			uint32_t  vcnt_, hcnt_;
+			bool      jumped_;
+		protected:
+		public:
+			SyncToCount(const SimTiming& t) : t_(t) { reset(); }
+			void reset() {
+				prev_vsync_ = prev_hsync_ = false;
+				vcnt_ = hcnt_ = 0;
+				jumped_ = false;
+			}
+			/* rising edge with <vsync> and <hsync> at the input */
+			void clock(bool vsync, bool hsync) {
+				const uint32_t hf = t_.h_frame(), vf = t_.v_frame();
+				uint32_t h = (hcnt_ == hf - 1) ? 0 : hcnt_ + 1;
+				uint32_t v = (hcnt_ == hf - 1) ? ((vcnt_ == vf - 1) ? 0 : vcnt_ + 1) : vcnt_;
+				uint32_t nh = (prev_hsync_ && !hsync) ? t_.h_active + t_.h_fp + 1 : h;
+				uint32_t nv = (prev_vsync_ && !vsync) ? t_.v_active + t_.v_fp    : v;
+				jumped_ = (nh != h || nv != v);
+				hcnt_ = nh;
+				vcnt_ = nv;
+				prev_vsync_ = vsync;
+				prev_hsync_ = hsync;
+			}
+			uint32_t vcnt() const { return vcnt_; }
+			uint32_t hcnt() const { return hcnt_; }
+			/* the last edge reloaded a count with another value than +1 */
+			bool jumped() const { return jumped_; }
+	};
+
+	/* VTC and VDMA output: one pixel ({r, g, b}) per cycle */
+	class PixelStream {
+		private:
+			SimTiming             t_;
+			uint32_t              vpos_, hpos_;
+			uint64_t              frames_;
+			std::vector<uint32_t> frame_;   // {r, g, b} of the frame being sent
+			std::vector<uint32_t> next_;    // frame for the next vpos = 0
+			bool                  pending_;
+		protected:
+		public:
+			PixelStream(const SimTiming& t) :
+				t_(t), vpos_(0), hpos_(0), frames_(0),
+				frame_((size_t)t.h_active * t.v_active, 0), pending_(false) {}
+			/* frame sent from the next (0, 0) on; false while one is pending */
+			bool push(const std::vector<uint32_t>& rgb) {
+				if (pending_) return false;
+				next_    = rgb;
+				pending_ = true;
+				return true;
+			}
+			bool pending() const { return pending_; }
+			/* advances to the next cycle (call before the rising edge) */
+			void step() {
+				if (++hpos_ == t_.h_frame()) {
+					hpos_ = 0;
+					if (++vpos_ == t_.v_frame()) vpos_ = 0;
+				}
+				if (vpos_ == 0 && hpos_ == 0) start();
+			}
+			void start() {
+				if (pending_) {
+					frame_.swap(next_);
+					pending_ = false;
+				}
+				frames_++;
+			}
+			bool hsync() const {
+				bool s = (t_.h_active + t_.h_fp <= hpos_ && hpos_ < t_.h_active + t_.h_fp + t_.h_sync);
+				return s == t_.h_pos;
+			}
+			bool vsync() const {
+				/* from hpos = H_ACTIVE + H_FRONT_PORCH of the first sync line */
+				const uint32_t hs = t_.h_active + t_.h_fp;
+				uint64_t p  = (uint64_t)vpos_ * t_.h_frame() + hpos_;
+				uint64_t p0 = (uint64_t)(t_.v_active + t_.v_fp) * t_.h_frame() + hs;
+				bool     s  = (p0 <= p && p < p0 + (uint64_t)t_.v_sync * t_.h_frame());
+				return s == t_.v_pos;
+			}
+			bool active() const { return vpos_ < t_.v_active && hpos_ < t_.h_active; }
+			uint32_t data() const {
+				if (!active()) return 0;
+				return frame_[(size_t)vpos_ * t_.h_active + hpos_];
+			}
+			uint32_t vpos()   const { return vpos_;   }
+			uint32_t hpos()   const { return hpos_;   }
+			/* frames started (including the one on the wire) */
+			uint64_t frames() const { return frames_; }
+	};
+
+	/* active pixels of a (vcnt, hcnt) stream into frames */
+	template <class T>
+	class FrameCapture {
+		private:
+			uint32_t       iw_, ih_;
+			std::vector<T> frame_;
+			uint64_t       next_;   // raster index expected next (iw * ih: none)
+		protected:
+		public:
+			FrameCapture(uint32_t width, uint32_t height) :
+				iw_(width), ih_(height), frame_((size_t)width * height), next_((uint64_t)width * height) {}
+			/* true when <value> completes a frame (frame() until the next call) */
+			bool feed(uint32_t vcnt, uint32_t hcnt, T value) {
+				if (vcnt >= ih_ || hcnt >= iw_) return false;
+				const uint64_t k = (uint64_t)vcnt * iw_ + hcnt;
+				if (k == 0) next_ = 0;
+				if (k != next_) {
+					next_ = (uint64_t)iw_ * ih_; // broken until the next (0, 0)
+					return false;
+				}
+				frame_[k] = value;
+				return ++next_ == (uint64_t)iw_ * ih_;
+			}
+			const std::vector<T>& frame() const { return frame_; }
+			uint32_t width()  const { return iw_; }
+			uint32_t height() const { return ih_; }
+	};
+
+	/* frames of the inputs in order ("-": RGB24 frames from stdin until EOF) */
+	class FrameSource {
+		private:
+			SimTiming                t_;
+			std::vector<const char*> inputs_;
+			uint64_t                 limit_;   // 0: no limit
+			bool                     loop_;    // files repeat up to <limit>
+			size_t                   input_;
+			uint64_t                 count_;
+			bool                     eof_;
+		protected:
+		public:
+			FrameSource(const SimTiming& t, const std::vector<const char*>& inputs, uint64_t limit, bool loop) :
+				t_(t), inputs_(inputs), limit_(limit), loop_(loop), input_(0), count_(0), eof_(inputs.empty()) {}
+			bool next(std::vector<uint32_t>& rgb) {
+				if (eof_ || (limit_ != 0 && count_ >= limit_)) return false;
+				const char *in = inputs_[input_ % inputs_.size()];
+				bool        ok;
+				if (!strcmp(in, "-")) {
+					ok = load_raw(stdin, t_, rgb);
+				}
+				else {
+					ok = load_pnm(in, t_, rgb);
+					if (++input_ == inputs_.size() && !loop_) eof_ = true;
+				}
+				if (!ok) {
+					eof_ = true;
+					return false;
+				}
+				count_++;
+				return true;
+			}
+			/* frames returned by next() */
+			uint64_t count() const { return count_; }
+
+			/* binary PGM (P5) or PPM (P6) with maxval 255 as {r, g, b} */
+			static bool load_pnm(const char *path, const SimTiming& t, std::vector<uint32_t>& rgb) {
+				FILE    *fp;
+				char     magic[3] = {0};
+				unsigned w, h, maxval;
+
+				if ((fp = fopen(path, "rb")) == NULL) {
+					fprintf(stderr, "%s: cannot open\n", path);
+					return false;
+				}
+				if (fscanf(fp, "%2s %u %u %u", magic, &w, &h, &maxval) != 4 || fgetc(fp) == EOF ||
+						(strcmp(magic, "P5") && strcmp(magic, "P6")) || maxval != 255) {
+					fprintf(stderr, "%s: not a binary PGM / PPM\n", path);
+					fclose(fp);
+					return false;
+				}
+				if (w != t.h_active || h != t.v_active) {
+					fprintf(stderr, "%s: %ux%u (the harness is built for %ux%u)\n", path, w, h,
+							t.h_active, t.v_active);
+					fclose(fp);
+					return false;
+				}
+				const size_t ch = (magic[1] == '6') ? 3 : 1;
+				std::vector<uint8_t> buf((size_t)w * h * ch);
+				bool ok = (fread(buf.data(), 1, buf.size(), fp) == buf.size());
+				fclose(fp);
+				if (!ok) {
+					fprintf(stderr, "%s: truncated\n", path);
+					return false;
+				}
+				rgb.resize((size_t)w * h);
+				for (size_t k=0; k<rgb.size(); k++) {
+					const uint8_t *p = &buf[k * ch];
+					rgb[k] = (ch == 3) ? ((uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2]) : (p[0] * 0x010101u);
+				}
+				return true;
+			}
+
+			/* raw RGB24 frames (e.g. ffmpeg -f rawvideo -pix_fmt rgb24 -) */
+			static bool load_raw(FILE *fp, const SimTiming& t, std::vector<uint32_t>& rgb) {
+				std::vector<uint8_t> buf((size_t)t.h_active * t.v_active * 3);
+				if (fread(buf.data(), 1, buf.size(), fp) != buf.size()) return false;
+				rgb.resize(buf.size() / 3);
+				for (size_t k=0; k<rgb.size(); k++)
+					rgb[k] = (uint32_t)buf[k * 3] << 16 | (uint32_t)buf[k * 3 + 1] << 8 | buf[k * 3 + 2];
+				return true;
+			}
+	};
+};
+
+#endif // _SIM_PIXEL_STREAM_H_
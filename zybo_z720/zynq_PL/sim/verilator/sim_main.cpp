@@ -0,0 +1,440 @@
+//-----------------------------------------------------------------------------
+// <sim_main.cpp>
+//  - Verilator harness of <image_processor>
+//    - streams frames of PPM / PGM files or raw RGB24 video (stdin) with
+//      the syncs of timing[] and the counts of vid_sync2cnt
+//    - captures out_data, the luma and outputs of simple_lsd (corpus of
+//      libimgproc) and the LSD buffer read like slab::LSDReader
+//    - reports simulated cycles per frame and the speed of the host
+//-----------------------------------------------------------------------------
+// Clocks
+//  - pixelclk at pclk_freq_Hz of the mode, psclk at --psclk MHz (50 MHz
+//    like ps_clk of vdma_top); the LSD buffer is read in the psclk domain
+// Corpus
+//  - NNNN.pgm is in_y of simple_lsd (cs_data) and NNNN.txt holds the
+//    cycles with out_flag up to the end of the next luma frame, i.e. the
+//    format read by "main verify <dir>" of libimgproc/sample
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 17, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 18, 2020)
+//  - Moved the input frames to slab::FrameSource (pixel_stream.hpp)
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <verilated.h>
+#if VM_TRACE_FST
+#include <verilated_fst_c.h>
+typedef VerilatedFstC VerilatedTrace;
+#elif VM_TRACE
+#include <verilated_vcd_c.h>
+typedef VerilatedVcdC VerilatedTrace;
+#endif
+#include "Vsim_top.h"
+#include "pixel_stream.hpp"
+
+/* mode of the build (-G parameters of sim_top, see Makefile) */
+static const slab::SimTiming timing = {
+	SIM_H_ACTIVE, SIM_H_FP, SIM_H_SYNC, SIM_H_BP, SIM_H_POS,
+	SIM_V_ACTIVE, SIM_V_FP, SIM_V_SYNC, SIM_V_BP, SIM_V_POS,
+	SIM_PCLK_FREQ
+};
+
+#define RESET_CYCLES 16
+#define DRAIN_FRAMES  2
+
+static uint64_t monotonic_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static std::string frame_path(const std::string& dir, uint64_t i, const char *ext) {
+	char name[32];
+	snprintf(name, sizeof(name), "/%04llu.%s", (unsigned long long)i, ext);
+	return dir + name;
+}
+
+//-----------------------------------------------------------------------------
+// frames
+//-----------------------------------------------------------------------------
+static bool save_ppm(const std::string& path, const std::vector<uint32_t>& rgb) {
+	FILE *fp = fopen(path.c_str(), "wb");
+	if (fp == NULL) return false;
+	fprintf(fp, "P6\n%u %u\n255\n", timing.h_active, timing.v_active);
+	std::vector<uint8_t> buf(rgb.size() * 3);
+	for (size_t k=0; k<rgb.size(); k++) {
+		buf[k * 3    ] = rgb[k] >> 16;
+		buf[k * 3 + 1] = rgb[k] >> 8;
+		buf[k * 3 + 2] = rgb[k];
+	}
+	bool ok = (fwrite(buf.data(), 1, buf.size(), fp) == buf.size());
+	fclose(fp);
+	return ok;
+}
+
+static bool save_pgm(const std::string& path, const std::vector<uint8_t>& y) {
+	FILE *fp = fopen(path.c_str(), "wb");
+	if (fp == NULL) return false;
+	fprintf(fp, "P5\n%u %u\n255\n", timing.h_active, timing.v_active);
+	bool ok = (fwrite(y.data(), 1, y.size(), fp) == y.size());
+	fclose(fp);
+	return ok;
+}
+
+//-----------------------------------------------------------------------------
+// options
+//-----------------------------------------------------------------------------
+typedef struct Options {
+	uint32_t                 sw;
+	uint64_t                 frames;       // 0: until the inputs run out
+	double                   psclk_mhz;
+	std::string              out_dir, corpus_dir, lsdbuf_dir, trace_path;
+	uint64_t                 trace_from, trace_to;
+	std::vector<const char*> inputs;
+} Options;
+
+static void usage(const char *name) {
+	printf("usage: %s [options] <ppm|pgm|-> ...  (%ux%u, %.2f MHz)\n", name,
+			timing.h_active, timing.v_active, timing.pclk_freq_Hz / 1e6);
+	printf("  -                   raw RGB24 frames from stdin\n");
+	printf("  --sw <n>            sw[3:0] of image_processor (default 3)\n");
+	printf("  --frames <n>        input frames (default: every input once)\n");
+	printf("  --psclk <MHz>       clock of the LSD buffer and registers (default 50)\n");
+	printf("  --out <dir>         out_data of every frame (NNNN.ppm)\n");
+	printf("  --corpus <dir>      in_y and outputs of simple_lsd (NNNN.pgm, NNNN.txt)\n");
+	printf("  --lsdbuf <dir>      LSD buffer after every frame (NNNN.txt)\n");
+	printf("  --trace <file>      waveforms (builds with TRACE=1)\n");
+	printf("  --trace-frames a:b  input frames a to b of the trace (default all)\n");
+}
+
+static bool parse(int argc, char **argv, Options& o) {
+	o.sw         = 3;
+	o.frames     = 0;
+	o.psclk_mhz  = 50.0;
+	o.trace_from = 0;
+	o.trace_to   = UINT64_MAX;
+	for (int i=1; i<argc; i++) {
+		const char *a = argv[i];
+		const bool  v = (i + 1 < argc);
+		if      (!strcmp(a, "--sw")     && v) o.sw         = atoi(argv[++i]) & 0xf;
+		else if (!strcmp(a, "--frames") && v) o.frames     = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(a, "--psclk")  && v) o.psclk_mhz  = atof(argv[++i]);
+		else if (!strcmp(a, "--out")    && v) o.out_dir    = argv[++i];
+		else if (!strcmp(a, "--corpus") && v) o.corpus_dir = argv[++i];
+		else if (!strcmp(a, "--lsdbuf") && v) o.lsdbuf_dir = argv[++i];
+		else if (!strcmp(a, "--trace")  && v) o.trace_path = argv[++i];
+		else if (!strcmp(a, "--trace-frames") && v) {
+			unsigned long long from, to;
+			if (sscanf(argv[++i], "%llu:%llu", &from, &to) != 2) return false;
+			o.trace_from = from;
+			o.trace_to   = to;
+		}
+		else if (a[0] == '+') continue; // +verilator+ arguments
+		else if (a[0] == '-' && a[1] != '\0') return false;
+		else o.inputs.push_back(a);
+	}
+	return !o.inputs.empty() && o.psclk_mhz > 0;
+}
+
+//-----------------------------------------------------------------------------
+// harness
+//-----------------------------------------------------------------------------
+class Harness {
+	private:
+		typedef struct LsdOutput {
+			uint32_t start_v, start_h, end_v, end_h, angle, valid;
+		} LsdOutput;
+		typedef struct LsdLine {
+			uint32_t start_h, start_v, end_h, end_v;
+		} LsdLine;
+		enum ReaderState {READER_IDLE, READER_WAIT, READER_READ};
+
+		const Options&                 o_;
+		std::unique_ptr<VerilatedContext> ctx_;
+		std::unique_ptr<Vsim_top>      top_;
+#if VM_TRACE
+		std::unique_ptr<VerilatedTrace> trace_;
+#endif
+		slab::PixelStream              stream_;
+		slab::SyncToCount              sync_;
+		slab::FrameCapture<uint32_t>   out_;
+		slab::FrameCapture<uint8_t>    luma_;
+
+		/* inputs */
+		slab::FrameSource              source_;
+
+		/* corpus */
+		uint64_t                       luma_frames_, out_frames_;
+		std::vector<LsdOutput>         flags_;
+		uint64_t                       luma_done_cycle_, burst_first_, burst_last_;
+
+		/* LSD buffer (psclk) */
+		ReaderState                    reader_;
+		bool                           fetch_;
+		uint32_t                       line_num_, line_;
+		std::vector<LsdLine>           lines_;
+		uint64_t                       fetches_;
+
+		/* statistics */
+		uint64_t                       cycles_, jumps_, frame_cycle_, frame_ns_, start_ns_;
+
+		void trace_control() {
+#if VM_TRACE
+			const uint64_t f = stream_.frames() - 1;
+			if (!o_.trace_path.empty() && !trace_ && f >= o_.trace_from && f <= o_.trace_to) {
+				trace_.reset(new VerilatedTrace);
+				top_->trace(trace_.get(), 99);
+				trace_->open(o_.trace_path.c_str());
+			}
+			if (trace_ && f > o_.trace_to) {
+				trace_->close();
+				trace_.reset();
+			}
+#endif
+		}
+
+		void flush_flags() {
+			if (luma_frames_ == 0) return;
+			const uint64_t i = luma_frames_ - 1;
+			if (!o_.corpus_dir.empty() && i < source_.count()) {
+				FILE *fp = fopen(frame_path(o_.corpus_dir, i, "txt").c_str(), "w");
+				if (fp != NULL) {
+					for (size_t k=0; k<flags_.size(); k++) {
+						const LsdOutput& f = flags_[k];
+						fprintf(fp, "%u %u %u %u %u %u\n", f.start_v, f.start_h, f.end_v, f.end_h,
+								f.angle, f.valid);
+					}
+					fclose(fp);
+				}
+			}
+			if (!flags_.empty())
+				printf("  lsd   %04llu : %zu outputs, +%llu..%llu cycles after the frame\n",
+						(unsigned long long)i, flags_.size(),
+						(unsigned long long)(burst_first_ - luma_done_cycle_),
+						(unsigned long long)(burst_last_  - luma_done_cycle_));
+			flags_.clear();
+		}
+
+		/* after a rising edge of pixelclk: outputs of the cycle, then the next inputs */
+		void pixelclk_edge() {
+			cycles_++;
+			if (top_->out_vde && out_.feed(top_->out_vcnt, top_->out_hcnt, top_->out_data)) {
+				if (!o_.out_dir.empty() && out_frames_ < source_.count()) save_ppm(frame_path(o_.out_dir, out_frames_, "ppm"), out_.frame());
+				out_frames_++;
+			}
+			if (luma_.feed(top_->tap_y_vcnt, top_->tap_y_hcnt, top_->tap_y)) {
+				flush_flags();
+				if (!o_.corpus_dir.empty() && luma_frames_ < source_.count()) save_pgm(frame_path(o_.corpus_dir, luma_frames_, "pgm"), luma_.frame());
+				luma_frames_++;
+				luma_done_cycle_ = cycles_;
+				fetch_ = true;
+			}
+			if (top_->tap_lsd_flag && luma_frames_ > 0) {
+				LsdOutput f = {top_->tap_lsd_start_v, top_->tap_lsd_start_h, top_->tap_lsd_end_v,
+					top_->tap_lsd_end_h, top_->tap_lsd_angle, top_->tap_lsd_valid};
+				if (flags_.empty()) burst_first_ = cycles_;
+				burst_last_ = cycles_;
+				flags_.push_back(f);
+			}
+
+			/* vid_sync2cnt samples the syncs of this cycle */
+			sync_.clock(stream_.vsync(), stream_.hsync());
+			jumps_ += sync_.jumped();
+			stream_.step();
+			if (stream_.vpos() == 0 && stream_.hpos() == 0) frame_done();
+			top_->in_data = stream_.data();
+			top_->in_vcnt = sync_.vcnt();
+			top_->in_hcnt = sync_.hcnt();
+		}
+
+		void frame_done() {
+			const uint64_t now = monotonic_ns(), f = stream_.frames() - 2;
+			const uint64_t c   = cycles_ - frame_cycle_;
+			printf("frame %04llu : %llu cycles (%.2f ms at %.2f MHz), %.3f s, %.1f kcycles/s\n",
+					(unsigned long long)f, (unsigned long long)c, c * 1e3 / timing.pclk_freq_Hz,
+					timing.pclk_freq_Hz / 1e6, (now - frame_ns_) / 1e9, c * 1e6 / (now - frame_ns_));
+			fflush(stdout);
+			frame_cycle_ = cycles_;
+			frame_ns_    = now;
+
+			trace_control();
+			push_next();
+		}
+
+		/* PixelStream latches the pending frame at (0, 0): keep one queued */
+		void push_next() {
+			std::vector<uint32_t> rgb;
+			if (source_.next(rgb)) stream_.push(rgb);
+		}
+
+		/* after a rising edge of psclk: slab::LSDReader::fetch() one cycle at a time */
+		void psclk_edge() {
+			switch (reader_) {
+				case READER_IDLE:
+					if (!fetch_) break;
+					fetch_ = false;
+					top_->in_lsdbuf_write_protect = 1;
+					reader_ = READER_WAIT;
+					break;
+				case READER_WAIT:
+					if (!top_->out_lsdbuf_ready) break;
+					line_num_ = std::min<uint32_t>(top_->out_lsdbuf_line_num, SIM_RAM_SIZE);
+					line_     = 0;
+					lines_.clear();
+					top_->in_lsdbuf_raddr = 0;
+					reader_ = READER_READ;
+					break;
+				case READER_READ:
+					/* rd_addr was registered at this edge */
+					if (line_ < line_num_) {
+						LsdLine l = {top_->out_lsdbuf_start_h, top_->out_lsdbuf_start_v,
+							top_->out_lsdbuf_end_h, top_->out_lsdbuf_end_v};
+						lines_.push_back(l);
+						top_->in_lsdbuf_raddr = ++line_;
+						if (line_ < line_num_) break;
+					}
+					top_->in_lsdbuf_write_protect = 0;
+					save_lines();
+					reader_ = READER_IDLE;
+					break;
+			}
+		}
+
+		void save_lines() {
+			if (!o_.lsdbuf_dir.empty()) {
+				FILE *fp = fopen(frame_path(o_.lsdbuf_dir, fetches_, "txt").c_str(), "w");
+				if (fp != NULL) {
+					for (size_t k=0; k<lines_.size(); k++)
+						fprintf(fp, "%u %u %u %u\n", lines_[k].start_h, lines_[k].start_v,
+								lines_[k].end_h, lines_[k].end_v);
+					fclose(fp);
+				}
+			}
+			printf("  lsdbuf %04llu : %zu lines\n", (unsigned long long)fetches_, lines_.size());
+			fetches_++;
+		}
+	protected:
+	public:
+		Harness(const Options& o, int argc, char **argv) :
+			o_(o), ctx_(new VerilatedContext), stream_(timing), sync_(timing),
+			out_(timing.h_active, timing.v_active), luma_(timing.h_active, timing.v_active),
+			source_(timing, o.inputs, o.frames, o.frames != 0), luma_frames_(0), out_frames_(0),
+			luma_done_cycle_(0), burst_first_(0), burst_last_(0),
+			reader_(READER_IDLE), fetch_(false), line_num_(0), line_(0), fetches_(0),
+			cycles_(0), jumps_(0), frame_cycle_(0), frame_ns_(0), start_ns_(0)
+		{
+			ctx_->commandArgs(argc, argv);
+#if VM_TRACE
+			ctx_->traceEverOn(true);
+#endif
+			top_.reset(new Vsim_top(ctx_.get()));
+		}
+
+		~Harness() {
+#if VM_TRACE
+			if (trace_) trace_->close();
+#endif
+			top_->final();
+		}
+
+		int run() {
+			const uint64_t pix_half = (uint64_t)(5e11 / timing.pclk_freq_Hz); // ps
+			const uint64_t ps_half  = (uint64_t)(5e5 / o_.psclk_mhz);
+			uint64_t t_pix = pix_half, t_ps = ps_half, now = 0;
+			std::vector<uint32_t> rgb;
+
+			if (!source_.next(rgb)) return -1;
+			stream_.push(rgb);
+#if !VM_TRACE
+			if (!o_.trace_path.empty()) fprintf(stderr, "--trace: build with TRACE=1\n");
+#endif
+			top_->sw                  = o_.sw;
+			top_->in_lsd_angle_thres  = 0;  // parameters of simple_lsd
+			top_->in_lsd_grad_thres   = 0;
+			top_->in_lsd_length_thres = 0;
+			top_->in_lsd_manual_thres = 0;
+			top_->in_lsdbuf_write_protect = 0;
+			top_->in_lsdbuf_raddr     = 0;
+			top_->rst                 = 1;
+
+			/* vid_sync2cnt has seen one frame of syncs, so frame 0 is complete */
+			slab::PixelStream preroll(timing);
+			for (uint64_t k=0; k<(uint64_t)timing.h_frame() * timing.v_frame(); k++) {
+				sync_.clock(preroll.vsync(), preroll.hsync());
+				preroll.step();
+			}
+
+			uint32_t reset = RESET_CYCLES;
+			bool     pix = false, ps = false;
+			start_ns_ = frame_ns_ = monotonic_ns();
+			while (!ctx_->gotFinish()) {
+				const uint64_t t = std::min(t_pix, t_ps);
+				const bool pix_edge = (t == t_pix), ps_edge = (t == t_ps);
+				if (pix_edge) { pix = !pix; top_->pixelclk = pix; t_pix += pix_half; }
+				if (ps_edge)  { ps  = !ps;  top_->psclk    = ps;  t_ps  += ps_half;  }
+				ctx_->timeInc(t - now);
+				now = t;
+				top_->eval();
+#if VM_TRACE
+				if (trace_) trace_->dump(ctx_->time());
+#endif
+				if (pix_edge && pix) {
+					if (reset > 0) {
+						/* the stream starts at (0, 0) with the release of rst */
+						if (--reset == 0) {
+							top_->rst = 0;
+							stream_.start();
+							trace_control();
+							push_next();
+							top_->in_data = stream_.data();
+							top_->in_vcnt = sync_.vcnt();
+							top_->in_hcnt = sync_.hcnt();
+						}
+						continue;
+					}
+					pixelclk_edge();
+					/* two more frames after the last input drain simple_lsd */
+					if (stream_.frames() > source_.count() + DRAIN_FRAMES) break;
+				}
+				if (ps_edge && ps && reset == 0) psclk_edge();
+			}
+			flush_flags();
+
+			const double sec = (monotonic_ns() - start_ns_) / 1e9;
+			printf("%llu input frames, %llu output frames, %llu luma frames, %llu LSD buffer reads\n",
+					(unsigned long long)source_.count(), (unsigned long long)out_frames_,
+					(unsigned long long)luma_frames_, (unsigned long long)fetches_);
+			printf("%llu cycles (%llu per frame) in %.2f s : %.1f kcycles/s, %.3f frames/s, %.1fx slower than the PL\n",
+					(unsigned long long)cycles_, (unsigned long long)timing.h_frame() * timing.v_frame(), sec,
+					cycles_ / sec / 1e3, cycles_ / sec / ((double)timing.h_frame() * timing.v_frame()),
+					sec * timing.pclk_freq_Hz / (cycles_ ? cycles_ : 1));
+			if (jumps_ > 0) printf("vid_sync2cnt reloaded the counts %llu times with a jump\n",
+					(unsigned long long)jumps_);
+			return 0;
+		}
+};
+
+int main(int argc, char **argv) {
+	Options o;
+	if (!parse(argc, argv, o)) {
+		usage(argv[0]);
+		return 1;
+	}
+	printf("%ux%u (frame %ux%u), hsync %s, vsync %s, sw = %u\n", timing.h_active, timing.v_active,
+			timing.h_frame(), timing.v_frame(), timing.h_pos ? "+" : "-", timing.v_pos ? "+" : "-", o.sw);
+	Harness harness(o, argc, argv);
+	return harness.run() ? 1 : 0;
+}
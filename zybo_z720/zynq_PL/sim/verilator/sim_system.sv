@@ -0,0 +1,83 @@
+//-----------------------------------------------------------------------------
+// <sim_system>
+//  - Top module of the register simulator (sim_uio.cpp)
+//    - vdma_top as synthesized, with the Xilinx IPs replaced by stub/
+//      (block_design_wrapper, BUFG, rgb2dvi_0)
+//    - block_design_wrapper takes the clocks, the VTC / VDMA video and the
+//      AXI-Lite registers (slv_wireNN, axi_araddr) from the ports below
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 18, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+`default_nettype none
+
+module sim_system
+	#(
+		parameter integer H_ACTIVE      = 640,
+		parameter integer H_FRONT_PORCH =  16,
+		parameter integer H_SYNC_WIDTH  =  96,
+		parameter integer H_BACK_PORCH  =  48,
+		parameter integer V_ACTIVE      = 480,
+		parameter integer V_FRONT_PORCH =  10,
+		parameter integer V_SYNC_WIDTH  =   2,
+		parameter integer V_BACK_PORCH  =  33
+	)
+	(
+		/* block design: clocks and vid_locked */
+		input  wire pixelclk, psclk, locked,
+		input  wire [3:0] sw,
+
+		/* block design: VTC / VDMA (MM2S) */
+		input  wire [23:0] vid_data,
+		input  wire vid_hsync, vid_vsync, vid_vde,
+
+		/* block design: AXI-Lite registers (slab::UIO) */
+		input  wire [4:0]  axi_waddr,
+		input  wire [31:0] axi_wdata,
+		input  wire axi_wen,
+		input  wire [4:0]  axi_raddr,
+		output wire [31:0] axi_rdata,
+
+		/* HDMI side (before rgb2dvi) */
+		output wire [23:0] out_data,
+		output wire out_vde,
+		output wire [3:0] led
+	);
+
+	wire [2:0] led5, led6;
+	wire hdmi_tx_clk_n, hdmi_tx_clk_p;
+	wire [2:0] hdmi_tx_n, hdmi_tx_p;
+	vdma_top #(
+		.PS_CLK_FREQ        (50 * 10 ** 6 ),
+		.VID_H_ACTIVE       (H_ACTIVE     ),
+		.VID_H_FRONT_PORCH  (H_FRONT_PORCH),
+		.VID_H_SYNC_WIDTH   (H_SYNC_WIDTH ),
+		.VID_H_BACK_PORCH   (H_BACK_PORCH ),
+		.VID_V_ACTIVE       (V_ACTIVE     ),
+		.VID_V_FRONT_PORCH  (V_FRONT_PORCH),
+		.VID_V_SYNC_WIDTH   (V_SYNC_WIDTH ),
+		.VID_V_BACK_PORCH   (V_BACK_PORCH ),
+		.C_S_AXI_DATA_WIDTH (          32),
+		.C_S_AXI_ADDR_WIDTH (           7)
+	) dut (
+		.hdmi_tx_clk_n (hdmi_tx_clk_n),
+		.hdmi_tx_clk_p (hdmi_tx_clk_p),
+		.hdmi_tx_n     (hdmi_tx_n    ),
+		.hdmi_tx_p     (hdmi_tx_p    ),
+		.btn           (4'h1         ),
+		.sw            (sw           ),
+		.led5          (led5         ),
+		.led6          (led6         ),
+		.led           (led          )
+	);
+
+	assign axi_rdata = dut.zynq_ps_interface_inst0.reg_data_out;
+	assign out_data  = {dut.vid_out_r, dut.vid_out_g, dut.vid_out_b};
+	assign out_vde   = dut.vid_out_VDE;
+
+endmodule
+
+`default_nettype wire
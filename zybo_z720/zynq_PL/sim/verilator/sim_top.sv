@@ -0,0 +1,137 @@
+//-----------------------------------------------------------------------------
+// <sim_top>
+//  - Top module of the Verilator harness of <image_processor>
+//    - image_processor with the parameters of vdma_top
+//    - in_vcnt / in_hcnt / in_data come from the pixel-stream driver
+//      (pixel_stream.hpp models vid_sync2cnt)
+//    - taps of the luma into simple_lsd and of its outputs (for the corpus
+//      of the C++ model)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 17, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+`default_nettype none
+
+module sim_top
+	#(
+		parameter integer H_ACTIVE      = 640,
+		parameter integer H_FRONT_PORCH =  16,
+		parameter integer H_SYNC_WIDTH  =  96,
+		parameter integer H_BACK_PORCH  =  48,
+		parameter integer V_ACTIVE      = 480,
+		parameter integer V_FRONT_PORCH =  10,
+		parameter integer V_SYNC_WIDTH  =   2,
+		parameter integer V_BACK_PORCH  =  33,
+		parameter integer RAM_SIZE      = 4096,
+		parameter integer H_FRAME       = H_ACTIVE + H_FRONT_PORCH + H_SYNC_WIDTH + H_BACK_PORCH,
+		parameter integer V_FRAME       = V_ACTIVE + V_FRONT_PORCH + V_SYNC_WIDTH + V_BACK_PORCH
+	)
+	(
+		/* clock and reset */
+		input  wire  pixelclk, psclk, rst,
+		input  wire  [3:0] sw,
+
+		/* video input (VDMA IP -> vid_sync2cnt) */
+		input  wire  [23:0] in_data,
+		input  wire  [$clog2(V_FRAME)-1:0] in_vcnt,
+		input  wire  [$clog2(H_FRAME)-1:0] in_hcnt,
+
+		/* video output */
+		output wire  [23:0] out_data,
+		output wire  [$clog2(V_FRAME)-1:0] out_vcnt,
+		output wire  [$clog2(H_FRAME)-1:0] out_hcnt,
+		output wire  out_vde,
+
+		/* LSD buffer (psclk) */
+		input  wire  [$clog2(RAM_SIZE)-1:0] in_lsdbuf_raddr,
+		input  wire  in_lsdbuf_write_protect,
+		output wire  [$clog2(RAM_SIZE)-1:0] out_lsdbuf_line_num,
+		output wire  [$clog2(V_FRAME)-1:0]  out_lsdbuf_start_v, out_lsdbuf_end_v,
+		output wire  [$clog2(H_FRAME)-1:0]  out_lsdbuf_start_h, out_lsdbuf_end_h,
+		output wire  out_lsdbuf_ready,
+
+		/* thresholds and status of LSD (psclk) */
+		input  wire  [7:0]  in_lsd_angle_thres, in_lsd_grad_thres, in_lsd_length_thres,
+		input  wire  in_lsd_manual_thres,
+		output wire  out_lsd_overused,
+		output wire  [16:0] out_lsd_thres_offset,
+
+		/* taps (pixelclk) */
+		output wire  [7:0] tap_y,                   // in_y of simple_lsd
+		output wire  [$clog2(V_FRAME)-1:0] tap_y_vcnt,
+		output wire  [$clog2(H_FRAME)-1:0] tap_y_hcnt,
+		output wire  tap_lsd_flag, tap_lsd_valid,   // outputs of simple_lsd
+		output wire  [$clog2(V_FRAME)-1:0] tap_lsd_start_v, tap_lsd_end_v,
+		output wire  [$clog2(H_FRAME)-1:0] tap_lsd_start_h, tap_lsd_end_h,
+		output wire  [7:0] tap_lsd_angle
+	);
+
+	/* Image Processing */
+	wire out_hblank, out_vblank, out_field;
+	wire [$clog2(H_ACTIVE*V_ACTIVE)-1:0] hist_data;
+	wire [7:0]  hist_min, hist_max;
+	wire [31:0] hist_frames;
+	wire hist_ready;
+	image_processor #(
+		.DATA_WIDTH (8       ),
+		.H_ACTIVE   (H_ACTIVE),
+		.V_ACTIVE   (V_ACTIVE),
+		.H_FRAME    (H_FRAME ),
+		.V_FRAME    (V_FRAME ),
+		.RAM_SIZE   (RAM_SIZE)
+	) dut (
+		.pixelclk                (pixelclk               ),
+		.psclk                   (psclk                  ),
+		.rst                     (rst                    ),
+		.sw                      (sw                     ),
+		.in_data                 (in_data                ),
+		.in_vcnt                 (in_vcnt                ),
+		.in_hcnt                 (in_hcnt                ),
+		.in_lsdbuf_raddr         (in_lsdbuf_raddr        ),
+		.in_lsdbuf_write_protect (in_lsdbuf_write_protect),
+		.out_lsdbuf_line_num     (out_lsdbuf_line_num    ),
+		.out_lsdbuf_start_v      (out_lsdbuf_start_v     ),
+		.out_lsdbuf_end_v        (out_lsdbuf_end_v       ),
+		.out_lsdbuf_start_h      (out_lsdbuf_start_h     ),
+		.out_lsdbuf_end_h        (out_lsdbuf_end_h       ),
+		.out_lsdbuf_ready        (out_lsdbuf_ready       ),
+		.in_lsd_angle_thres      (in_lsd_angle_thres     ),
+		.in_lsd_grad_thres       (in_lsd_grad_thres      ),
+		.in_lsd_length_thres     (in_lsd_length_thres    ),
+		.in_lsd_manual_thres     (in_lsd_manual_thres    ),
+		.out_lsd_overused        (out_lsd_overused       ),
+		.out_lsd_thres_offset    (out_lsd_thres_offset   ),
+		.out_lsd_flag            (tap_lsd_flag           ),
+		.out_lsd_valid           (tap_lsd_valid          ),
+		.in_hist_raddr           (8'd0                   ),
+		.in_hist_freeze          (1'b0                   ),
+		.out_hist_ready          (hist_ready             ),
+		.out_hist_data           (hist_data              ),
+		.out_hist_min            (hist_min               ),
+		.out_hist_max            (hist_max               ),
+		.out_hist_frames         (hist_frames            ),
+		.out_data                (out_data               ),
+		.out_vcnt                (out_vcnt               ),
+		.out_hcnt                (out_hcnt               ),
+		.out_hblank              (out_hblank             ),
+		.out_vblank              (out_vblank             ),
+		.out_field               (out_field              ),
+		.out_vde                 (out_vde                )
+	);
+
+	/* taps (hierarchical references into image_processor) */
+	assign tap_y           = dut.cs_data;
+	assign tap_y_vcnt      = dut.cs_vcnt;
+	assign tap_y_hcnt      = dut.cs_hcnt;
+	assign tap_lsd_start_v = dut.lsd_start_v;
+	assign tap_lsd_start_h = dut.lsd_start_h;
+	assign tap_lsd_end_v   = dut.lsd_end_v;
+	assign tap_lsd_end_h   = dut.lsd_end_h;
+	assign tap_lsd_angle   = dut.lsd_angle;
+
+endmodule
+
+`default_nettype wire
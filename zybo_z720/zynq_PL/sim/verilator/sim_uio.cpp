@@ -0,0 +1,330 @@
+//-----------------------------------------------------------------------------
+// <sim_uio.cpp>
+//  - Register simulator: Verilated vdma_top (sim_system) behind slab::UIO
+//    - creates the mailbox of slab/uio/sim.hpp in shared memory; programs
+//      started with SLAB_UIO_SIM=<name> (e.g. zynq_PS/rootfs/sample) read
+//      and write the registers of zynq_ps_interface through it
+//    - the VTC / VDMA video comes from PPM / PGM files or raw RGB24 video
+//      (stdin), repeated until --frames or SIGINT
+//    - prints the register traffic and the speed of the host per frame
+//-----------------------------------------------------------------------------
+// Registers
+//  - one access every --axi-cycles cycles of psclk (default 4, about an
+//    AXI-Lite transaction of M_AXI_GP0): a write sets slv_wireNN at the
+//    first edge, a read samples reg_data_out at the last one
+//  - every access posted since the last look is served back to back, so
+//    the writes of slab::UIO go in batches and a read waits only for the
+//    accesses before it
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 18, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <verilated.h>
+#include "Vsim_system.h"
+#include "pixel_stream.hpp"
+#include <slab/uio/sim.hpp>
+
+/* mode of the build (-G parameters of sim_system, see Makefile) */
+static const slab::SimTiming timing = {
+	SIM_H_ACTIVE, SIM_H_FP, SIM_H_SYNC, SIM_H_BP, SIM_H_POS,
+	SIM_V_ACTIVE, SIM_V_FP, SIM_V_SYNC, SIM_V_BP, SIM_V_POS,
+	SIM_PCLK_FREQ
+};
+
+#define RESET_CYCLES 16
+#define DRAIN_FRAMES  2
+
+static volatile sig_atomic_t stop_flag = 0;
+
+static void on_signal(int) {
+	stop_flag = 1;
+}
+
+static uint64_t monotonic_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+//-----------------------------------------------------------------------------
+// options
+//-----------------------------------------------------------------------------
+typedef struct Options {
+	uint32_t                 sw;
+	uint64_t                 frames;       // 0: until SIGINT
+	double                   psclk_mhz;
+	uint32_t                 axi_cycles;
+	uint32_t                 interval;     // frames per line of statistics
+	std::string              shm;
+	std::vector<const char*> inputs;
+} Options;
+
+static void usage(const char *name) {
+	printf("usage: %s [options] <ppm|pgm|-> ...  (%ux%u, %.2f MHz)\n", name,
+			timing.h_active, timing.v_active, timing.pclk_freq_Hz / 1e6);
+	printf("  -                   raw RGB24 frames from stdin\n");
+	printf("  --shm <name>        shared memory of the mailbox (default /slab_uio)\n");
+	printf("  --sw <n>            sw[3:0] of vdma_top (default 3)\n");
+	printf("  --frames <n>        input frames (default: repeat until SIGINT)\n");
+	printf("  --psclk <MHz>       ps_clk (default 50)\n");
+	printf("  --axi-cycles <n>    psclk cycles of one register access (default 4)\n");
+	printf("  --interval <n>      frames per line of statistics (default 1)\n");
+	printf("then run the program with %s=<name>\n", UIO_SIM_ENV);
+}
+
+static bool parse(int argc, char **argv, Options& o) {
+	o.sw         = 3;
+	o.frames     = 0;
+	o.psclk_mhz  = 50.0;
+	o.axi_cycles = 4;
+	o.interval   = 1;
+	o.shm        = "/slab_uio";
+	for (int i=1; i<argc; i++) {
+		const char *a = argv[i];
+		const bool  v = (i + 1 < argc);
+		if      (!strcmp(a, "--shm")        && v) o.shm        = argv[++i];
+		else if (!strcmp(a, "--sw")         && v) o.sw         = atoi(argv[++i]) & 0xf;
+		else if (!strcmp(a, "--frames")     && v) o.frames     = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(a, "--psclk")      && v) o.psclk_mhz  = atof(argv[++i]);
+		else if (!strcmp(a, "--axi-cycles") && v) o.axi_cycles = atoi(argv[++i]);
+		else if (!strcmp(a, "--interval")   && v) o.interval   = atoi(argv[++i]);
+		else if (a[0] == '+') continue; // +verilator+ arguments
+		else if (a[0] == '-' && a[1] != '\0') return false;
+		else o.inputs.push_back(a);
+	}
+	return !o.inputs.empty() && o.psclk_mhz > 0 && o.axi_cycles > 0 && o.interval > 0;
+}
+
+//-----------------------------------------------------------------------------
+// simulator
+//-----------------------------------------------------------------------------
+class RegisterSimulator {
+	private:
+		const Options&                    o_;
+		std::unique_ptr<VerilatedContext> ctx_;
+		std::unique_ptr<Vsim_system>      top_;
+		slab::PixelStream                 stream_;
+		slab::FrameSource                 source_;
+		slab::UIOSimMailbox              *mb_;
+
+		/* access in flight */
+		uint32_t              next_;     // index of the next access
+		uint32_t              seen_;     // accesses seen in the mailbox
+		bool                  busy_;
+		uint32_t              wait_;
+		std::vector<uint64_t> seen_at_;  // psclk cycle an access was seen
+
+		/* statistics (since the last line) */
+		uint64_t cycles_, ps_cycles_, frame_cycle_, line_ns_, start_ns_;
+		uint64_t reads_, writes_, batches_, batch_max_, read_wait_, total_accesses_;
+
+		bool create_mailbox() {
+			int fd = shm_open(o_.shm.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0666);
+			if (fd < 0) {
+				perror("cannot create the mailbox");
+				return false;
+			}
+			if (ftruncate(fd, sizeof(slab::UIOSimMailbox)) < 0) {
+				perror("cannot size the mailbox");
+				close(fd);
+				return false;
+			}
+			void *p = mmap(NULL, sizeof(slab::UIOSimMailbox), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd);
+			if (p == MAP_FAILED) {
+				perror("cannot mmap the mailbox");
+				return false;
+			}
+			mb_ = new (p) slab::UIOSimMailbox;
+			mb_->magic   = UIO_SIM_MAGIC;
+			mb_->version = UIO_SIM_VERSION;
+			mb_->head.store(0, std::memory_order_relaxed);
+			mb_->done.store(0, std::memory_order_relaxed);
+			mb_->alive.store(1, std::memory_order_release);
+			return true;
+		}
+
+		void push_next() {
+			std::vector<uint32_t> rgb;
+			if (source_.next(rgb)) stream_.push(rgb);
+		}
+
+		void drive_video() {
+			top_->vid_data  = stream_.data();
+			top_->vid_hsync = stream_.hsync();
+			top_->vid_vsync = stream_.vsync();
+			top_->vid_vde   = stream_.active();
+		}
+
+		void frame_done() {
+			const uint64_t f = stream_.frames() - 2;
+			push_next();
+			if ((f + 1) % o_.interval != 0) return;
+
+			const uint64_t now = monotonic_ns(), c = cycles_ - frame_cycle_;
+			const uint64_t n   = reads_ + writes_;
+			printf("frame %04llu : %.1f kcycles/s, %llu reads, %llu writes, batch %.1f (max %llu), read %.1f psclk\n",
+					(unsigned long long)f, c * 1e6 / (now - line_ns_),
+					(unsigned long long)reads_, (unsigned long long)writes_,
+					batches_ ? (double)n / batches_ : 0.0, (unsigned long long)batch_max_,
+					reads_ ? (double)read_wait_ / reads_ : 0.0);
+			fflush(stdout);
+			total_accesses_ += n;
+			reads_ = writes_ = batches_ = batch_max_ = read_wait_ = 0;
+			frame_cycle_ = cycles_;
+			line_ns_     = now;
+		}
+
+		/* after a rising edge of psclk: one register access at a time */
+		void psclk_edge() {
+			ps_cycles_++;
+			top_->axi_wen = 0;
+
+			/* accesses posted since the last look */
+			const uint32_t head = mb_->head.load(std::memory_order_acquire);
+			if (head != seen_) {
+				const uint32_t n = head - seen_;
+				for (; seen_ != head; seen_++) seen_at_[seen_ % UIO_SIM_SLOTS] = ps_cycles_;
+				if (!busy_) {
+					batches_++;
+					batch_max_ = std::max<uint64_t>(batch_max_, n);
+				}
+			}
+
+			if (busy_ && --wait_ == 0) {
+				slab::UIOSimAccess& a = mb_->slot[next_ % UIO_SIM_SLOTS];
+				if (!a.write) {
+					a.data      = top_->axi_rdata;
+					read_wait_ += ps_cycles_ - seen_at_[next_ % UIO_SIM_SLOTS];
+					reads_++;
+				}
+				else {
+					writes_++;
+				}
+				mb_->done.store(++next_, std::memory_order_release);
+				busy_ = false;
+			}
+			if (!busy_ && next_ != seen_) {
+				const slab::UIOSimAccess& a = mb_->slot[next_ % UIO_SIM_SLOTS];
+				if (a.write) {
+					top_->axi_waddr = a.addr & 0x1f;
+					top_->axi_wdata = a.data;
+					top_->axi_wen   = 1;
+				}
+				else {
+					top_->axi_raddr = a.addr & 0x1f;
+				}
+				wait_ = o_.axi_cycles;
+				busy_ = true;
+			}
+		}
+	protected:
+	public:
+		RegisterSimulator(const Options& o, int argc, char **argv) :
+			o_(o), ctx_(new VerilatedContext), stream_(timing),
+			source_(timing, o.inputs, o.frames, true), mb_(NULL),
+			next_(0), seen_(0), busy_(false), wait_(0), seen_at_(UIO_SIM_SLOTS, 0),
+			cycles_(0), ps_cycles_(0), frame_cycle_(0), line_ns_(0), start_ns_(0),
+			reads_(0), writes_(0), batches_(0), batch_max_(0), read_wait_(0), total_accesses_(0)
+		{
+			ctx_->commandArgs(argc, argv);
+			top_.reset(new Vsim_system(ctx_.get()));
+		}
+
+		~RegisterSimulator() {
+			top_->final();
+			if (mb_ != NULL) {
+				mb_->alive.store(0, std::memory_order_release);
+				munmap((void*)mb_, sizeof(slab::UIOSimMailbox));
+				shm_unlink(o_.shm.c_str());
+			}
+		}
+
+		int run() {
+			const uint64_t pix_half = (uint64_t)(5e11 / timing.pclk_freq_Hz); // ps
+			const uint64_t ps_half  = (uint64_t)(5e5 / o_.psclk_mhz);
+			uint64_t t_pix = pix_half, t_ps = ps_half, now = 0;
+			std::vector<uint32_t> rgb;
+
+			if (!source_.next(rgb)) return -1;
+			stream_.push(rgb);
+			if (!create_mailbox()) return -1;
+			printf("mailbox %s : run the program with %s=%s\n", o_.shm.c_str(), UIO_SIM_ENV, o_.shm.c_str());
+
+			top_->sw     = o_.sw;
+			top_->locked = 0;
+			top_->axi_wen = 0;
+
+			uint32_t reset = RESET_CYCLES;
+			bool     pix = false, ps = false;
+			start_ns_ = line_ns_ = monotonic_ns();
+			while (!stop_flag && !ctx_->gotFinish()) {
+				const uint64_t t = std::min(t_pix, t_ps);
+				const bool pix_edge = (t == t_pix), ps_edge = (t == t_ps);
+				if (pix_edge) { pix = !pix; top_->pixelclk = pix; t_pix += pix_half; }
+				if (ps_edge)  { ps  = !ps;  top_->psclk    = ps;  t_ps  += ps_half;  }
+				ctx_->timeInc(t - now);
+				now = t;
+				top_->eval();
+
+				if (pix_edge && pix) {
+					if (reset > 0) {
+						/* vid_locked rises with the first frame at (0, 0) */
+						if (--reset == 0) {
+							top_->locked = 1;
+							stream_.start();
+							push_next();
+							drive_video();
+						}
+						continue;
+					}
+					cycles_++;
+					stream_.step();
+					if (stream_.vpos() == 0 && stream_.hpos() == 0) {
+						frame_done();
+						if (o_.frames != 0 && stream_.frames() > source_.count() + DRAIN_FRAMES) break;
+					}
+					drive_video();
+				}
+				if (ps_edge && ps) psclk_edge();
+			}
+
+			const double sec = (monotonic_ns() - start_ns_) / 1e9;
+			printf("%llu frames, %llu cycles in %.2f s : %.1f kcycles/s, %llu register accesses\n",
+					(unsigned long long)(stream_.frames() - 1), (unsigned long long)cycles_, sec,
+					cycles_ / sec / 1e3, (unsigned long long)(total_accesses_ + reads_ + writes_));
+			return 0;
+		}
+};
+
+int main(int argc, char **argv) {
+	Options o;
+	if (!parse(argc, argv, o)) {
+		usage(argv[0]);
+		return 1;
+	}
+	signal(SIGINT,  on_signal);
+	signal(SIGTERM, on_signal);
+	printf("%ux%u (frame %ux%u), sw = %u, %u psclk per access\n", timing.h_active, timing.v_active,
+			timing.h_frame(), timing.v_frame(), o.sw, o.axi_cycles);
+	RegisterSimulator sim(o, argc, argv);
+	return sim.run() ? 1 : 0;
+}
@@ -0,0 +1,23 @@
+//-----------------------------------------------------------------------------
+// <BUFG>
+//  - Stub of the Xilinx clock buffer for Verilator
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 18, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+`default_nettype none
+
+module BUFG
+	(
+		input  wire I,
+		output wire O
+	);
+
+	assign O = I;
+
+endmodule
+
+`default_nettype wire
@@ -0,0 +1,122 @@
+//-----------------------------------------------------------------------------
+// <block_design_wrapper>
+//  - Stub of the block design (Zynq PS, VTC, VDMA, AXI-Lite registers) for
+//    Verilator
+//    - clocks, vid_locked and the video come from the ports of sim_system
+//      (driven by sim_uio.cpp)
+//    - slv_wireNN are written one at a time (axi_wen) like the AXI-Lite
+//      slave of the block design; axi_araddr selects reg_data_out
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 18, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+`default_nettype none
+
+module block_design_wrapper
+	(
+		/* zynq clock (50 MHz) */
+		output wire ps_clk,
+
+		/* Video Direct Memory Access */
+		output wire PixelClk, SerialClk, vid_locked,
+		output wire [23:0] vid_io_out_data,
+		output wire vid_io_out_hsync, vid_io_out_vsync, vid_io_out_active_video,
+
+		/* registers of zynq_processor */
+		output wire [6:0]  axi_araddr,
+		input  wire [31:0] reg_data_out,
+		output wire [31:0] slv_wire00,
+		output wire [31:0] slv_wire01,
+		output wire [31:0] slv_wire02,
+		output wire [31:0] slv_wire03,
+		output wire [31:0] slv_wire04,
+		output wire [31:0] slv_wire05,
+		output wire [31:0] slv_wire06,
+		output wire [31:0] slv_wire07,
+		output wire [31:0] slv_wire08,
+		output wire [31:0] slv_wire09,
+		output wire [31:0] slv_wire10,
+		output wire [31:0] slv_wire11,
+		output wire [31:0] slv_wire12,
+		output wire [31:0] slv_wire13,
+		output wire [31:0] slv_wire14,
+		output wire [31:0] slv_wire15,
+		output wire [31:0] slv_wire16,
+		output wire [31:0] slv_wire17,
+		output wire [31:0] slv_wire18,
+		output wire [31:0] slv_wire19,
+		output wire [31:0] slv_wire20,
+		output wire [31:0] slv_wire21,
+		output wire [31:0] slv_wire22,
+		output wire [31:0] slv_wire23,
+		output wire [31:0] slv_wire24,
+		output wire [31:0] slv_wire25,
+		output wire [31:0] slv_wire26,
+		output wire [31:0] slv_wire27,
+		output wire [31:0] slv_wire28,
+		output wire [31:0] slv_wire29,
+		output wire [31:0] slv_wire30,
+		output wire [31:0] slv_wire31
+	);
+
+	/* clocks and video (upward references to the top module) */
+	assign ps_clk                  = sim_system.psclk;
+	assign PixelClk                = sim_system.pixelclk;
+	assign SerialClk               = 1'b0;
+	assign vid_locked              = sim_system.locked;
+	assign vid_io_out_data         = sim_system.vid_data;
+	assign vid_io_out_hsync        = sim_system.vid_hsync;
+	assign vid_io_out_vsync        = sim_system.vid_vsync;
+	assign vid_io_out_active_video = sim_system.vid_vde;
+
+	/* AXI-Lite registers */
+	reg [31:0] slv_reg [0:31];
+	integer i;
+	initial begin
+		for (i=0; i<32; i=i+1) slv_reg[i] = 32'd0;
+	end
+	always @(posedge ps_clk) begin
+		if (sim_system.axi_wen) begin
+			slv_reg[sim_system.axi_waddr] <= sim_system.axi_wdata;
+		end
+	end
+	assign axi_araddr = {sim_system.axi_raddr, 2'b00};
+	assign slv_wire00 = slv_reg[0];
+	assign slv_wire01 = slv_reg[1];
+	assign slv_wire02 = slv_reg[2];
+	assign slv_wire03 = slv_reg[3];
+	assign slv_wire04 = slv_reg[4];
+	assign slv_wire05 = slv_reg[5];
+	assign slv_wire06 = slv_reg[6];
+	assign slv_wire07 = slv_reg[7];
+	assign slv_wire08 = slv_reg[8];
+	assign slv_wire09 = slv_reg[9];
+	assign slv_wire10 = slv_reg[10];
+	assign slv_wire11 = slv_reg[11];
+	assign slv_wire12 = slv_reg[12];
+	assign slv_wire13 = slv_reg[13];
+	assign slv_wire14 = slv_reg[14];
+	assign slv_wire15 = slv_reg[15];
+	assign slv_wire16 = slv_reg[16];
+	assign slv_wire17 = slv_reg[17];
+	assign slv_wire18 = slv_reg[18];
+	assign slv_wire19 = slv_reg[19];
+	assign slv_wire20 = slv_reg[20];
+	assign slv_wire21 = slv_reg[21];
+	assign slv_wire22 = slv_reg[22];
+	assign slv_wire23 = slv_reg[23];
+	assign slv_wire24 = slv_reg[24];
+	assign slv_wire25 = slv_reg[25];
+	assign slv_wire26 = slv_reg[26];
+	assign slv_wire27 = slv_reg[27];
+	assign slv_wire28 = slv_reg[28];
+	assign slv_wire29 = slv_reg[29];
+	assign slv_wire30 = slv_reg[30];
+	assign slv_wire31 = slv_reg[31];
+
+endmodule
+
+`default_nettype wire
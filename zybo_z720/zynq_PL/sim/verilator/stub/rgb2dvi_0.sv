@@ -0,0 +1,30 @@
+//-----------------------------------------------------------------------------
+// <rgb2dvi_0>
+//  - Stub of the Digilent rgb2dvi IP for Verilator (no TMDS output;
+//    sim_system takes the video before it)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 18, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+`default_nettype none
+
+module rgb2dvi_0
+	(
+		input  wire PixelClk, SerialClk, aRst_n,
+		input  wire [23:0] vid_pData,
+		input  wire vid_pVDE, vid_pHSync, vid_pVSync,
+		output wire [2:0] TMDS_Data_p, TMDS_Data_n,
+		output wire TMDS_Clk_p, TMDS_Clk_n
+	);
+
+	assign TMDS_Data_p = 3'b000;
+	assign TMDS_Data_n = 3'b111;
+	assign TMDS_Clk_p  = PixelClk;
+	assign TMDS_Clk_n  = !PixelClk;
+
+endmodule
+
+`default_nettype wire
@@ -7,6 +7,16 @@
 //  - Connected filter_3x3 module
 //  - Other minor refinements
 //-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 7, 2020)
+//  - Connected runtime thresholds of simple_lsd (PS -> PL)
+//  - Added status of simple_lsd (PL -> PS)
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 8, 2020)
+//  - Added out_lsd_flag / out_lsd_valid for performance counters
+//-----------------------------------------------------------------------------
+// Version 1.03 (Dec. 9, 2020)
+//  - Connected histogram snapshot of contrast_stretch (PL -> PS)
+//-----------------------------------------------------------------------------
 // (C) 2020 Naofumi Yoshinaga. All rights reserved.
 //-----------------------------------------------------------------------------
 
@@ -39,6 +49,25 @@ module image_processor
 		output logic [$clog2(H_FRAME)-1:0]  out_lsdbuf_start_h, out_lsdbuf_end_h,
 		output logic out_lsdbuf_ready,
 
+		/* thresholds and status of LSD (psclk) */
+		input  wire  [7:0]              in_lsd_angle_thres,
+		input  wire  [DATA_WIDTH-1:0]   in_lsd_grad_thres,
+		input  wire  [7:0]              in_lsd_length_thres,
+		input  wire  in_lsd_manual_thres,
+		output logic out_lsd_overused,
+		output logic [DATA_WIDTH*2:0]   out_lsd_thres_offset,
+
+		/* output of LSD (pixelclk, for performance counters) */
+		output logic out_lsd_flag, out_lsd_valid,
+
+		/* histogram of contrast_stretch (psclk) */
+		input  wire  [DATA_WIDTH-1:0]                 in_hist_raddr,
+		input  wire  in_hist_freeze,
+		output logic out_hist_ready,
+		output logic [$clog2(V_ACTIVE*H_ACTIVE)-1:0] out_hist_data,
+		output logic [DATA_WIDTH-1:0]                 out_hist_min, out_hist_max,
+		output logic [31:0]                           out_hist_frames,
+
 		/* output image */
 		output logic [DATA_WIDTH*3-1:0]    out_data,
 		output logic [$clog2(V_FRAME)-1:0] out_vcnt,
@@ -109,15 +138,41 @@ module image_processor
 		.in_hcnt   (gray_hcnt),
 		.out_pixel (cs_data  ),
 		.out_vcnt  (cs_vcnt  ),
-		.out_hcnt  (cs_hcnt  )
+		.out_hcnt  (cs_hcnt  ),
+
+		.hst_clock       (psclk          ),
+		.in_hst_freeze   (in_hist_freeze ),
+		.in_hst_rd_addr  (in_hist_raddr  ),
+		.out_hst_ready   (out_hist_ready ),
+		.out_hst_rd_data (out_hist_data  ),
+		.out_hst_min     (out_hist_min   ),
+		.out_hst_max     (out_hist_max   ),
+		.out_hst_frames  (out_hist_frames)
 	);
 	assign cs_hblank = (H_ACTIVE <= cs_hcnt);
 	assign cs_vblank = (V_ACTIVE <= cs_vcnt);
 	assign cs_field  = 1'b0;
 	assign cs_vde    = (cs_vcnt < V_ACTIVE) & (cs_hcnt < H_ACTIVE);
 
+	/* thresholds (psclk -> pixelclk), latched by simple_lsd at frame start */
+	reg  [7:0]            lsd_angle_thres [0:1];
+	reg  [DATA_WIDTH-1:0] lsd_grad_thres  [0:1];
+	reg  [7:0]            lsd_length_thres[0:1];
+	reg  [1:0]            lsd_manual_thres;
+	always @(posedge pixelclk) begin
+		lsd_angle_thres[0]  <= in_lsd_angle_thres;
+		lsd_angle_thres[1]  <= lsd_angle_thres[0];
+		lsd_grad_thres[0]   <= in_lsd_grad_thres;
+		lsd_grad_thres[1]   <= lsd_grad_thres[0];
+		lsd_length_thres[0] <= in_lsd_length_thres;
+		lsd_length_thres[1] <= lsd_length_thres[0];
+		lsd_manual_thres    <= {lsd_manual_thres[0], in_lsd_manual_thres};
+	end
+
 	/* Simplified Line Segment Detector (Simple-LSD) */
 	wire lsd_flag, lsd_valid;
+	wire lsd_overused;
+	wire [DATA_WIDTH*2:0] lsd_thres_offset;
 	wire [$clog2(V_FRAME)-1:0] lsd_start_v, lsd_end_v;
 	wire [$clog2(H_FRAME)-1:0] lsd_start_h, lsd_end_h;
 	wire [7:0] lsd_angle;
@@ -145,9 +200,29 @@ module image_processor
 		.out_end_v   (lsd_end_v  ),
 		.out_start_h (lsd_start_h),
 		.out_end_h   (lsd_end_h  ),
-		.out_angle   (lsd_angle  )
+		.out_angle   (lsd_angle  ),
+
+		.in_angle_thres   (lsd_angle_thres[1] ),
+		.in_grad_thres    (lsd_grad_thres[1]  ),
+		.in_length_thres  (lsd_length_thres[1]),
+		.in_manual_thres  (lsd_manual_thres[1]),
+		.out_overused     (lsd_overused       ),
+		.out_thres_offset (lsd_thres_offset   )
 	);
 
+	/* status (pixelclk -> psclk), updated once per frame */
+	reg [1:0]            lsd_overused_sync;
+	reg [DATA_WIDTH*2:0] lsd_thres_offset_sync [0:1];
+	always @(posedge psclk) begin
+		lsd_overused_sync        <= {lsd_overused_sync[0], lsd_overused};
+		lsd_thres_offset_sync[0] <= lsd_thres_offset;
+		lsd_thres_offset_sync[1] <= lsd_thres_offset_sync[0];
+	end
+	assign out_lsd_overused     = lsd_overused_sync[1];
+	assign out_lsd_thres_offset = lsd_thres_offset_sync[1];
+	assign out_lsd_flag         = lsd_flag;
+	assign out_lsd_valid        = lsd_valid;
+
 	/* Buffering result of Simple-LSD */
 	lsd_output_buffer_wp #(
 		.BIT_WIDTH    (DATA_WIDTH),
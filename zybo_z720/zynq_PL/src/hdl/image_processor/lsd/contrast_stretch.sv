@@ -22,10 +22,19 @@
 //      and C = T * (100 - r) / 200, then
 //      f(x) = (2^(BIT_WIDTH) - 1) * (N(x) - C) / (T - C * 2)
 //  - Latency: 2 clock cycles
+//  - The histogram of each frame and its [a, b] are copied into a
+//    double-buffered snapshot RAM readable from <hst_clock>
+//    - While <in_hst_freeze> is high the snapshot is not replaced;
+//      <out_hst_ready> (hst_clock) tells it is safe to read
+//    - <out_hst_min>, <out_hst_max> and <out_hst_frames> are stable
+//      while <out_hst_ready> is high
 //-----------------------------------------------------------------------------
 // Version 1.01 (Aug. 18, 2020)
 //  - Improved the table generation method
 //-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 9, 2020)
+//  - Added histogram snapshot for PS (hst_clock domain)
+//-----------------------------------------------------------------------------
 // (C) 2020 Taito Manabe. All rights reserved.
 //-----------------------------------------------------------------------------
 `default_nettype none
@@ -40,7 +49,9 @@ module contrast_stretch
      parameter int WINDOW_RANGE  = 90, // value range for windowing (%)
      parameter int EQUALIZE_HIST =  0) // to apply histogram equalization
    ( clock, n_rst, 
-     in_pixel, in_vcnt, in_hcnt, out_pixel, out_vcnt, out_hcnt );
+     in_pixel, in_vcnt, in_hcnt, out_pixel, out_vcnt, out_hcnt,
+     hst_clock, in_hst_freeze, in_hst_rd_addr, out_hst_ready,
+     out_hst_rd_data, out_hst_min, out_hst_max, out_hst_frames );
 
    // the following parameters are calculated automatically -------------------
    localparam int V_BITW     = $clog2(FRAME_HEIGHT);
@@ -58,6 +69,12 @@ module contrast_stretch
    output wire [BIT_WIDTH-1:0] out_pixel;
    output reg [V_BITW-1:0]     out_vcnt;
    output reg [H_BITW-1:0]     out_hcnt;
+   input wire 		       hst_clock, in_hst_freeze;
+   input wire [BIT_WIDTH-1:0]  in_hst_rd_addr;
+   output reg 		       out_hst_ready;
+   output wire [COUNT_BITW-1:0] out_hst_rd_data;
+   output reg [BIT_WIDTH-1:0]  out_hst_min, out_hst_max;
+   output reg [31:0] 	       out_hst_frames;
 
    // tables ------------------------------------------------------------------
    logic [BIT_WIDTH*2-1:0]     inv_table [DRANGE];
@@ -275,6 +292,62 @@ module contrast_stretch
       end
    endgenerate
    
+   // histogram snapshot ------------------------------------------------------
+   // bin (hst_rd_addr - 1) appears on hst_rd_data while <counting>,
+   // so the analysis sweep of state 1 is copied without an extra pass
+   reg [1:0] 		       snp_freeze;
+   reg 			       snp_frozen, snp_bank;
+   reg                         snp_min_found, snp_max_found;
+   reg [BIT_WIDTH-1:0]         snp_min, snp_max;
+   reg [31:0] 		       snp_frames;
+   ram_dc
+     #( .WORD_SIZE(COUNT_BITW), .RAM_SIZE(DRANGE * 2) )
+   snp_ram
+     (  .wr_clock(clock),   .rd_clock(hst_clock),
+	.wr_en(counting),   .wr_addr({snp_bank, hst_rd_addr - 1'b1}),
+	.wr_data(hst_rd_data),
+	.rd_addr({!snp_bank, in_hst_rd_addr}),
+	.rd_data(out_hst_rd_data)                                       );
+   always_ff @(posedge clock) begin
+      snp_freeze <= {snp_freeze[0], in_hst_freeze};
+      if(!n_rst) begin
+	 snp_frozen <= 0;
+	 snp_bank   <= 0;
+	 snp_frames <= 0;
+      end
+      else begin
+	 snp_frozen <= snp_freeze[1];
+	 // [a, b] of this frame (same conditions as cst_linear)
+	 if((state == 1) && !counting) begin
+	    {snp_min_found, snp_max_found} <= 0;
+	 end
+	 else if(counting) begin
+	    if(!snp_min_found && (CLIP_PIXS < current_total)) begin
+	       snp_min_found <= 1;
+	       snp_min       <= hst_rd_addr - 1;
+	    end
+	    if(!snp_max_found && ((TOTAL_PIXS - CLIP_PIXS) <= current_total)) begin
+	       snp_max_found <= 1;
+	       snp_max       <= hst_rd_addr - 1;
+	    end
+	 end
+	 // the last bin is written in this cycle: publishes the bank
+	 if((state == 2) && counting) begin
+	    snp_frames <= snp_frames + 1;
+	    if(!snp_frozen) begin
+	       snp_bank       <= !snp_bank;
+	       out_hst_min    <= snp_min;
+	       out_hst_max    <= snp_max;
+	       out_hst_frames <= snp_frames + 1;
+	    end
+	 end
+      end
+   end
+   reg [1:0] 		       snp_ready;
+   always_ff @(posedge hst_clock) begin
+      {out_hst_ready, snp_ready} <= {snp_ready, snp_frozen};
+   end
+
    // outputs results ---------------------------------------------------------
    reg [BIT_WIDTH-1:0] res_pixel;
    reg [V_BITW-1:0]    res_vcnt;
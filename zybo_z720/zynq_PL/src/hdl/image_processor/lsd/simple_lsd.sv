@@ -8,6 +8,12 @@
 //  - Fixed the asymmetry between in-line and inter-line region growing
 //  - Other minor refinements
 //-----------------------------------------------------------------------------
+// Version 1.11 (Dec. 7, 2020)
+//  - Added runtime thresholds (in_*_thres, latched at the start of a frame)
+//    - 0 selects the corresponding parameter (ANGLE_THRES etc.)
+//  - Added in_manual_thres to disable the automatic threshold control
+//  - Added out_overused / out_thres_offset (status of the last frame)
+//-----------------------------------------------------------------------------
 // (C) 2019-2020 Taito Manabe. All rights reserved.
 //-----------------------------------------------------------------------------
 `default_nettype none
@@ -26,13 +32,16 @@ module simple_lsd
      parameter int RAM_SIZE     = 4096) // size of line segments RAM
    ( clock, n_rst, 
      in_y, in_vcnt, in_hcnt, out_flag, out_valid, 
-     out_start_v, out_start_h, out_end_v, out_end_h, out_angle   );
+     out_start_v, out_start_h, out_end_v, out_end_h, out_angle,
+     in_angle_thres, in_grad_thres, in_length_thres, in_manual_thres,
+     out_overused, out_thres_offset                                );
 
    // local parameters --------------------------------------------------------
    localparam int ANGLE_BITW   = 8;     // currently only 8 is supported
    localparam int TUNING_STEP  = 16;
    localparam int ATAN_LATENCY = 5;
    localparam int MAX_PIXS     = (IMAGE_HEIGHT + IMAGE_WIDTH) * 2;
+   localparam int THRES_BITW   = 8;     // bit width of runtime thresholds
 
    // following parameters are calculated automatically -----------------------
    localparam int OVER_THRES   = (RAM_SIZE * 9) / 10;
@@ -56,6 +65,12 @@ module simple_lsd
    output reg [V_BITW-1:0] 	out_start_v, out_end_v;
    output reg [H_BITW-1:0] 	out_start_h, out_end_h;
    output reg [ANGLE_BITW-1:0] 	out_angle;
+   input wire [ANGLE_BITW-1:0] 	in_angle_thres;
+   input wire [BIT_WIDTH-1:0] 	in_grad_thres;
+   input wire [THRES_BITW-1:0] 	in_length_thres;
+   input wire 			in_manual_thres;
+   output reg 			out_overused;
+   output reg [BIT_WIDTH*2:0] 	out_thres_offset;
 
    // preprocessing -----------------------------------------------------------
    // 3x3 gaussian filter
@@ -107,6 +122,9 @@ module simple_lsd
    wire [H_BITW-1:0] 		grd_hcnt;
    reg [BIT_WIDTH*2:0]          gx2, gy2;
    reg [BIT_WIDTH*2:0] 		grd_thres_offset;
+   reg [BIT_WIDTH*2:0] 		grad_thres2;     // squared gradient threshold
+   wire [BIT_WIDTH*2+1:0] 	grd_thres;
+   assign grd_thres = grad_thres2 + grd_thres_offset;
    always_ff @(posedge clock) begin
       gx2 <= gx * gx;
       gy2 <= gy * gy;
@@ -115,8 +133,7 @@ module simple_lsd
      #( .BIT_WIDTH(1), .LATENCY(ATAN_LATENCY - 1) )
    dly_grad
      (  .clock(clock), .n_rst(n_rst), .out_data(grd_valid),
-	.in_data(((gx2 + gy2) >= 
-		  (GRAD_THRES * GRAD_THRES + grd_thres_offset))) );
+	.in_data((gx2 + gy2) >= grd_thres) );
    
    arctan_calc
      #( .IN_BITW(BIT_WIDTH + 1),  .OUT_BITW(ANGLE_BITW)          )
@@ -134,6 +151,7 @@ module simple_lsd
    // state
    reg [1:0]                       state;
    reg 				   overused;
+   wire 			   frame_start;
    reg [ADDR_BITW:0] 		   seg_num, rd_segid;
    // neighbors ([1][1] is the current pixel)
    wire [0:2][0:3] 		   valid_map;
@@ -191,6 +209,14 @@ module simple_lsd
    wire signed [PIXS_BITW+6:0] 	   tmp_asum_bias;
    // whether there is a candidate in the next line
    wire 			   n_found;
+   // runtime thresholds
+   reg [ANGLE_BITW-1:0] 	   angle_thres;
+   reg [THRES_BITW-1:0] 	   length_thres;
+   reg [THRES_BITW*2-1:0] 	   length_thres2;
+   reg 				   manual_thres;
+   assign frame_start 
+     = (vcnt == (START_VCNT == 0 ? FRAME_HEIGHT - 1 : START_VCNT - 1)) &&
+       (hcnt == FRAME_WIDTH - 1);
    
    // state and output address control ----------------------------------------
    always_ff @(posedge clock) begin
@@ -198,8 +224,7 @@ module simple_lsd
 	 state <= 0;
       end
       else if(state == 0) begin   // wait for a new frame
-	 if((vcnt == (START_VCNT == 0 ? FRAME_HEIGHT - 1 : START_VCNT - 1)) &&
-	    (hcnt == FRAME_WIDTH - 1)) begin
+	 if(frame_start) begin
 	    state <= 1;
 	 end
       end
@@ -224,21 +249,47 @@ module simple_lsd
       end
    end
 
+   // runtime thresholds (0: uses the parameter) ------------------------------
+   always_ff @(posedge clock) begin
+      if(!n_rst) begin
+	 angle_thres   <= ANGLE_THRES;
+	 grad_thres2   <= GRAD_THRES * GRAD_THRES;
+	 length_thres  <= LENGTH_THRES;
+	 length_thres2 <= LENGTH_THRES * LENGTH_THRES;
+	 manual_thres  <= 0;
+      end
+      else if(frame_start) begin
+	 angle_thres   <= (in_angle_thres  != 0) ? in_angle_thres  : ANGLE_THRES;
+	 grad_thres2   <= (in_grad_thres   != 0) ? 
+			  in_grad_thres * in_grad_thres : GRAD_THRES * GRAD_THRES;
+	 length_thres  <= (in_length_thres != 0) ? in_length_thres : LENGTH_THRES;
+	 length_thres2 <= (in_length_thres != 0) ? 
+			  in_length_thres * in_length_thres : 
+			  LENGTH_THRES * LENGTH_THRES;
+	 manual_thres  <= in_manual_thres;
+      end
+   end
+
    // automatic threshold control ---------------------------------------------
    always_ff @(posedge clock) begin
       if(!n_rst) begin
 	 {overused, grd_thres_offset} <= 0;
+	 {out_overused, out_thres_offset} <= 0;
       end
       else begin
 	 if((vcnt < IMAGE_HEIGHT) && (OVER_THRES < seg_num)) begin
 	    overused <= 1;
 	 end
 	 else if((vcnt == IMAGE_HEIGHT) && (hcnt == 0)) begin
-	    if(overused)
+	    if(manual_thres)
+	      grd_thres_offset <= 0;
+	    else if(overused)
 	      grd_thres_offset <= grd_thres_offset + TUNING_STEP;
 	    else if(TUNING_STEP <= grd_thres_offset)
 	      grd_thres_offset <= grd_thres_offset - TUNING_STEP;
-	    overused <= 0;
+	    overused         <= 0;
+	    out_overused     <= overused;
+	    out_thres_offset <= grd_thres_offset;
 	 end
       end
    end 
@@ -403,15 +454,14 @@ module simple_lsd
 
    // parameter update --------------------------------------------------------
    always_ff @(posedge clock) begin
-      if((vcnt == (START_VCNT == 0 ? FRAME_HEIGHT - 1 : START_VCNT - 1)) &&
-	 (hcnt == FRAME_WIDTH - 1)) begin
+      if(frame_start) begin
 	 seg_num  <=  0;
 	 merging  <=  0;
 	 alias_id <= -1;
       end
       else if(cond_save) begin
 	 if((segid == seg_num) && 
-	    (!last || ((ev - sv) + (eh - sh) >= LENGTH_THRES)))
+	    (!last || ((ev - sv) + (eh - sh) >= 32'(length_thres))))
 	   seg_num <= seg_num + 1;
 	 merging <=  0;
       end
@@ -659,8 +709,7 @@ module simple_lsd
    // [stage 12] outputs results
    always_ff @(posedge clock) begin
       out_flag  <= rb_flag;
-      out_valid <= rb_exist && (rb_len1 + rb_len2 >= 
-				(LENGTH_THRES * LENGTH_THRES));
+      out_valid <= rb_exist && (rb_len1 + rb_len2 >= 32'(length_thres2));
       {out_start_v, out_start_h, out_end_v, out_end_h, out_angle}
 	<= {rb_v1, rb_h1, rb_v2, rb_h2, rb_angle};
    end
@@ -674,7 +723,7 @@ module simple_lsd
 	 abs_diff = (a > b) ? (a - b) : (b - a);
 	 angle_check 
 	   = (({abs_diff, 1'b0} < (1 << ANGLE_BITW)) ?
-	      abs_diff : (1 << ANGLE_BITW) - abs_diff) < ANGLE_THRES;
+	      abs_diff : (1 << ANGLE_BITW) - abs_diff) < angle_thres;
       end
    endfunction
 
@@ -5,6 +5,13 @@
 // Version 1.00 (Sep. 23, 2020)
 //  - initial version
 //-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 8, 2020)
+//  - Connected thresholds / status of simple_lsd to zynq_ps_interface
+//  - Connected performance counters to zynq_ps_interface
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 9, 2020)
+//  - Connected histogram of contrast_stretch to zynq_ps_interface
+//-----------------------------------------------------------------------------
 // (C) 2020 Naofumi Yoshinaga. All rights reserved.
 //-----------------------------------------------------------------------------
 
@@ -94,6 +101,14 @@ module vdma_top
 	wire [$clog2(VID_H_FRAME)-1:0] lsdbuf_start_h, lsdbuf_end_h;
 	wire [$clog2(VID_V_FRAME)-1:0] lsdbuf_start_v, lsdbuf_end_v;
 	wire lsdbuf_write_protect, lsdbuf_ready;
+	wire [7:0]  lsd_angle_thres, lsd_grad_thres, lsd_length_thres;
+	wire [16:0] lsd_thres_offset;
+	wire lsd_manual_thres, lsd_overused;
+	wire lsd_flag, lsd_valid;
+	wire [7:0]  hist_raddr, hist_min, hist_max;
+	wire [$clog2(VID_PIXELS)-1:0] hist_data;
+	wire [31:0] hist_frames;
+	wire hist_freeze, hist_ready;
 	image_processor #(
 		.DATA_WIDTH (8           ),
 		.H_ACTIVE   (VID_H_ACTIVE),
@@ -129,7 +144,26 @@ module vdma_top
 		.out_lsdbuf_start_h      (lsdbuf_start_h      ),
 		.out_lsdbuf_end_v        (lsdbuf_end_v        ),
 		.out_lsdbuf_end_h        (lsdbuf_end_h        ),
-		.out_lsdbuf_ready        (lsdbuf_ready        )
+		.out_lsdbuf_ready        (lsdbuf_ready        ),
+
+		/* LSD thresholds and status (to Userspace I/O) */
+		.in_lsd_angle_thres      (lsd_angle_thres     ),
+		.in_lsd_grad_thres       (lsd_grad_thres      ),
+		.in_lsd_length_thres     (lsd_length_thres    ),
+		.in_lsd_manual_thres     (lsd_manual_thres    ),
+		.out_lsd_overused        (lsd_overused        ),
+		.out_lsd_thres_offset    (lsd_thres_offset    ),
+		.out_lsd_flag            (lsd_flag            ),
+		.out_lsd_valid           (lsd_valid           ),
+
+		/* histogram of contrast_stretch (to Userspace I/O) */
+		.in_hist_raddr           (hist_raddr          ),
+		.in_hist_freeze          (hist_freeze         ),
+		.out_hist_ready          (hist_ready          ),
+		.out_hist_data           (hist_data           ),
+		.out_hist_min            (hist_min            ),
+		.out_hist_max            (hist_max            ),
+		.out_hist_frames         (hist_frames         )
 	);
 
 	/* Count to Video Sync */
@@ -153,6 +187,8 @@ module vdma_top
 
 	/* Zynq Interface */
 	zynq_ps_interface #(
+		.H_ACTIVE           (VID_H_ACTIVE      ),
+		.V_ACTIVE           (VID_V_ACTIVE      ),
 		.H_FRAME            (VID_H_FRAME       ),
 		.V_FRAME            (VID_V_FRAME       ),
 		.LSD_BUFSIZE        (LSD_BUFSIZE       ),
@@ -186,6 +222,29 @@ module vdma_top
 		.in_lsdbuf_end_h          (lsdbuf_end_h        ),
 		.in_lsdbuf_ready          (lsdbuf_ready        ),
 
+		/* LSD thresholds and status (to Userspace I/O) */
+		.out_lsd_angle_thres      (lsd_angle_thres     ),
+		.out_lsd_grad_thres       (lsd_grad_thres      ),
+		.out_lsd_length_thres     (lsd_length_thres    ),
+		.out_lsd_manual_thres     (lsd_manual_thres    ),
+		.in_lsd_overused          (lsd_overused        ),
+		.in_lsd_thres_offset      (lsd_thres_offset    ),
+
+		/* performance counters */
+		.in_vid_vcnt              (vid_in_vcnt         ),
+		.in_vid_hcnt              (vid_in_hcnt         ),
+		.in_lsd_flag              (lsd_flag            ),
+		.in_lsd_valid             (lsd_valid           ),
+
+		/* histogram of contrast_stretch */
+		.out_hist_raddr           (hist_raddr          ),
+		.out_hist_freeze          (hist_freeze         ),
+		.in_hist_ready            (hist_ready          ),
+		.in_hist_data             (hist_data           ),
+		.in_hist_min              (hist_min            ),
+		.in_hist_max              (hist_max            ),
+		.in_hist_frames           (hist_frames         ),
+
 		/* debug */
 		.led       (led),
 		.sw        (sw)
@@ -0,0 +1,135 @@
+//-----------------------------------------------------------------------------
+// <perf_counter>
+//  - Performance counters of the LSD pipeline (read by PS)
+//    - Counts in the pixel clock domain and copies every counter into
+//      the PS clock domain once per frame (snapshot at frame start)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 8, 2020)
+//  - initial version
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+`default_nettype none
+
+module perf_counter
+	#(
+		parameter integer H_ACTIVE    = -1,
+		parameter integer V_ACTIVE    = -1,
+		parameter integer H_FRAME     = -1,
+		parameter integer V_FRAME     = -1,
+		parameter integer LSD_BUFSIZE = -1
+	)
+	(
+		/* clock and reset */
+		input  wire pixelclk, psclk, rst,
+
+		/* events (pixelclk) */
+		input  wire [$clog2(V_FRAME)-1:0] in_vcnt,
+		input  wire [$clog2(H_FRAME)-1:0] in_hcnt,
+		input  wire in_vde,           // active video from VDMA (MM2S)
+		input  wire in_seg_flag,      // out_flag  of simple_lsd
+		input  wire in_seg_valid,     // out_valid of simple_lsd
+		input  wire in_write_protect, // write_protect of lsd_output_buffer_wp
+
+		/* counters (psclk) */
+		output reg  [31:0] out_frames,        // number of frames
+		output reg  [31:0] out_frame_cycles,  // cycles of the last frame
+		output reg  [31:0] out_seg_emitted,   // segments from simple_lsd
+		output reg  [31:0] out_drop_protect,  // dropped by write_protect
+		output reg  [31:0] out_drop_overflow, // dropped by LSD_BUFSIZE
+		output reg  [31:0] out_protect_cycles,// cycles of write_protect
+		output reg  [31:0] out_underflow      // active pixels without VDE
+	);
+
+	/* frame start */
+	wire frame_start;
+	assign frame_start = (in_vcnt == 0) && (in_hcnt == 0);
+
+	/* counters (pixelclk) */
+	reg [31:0] frames, cycles, seg_emitted, drop_protect, drop_overflow;
+	reg [31:0] protect_cycles, underflow;
+	reg [$clog2(LSD_BUFSIZE):0] seg_stored; // segments stored in this burst
+	wire seg_in;
+	assign seg_in = in_seg_flag && in_seg_valid;
+	always @(posedge pixelclk) begin
+		if (rst) begin
+			frames         <= 'd0;
+			cycles         <= 'd0;
+			seg_emitted    <= 'd0;
+			drop_protect   <= 'd0;
+			drop_overflow  <= 'd0;
+			protect_cycles <= 'd0;
+			underflow      <= 'd0;
+			seg_stored     <= 'd0;
+		end
+		else begin
+			cycles <= (frame_start) ? 'd1 : cycles + 1;
+			if (frame_start) begin
+				frames <= frames + 1;
+			end
+
+			/* segments (same conditions as lsd_output_buffer_wp) */
+			if (!in_seg_flag) begin
+				seg_stored <= 'd0;
+			end
+			else if (seg_in) begin
+				seg_emitted <= seg_emitted + 1;
+				if (in_write_protect) begin
+					drop_protect <= drop_protect + 1;
+				end
+				else if (seg_stored >= LSD_BUFSIZE) begin
+					drop_overflow <= drop_overflow + 1;
+				end
+				else begin
+					seg_stored <= seg_stored + 1;
+				end
+			end
+
+			if (in_write_protect) begin
+				protect_cycles <= protect_cycles + 1;
+			end
+			if ((in_vcnt < V_ACTIVE) && (in_hcnt < H_ACTIVE) && !in_vde) begin
+				underflow <= underflow + 1;
+			end
+		end
+	end
+
+	/* snapshot (pixelclk), stable for a whole frame after the toggle */
+	reg [31:0] snap_frames, snap_frame_cycles, snap_seg_emitted, snap_drop_protect;
+	reg [31:0] snap_drop_overflow, snap_protect_cycles, snap_underflow;
+	reg        snap_toggle;
+	always @(posedge pixelclk) begin
+		if (rst) begin
+			snap_toggle <= 1'b0;
+		end
+		else if (frame_start) begin
+			snap_frames         <= frames + 1;
+			snap_frame_cycles   <= cycles;
+			snap_seg_emitted    <= seg_emitted;
+			snap_drop_protect   <= drop_protect;
+			snap_drop_overflow  <= drop_overflow;
+			snap_protect_cycles <= protect_cycles;
+			snap_underflow      <= underflow;
+			snap_toggle         <= !snap_toggle;
+		end
+	end
+
+	/* pixelclk -> psclk */
+	reg [2:0] toggle_sync;
+	always @(posedge psclk) begin
+		toggle_sync <= {toggle_sync[1:0], snap_toggle};
+		if (toggle_sync[2] != toggle_sync[1]) begin
+			out_frames         <= snap_frames;
+			out_frame_cycles   <= snap_frame_cycles;
+			out_seg_emitted    <= snap_seg_emitted;
+			out_drop_protect   <= snap_drop_protect;
+			out_drop_overflow  <= snap_drop_overflow;
+			out_protect_cycles <= snap_protect_cycles;
+			out_underflow      <= snap_underflow;
+		end
+	end
+
+endmodule
+
+`default_nettype wire
@@ -6,6 +6,17 @@
 //  - Added 32 slave-wires
 //  - Other minor refinements
 //-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 7, 2020)
+//  - Added runtime thresholds of simple_lsd (slv_wire02 - slv_wire05)
+//  - Added status of simple_lsd (read address 0x06)
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 8, 2020)
+//  - Added performance counters (read address 0x07 - 0x0D)
+//-----------------------------------------------------------------------------
+// Version 1.03 (Dec. 9, 2020)
+//  - Added histogram of contrast_stretch (slv_wire06 - slv_wire07,
+//    read address 0x0E - 0x10)
+//-----------------------------------------------------------------------------
 // (C) 2020 Naofumi Yoshinaga. All rights reserved.
 //-----------------------------------------------------------------------------
 
@@ -14,6 +25,8 @@
 module zynq_ps_interface
 	#(
 		/* Simple-LSD */
+		parameter integer H_ACTIVE          = -1,
+		parameter integer V_ACTIVE          = -1,
 		parameter integer H_FRAME           = -1,
 		parameter integer V_FRAME           = -1,
 		parameter integer LSD_BUFSIZE       = -1,
@@ -50,6 +63,27 @@ module zynq_ps_interface
 		input  wire [$clog2(V_FRAME)-1:0] in_lsdbuf_start_v, in_lsdbuf_end_v,
 		input  wire in_lsdbuf_ready,
 
+		/* LSD thresholds and status (to Userspace I/O) */
+		output reg  [7:0]  out_lsd_angle_thres,  // 0: ANGLE_THRES
+		output reg  [7:0]  out_lsd_grad_thres,   // 0: GRAD_THRES
+		output reg  [7:0]  out_lsd_length_thres, // 0: LENGTH_THRES
+		output reg         out_lsd_manual_thres, // 1: disables auto control
+		input  wire        in_lsd_overused,
+		input  wire [16:0] in_lsd_thres_offset,
+
+		/* performance counters (PixelClk) */
+		input  wire [$clog2(V_FRAME)-1:0] in_vid_vcnt,
+		input  wire [$clog2(H_FRAME)-1:0] in_vid_hcnt,
+		input  wire in_lsd_flag, in_lsd_valid,
+
+		/* histogram of contrast_stretch (to Userspace I/O) */
+		output reg  [7:0]  out_hist_raddr,
+		output reg         out_hist_freeze,
+		input  wire        in_hist_ready,
+		input  wire [$clog2(H_ACTIVE*V_ACTIVE)-1:0] in_hist_data,
+		input  wire [7:0]  in_hist_min, in_hist_max,
+		input  wire [31:0] in_hist_frames,
+
 		/* Test */
 		input  wire [3:0]  sw,
 		output reg  [3:0]  led
@@ -158,6 +192,35 @@ module zynq_ps_interface
 		.slv_wire31   (slv_wire31  )
 	);
 
+	/* performance counters */
+	wire [31:0] perf_frames, perf_frame_cycles, perf_seg_emitted, perf_drop_protect;
+	wire [31:0] perf_drop_overflow, perf_protect_cycles, perf_underflow;
+	perf_counter #(
+		.H_ACTIVE    (H_ACTIVE   ),
+		.V_ACTIVE    (V_ACTIVE   ),
+		.H_FRAME     (H_FRAME    ),
+		.V_FRAME     (V_FRAME    ),
+		.LSD_BUFSIZE (LSD_BUFSIZE)
+	)
+	perf_counter_inst (
+		.pixelclk           (PixelClk           ),
+		.psclk              (ps_clk             ),
+		.rst                (!vid_rstn          ),
+		.in_vcnt            (in_vid_vcnt        ),
+		.in_hcnt            (in_vid_hcnt        ),
+		.in_vde             (vid_out_VDE        ),
+		.in_seg_flag        (in_lsd_flag        ),
+		.in_seg_valid       (in_lsd_valid       ),
+		.in_write_protect   (in_lsdbuf_ready    ), // ready == write_protect
+		.out_frames         (perf_frames        ),
+		.out_frame_cycles   (perf_frame_cycles  ),
+		.out_seg_emitted    (perf_seg_emitted   ),
+		.out_drop_protect   (perf_drop_protect  ),
+		.out_drop_overflow  (perf_drop_overflow ),
+		.out_protect_cycles (perf_protect_cycles),
+		.out_underflow      (perf_underflow     )
+	);
+
 	/* PS <- PL */
 	always @(*) begin
 		// Address decoding for reading registers
@@ -168,17 +231,17 @@ module zynq_ps_interface
 			5'h03   : reg_data_out <= {{(32-$clog2(V_FRAME)){1'b0}}, in_lsdbuf_start_v};
 			5'h04   : reg_data_out <= {{(32-$clog2(H_FRAME)){1'b0}}, in_lsdbuf_end_h};
 			5'h05   : reg_data_out <= {{(32-$clog2(V_FRAME)){1'b0}}, in_lsdbuf_end_v};
-			5'h06   : reg_data_out <= slv_wire06;
-			5'h07   : reg_data_out <= slv_wire07;
-			5'h08   : reg_data_out <= slv_wire08;
-			5'h09   : reg_data_out <= slv_wire09;
-			5'h0A   : reg_data_out <= slv_wire10;
-			5'h0B   : reg_data_out <= slv_wire11;
-			5'h0C   : reg_data_out <= slv_wire12;
-			5'h0D   : reg_data_out <= slv_wire13;
-			5'h0E   : reg_data_out <= slv_wire14;
-			5'h0F   : reg_data_out <= slv_wire15;
-			5'h10   : reg_data_out <= slv_wire16;
+			5'h06   : reg_data_out <= {7'd0, in_lsd_thres_offset, 7'd0, in_lsd_overused};
+			5'h07   : reg_data_out <= perf_frames;
+			5'h08   : reg_data_out <= perf_frame_cycles;
+			5'h09   : reg_data_out <= perf_seg_emitted;
+			5'h0A   : reg_data_out <= perf_drop_protect;
+			5'h0B   : reg_data_out <= perf_drop_overflow;
+			5'h0C   : reg_data_out <= perf_protect_cycles;
+			5'h0D   : reg_data_out <= perf_underflow;
+			5'h0E   : reg_data_out <= {{(32-$clog2(H_ACTIVE*V_ACTIVE)){1'b0}}, in_hist_data};
+			5'h0F   : reg_data_out <= {8'd0, in_hist_max, in_hist_min, 7'd0, in_hist_ready};
+			5'h10   : reg_data_out <= in_hist_frames;
 			5'h11   : reg_data_out <= slv_wire17;
 			5'h12   : reg_data_out <= slv_wire18;
 			5'h13   : reg_data_out <= slv_wire19;
@@ -202,12 +265,12 @@ module zynq_ps_interface
 	always @(posedge ps_clk) begin
 		out_lsdbuf_write_protect <= slv_wire00[0];
 		out_lsdbuf_raddr         <= slv_wire01[$clog2(LSD_BUFSIZE)-1:0];
-		// <= slv_wire02;
-		// <= slv_wire03;
-		// <= slv_wire04;
-		// <= slv_wire05;
-		// <= slv_wire06;
-		// <= slv_wire07;
+		out_lsd_angle_thres      <= slv_wire02[7:0];
+		out_lsd_grad_thres       <= slv_wire03[7:0];
+		out_lsd_length_thres     <= slv_wire04[7:0];
+		out_lsd_manual_thres     <= slv_wire05[0];
+		out_hist_raddr           <= slv_wire06[7:0];
+		out_hist_freeze          <= slv_wire07[0];
 		// <= slv_wire08;
 		// <= slv_wire09;
 		// <= slv_wire10;
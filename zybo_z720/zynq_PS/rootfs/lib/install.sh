@@ -6,3 +6,11 @@ cd ../
 
 cd ./libvdma
 make && sudo make install && make clean
+cd ../
+
+cd ./liblsd
+make && sudo make install && make clean
+cd ../
+
+cd ./libimgproc
+make && sudo make install && make clean
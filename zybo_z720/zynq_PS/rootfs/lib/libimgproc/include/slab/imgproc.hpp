@@ -0,0 +1,58 @@
+//-----------------------------------------------------------------------------
+// <imgproc.hpp>
+//  - Header of the software models of <image_processor> (PL)
+//    - Declared slab::FrameGeometry (active size and frame size)
+//    - Declared slab::GrayImage (8-bit single channel image, PGM I/O)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 10, 2020)
+//  - Added slab::FrameGeometry and slab::GrayImage
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_H_
+#define _IMGPROC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+namespace slab {
+	/*
+	 * size of a video frame as seen by the PL
+	 *  - image  : active video (H_ACTIVE x V_ACTIVE)
+	 *  - frame  : including blanking (H_FRAME x V_FRAME)
+	 */
+	typedef struct FrameGeometry {
+		uint32_t image_width, image_height;
+		uint32_t frame_width, frame_height;
+	} FrameGeometry;
+
+	/* $clog2() of SystemVerilog */
+	uint32_t clog2(uint64_t);
+
+	/* 8-bit single channel image (rows are contiguous) */
+	class GrayImage {
+		private:
+			uint32_t             width_, height_;
+			std::vector<uint8_t> data_;
+		protected:
+		public:
+			GrayImage();
+			GrayImage(uint32_t width, uint32_t height, uint8_t fill = 0);
+			~GrayImage();
+			void resize(uint32_t width, uint32_t height, uint8_t fill = 0);
+			uint32_t       width()  const { return width_;  }
+			uint32_t       height() const { return height_; }
+			uint8_t       *data()         { return data_.data(); }
+			const uint8_t *data()   const { return data_.data(); }
+			uint8_t       *row(uint32_t v)       { return data_.data() + (size_t)v * width_; }
+			const uint8_t *row(uint32_t v) const { return data_.data() + (size_t)v * width_; }
+			bool load_pgm(const std::string&); // binary PGM (P5, maxval 255)
+			bool save_pgm(const std::string&) const;
+	};
+};
+
+#endif // _IMGPROC_H_
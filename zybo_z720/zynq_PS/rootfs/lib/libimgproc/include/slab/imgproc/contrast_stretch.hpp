@@ -0,0 +1,105 @@
+//-----------------------------------------------------------------------------
+// <contrast_stretch.hpp>
+//  - Header of slab::ContrastStretch class
+//    - bit-exact software model of <contrast_stretch> (PL)
+//-----------------------------------------------------------------------------
+// Model
+//  - every frame is converted with the table made from the histogram of
+//    the previous frame (the table of the PL is updated in the blanking)
+//  - the first frame after reset() is converted with an empty table (all
+//    zero), as the PL does after the bitstream is loaded
+//  - conversion and histogram (multi-threaded, SIMD if available)
+//      rows are split into bands; every band looks up the table and counts
+//      its own histogram, which are summed when all bands are done
+//  - table update (sequential, 256 bins)
+//      the same sweep, window search and fixed-point products as the PL,
+//      including the case where a window point found at the last bin is
+//      not yet visible to the weight (and to the snapshot)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 11, 2020)
+//  - Added declaration of slab::ContrastStretch class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 16, 2020)
+//  - Made the band API public for fused pipelines
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 30, 2020)
+//  - Added simd_supported()
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_CONTRAST_STRETCH_H_
+#define _IMGPROC_CONTRAST_STRETCH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include <slab/lsd/histogram.hpp>
+#include <slab/imgproc.hpp>
+
+namespace slab {
+	/* parameters of contrast_stretch.sv (BIT_WIDTH = 8) */
+	typedef struct ContrastStretchParams {
+		FrameGeometry geometry;
+		uint32_t      window_range;  // WINDOW_RANGE (%)
+		bool          equalize_hist; // EQUALIZE_HIST
+	} ContrastStretchParams;
+
+	/* parameters of contrast_stretch in image_processor.sv for <geometry> */
+	ContrastStretchParams contrast_stretch_params(const FrameGeometry& geometry);
+
+	class ContrastStretch {
+		private:
+			ContrastStretchParams params_;
+			uint32_t              iw_, ih_;
+
+			/* localparams of contrast_stretch.sv */
+			uint32_t total_pixs_, count_bitw_, clip_pixs_;
+			uint32_t inv_table_[HIST_BINS]; // cst_linear
+			uint64_t weight_;               // cst_eq_hist
+
+			/* conversion and histogram */
+			unsigned              threads_;
+			bool                  simd_;
+			std::vector<uint32_t> partial_; // histograms of the bands
+			uint8_t               table_[HIST_BINS];  // ctb_ram
+			uint32_t              hist_[HIST_BINS];   // hst_ram
+
+			/* window points (min_val / max_val, snp_min / snp_max) */
+			uint8_t       min_val_, max_val_;
+			LumaHistogram snapshot_;
+
+			void update();
+		protected:
+		public:
+			ContrastStretch(const ContrastStretchParams&, unsigned threads = 0);
+			~ContrastStretch();
+			void reset();
+			void set_threads(unsigned threads) { threads_ = (threads > 0) ? threads : 1; }
+			void set_simd(bool enable)         { simd_ = enable; }
+			unsigned threads() const { return threads_; }
+			/* false: set_simd(true) still runs the scalar lookup on this host */
+			static bool simd_supported();
+			/* one frame (image_width x image_height); <out> may be <in> */
+			void process(const uint8_t *in, size_t in_stride, uint8_t *out, size_t out_stride);
+			void process(const GrayImage& in, GrayImage& out);
+			/*
+			 * the same frame in pieces: begin_frame(bands), convert_rows() of
+			 * every row once (rows r0 to r1 of <in> / <out>, any order, each
+			 * band from one thread at a time), then end_frame()
+			 */
+			void begin_frame(unsigned bands);
+			void convert_rows(const uint8_t *in, size_t in_stride, uint8_t *out, size_t out_stride,
+					uint32_t r0, uint32_t r1, unsigned band);
+			void end_frame();
+			/* table for the next frame (ctb_ram) */
+			const uint8_t *table() const { return table_; }
+			/* out_hst_* after the last frame (what HistogramReader reads) */
+			const LumaHistogram& histogram() const { return snapshot_; }
+			const ContrastStretchParams& params() const { return params_; }
+	};
+};
+
+#endif // _IMGPROC_CONTRAST_STRETCH_H_
@@ -0,0 +1,109 @@
+//-----------------------------------------------------------------------------
+// <conv_net.hpp>
+//  - Header of slab::ConvNet class
+//    - fixed-point CNN runtime, bit-exact with <conv_layer_fixed> and
+//      <batch_norm> (PL)
+//-----------------------------------------------------------------------------
+// Model
+//  - a layer is given with the parameters of conv_layer_fixed.sv (real
+//    weights, biases and batch norm. parameters) and is quantized the same
+//    way: WEIGHTS to WGT_FRAC_BITW, BIASES to IN_FRAC_BITW + WGT_FRAC_BITW,
+//    products and sums wrap at MID_BITW, replicate padding at the edges
+//  - the PL rounds batch norm. on its own (batch_norm.sv), so it cannot be
+//    folded into the weights without changing results; it is applied as
+//    an integer epilogue right after the dot products instead
+//  - layers are fused into tiles of rows: a tile of the last layer pulls
+//    only the rows it needs (with halos) through the earlier layers, so
+//    intermediate feature maps stay in cache. Tiles run on threads
+//  - dot products use int16 SIMD (SSE2 pmaddwd / NEON vmlal) when the
+//    inputs and weights fit (sums are exact mod 2^32, and MID_BITW <= 32),
+//    NEON int8 when they fit 8 bits, or exact 64-bit scalar otherwise.
+//    Common filter sizes and channel counts are compile-time specialized
+//  - feature maps are int32_t, rows x columns x channels (HWC)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 13, 2020)
+//  - Added declaration of slab::ConvNet class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_CONV_NET_H_
+#define _IMGPROC_CONV_NET_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include <slab/imgproc.hpp>
+
+namespace slab {
+	/* parameters of conv_layer_fixed.sv */
+	typedef struct ConvLayerParams {
+		uint32_t in_bitw, out_bitw;                           // IN_BITW, OUT_BITW
+		uint32_t in_frac_bitw, wgt_frac_bitw, out_frac_bitw;  // *_FRAC_BITW
+		uint32_t in_chs, out_chs, flt_size;                   // IN_CHS, OUT_CHS, FLT_SIZE
+		int32_t  lrelu_slope;                                 // LRELU_SLOPE (-1: none)
+		bool     batch_norm, residual;                        // BATCH_NORM, RESIDUAL
+		std::vector<double> weights;   // (out_ch, in_ch, flt_v, flt_h)
+		std::vector<double> biases;    // out_chs
+		std::vector<double> avg_means, avg_vars, gammas, betas; // out_chs each
+	} ConvLayerParams;
+
+	/* defaults of conv_layer_fixed.sv (1x1, 1 channel, no activation) */
+	ConvLayerParams conv_layer_params(uint32_t in_bitw, uint32_t out_bitw);
+
+	/* a quantized layer */
+	typedef struct ConvLayer {
+		ConvLayerParams params;
+		uint32_t mid_bitw, res_shift, bn_bitw;
+		int32_t  skip_shift;
+		uint32_t flt_pixs, taps;     // FLT_SIZE^2, IN_CHS * FLT_SIZE^2
+		uint32_t taps_pad;           // taps rounded up for SIMD
+		std::vector<int64_t> scale;  // SCALE   (out_chs x taps)
+		std::vector<int64_t> offset; // OFFSET  (out_chs)
+		std::vector<int64_t> bn_mult, bn_bias; // MULTIPLIER, BIAS of batch_norm
+		int      simd;               // 0: scalar, 8: int8, 16: int16
+		std::vector<int16_t> wgt16;  // out_chs (to a multiple of 4) x taps_pad, HWC order
+		std::vector<int8_t>  wgt8;   // |
+	} ConvLayer;
+
+	class ConvNet {
+		private:
+			uint32_t               iw_, ih_;
+			unsigned               threads_;
+			bool                   simd_;
+			uint32_t               tile_rows_;
+			std::vector<ConvLayer> layers_;
+
+			void run_tile(size_t, size_t, const int32_t*, int32_t*, uint32_t, uint32_t,
+					std::vector<std::vector<int32_t> >&, std::vector<int16_t>&) const;
+			void run_layer(const ConvLayer&, const int32_t*, uint32_t, int32_t*, uint32_t,
+					uint32_t, uint32_t, std::vector<int16_t>&) const;
+		protected:
+		public:
+			ConvNet(uint32_t width, uint32_t height, unsigned threads = 0);
+			~ConvNet();
+			/* false if the layer does not follow the previous one */
+			bool add_layer(const ConvLayerParams&);
+			void clear() { layers_.clear(); }
+			void set_threads(unsigned threads) { threads_ = (threads > 0) ? threads : 1; }
+			void set_simd(bool enable)         { simd_ = enable; }
+			/* rows of the last layer per tile (0: whole frame in one pass) */
+			void set_tile_rows(uint32_t rows)  { tile_rows_ = rows; }
+			size_t           layers() const { return layers_.size(); }
+			const ConvLayer& layer(size_t i) const { return layers_[i]; }
+			unsigned         threads() const { return threads_; }
+			/*
+			 * layers [first, last) on one frame (HWC int32_t); <in> has
+			 * in_chs of layer <first>, <out> has out_chs of layer <last - 1>,
+			 * so a network can be split between the PS and the PL
+			 */
+			void process(const int32_t *in, int32_t *out, size_t first, size_t last) const;
+			void process(const int32_t *in, int32_t *out) const { process(in, out, 0, layers_.size()); }
+			/* luma as the first input ({1'b0, y}, 1 channel) */
+			void process(const GrayImage&, std::vector<int32_t>& out) const;
+	};
+};
+
+#endif // _IMGPROC_CONV_NET_H_
@@ -0,0 +1,95 @@
+//-----------------------------------------------------------------------------
+// <fixed_math.hpp>
+//  - Header of slab::ArctanCalc, slab::SinCalc and slab::DividerIterS classes
+//    - bit-exact models of <arctan_calc> (v1.03), <sin_calc> (v1.05) and
+//      <divider_iter_s> (v1.03) with batch APIs
+//-----------------------------------------------------------------------------
+// Model
+//  - the ROMs are generated like the always_comb blocks of the PL, and
+//    every truncation, saturation and wrap-around is reproduced
+//  - operator() is the scalar reference; process() runs arrays with
+//    SSE2 or NEON (set_simd(false) for the scalar loop)
+//    - arctan_calc / sin_calc: address and sign stages in SIMD, ROM reads
+//      per element (the ROMs are small enough for L1)
+//    - divider_iter_s: reciprocal estimate, then exact integer correction
+//      (TOTAL_BITW = BIT_WIDTH + OUT_FRAC_BITW <= 24)
+//  - DividerIterS also returns the cycles of the PL for one division
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 15, 2020)
+//  - Added declaration of slab::ArctanCalc, slab::SinCalc and
+//    slab::DividerIterS classes
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_FIXED_MATH_H_
+#define _IMGPROC_FIXED_MATH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+namespace slab {
+	/* atan2(y, x) as an <out_bitw>-bit angle in [0, 2pi) */
+	class ArctanCalc {
+		private:
+			uint32_t              in_bitw_, out_bitw_;
+			std::vector<uint16_t> rom_;  // arctan_table
+			bool                  simd_;
+		protected:
+		public:
+			/* 4 <= out_bitw <= 12, out_bitw - 2 <= in_bitw <= 16 */
+			ArctanCalc(uint32_t in_bitw = 9, uint32_t out_bitw = 8);
+			~ArctanCalc();
+			void     set_simd(bool enable) { simd_ = enable; }
+			uint32_t in_bitw()  const { return in_bitw_;  }
+			uint32_t out_bitw() const { return out_bitw_; }
+			/* in_y, in_x (<in_bitw> bits signed) -> out_val */
+			uint32_t operator()(int32_t y, int32_t x) const;
+			void     process(const int16_t *y, const int16_t *x, uint16_t *out, size_t n) const;
+	};
+
+	/* sin(phase / 2^in_bitw * 2pi) with <out_bitw> - 2 fractional bits */
+	class SinCalc {
+		private:
+			uint32_t             in_bitw_, out_bitw_;
+			std::vector<int16_t> rom_;   // sine_table (a quarter)
+			bool                 simd_;
+		protected:
+		public:
+			/* 3 <= in_bitw <= 16, 3 <= out_bitw <= 16 (cosine: phase + 2^(in_bitw - 2)) */
+			SinCalc(uint32_t in_bitw = 12, uint32_t out_bitw = 12);
+			~SinCalc();
+			void     set_simd(bool enable) { simd_ = enable; }
+			uint32_t in_bitw()  const { return in_bitw_;  }
+			uint32_t out_bitw() const { return out_bitw_; }
+			/* in_phase (<in_bitw> bits) -> out_val */
+			int32_t  operator()(uint32_t phase) const;
+			void     process(const uint16_t *phase, int16_t *out, size_t n) const;
+	};
+
+	/* q = a * 2^out_frac_bitw / b (truncated toward 0), r with the sign of a */
+	class DividerIterS {
+		private:
+			uint32_t bit_width_, frac_bitw_, total_bitw_;
+			bool     simd_;
+		protected:
+		public:
+			/* total_bitw = bit_width + out_frac_bitw <= 62 (process(): <= 31) */
+			DividerIterS(uint32_t bit_width, uint32_t out_frac_bitw = 0);
+			~DividerIterS();
+			void     set_simd(bool enable) { simd_ = enable; }
+			uint32_t bit_width()     const { return bit_width_;  }
+			uint32_t out_frac_bitw() const { return frac_bitw_;  }
+			uint32_t total_bitw()    const { return total_bitw_; }
+			/*
+			 * in_a, in_b (<bit_width> bits signed) -> out_q (total_bitw + 1 bits),
+			 * out_r (total_bitw bits); returns the cycles from in_en to out_ready
+			 */
+			uint32_t operator()(int64_t a, int64_t b, int64_t& q, int64_t& r) const;
+			void     process(const int32_t *a, const int32_t *b, int32_t *q, int32_t *r, size_t n) const;
+	};
+};
+
+#endif // _IMGPROC_FIXED_MATH_H_
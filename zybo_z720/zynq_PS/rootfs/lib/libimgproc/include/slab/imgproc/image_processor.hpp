@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// <image_processor.hpp>
+//  - Header of slab::ImageProcessor class
+//    - software model of <image_processor> (PL) with the four outputs of
+//      sw[3:0] written into a framebuffer
+//-----------------------------------------------------------------------------
+// Model
+//  - modes (sw of image_processor.sv)
+//      0: passthrough              in_data
+//      1: gray                     {3{out_y}} of rgb2ycbcr
+//      2: contrast-stretched gray  {3{out_pixel}} of contrast_stretch
+//      3: LSD                      lsd_visualizer (line_draw and
+//                                  slsd_mem_overlay) on simple_lsd
+//  - one pass over the frame, split into row bands (one band per thread);
+//    every row goes rgb2ycbcr -> contrast_stretch -> framebuffer while it
+//    is in cache, so modes 0 to 2 have no intermediate frame
+//  - mode 3 keeps one luma plane for SimpleLSD (its front end needs the
+//    neighbouring rows and its region growing is sequential), then draws
+//    the lines and the memory bar straight into the framebuffer
+//  - the stages run only up to the selected output: contrast_stretch
+//    counts its histogram in modes 1 to 3 and simple_lsd runs in mode 3
+//    only (the PL runs both in every mode)
+//  - line_draw uses divider_iter_s and the same fixed-point steps as the
+//    PL. The lines and the bar of a frame are shown on the next frame, as
+//    the segments of simple_lsd come out after the raster has passed them
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 16, 2020)
+//  - Added declaration of slab::ImageProcessor class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_IMAGE_PROCESSOR_H_
+#define _IMGPROC_IMAGE_PROCESSOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include <slab/vdma.hpp>
+#include <slab/imgproc.hpp>
+#include <slab/imgproc/rgb2ycbcr.hpp>
+#include <slab/imgproc/contrast_stretch.hpp>
+#include <slab/imgproc/simple_lsd.hpp>
+#include <slab/imgproc/fixed_math.hpp>
+
+namespace slab {
+	/* sw[3:0] of image_processor.sv */
+	typedef enum ImageProcessorMode {
+		IMGPROC_PASSTHROUGH = 0,
+		IMGPROC_GRAY,
+		IMGPROC_STRETCH,
+		IMGPROC_LSD
+	} ImageProcessorMode;
+
+	/* parameters of the modules in image_processor.sv */
+	typedef struct ImageProcessorParams {
+		FrameGeometry         geometry;
+		ContrastStretchParams stretch;
+		SimpleLSDParams       lsd;     // RAM_SIZE is also that of slsd_mem_overlay
+	} ImageProcessorParams;
+
+	/* parameters of image_processor in vdma_top.sv for <geometry> */
+	ImageProcessorParams image_processor_params(const FrameGeometry& geometry);
+
+	class ImageProcessor {
+		private:
+			ImageProcessorParams params_;
+			uint32_t             iw_, ih_;
+			unsigned             threads_;
+			bool                 simd_;
+			ImageProcessorMode   mode_;
+
+			RGB2YCbCr       gray_;
+			ContrastStretch stretch_;
+			SimpleLSD       lsd_;
+			DividerIterS    slope_;  // div_0 of line_draw
+			LineFrame       frame_;  // lines of the last frame (mode 3)
+
+			std::vector<uint8_t> rows_;  // one luma row per band
+			std::vector<uint8_t> luma_;  // image for simple_lsd (mode 3)
+			std::vector<uint8_t> fb_;    // fb_ram_0 of line_draw
+
+			/* slsd_mem_overlay */
+			uint32_t count_bitw_, scale_;
+			uint32_t total_count_, valid_count_;
+
+			void process_rows(const bgr_t*, size_t, bgr_t*, size_t, uint32_t, uint32_t, unsigned);
+			void overlay_row(bgr_t*, uint32_t) const;
+			void draw_lines();
+		protected:
+		public:
+			ImageProcessor(const ImageProcessorParams&, unsigned threads = 0);
+			~ImageProcessor();
+			/* n_rst of every module */
+			void reset();
+			/* false (and no change) for sw values without an output */
+			bool set_mode(uint32_t sw);
+			void set_threads(unsigned threads);
+			void set_simd(bool enable);
+			ImageProcessorMode mode()    const { return mode_;    }
+			unsigned           threads() const { return threads_; }
+			/*
+			 * one frame (image_width x image_height, strides in bytes) into the
+			 * framebuffer <out>; <out> may be <in> (e.g. a frame of slab::VDMA)
+			 */
+			void process(const bgr_t *in, size_t in_stride, bgr_t *out, size_t out_stride);
+
+			/* the stages (thresholds, histogram, outputs of the last frame) */
+			ContrastStretch&       stretch()       { return stretch_; }
+			const ContrastStretch& stretch() const { return stretch_; }
+			SimpleLSD&             lsd()           { return lsd_;     }
+			const SimpleLSD&       lsd()     const { return lsd_;     }
+			/* lines of the last frame in mode 3 (lsd_output_buffer_wp) */
+			const LineFrame&       lines()   const { return frame_;   }
+			const ImageProcessorParams& params() const { return params_; }
+	};
+};
+
+#endif // _IMGPROC_IMAGE_PROCESSOR_H_
@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// <lsd_sweep.hpp>
+//  - Header of slab::LSDFrameCache and slab::LSDSweep classes
+//    - parameter sweep of simple_lsd (ANGLE_THRES, GRAD_THRES,
+//      LENGTH_THRES, RAM_SIZE and resolution) over recorded frames
+//-----------------------------------------------------------------------------
+// Model
+//  - the frames are decoded once and resampled once per resolution
+//    (bilinear) into LSDFrameCache; every worker reads the same images
+//  - one worker per core takes the grid points in turn (largest frames
+//    first); a point runs a single-threaded SimpleLSD over every frame in
+//    order, so the state kept between frames (offset control, RAM) is that
+//    of the PL fed with the corpus as a video
+//  - per point: valid segments per frame, frames over OVER_THRES (90 % of
+//    RAM_SIZE, out_overused), frames that wrap the RAM, the register
+//    accesses of slab::LSDReader::fetch() and their estimated time, and the
+//    runtime of the model
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 19, 2020)
+//  - Added declaration of slab::LSDFrameCache and slab::LSDSweep classes
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 30, 2020)
+//  - LSDSweepResult::lines counts the lines held in RAM_SIZE
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_LSD_SWEEP_H_
+#define _IMGPROC_LSD_SWEEP_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <slab/imgproc.hpp>
+#include <slab/imgproc/simple_lsd.hpp>
+
+namespace slab {
+	/* frames of a corpus at every resolution of the sweep */
+	class LSDFrameCache {
+		private:
+			std::vector<GrayImage>                         source_;
+			std::map<uint64_t, std::vector<GrayImage> >    scaled_; // (width << 32) | height
+		protected:
+		public:
+			LSDFrameCache();
+			~LSDFrameCache();
+			/* decodes PGM files (all of the same size) */
+			bool load(const std::vector<std::string>& paths, unsigned threads = 0);
+			void add(const GrayImage&);
+			/* resamples every frame to <width> x <height> once */
+			void prepare(uint32_t width, uint32_t height, unsigned threads = 0);
+			/* frames at <width> x <height> (after prepare(), or the source size) */
+			const std::vector<GrayImage>& frames(uint32_t width, uint32_t height) const;
+			size_t   size()   const { return source_.size(); }
+			uint32_t width()  const { return source_.empty() ? 0 : source_[0].width();  }
+			uint32_t height() const { return source_.empty() ? 0 : source_[0].height(); }
+	};
+
+	/* one grid point (parameters of simple_lsd) */
+	typedef struct LSDSweepPoint {
+		FrameGeometry geometry;
+		LSDThresholds thres;
+		uint32_t      ram_size;
+	} LSDSweepPoint;
+
+	typedef struct LSDSweepResult {
+		LSDSweepPoint point;
+		uint32_t      frames;
+		double        segments;     // valid segments per frame
+		uint32_t      segments_max;
+		double        lines;        // lines held in RAM_SIZE per frame (read back)
+		uint32_t      overused;     // frames with out_overused (OVER_THRES)
+		uint32_t      wrapped;      // frames with more segments than RAM_SIZE
+		double        reads, writes; // accesses of LSDReader::fetch() per frame
+		double        readback_us;  // estimated time of LSDReader::fetch()
+		double        model_ms;     // runtime of the model per frame
+	} LSDSweepResult;
+
+	class LSDSweep {
+		private:
+			LSDFrameCache&              cache_;
+			unsigned                    threads_;
+			bool                        auto_offset_;
+			double                      read_ns_, write_ns_;
+			double                      fps_;
+			std::vector<LSDSweepPoint>  points_;
+			std::vector<LSDSweepResult> results_;
+
+			void run_point(const LSDSweepPoint&, LSDSweepResult&) const;
+		protected:
+		public:
+			LSDSweep(LSDFrameCache&, unsigned threads = 0);
+			~LSDSweep();
+			void set_threads(unsigned threads);
+			/* automatic offset of simple_lsd (in_manual_thres = 0), default on */
+			void set_auto_offset(bool enable) { auto_offset_ = enable; }
+			/* time of one register access through slab::UIO */
+			void set_cost(double read_ns, double write_ns) { read_ns_ = read_ns; write_ns_ = write_ns; }
+			/* frame rate of the video (default 60, as every mode of timing[]) */
+			void set_frame_rate(double fps) { fps_ = fps; }
+			void add(const LSDSweepPoint&);
+			/* every combination of the values */
+			void add_grid(const std::vector<FrameGeometry>&, const std::vector<uint8_t>& angle,
+					const std::vector<uint8_t>& grad, const std::vector<uint8_t>& length,
+					const std::vector<uint32_t>& ram_size);
+			void clear() { points_.clear(); results_.clear(); }
+			size_t points() const { return points_.size(); }
+			/* runs every point (results in the order of add) */
+			const std::vector<LSDSweepResult>& run();
+			const std::vector<LSDSweepResult>& results() const { return results_; }
+			/* table (or CSV) of the results */
+			void print(FILE*, bool csv = false) const;
+	};
+};
+
+#endif // _IMGPROC_LSD_SWEEP_H_
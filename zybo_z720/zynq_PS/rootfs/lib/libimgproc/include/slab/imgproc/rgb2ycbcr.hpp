@@ -0,0 +1,90 @@
+//-----------------------------------------------------------------------------
+// <rgb2ycbcr.hpp>
+//  - Header of slab::RGB2YCbCr class
+//    - bit-exact software model of <rgb2ycbcr> (PL, BIT_WIDTH = 8)
+//-----------------------------------------------------------------------------
+// Model
+//  - rgb2ycbcr.sv rounds every weight to FRAC_BITW (= 11) bits, adds the
+//    products and rounds the sum to 8 bits. For 8-bit inputs it is
+//      Y  = ( 435 R + 1465 G +  148 B + 1024  ) >> 11
+//      Cb = (-235 R -  789 G + 1024 B + 262144) >> 11
+//      Cr = (1024 R -  930 G -   94 B + 262144) >> 11
+//    (the Cb/Cr bias 127.5 and the rounding 0.5 make 128 << 11), which
+//    differs from cv::cvtColor() by one for many pixels
+//  - kernels: NEON, SSSE3 and AVX2 (chosen at run time), scalar fallback
+//  - frames are bgr_t rows with any stride, e.g. cv::Mat (CV_8UC3) with
+//    (bgr_t*)mat.data and mat.step, or a framebuffer of slab::VDMA.
+//    The packed output may overwrite the input (in-place)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 12, 2020)
+//  - Added declaration of slab::RGB2YCbCr class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 16, 2020)
+//  - Added process_row()
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_RGB2YCBCR_H_
+#define _IMGPROC_RGB2YCBCR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <slab/vdma.hpp>
+#include <slab/imgproc.hpp>
+
+namespace slab {
+	/* one pixel of the packed output (same size as bgr_t) */
+	typedef struct ycbcr_t {
+		uint8_t y, cb, cr;
+	} ycbcr_t;
+
+	/* one pixel (out_y, out_cb, out_cr of rgb2ycbcr.sv) */
+	static inline uint8_t rgb2y(int r, int g, int b) {
+		return (435 * r + 1465 * g + 148 * b + 1024) >> 11;
+	}
+	static inline uint8_t rgb2cb(int r, int g, int b) {
+		return (-235 * r - 789 * g + 1024 * b + 262144) >> 11;
+	}
+	static inline uint8_t rgb2cr(int r, int g, int b) {
+		return (1024 * r - 930 * g - 94 * b + 262144) >> 11;
+	}
+
+	typedef enum RGB2YCbCrKernel {
+		RGB2YCBCR_SCALAR = 0,
+		RGB2YCBCR_SSSE3,
+		RGB2YCBCR_AVX2,
+		RGB2YCBCR_NEON
+	} RGB2YCbCrKernel;
+
+	class RGB2YCbCr {
+		private:
+			uint32_t        iw_, ih_;
+			unsigned        threads_;
+			RGB2YCbCrKernel kernel_;
+		protected:
+		public:
+			RGB2YCbCr(uint32_t width, uint32_t height, unsigned threads = 0);
+			~RGB2YCbCr();
+			void set_threads(unsigned threads) { threads_ = (threads > 0) ? threads : 1; }
+			/* the fastest kernel of this CPU, or scalar */
+			void set_simd(bool enable);
+			/* false if <kernel> is not supported by this CPU */
+			bool set_kernel(RGB2YCbCrKernel kernel);
+			RGB2YCbCrKernel kernel() const { return kernel_; }
+			const char     *kernel_name() const;
+			unsigned        threads() const { return threads_; }
+			/* Y of one row (image_width pixels, no threads) */
+			void process_row(const bgr_t *in, uint8_t *y) const;
+			/* Y only (strides in bytes) */
+			void process(const bgr_t *in, size_t in_stride, uint8_t *y, size_t y_stride);
+			void process(const bgr_t *in, size_t in_stride, GrayImage& y);
+			/* Y, Cb and Cr (<out> may be (ycbcr_t*)<in> with the same stride) */
+			void process(const bgr_t *in, size_t in_stride, ycbcr_t *out, size_t out_stride);
+
+			static bool supported(RGB2YCbCrKernel kernel);
+	};
+};
+
+#endif // _IMGPROC_RGB2YCBCR_H_
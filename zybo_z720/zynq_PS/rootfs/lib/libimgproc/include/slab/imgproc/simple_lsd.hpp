@@ -0,0 +1,138 @@
+//-----------------------------------------------------------------------------
+// <simple_lsd.hpp>
+//  - Header of slab::SimpleLSD class
+//    - bit-exact software model of <simple_lsd> (PL)
+//-----------------------------------------------------------------------------
+// Model
+//  - front end (multi-threaded, SIMD if available)
+//      3x3 gaussian (conv_layer_fixed) -> 2x2 difference -> gradient
+//      threshold (+ offset) -> 8-bit angle (arctan_calc)
+//    rows are split into bands, one band per thread
+//  - region growing (sequential)
+//      raster scan with the same RAM, segment ids and approximate average
+//      angles as the PL, including RAM_SIZE wrap-around and the OVER_THRES
+//      offset control. The state is kept between frames like the PL does
+//      (e.g. the first FRAME_WIDTH + 7 pixels of a frame are still compared
+//      with the gradient threshold of the previous frame)
+//  - output (centroid, angle and end points of every segment)
+//
+// Inputs and outputs are those of <simple_lsd>: the luma image after
+// <contrast_stretch> goes in, and the segments with out_flag (and
+// out_valid) come out. The LineFrame view follows lsd_output_buffer_wp.
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 10, 2020)
+//  - Added declaration of slab::SimpleLSD class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_SIMPLE_LSD_H_
+#define _IMGPROC_SIMPLE_LSD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include <slab/lsd.hpp>
+#include <slab/lsd/threshold.hpp>
+#include <slab/imgproc.hpp>
+
+namespace slab {
+	/* parameters of simple_lsd.sv */
+	typedef struct SimpleLSDParams {
+		FrameGeometry geometry;
+		LSDThresholds thres;    // ANGLE_THRES, GRAD_THRES, LENGTH_THRES
+		uint32_t      ram_size; // RAM_SIZE
+	} SimpleLSDParams;
+
+	/* parameters of simple_lsd in vdma_top.sv for <geometry> */
+	SimpleLSDParams simple_lsd_params(const FrameGeometry& geometry);
+
+	/* one output of simple_lsd (a cycle with out_flag) */
+	typedef struct SimpleLSDOutput {
+		uint16_t start_v, start_h, end_v, end_h;
+		uint8_t  angle;
+		uint8_t  valid;
+	} SimpleLSDOutput;
+
+	class SimpleLSD {
+		private:
+			/* one word of the segment RAM (and the region registers) */
+			typedef struct Region {
+				bool     exist;
+				uint32_t total_pixs;
+				uint32_t start_v, start_h, end_v, end_h;
+				uint64_t v_sum, h_sum;
+				uint8_t  base_angle;
+				int64_t  angle_sum;
+				uint8_t  avg_angle;
+			} Region;
+
+			SimpleLSDParams params_;
+			uint32_t        iw_, ih_;
+
+			/* bit widths of simple_lsd.sv */
+			uint32_t v_bitw_, h_bitw_, addr_bitw_, pixs_bitw_;
+			uint32_t v_sum_bitw_, h_sum_bitw_, a_sum_bitw_;
+			uint32_t id_none_, addr_mask_, over_thres_;
+
+			/* front end */
+			unsigned             threads_;
+			bool                 simd_;
+			size_t               gstride_;
+			std::vector<uint8_t> gauss_;          // (IH + 1) rows, replicated edges
+			std::vector<uint8_t> valid_, angle_;  // IH x IW
+
+			/* region growing */
+			std::vector<Region>   ram_;
+			std::vector<uint32_t> ids_prev_, ids_cur_;
+			Region                cur_;
+			bool                  last_, merging_, overused_;
+			uint32_t              seg_num_, segid_, alias_id_;
+
+			/* thresholds (inputs, latched at frame start, and offset) */
+			LSDThresholds in_thres_;
+			bool          in_manual_;
+			uint8_t       angle_thres_, length_thres_;
+			uint32_t      grad_thres2_, length_thres2_;
+			bool          manual_;
+			uint32_t      offset_;
+			bool          out_overused_;
+			uint32_t      out_offset_;
+
+			/* outputs */
+			uint64_t                     sequence_;
+			std::vector<SimpleLSDOutput> outputs_;
+			std::vector<LineSegment>     lines_;    // lsd_output_buffer_wp
+			uint32_t                     line_num_;
+
+			void gauss_rows(const uint8_t*, size_t, uint32_t, uint32_t);
+			void grad_rows(uint32_t, uint32_t, uint32_t, uint32_t);
+			void grow_row(uint32_t);
+			void save();
+			uint8_t avg_angle(uint32_t, int64_t, uint8_t) const;
+			void emit();
+		protected:
+		public:
+			SimpleLSD(const SimpleLSDParams&, unsigned threads = 0);
+			~SimpleLSD();
+			void reset();
+			/* in_*_thres and in_manual_thres (0: parameter) */
+			void set_thresholds(const LSDThresholds&, bool manual = false);
+			void set_threads(unsigned threads) { threads_ = (threads > 0) ? threads : 1; }
+			void set_simd(bool enable)         { simd_ = enable; }
+			unsigned threads() const { return threads_; }
+			/* one frame of luma (image_width x image_height, <stride> bytes per row) */
+			void process(const uint8_t *y, size_t stride, LineFrame&);
+			void process(const GrayImage&, LineFrame&);
+			/* outputs of the last frame (including out_valid == 0) */
+			const std::vector<SimpleLSDOutput>& outputs() const { return outputs_; }
+			/* out_overused and out_thres_offset after the last frame */
+			bool     overused() const { return out_overused_; }
+			uint32_t offset()   const { return out_offset_;   }
+			const SimpleLSDParams& params() const { return params_; }
+	};
+};
+
+#endif // _IMGPROC_SIMPLE_LSD_H_
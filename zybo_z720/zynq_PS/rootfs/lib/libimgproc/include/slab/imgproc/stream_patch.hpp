@@ -0,0 +1,240 @@
+//-----------------------------------------------------------------------------
+// <stream_patch.hpp>
+//  - slab::StreamPatch, slab::PatchStage and slab::StreamPipeline templates
+//    - line-buffer windowing of <stream_patch> (PL) for CPU image kernels
+//-----------------------------------------------------------------------------
+// Model
+//  - rows are pushed one by one into a ring of PATCH_HEIGHT line buffers;
+//    a row of patches is handed out as soon as its last row has arrived,
+//    and the remaining rows are flushed with the last row of the frame
+//  - every patch has the compile-time size of the kernel; patch(v, h) is
+//    the pixel at (y - CENTER_V + v, x - CENTER_H + h) like out_patch
+//  - PADDING = 1 replicates the edges like stream_patch.sv; PADDING = 0
+//    gives 0 outside the image (the blanking pixels of the stream)
+//  - PatchStage applies a kernel to every patch; StreamPipeline chains
+//    stages in one pass, so each stage keeps PATCH_HEIGHT rows instead of
+//    a frame and the whole pipeline stays in cache
+//  - a kernel is a class with
+//      typedef ... in_type, out_type;
+//      static const uint32_t PATCH_HEIGHT = ..., PATCH_WIDTH = ...;
+//      out_type operator()(const Patch<in_type, PATCH_HEIGHT, PATCH_WIDTH>&) const;
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 14, 2020)
+//  - Added slab::StreamPatch, slab::PatchStage and slab::StreamPipeline
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_STREAM_PATCH_H_
+#define _IMGPROC_STREAM_PATCH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace slab {
+	/* one patch (out_patch); <rows> start CENTER_H columns left of the image */
+	template <class T, uint32_t PH, uint32_t PW>
+	class Patch {
+		private:
+			const T *const *rows_;
+			uint32_t        x_;
+		protected:
+		public:
+			static const uint32_t PATCH_HEIGHT = PH;
+			static const uint32_t PATCH_WIDTH  = PW;
+
+			Patch(const T *const *rows, uint32_t x) : rows_(rows), x_(x) {}
+			T operator()(uint32_t v, uint32_t h) const { return rows_[v][x_ + h]; }
+			uint32_t x() const { return x_; }
+	};
+
+	/* rows of patches for one output row */
+	template <class T, uint32_t PH, uint32_t PW>
+	class PatchRows {
+		private:
+			const T *rows_[PH];
+		protected:
+		public:
+			PatchRows(const T *const *rows) { std::copy(rows, rows + PH, rows_); }
+			Patch<T, PH, PW> patch(uint32_t x) const { return Patch<T, PH, PW>(rows_, x); }
+			/* first pixel of the patch row <v> at column -CENTER_H */
+			const T *row(uint32_t v) const { return rows_[v]; }
+	};
+
+	template <class T, uint32_t PH, uint32_t PW,
+			  uint32_t CV = PH / 2, uint32_t CH = PW / 2, int PADDING = 1>
+	class StreamPatch {
+		static_assert(PH > 0 && PW > 0 && CV < PH && CH < PW, "invalid patch");
+		private:
+			uint32_t       iw_, ih_;
+			size_t         pitch_;    // IMAGE_WIDTH + PATCH_WIDTH - 1
+			std::vector<T> ring_;     // PATCH_HEIGHT line buffers
+			std::vector<T> zero_;     // rows out of the image (PADDING = 0)
+			uint32_t       in_rows_;  // rows pushed in this frame
+			uint32_t       out_rows_; // rows handed out in this frame
+
+			const T *line(int64_t r) const {
+				if (r < 0 || r >= ih_) {
+					if (PADDING == 0) return zero_.data();
+					r = (r < 0) ? 0 : ih_ - 1;
+				}
+				return &ring_[(size_t)(r % PH) * pitch_];
+			}
+		protected:
+		public:
+			typedef PatchRows<T, PH, PW> rows_type;
+			static const uint32_t PATCH_HEIGHT = PH;
+			static const uint32_t PATCH_WIDTH  = PW;
+			static const uint32_t CENTER_V     = CV;
+			static const uint32_t CENTER_H     = CH;
+
+			StreamPatch(uint32_t width = 0, uint32_t height = 0) { resize(width, height); }
+			void resize(uint32_t width, uint32_t height) {
+				iw_    = width;
+				ih_    = height;
+				pitch_ = (size_t)width + PW - 1;
+				ring_.assign(pitch_ * PH, T());
+				zero_.assign(pitch_, T());
+				reset();
+			}
+			/* start of a frame */
+			void reset() { in_rows_ = out_rows_ = 0; }
+			uint32_t width()  const { return iw_; }
+			uint32_t height() const { return ih_; }
+
+			/* feeds the next row; fn(y, rows) for every output row it completes */
+			template <class F>
+			void push(const T *in, F fn) {
+				if (in_rows_ >= ih_ || iw_ == 0) return;
+				T *dst = &ring_[(size_t)(in_rows_ % PH) * pitch_];
+				std::fill(dst, dst + CH, (PADDING == 0) ? T() : in[0]);
+				std::copy(in, in + iw_, dst + CH);
+				std::fill(dst + CH + iw_, dst + pitch_, (PADDING == 0) ? T() : in[iw_ - 1]);
+				const uint32_t r = in_rows_++;
+
+				for (; out_rows_<ih_ && (out_rows_ + (PH - 1 - CV) <= r || r + 1 == ih_); out_rows_++) {
+					const T *rows[PH];
+					for (uint32_t v=0; v<PH; v++) rows[v] = line((int64_t)out_rows_ - CV + v);
+					fn(out_rows_, rows_type(rows));
+				}
+			}
+	};
+
+	/* <K> on every patch (<CV>, <CH> and <PADDING> of stream_patch) */
+	template <class K, uint32_t CV = K::PATCH_HEIGHT / 2, uint32_t CH = K::PATCH_WIDTH / 2,
+			  int PADDING = 1>
+	class PatchStage {
+		public:
+			typedef typename K::in_type  in_type;
+			typedef typename K::out_type out_type;
+		private:
+			K                     kernel_;
+			StreamPatch<in_type, K::PATCH_HEIGHT, K::PATCH_WIDTH, CV, CH, PADDING> patch_;
+			std::vector<out_type> out_;
+		protected:
+		public:
+			PatchStage(const K& kernel = K()) : kernel_(kernel) {}
+			void resize(uint32_t width, uint32_t height) {
+				patch_.resize(width, height);
+				out_.assign(width, out_type());
+			}
+			void reset() { patch_.reset(); }
+			K&       kernel()       { return kernel_; }
+			const K& kernel() const { return kernel_; }
+
+			/* feeds the next row; next(y, out_row) for every row it completes */
+			template <class F>
+			void push(const in_type *in, F next) {
+				patch_.push(in, [this, &next](uint32_t y,
+							const PatchRows<in_type, K::PATCH_HEIGHT, K::PATCH_WIDTH>& rows) {
+					const uint32_t iw = patch_.width();
+					out_type      *o  = out_.data();
+					for (uint32_t x=0; x<iw; x++) o[x] = kernel_(rows.patch(x));
+					next(y, (const out_type*)o);
+				});
+			}
+	};
+
+	/* stages in one pass over the image (the output of one is the input of the next) */
+	template <class... Stages>
+	class StreamPipeline {
+		public:
+			static const size_t STAGES = sizeof...(Stages);
+			typedef typename std::tuple_element<0, std::tuple<Stages...> >::type::in_type in_type;
+			typedef typename std::tuple_element<STAGES - 1, std::tuple<Stages...> >::type::out_type out_type;
+		private:
+			uint32_t              iw_, ih_;
+			std::tuple<Stages...> stages_;
+
+			template <size_t I> void init(std::integral_constant<size_t, I>) {
+				typedef typename std::tuple_element<I, std::tuple<Stages...> >::type S;
+				typedef typename std::tuple_element<I + 1, std::tuple<Stages...> >::type N;
+				static_assert(std::is_same<typename S::out_type, typename N::in_type>::value,
+						"stage output does not match the input of the next stage");
+				std::get<I>(stages_).resize(iw_, ih_);
+				init(std::integral_constant<size_t, I + 1>());
+			}
+			void init(std::integral_constant<size_t, STAGES - 1>) {
+				std::get<STAGES - 1>(stages_).resize(iw_, ih_);
+			}
+
+			template <size_t I, class Row, class Sink>
+			void push(std::integral_constant<size_t, I>, uint32_t, const Row *row, Sink& sink) {
+				typedef typename std::tuple_element<I, std::tuple<Stages...> >::type S;
+				std::get<I>(stages_).push(row, [this, &sink](uint32_t y, const typename S::out_type *out) {
+					push(std::integral_constant<size_t, I + 1>(), y, out, sink);
+				});
+			}
+			template <class Sink>
+			void push(std::integral_constant<size_t, STAGES>, uint32_t y, const out_type *row, Sink& sink) {
+				sink(y, row);
+			}
+
+			template <size_t I> void reset(std::integral_constant<size_t, I>) {
+				std::get<I>(stages_).reset();
+				reset(std::integral_constant<size_t, I + 1>());
+			}
+			void reset(std::integral_constant<size_t, STAGES>) {}
+		protected:
+		public:
+			StreamPipeline(uint32_t width, uint32_t height, const Stages&... stages) :
+				iw_    (width    ),
+				ih_    (height   ),
+				stages_(stages...)
+			{
+				init(std::integral_constant<size_t, 0>());
+			}
+			template <size_t I>
+			typename std::tuple_element<I, std::tuple<Stages...> >::type& stage() {
+				return std::get<I>(stages_);
+			}
+
+			/* one frame; sink(y, out_row) gets the rows in order (strides in bytes) */
+			template <class Sink>
+			void process(const in_type *in, size_t in_stride, Sink sink) {
+				reset(std::integral_constant<size_t, 0>());
+				for (uint32_t r=0; r<ih_; r++)
+					push(std::integral_constant<size_t, 0>(), r,
+							(const in_type*)((const uint8_t*)in + (size_t)r * in_stride), sink);
+			}
+			void process(const in_type *in, size_t in_stride, out_type *out, size_t out_stride) {
+				const uint32_t iw = iw_;
+				process(in, in_stride, [out, out_stride, iw](uint32_t y, const out_type *row) {
+					std::copy(row, row + iw, (out_type*)((uint8_t*)out + (size_t)y * out_stride));
+				});
+			}
+	};
+
+	/* StreamPipeline<Stages...>(width, height, stages...) without the type list */
+	template <class... Stages>
+	StreamPipeline<Stages...> stream_pipeline(uint32_t width, uint32_t height, const Stages&... stages) {
+		return StreamPipeline<Stages...>(width, height, stages...);
+	}
+};
+
+#endif // _IMGPROC_STREAM_PATCH_H_
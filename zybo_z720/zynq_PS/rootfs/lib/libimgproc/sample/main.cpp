@@ -0,0 +1,1085 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <slab/lsd.hpp>
+#include <slab/lsd/recording.hpp>
+#include <slab/imgproc.hpp>
+#include <slab/imgproc/simple_lsd.hpp>
+#include <slab/imgproc/contrast_stretch.hpp>
+#include <slab/imgproc/rgb2ycbcr.hpp>
+#include <slab/imgproc/conv_net.hpp>
+#include <slab/imgproc/stream_patch.hpp>
+#include <slab/imgproc/fixed_math.hpp>
+#include <slab/imgproc/image_processor.hpp>
+#include <slab/imgproc/lsd_sweep.hpp>
+#include <slab/video/VideoOutput.hpp>
+
+/*
+ * test corpus of simple_lsd (dumped by the HDL simulation)
+ *  - <dir>/0000.pgm, 0001.pgm, ... : in_y of simple_lsd (frames in order)
+ *  - <dir>/0000.txt, 0001.txt, ... : one line per cycle with out_flag
+ *      "start_v start_h end_v end_h angle valid"
+ */
+static std::string corpus_path(const char *dir, uint32_t i, const char *ext) {
+	char name[32];
+	snprintf(name, sizeof(name), "/%04u.%s", i, ext);
+	return std::string(dir) + name;
+}
+
+static bool load_expected(const std::string& path, std::vector<slab::SimpleLSDOutput>& out) {
+	FILE *fp;
+	unsigned sv, sh, ev, eh, angle, valid;
+
+	if ((fp = fopen(path.c_str(), "r")) == NULL) return false;
+	out.clear();
+	while (fscanf(fp, "%u %u %u %u %u %u", &sv, &sh, &ev, &eh, &angle, &valid) == 6) {
+		slab::SimpleLSDOutput o;
+		o.start_v = sv; o.start_h = sh; o.end_v = ev; o.end_h = eh;
+		o.angle   = angle;
+		o.valid   = valid;
+		out.push_back(o);
+	}
+	fclose(fp);
+	return true;
+}
+
+static bool same(const slab::SimpleLSDOutput& a, const slab::SimpleLSDOutput& b) {
+	return a.start_v == b.start_v && a.start_h == b.start_h &&
+		a.end_v == b.end_v && a.end_h == b.end_h &&
+		a.angle == b.angle && a.valid == b.valid;
+}
+
+static void print_output(const char *label, const slab::SimpleLSDOutput& o) {
+	printf("    %s : (%u, %u) - (%u, %u), angle %u, valid %u\n", label,
+			o.start_v, o.start_h, o.end_v, o.end_h, o.angle, o.valid);
+}
+
+/* compares the model with the outputs of the HDL simulation */
+static int verify(const char *dir, unsigned threads) {
+	slab::GrayImage image;
+	slab::LineFrame frame;
+	std::vector<slab::SimpleLSDOutput> expected;
+	uint32_t frames = 0, failed = 0;
+
+	if (!image.load_pgm(corpus_path(dir, 0, "pgm"))) return -1;
+	slab::FrameGeometry geometry = {image.width(), image.height(), 0, 0};
+	for (size_t i=0; i<sizeof(slab::timing)/sizeof(slab::timing[0]); i++) {
+		const slab::timing_t& t = slab::timing[i];
+		if (t.h_active == image.width() && t.v_active == image.height()) {
+			geometry.frame_width  = t.h_active + t.h_fp + t.h_sync + t.h_bp;
+			geometry.frame_height = t.v_active + t.v_fp + t.v_sync + t.v_bp;
+		}
+	}
+	if (geometry.frame_width == 0) {
+		fprintf(stderr, "%ux%u: not in timing[]\n", image.width(), image.height());
+		return -1;
+	}
+	slab::SimpleLSD lsd(slab::simple_lsd_params(geometry), threads);
+
+	for (uint32_t i=0; image.load_pgm(corpus_path(dir, i, "pgm")); i++) {
+		if (!load_expected(corpus_path(dir, i, "txt"), expected)) {
+			fprintf(stderr, "%s: not found\n", corpus_path(dir, i, "txt").c_str());
+			return -1;
+		}
+		lsd.process(image, frame);
+
+		const std::vector<slab::SimpleLSDOutput>& out = lsd.outputs();
+		size_t n = std::min(out.size(), expected.size()), k = 0;
+		while (k < n && same(out[k], expected[k])) k++;
+		if (k == n && out.size() == expected.size()) {
+			printf("frame %04u : ok (%zu segments, %u lines)\n", i, out.size(), frame.count);
+		}
+		else {
+			printf("frame %04u : MISMATCH at output %zu (model %zu, hdl %zu)\n",
+					i, k, out.size(), expected.size());
+			if (k < out.size())      print_output("model", out[k]);
+			if (k < expected.size()) print_output("hdl  ", expected[k]);
+			failed++;
+		}
+		frames++;
+	}
+	printf("%u / %u frames match\n", frames - failed, frames);
+	return (frames > 0 && failed == 0) ? 0 : -1;
+}
+
+/* runs the model over PGM files and records the line frames */
+static int run(const char *path, int num, char **files, unsigned threads) {
+	slab::GrayImage image;
+	slab::LineFrame frame;
+
+	if (num < 1 || !image.load_pgm(files[0])) return -1;
+	slab::FrameGeometry geometry = {image.width(), image.height(), image.width(), image.height()};
+	for (size_t i=0; i<sizeof(slab::timing)/sizeof(slab::timing[0]); i++) {
+		const slab::timing_t& t = slab::timing[i];
+		if (t.h_active == image.width() && t.v_active == image.height()) {
+			geometry.frame_width  = t.h_active + t.h_fp + t.h_sync + t.h_bp;
+			geometry.frame_height = t.v_active + t.v_fp + t.v_sync + t.v_bp;
+		}
+	}
+	slab::SimpleLSD    lsd(slab::simple_lsd_params(geometry), threads);
+	slab::LineRecorder recorder(path, image.width(), image.height());
+
+	for (int i=0; i<num; i++) {
+		if (!image.load_pgm(files[i])) break;
+		if (image.width() != geometry.image_width || image.height() != geometry.image_height) {
+			fprintf(stderr, "%s: size mismatch\n", files[i]);
+			break;
+		}
+		lsd.process(image, frame);
+		recorder.push(frame);
+		printf("%s : %u lines, offset %u%s\n", files[i], frame.count, lsd.offset(),
+				lsd.overused() ? " [overused]" : "");
+	}
+	recorder.close();
+	return recorder.error() ? -1 : 0;
+}
+
+/* synthetic scene: gradient background with rotated bars and noise */
+static void synth(slab::GrayImage& image, uint32_t seed) {
+	const uint32_t w = image.width(), h = image.height();
+	uint32_t rand = seed;
+	for (uint32_t v=0; v<h; v++) {
+		uint8_t *row = image.row(v);
+		for (uint32_t u=0; u<w; u++) {
+			uint32_t x = u + seed * 3, y = v + seed;
+			uint32_t val = ((x / 37 + y / 29) & 1) ? 200 : 40;
+			if (((x + 2 * y) / 53) % 3 == 0) val = 120;
+			rand = rand * 1103515245 + 12345;
+			row[u] = val + ((rand >> 16) & 7);
+		}
+	}
+}
+
+/* frames per second for every resolution of timing[] */
+static int bench(uint32_t frames, unsigned threads) {
+	slab::LineFrame frame;
+
+	printf("%-10s %-8s %10s %10s %8s\n", "size", "threads", "scalar", "simd", "lines");
+	for (size_t i=0; i<sizeof(slab::timing)/sizeof(slab::timing[0]); i++) {
+		const slab::timing_t& t = slab::timing[i];
+		slab::FrameGeometry geometry = {t.h_active, t.v_active,
+			(uint32_t)(t.h_active + t.h_fp + t.h_sync + t.h_bp),
+			(uint32_t)(t.v_active + t.v_fp + t.v_sync + t.v_bp)};
+		slab::GrayImage image(t.h_active, t.v_active);
+		synth(image, i);
+
+		slab::SimpleLSD ref(slab::simple_lsd_params(geometry), 1);
+		slab::SimpleLSD lsd(slab::simple_lsd_params(geometry), threads);
+		ref.set_simd(false);
+
+		double fps[2];
+		slab::SimpleLSD *models[2] = {&ref, &lsd};
+		for (int m=0; m<2; m++) {
+			uint64_t start = slab::monotonic_ns();
+			for (uint32_t f=0; f<frames; f++) models[m]->process(image, frame);
+			fps[m] = frames * 1e9 / (slab::monotonic_ns() - start);
+		}
+
+		/* both models have seen the same frames, so the outputs must be equal */
+		const std::vector<slab::SimpleLSDOutput>& a = ref.outputs();
+		const std::vector<slab::SimpleLSDOutput>& b = lsd.outputs();
+		bool ok = a.size() == b.size();
+		for (size_t k=0; ok && k<a.size(); k++) ok = same(a[k], b[k]);
+
+		char size[16];
+		snprintf(size, sizeof(size), "%ux%u", t.h_active, t.v_active);
+		printf("%-10s %-8u %10.1f %10.1f %8u%s\n", size, lsd.threads(), fps[0], fps[1],
+				frame.count, ok ? "" : "  [scalar/simd MISMATCH]");
+		if (!ok) return -1;
+	}
+	return 0;
+}
+
+/* converts PGM files (frames in order) like contrast_stretch of the PL */
+static int stretch(const char *dir, int num, char **files, uint32_t range, bool equalize) {
+	slab::GrayImage in, out;
+
+	if (num < 1 || !in.load_pgm(files[0])) return -1;
+	slab::FrameGeometry geometry = {in.width(), in.height(), in.width(), in.height()};
+	slab::ContrastStretchParams params = slab::contrast_stretch_params(geometry);
+	params.window_range  = range;
+	params.equalize_hist = equalize;
+	slab::ContrastStretch cs(params);
+
+	for (int i=0; i<num; i++) {
+		if (!in.load_pgm(files[i])) return -1;
+		if (in.width() != geometry.image_width || in.height() != geometry.image_height) {
+			fprintf(stderr, "%s: size mismatch\n", files[i]);
+			return -1;
+		}
+		cs.process(in, out);
+		if (!out.save_pgm(corpus_path(dir, i, "pgm"))) return -1;
+		printf("%s : a %3u, b %3u\n", files[i], cs.histogram().a, cs.histogram().b);
+	}
+	return 0;
+}
+
+/* frames per second of contrast_stretch (both modes) */
+static int bench_cs(uint32_t frames, unsigned threads) {
+	static const uint32_t sizes[][2] = {{640, 480}, {1280, 720}, {1920, 1080}};
+
+	/* without a SIMD lookup both columns run the scalar one (threads only) */
+	printf("%-10s %-6s %-8s %10s %10s\n", "size", "mode", "threads", "scalar",
+			slab::ContrastStretch::simd_supported() ? "simd" : "scalar");
+	for (size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+		slab::FrameGeometry geometry = {sizes[i][0], sizes[i][1], sizes[i][0], sizes[i][1]};
+		slab::GrayImage image(sizes[i][0], sizes[i][1]), out[2];
+		synth(image, i);
+
+		for (int eq=0; eq<2; eq++) {
+			slab::ContrastStretchParams params = slab::contrast_stretch_params(geometry);
+			params.equalize_hist = eq;
+			slab::ContrastStretch ref(params, 1);
+			slab::ContrastStretch cs(params, threads);
+			ref.set_simd(false);
+
+			double fps[2];
+			slab::ContrastStretch *models[2] = {&ref, &cs};
+			for (int m=0; m<2; m++) {
+				uint64_t start = slab::monotonic_ns();
+				for (uint32_t f=0; f<frames; f++) models[m]->process(image, out[m]);
+				fps[m] = frames * 1e9 / (slab::monotonic_ns() - start);
+			}
+
+			bool ok = !memcmp(out[0].data(), out[1].data(), (size_t)sizes[i][0] * sizes[i][1]) &&
+				!memcmp(ref.table(), cs.table(), HIST_BINS);
+			char size[16];
+			snprintf(size, sizeof(size), "%ux%u", sizes[i][0], sizes[i][1]);
+			printf("%-10s %-6s %-8u %10.1f %10.1f%s\n", size, eq ? "equal" : "linear",
+					cs.threads(), fps[0], fps[1], ok ? "" : "  [MISMATCH]");
+			if (!ok) return -1;
+		}
+	}
+	return 0;
+}
+
+/* every kernel of rgb2ycbcr against rgb2y/cb/cr() for all 2^24 colors */
+static int verify_ycc() {
+	const uint32_t w = 4099, h = 256; // odd width for the scalar tails
+	std::vector<slab::bgr_t>   in(w * h), work(w * h);
+	std::vector<slab::ycbcr_t> ycc(w * h);
+	std::vector<uint8_t>       y(w * h);
+	slab::RGB2YCbCr conv(w, h);
+	int failed = 0;
+
+	for (int k=slab::RGB2YCBCR_SCALAR; k<=slab::RGB2YCBCR_NEON; k++) {
+		if (!conv.set_kernel((slab::RGB2YCbCrKernel)k)) continue;
+		uint64_t errors = 0;
+		for (uint32_t color=0; color<(1u << 24); color+=w*h) {
+			for (uint32_t i=0; i<w*h; i++) {
+				uint32_t c = (color + i) & 0xffffff;
+				in[i].b = c; in[i].g = c >> 8; in[i].r = c >> 16;
+			}
+			work = in;
+			conv.process(in.data(), w * 3, y.data(), w);
+			conv.process(in.data(), w * 3, ycc.data(), w * 3);
+			conv.process(work.data(), w * 3, (slab::ycbcr_t*)work.data(), w * 3); // in-place
+			for (uint32_t i=0; i<w*h; i++) {
+				const slab::bgr_t& p = in[i];
+				uint8_t ey  = slab::rgb2y (p.r, p.g, p.b);
+				uint8_t ecb = slab::rgb2cb(p.r, p.g, p.b);
+				uint8_t ecr = slab::rgb2cr(p.r, p.g, p.b);
+				if (y[i] != ey || ycc[i].y != ey || ycc[i].cb != ecb || ycc[i].cr != ecr ||
+						work[i].b != ey || work[i].g != ecb || work[i].r != ecr) errors++;
+			}
+		}
+		printf("%-8s : %s (%llu errors)\n", conv.kernel_name(), errors ? "NG" : "ok",
+				(unsigned long long)errors);
+		if (errors) failed++;
+	}
+	return failed ? -1 : 0;
+}
+
+/* megapixels per second of rgb2ycbcr on one core */
+static int bench_ycc(uint32_t frames) {
+	static const uint32_t sizes[][2] = {{640, 480}, {1280, 720}, {1920, 1080}};
+
+	printf("%-10s %-8s %12s %12s\n", "size", "kernel", "Y [Mpix/s]", "YCbCr");
+	for (size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+		const uint32_t w = sizes[i][0], h = sizes[i][1];
+		std::vector<slab::bgr_t>   in(w * h);
+		std::vector<slab::ycbcr_t> ycc(w * h);
+		slab::GrayImage            y;
+		slab::RGB2YCbCr            conv(w, h, 1);
+		for (uint32_t k=0; k<w*h; k++) {
+			in[k].b = k; in[k].g = k >> 3; in[k].r = k >> 7;
+		}
+
+		for (int k=slab::RGB2YCBCR_SCALAR; k<=slab::RGB2YCBCR_NEON; k++) {
+			if (!conv.set_kernel((slab::RGB2YCbCrKernel)k)) continue;
+			double mpix[2];
+			for (int m=0; m<2; m++) {
+				uint64_t start = slab::monotonic_ns();
+				for (uint32_t f=0; f<frames; f++) {
+					if (m == 0) conv.process(in.data(), w * 3, y);
+					else        conv.process(in.data(), w * 3, ycc.data(), w * 3);
+				}
+				mpix[m] = (double)frames * w * h * 1e3 / (slab::monotonic_ns() - start);
+			}
+			char size[16];
+			snprintf(size, sizeof(size), "%ux%u", w, h);
+			printf("%-10s %-8s %12.1f %12.1f\n", size, conv.kernel_name(), mpix[0], mpix[1]);
+		}
+	}
+	return 0;
+}
+
+/* gaussian of simple_lsd as a conv_layer_fixed (IN = OUT = 9 bits, WGT_FRAC_BITW = 4) */
+static slab::ConvLayerParams gaussian_layer() {
+	static const double g[9] = {1, 2, 1, 2, 4, 2, 1, 2, 1};
+	slab::ConvLayerParams p = slab::conv_layer_params(9, 9);
+	p.wgt_frac_bitw = 4;
+	p.flt_size      = 3;
+	p.weights.assign(9, 0.0);
+	for (int i=0; i<9; i++) p.weights[i] = g[i] / 16.0;
+	return p;
+}
+
+/* random layer with <in_chs>/<in_bitw> of the previous one */
+static slab::ConvLayerParams random_layer(uint32_t& rand, uint32_t in_chs, uint32_t in_bitw, bool last) {
+	static const uint32_t chs[] = {1, 3, 4, 5, 8, 16}, flts[] = {1, 3, 5, 2};
+	static const uint32_t bitws[] = {8, 9, 12, 16, 20};
+#define RAND(n) ((rand = rand * 1103515245 + 12345), (rand >> 16) % (n))
+	uint32_t out_bitw = last ? 16 : bitws[RAND(5)];
+	slab::ConvLayerParams p = slab::conv_layer_params(in_bitw, out_bitw);
+	p.in_chs        = in_chs;
+	p.out_chs       = chs[RAND(6)];
+	p.flt_size      = flts[RAND(4)];
+	p.in_frac_bitw  = RAND(5);
+	p.wgt_frac_bitw = RAND(2) ? 6 : 12;
+	p.out_frac_bitw = RAND(p.in_frac_bitw + 2);
+	p.lrelu_slope   = RAND(2) ? -1 : (int32_t)RAND(16);
+	p.batch_norm    = RAND(2);
+	p.residual      = RAND(2);
+	p.weights.resize(p.out_chs * p.in_chs * p.flt_size * p.flt_size);
+	for (size_t i=0; i<p.weights.size(); i++)
+		p.weights[i] = ((double)RAND(2001) - 1000.0) / ((p.wgt_frac_bitw > 6) ? 8000.0 :
+				(in_bitw <= 8) ? 1000.0 : 500.0); // int8 kernels for 8-bit inputs
+	p.biases.resize(p.out_chs);
+	for (uint32_t i=0; i<p.out_chs; i++) {
+		p.biases[i] = ((double)RAND(201) - 100.0) / 10.0;
+		if (p.batch_norm) {
+			p.avg_means.push_back(((double)RAND(201) - 100.0) / 20.0);
+			p.avg_vars .push_back((double)RAND(100) / 10.0 + 0.01);
+			p.gammas   .push_back(((double)RAND(201) - 100.0) / 50.0);
+			p.betas    .push_back(((double)RAND(201) - 100.0) / 20.0);
+		}
+	}
+#undef RAND
+	return p;
+}
+
+static int verify_cnn(unsigned threads) {
+	const uint32_t w = 67, h = 41;
+	slab::GrayImage image(w, h);
+	std::vector<int32_t> out;
+	int failed = 0;
+
+	/* [1] gaussian: (sum + 8) >> 4 with replicated edges */
+	synth(image, 7);
+	slab::ConvNet gauss(w, h, threads);
+	gauss.add_layer(gaussian_layer());
+	for (int simd=0; simd<2; simd++) {
+		uint64_t errors = 0;
+		gauss.set_simd(simd);
+		gauss.process(image, out);
+		for (int32_t v=0; v<(int32_t)h; v++) {
+			for (int32_t u=0; u<(int32_t)w; u++) {
+				static const int g[9] = {1, 2, 1, 2, 4, 2, 1, 2, 1};
+				int sum = 0;
+				for (int k=0; k<9; k++) {
+					int32_t y = std::min(std::max(v + k / 3 - 1, 0), (int32_t)h - 1);
+					int32_t x = std::min(std::max(u + k % 3 - 1, 0), (int32_t)w - 1);
+					sum += g[k] * image.row(y)[x];
+				}
+				if (out[v * w + u] != (sum + 8) >> 4) errors++;
+			}
+		}
+		printf("gaussian %-6s : %s (%llu errors)\n", simd ? "simd" : "scalar",
+				errors ? "NG" : "ok", (unsigned long long)errors);
+		if (errors) failed++;
+	}
+
+	/* [2] random networks: SIMD, tiles and threads against scalar whole frame */
+	uint32_t rand = 1;
+	for (int n=0; n<40; n++) {
+		slab::ConvNet ref(w, h, 1), net(w, h, threads);
+		uint32_t chs = 1, bitw = (n % 3) ? 9 : 8, depth = 1 + n % 4;
+		for (uint32_t i=0; i<depth; i++) {
+			slab::ConvLayerParams p = random_layer(rand, chs, bitw, i + 1 == depth);
+			if (!ref.add_layer(p) || !net.add_layer(p)) return -1;
+			chs  = p.out_chs;
+			bitw = p.out_bitw;
+		}
+		std::vector<int32_t> in(w * h), a(w * h * chs), b(w * h * chs);
+		for (uint32_t i=0; i<w*h; i++) {
+			rand = rand * 1103515245 + 12345;
+			in[i] = (int32_t)(rand >> 8) >> (n % 2 ? 23 : 15); // also out of IN_BITW
+		}
+		ref.set_simd(false);
+		ref.set_tile_rows(0);
+		ref.process(in.data(), a.data());
+		net.set_tile_rows(1 + n % 7);
+		net.process(in.data(), b.data());
+
+		uint64_t errors = 0;
+		for (size_t i=0; i<a.size(); i++) if (a[i] != b[i]) errors++;
+		printf("network %2d (%u layers, simd", n, depth);
+		for (uint32_t i=0; i<depth; i++) printf(" %d", net.layer(i).simd);
+		printf(") : %s (%llu errors)\n", errors ? "NG" : "ok", (unsigned long long)errors);
+		if (errors) failed++;
+	}
+	return failed ? -1 : 0;
+}
+
+/* frames per second of a small network, and milliseconds per layer */
+static int bench_cnn(uint32_t frames, unsigned threads) {
+	const uint32_t w = 640, h = 480;
+	const uint32_t chs[] = {1, 8, 8, 1};
+	slab::ConvNet net(w, h, threads);
+	slab::GrayImage image(w, h);
+	std::vector<int32_t> out;
+	uint32_t rand = 3;
+
+	for (int i=0; i<3; i++) {
+		slab::ConvLayerParams p = slab::conv_layer_params(i ? 16 : 9, 16);
+		p.in_chs        = chs[i];
+		p.out_chs       = chs[i + 1];
+		p.flt_size      = 3;
+		p.in_frac_bitw  = i ? 6 : 0;
+		p.wgt_frac_bitw = 8;
+		p.out_frac_bitw = 6;
+		p.lrelu_slope   = (i < 2) ? 1 : -1;
+		p.batch_norm    = (i == 1);
+		p.weights.resize(p.out_chs * p.in_chs * 9);
+		for (size_t k=0; k<p.weights.size(); k++) {
+			rand = rand * 1103515245 + 12345;
+			p.weights[k] = (((rand >> 16) % 201) - 100.0) / 400.0;
+		}
+		p.biases.assign(p.out_chs, 0.5);
+		if (p.batch_norm) {
+			p.avg_means.assign(p.out_chs, 1.0);
+			p.avg_vars .assign(p.out_chs, 2.0);
+			p.gammas   .assign(p.out_chs, 1.5);
+			p.betas    .assign(p.out_chs, 0.25);
+		}
+		net.add_layer(p);
+	}
+	synth(image, 1);
+
+	printf("%ux%u, 3x3 convolutions 1-8-8-1, %u threads\n", w, h, net.threads());
+	printf("%-16s %10s\n", "", "fps");
+	for (int m=0; m<3; m++) {
+		net.set_simd(m != 0);
+		net.set_tile_rows((m == 2) ? 0 : 16);
+		uint64_t start = slab::monotonic_ns();
+		for (uint32_t f=0; f<frames; f++) net.process(image, out);
+		printf("%-16s %10.2f\n", (m == 0) ? "scalar, tiles" : (m == 1) ? "simd, tiles" : "simd, frame",
+				frames * 1e9 / (slab::monotonic_ns() - start));
+	}
+
+	/* per layer (e.g. which layers to keep on the PS) */
+	std::vector<int32_t> in(image.data(), image.data() + w * h), tmp[2];
+	net.set_simd(true);
+	net.set_tile_rows(16);
+	for (size_t i=0; i<net.layers(); i++) {
+		const slab::ConvLayerParams& p = net.layer(i).params;
+		const std::vector<int32_t>& src = i ? tmp[(i - 1) & 1] : in;
+		tmp[i & 1].resize(w * h * p.out_chs);
+		uint64_t start = slab::monotonic_ns();
+		for (uint32_t f=0; f<frames; f++) net.process(src.data(), tmp[i & 1].data(), i, i + 1);
+		printf("layer %zu (%ux%u, %2u -> %2u ch, simd %2d) : %8.3f ms\n", i, p.flt_size, p.flt_size,
+				p.in_chs, p.out_chs, net.layer(i).simd, (slab::monotonic_ns() - start) / 1e6 / frames);
+	}
+	return 0;
+}
+
+/* kernels of the stream_patch examples */
+struct Gauss3 {
+	typedef uint8_t in_type, out_type;
+	static const uint32_t PATCH_HEIGHT = 3, PATCH_WIDTH = 3;
+	uint8_t operator()(const slab::Patch<uint8_t, 3, 3>& p) const {
+		return (p(0, 0) + 2 * p(0, 1) + p(0, 2) + 2 * p(1, 0) + 4 * p(1, 1) + 2 * p(1, 2) +
+				p(2, 0) + 2 * p(2, 1) + p(2, 2) + 8) >> 4;
+	}
+};
+struct Sobel3 {
+	typedef uint8_t in_type;
+	typedef uint16_t out_type;
+	static const uint32_t PATCH_HEIGHT = 3, PATCH_WIDTH = 3;
+	uint16_t operator()(const slab::Patch<uint8_t, 3, 3>& p) const {
+		int gx = (p(0, 2) + 2 * p(1, 2) + p(2, 2)) - (p(0, 0) + 2 * p(1, 0) + p(2, 0));
+		int gy = (p(2, 0) + 2 * p(2, 1) + p(2, 2)) - (p(0, 0) + 2 * p(0, 1) + p(0, 2));
+		return abs(gx) + abs(gy);
+	}
+};
+struct Sum2x5 {
+	typedef uint16_t in_type;
+	typedef uint32_t out_type;
+	static const uint32_t PATCH_HEIGHT = 2, PATCH_WIDTH = 5;
+	uint32_t operator()(const slab::Patch<uint16_t, 2, 5>& p) const {
+		uint32_t sum = 0;
+		for (uint32_t v=0; v<2; v++) for (uint32_t h=0; h<5; h++) sum += p(v, h) * (v * 5 + h + 1);
+		return sum;
+	}
+};
+
+/* full-frame stage with the border rules of stream_patch.sv (reference) */
+template <class K, uint32_t CV, uint32_t CH, int PADDING>
+static std::vector<typename K::out_type> frame_stage(const std::vector<typename K::in_type>& in,
+		uint32_t w, uint32_t h) {
+	typedef typename K::in_type T;
+	const uint32_t PH = K::PATCH_HEIGHT, PW = K::PATCH_WIDTH;
+	std::vector<typename K::out_type> out(w * h);
+	std::vector<T> patch(PH * (w + PW - 1));
+	std::vector<const T*> rows(PH);
+	K kernel;
+	for (uint32_t y=0; y<h; y++) {
+		for (uint32_t v=0; v<PH; v++) {
+			for (int64_t x=0; x<(int64_t)(w + PW - 1); x++) {
+				int64_t yy = (int64_t)y - CV + v, xx = x - CH;
+				bool    out_of = yy < 0 || yy >= h || xx < 0 || xx >= w;
+				yy = std::min<int64_t>(std::max<int64_t>(yy, 0), h - 1);
+				xx = std::min<int64_t>(std::max<int64_t>(xx, 0), w - 1);
+				patch[v * (w + PW - 1) + x] = (PADDING == 0 && out_of) ? 0 : in[yy * w + xx];
+			}
+			rows[v] = &patch[v * (w + PW - 1)];
+		}
+		for (uint32_t x=0; x<w; x++) out[y * w + x] = kernel(slab::Patch<T, K::PATCH_HEIGHT, K::PATCH_WIDTH>(rows.data(), x));
+	}
+	return out;
+}
+
+static int verify_patch() {
+	static const uint32_t sizes[][2] = {{67, 41}, {1, 1}, {5, 2}, {2, 7}, {640, 3}};
+	int failed = 0;
+
+	for (size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+		const uint32_t w = sizes[i][0], h = sizes[i][1];
+		slab::GrayImage image(w, h);
+		synth(image, i + 1);
+		std::vector<uint8_t> in(image.data(), image.data() + w * h);
+
+		/* [1] gaussian against conv_net (conv_layer_fixed) */
+		slab::ConvNet net(w, h, 1);
+		std::vector<int32_t> ref;
+		std::vector<uint8_t> g(w * h);
+		net.add_layer(gaussian_layer());
+		net.process(image, ref);
+		auto gauss = slab::stream_pipeline(w, h, slab::PatchStage<Gauss3>());
+		gauss.process(in.data(), w, g.data(), w);
+		uint64_t errors = 0;
+		for (uint32_t k=0; k<w*h; k++) if (g[k] != ref[k]) errors++;
+
+		/* [2] gaussian -> sobel -> 2x5 (CENTER = (0, 4), PADDING = 0) against full frames */
+		std::vector<uint32_t> out(w * h), expected = frame_stage<Sum2x5, 0, 4, 0>(
+				frame_stage<Sobel3, 1, 1, 1>(frame_stage<Gauss3, 1, 1, 1>(in, w, h), w, h), w, h);
+		auto chain = slab::stream_pipeline(w, h, slab::PatchStage<Gauss3>(), slab::PatchStage<Sobel3>(),
+				slab::PatchStage<Sum2x5, 0, 4, 0>());
+		for (int n=0; n<2; n++) { // twice (reset between frames)
+			chain.process(in.data(), w, out.data(), w * sizeof(uint32_t));
+			for (uint32_t k=0; k<w*h; k++) if (out[k] != expected[k]) errors++;
+		}
+		printf("%4ux%-4u : %s (%llu errors)\n", w, h, errors ? "NG" : "ok", (unsigned long long)errors);
+		if (errors) failed++;
+	}
+	return failed ? -1 : 0;
+}
+
+/* gaussian -> sobel -> 2x5 with full-frame temporaries and streamed */
+static int bench_patch(uint32_t frames) {
+	const uint32_t w = 640, h = 480;
+	slab::GrayImage image(w, h);
+	std::vector<uint8_t>  in;
+	std::vector<uint32_t> out(w * h);
+	synth(image, 1);
+	in.assign(image.data(), image.data() + w * h);
+	auto chain = slab::stream_pipeline(w, h, slab::PatchStage<Gauss3>(), slab::PatchStage<Sobel3>(),
+			slab::PatchStage<Sum2x5, 0, 4, 0>());
+
+	printf("%ux%u, gaussian -> sobel -> 2x5\n", w, h);
+	for (int m=0; m<2; m++) {
+		uint64_t start = slab::monotonic_ns();
+		for (uint32_t f=0; f<frames; f++) {
+			if (m == 0) out = frame_stage<Sum2x5, 0, 4, 0>(frame_stage<Sobel3, 1, 1, 1>(
+						frame_stage<Gauss3, 1, 1, 1>(in, w, h), w, h), w, h);
+			else chain.process(in.data(), w, out.data(), w * sizeof(uint32_t));
+		}
+		printf("%-12s : %8.3f ms\n", m ? "streamed" : "full frames", (slab::monotonic_ns() - start) / 1e6 / frames);
+	}
+	return 0;
+}
+
+/* fixed_math batches against the scalar models, and the models against libm */
+static int verify_math() {
+	static const uint32_t atan_bitw[][2] = {{9, 8}, {6, 8}, {12, 10}, {16, 12}};
+	static const uint32_t sin_bitw[][2]  = {{8, 12}, {12, 12}, {16, 16}, {5, 6}};
+	static const uint32_t div_bitw[][2]  = {{11, 8}, {8, 8}, {16, 8}, {20, 11}};
+	const size_t n = 1 << 18;
+	uint32_t rand = 1;
+	int failed = 0;
+
+	for (size_t i=0; i<sizeof(atan_bitw)/sizeof(atan_bitw[0]); i++) {
+		slab::ArctanCalc arctan(atan_bitw[i][0], atan_bitw[i][1]);
+		const uint32_t ib = arctan.in_bitw(), ob = arctan.out_bitw();
+		const size_t   m  = (2 * ib <= 18) ? (size_t)1 << (2 * ib) : n; // exhaustive or random
+		std::vector<int16_t>  y(m), x(m);
+		std::vector<uint16_t> out(m);
+		for (size_t k=0; k<m; k++) {
+			if (2 * ib <= 18) {
+				y[k] = (int16_t)(k >> ib) - (1 << (ib - 1));
+				x[k] = (int16_t)(k & ((1 << ib) - 1)) - (1 << (ib - 1));
+			}
+			else {
+				rand = rand * 1103515245 + 12345;
+				y[k] = (int16_t)(rand >> 8) >> (16 - ib);
+				x[k] = (int16_t)(rand >> 16) >> (16 - ib);
+			}
+		}
+		arctan.process(y.data(), x.data(), out.data(), m);
+		uint64_t errors = 0;
+		double   max_err = 0;
+		for (size_t k=0; k<m; k++) {
+			if (out[k] != arctan(y[k], x[k])) errors++;
+			if (y[k] == 0 && x[k] == 0) continue;
+			double e = atan2((double)y[k], (double)x[k]) / (2 * M_PI) * (1 << ob);
+			double d = fabs(fmod(out[k] - e + 1.5 * (1 << ob), (double)(1 << ob)) - 0.5 * (1 << ob));
+			max_err = std::max(max_err, d);
+		}
+		printf("arctan_calc    (%2u, %2u) : %s (%llu errors), max %.2f LSB from atan2\n", ib, ob,
+				errors ? "NG" : "ok", (unsigned long long)errors, max_err);
+		if (errors) failed++;
+	}
+
+	for (size_t i=0; i<sizeof(sin_bitw)/sizeof(sin_bitw[0]); i++) {
+		slab::SinCalc sine(sin_bitw[i][0], sin_bitw[i][1]);
+		const uint32_t ib = sine.in_bitw(), ob = sine.out_bitw();
+		std::vector<uint16_t> phase(1 << ib);
+		std::vector<int16_t>  out(1 << ib);
+		for (uint32_t k=0; k<phase.size(); k++) phase[k] = k;
+		sine.process(phase.data(), out.data(), phase.size());
+		uint64_t errors = 0;
+		double   max_err = 0;
+		for (uint32_t k=0; k<phase.size(); k++) {
+			if (out[k] != sine(k)) errors++;
+			max_err = std::max(max_err, fabs(out[k] - sin(2 * M_PI * k / (1 << ib)) * (1 << (ob - 2))));
+		}
+		printf("sin_calc       (%2u, %2u) : %s (%llu errors), max %.2f LSB from sin\n", ib, ob,
+				errors ? "NG" : "ok", (unsigned long long)errors, max_err);
+		if (errors) failed++;
+	}
+
+	for (size_t i=0; i<sizeof(div_bitw)/sizeof(div_bitw[0]); i++) {
+		slab::DividerIterS div(div_bitw[i][0], div_bitw[i][1]);
+		const uint32_t bw = div.bit_width();
+		std::vector<int32_t> a(n), b(n), q(n), r(n);
+		for (size_t k=0; k<n; k++) {
+			rand = rand * 1103515245 + 12345; a[k] = (int32_t)rand >> (32 - bw);
+			rand = rand * 1103515245 + 12345; b[k] = (int32_t)rand >> (32 - bw + (rand & 7));
+		}
+		div.process(a.data(), b.data(), q.data(), r.data(), n);
+		uint64_t errors = 0, wrong = 0;
+		for (size_t k=0; k<n; k++) {
+			int64_t eq, er;
+			div(a[k], b[k], eq, er);
+			if (q[k] != eq || r[k] != er) errors++;
+			if (b[k] != 0 && eq != ((int64_t)a[k] * (1LL << div.out_frac_bitw())) / b[k]) wrong++;
+		}
+		printf("divider_iter_s (%2u, %2u) : %s (%llu errors), %llu quotients differ from /\n", bw,
+				div.out_frac_bitw(), errors ? "NG" : "ok", (unsigned long long)errors, (unsigned long long)wrong);
+		if (errors) failed++;
+	}
+	return failed ? -1 : 0;
+}
+
+/* million elements per second of fixed_math and of libm / float division */
+static int bench_math(uint32_t rounds) {
+	const size_t n = 1 << 16;
+	std::vector<int16_t>  y(n), x(n), s(n);
+	std::vector<uint16_t> phase(n), angle(n);
+	std::vector<int32_t>  a(n), b(n), q(n), r(n);
+	std::vector<float>    f(n);
+	uint32_t rand = 1;
+	for (size_t k=0; k<n; k++) {
+		rand = rand * 1103515245 + 12345;
+		y[k] = (int16_t)(rand >> 8) >> 7; x[k] = (int16_t)(rand >> 16) >> 7; phase[k] = rand >> 20;
+		a[k] = (int32_t)rand >> 21; b[k] = ((int32_t)(rand << 11) >> 21) | 1;
+	}
+	slab::ArctanCalc   arctan;
+	slab::SinCalc      sine;
+	slab::DividerIterS div(11, 8);
+	volatile float     sink = 0;
+
+	printf("%-16s %12s %12s %12s\n", "Melem/s", "scalar", "SIMD", "libm/float");
+	for (int t=0; t<3; t++) {
+		double melem[3];
+		for (int m=0; m<3; m++) {
+			arctan.set_simd(m == 1); sine.set_simd(m == 1); div.set_simd(m == 1);
+			uint64_t start = slab::monotonic_ns();
+			for (uint32_t i=0; i<rounds; i++) {
+				if (m < 2) {
+					if      (t == 0) arctan.process(y.data(), x.data(), angle.data(), n);
+					else if (t == 1) sine.process(phase.data(), s.data(), n);
+					else             div.process(a.data(), b.data(), q.data(), r.data(), n);
+				}
+				else {
+					for (size_t k=0; k<n; k++) {
+						if      (t == 0) f[k] = atan2f(y[k], x[k]);
+						else if (t == 1) f[k] = sinf(phase[k] * (float)(2 * M_PI / 4096));
+						else             f[k] = (float)a[k] / b[k];
+					}
+					sink = sink + f[n - 1];
+				}
+			}
+			melem[m] = (double)rounds * n * 1e3 / (slab::monotonic_ns() - start);
+		}
+		static const char *name[3] = {"arctan_calc", "sin_calc", "divider_iter_s"};
+		printf("%-16s %12.1f %12.1f %12.1f\n", name[t], melem[0], melem[1], melem[2]);
+	}
+	return 0;
+}
+
+/* synthetic color scene (the gray scene of synth() with tinted bars) */
+static void synth_bgr(std::vector<slab::bgr_t>& image, uint32_t w, uint32_t h, uint32_t seed) {
+	slab::GrayImage gray(w, h);
+	synth(gray, seed);
+	image.resize((size_t)w * h);
+	for (uint32_t k=0; k<w*h; k++) {
+		const uint8_t y = gray.data()[k];
+		image[k].b = y;
+		image[k].g = (y > 100) ? y - 30 : y + 10;
+		image[k].r = y ^ (k & 0x1f);
+	}
+}
+
+/* image_processor in every mode against the stages run one by one */
+static int verify_ip() {
+	static const uint32_t sizes[][2] = {{640, 480}, {97, 61}};
+	int failed = 0;
+
+	for (size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+		const uint32_t w = sizes[i][0], h = sizes[i][1];
+		slab::FrameGeometry  g = {w, h, w + 160, h + 45};
+		slab::ImageProcessor ip(slab::image_processor_params(g), 3);
+		slab::RGB2YCbCr       gray(w, h, 1);
+		slab::ContrastStretch stretch(ip.params().stretch, 1);
+		slab::SimpleLSD       lsd(ip.params().lsd, 1);
+		slab::LineFrame       frame;
+		std::vector<slab::bgr_t> in, out(w * h);
+		std::vector<uint8_t>     y(w * h), cs(w * h);
+		uint64_t errors = 0;
+
+		for (uint32_t f=0; f<16; f++) {
+			const uint32_t mode = f % 4;
+			ip.set_mode(mode);
+			ip.set_simd(f & 4);
+			ip.set_threads(1 + f % 3);
+			synth_bgr(in, w, h, f / 2);
+			const bool in_place = (f & 8);
+			if (in_place) out = in;
+			ip.process(in_place ? out.data() : in.data(), w * 3, out.data(), w * 3);
+
+			if (mode != slab::IMGPROC_PASSTHROUGH) {
+				gray.process(in.data(), w * 3, y.data(), w);
+				stretch.process(y.data(), w, cs.data(), w);
+			}
+			for (uint32_t k=0; k<w*h; k++) {
+				const slab::bgr_t& p = out[k];
+				switch (mode) {
+					case slab::IMGPROC_PASSTHROUGH:
+						if (memcmp(&p, &in[k], sizeof(p))) errors++;
+						break;
+					case slab::IMGPROC_GRAY:
+						if (p.b != y[k] || p.g != y[k] || p.r != y[k]) errors++;
+						break;
+					case slab::IMGPROC_STRETCH:
+						if (p.b != cs[k] || p.g != cs[k] || p.r != cs[k]) errors++;
+						break;
+				}
+			}
+			if (mode == slab::IMGPROC_LSD) {
+				lsd.process(cs.data(), w, frame);
+				const std::vector<slab::SimpleLSDOutput>& a = ip.lsd().outputs();
+				const std::vector<slab::SimpleLSDOutput>& b = lsd.outputs();
+				if (a.size() != b.size()) errors++;
+				for (size_t k=0; k<std::min(a.size(), b.size()); k++) if (!same(a[k], b[k])) errors++;
+				/* lines of the previous LSD frame were cleared by set_mode(): black and the bar */
+				for (uint32_t v=0; v<h; v++) {
+					for (uint32_t u=0; u<w; u++) {
+						const slab::bgr_t& p = out[v * w + u];
+						if ((v < 20 || v >= 40) && (p.b | p.g | p.r)) errors++;
+					}
+				}
+			}
+		}
+
+		/* the segments of one frame are drawn on the next (the left or upper end exactly) */
+		std::vector<slab::SimpleLSDOutput> prev;
+		uint64_t drawn = 0;
+		ip.set_mode(slab::IMGPROC_LSD);
+		for (uint32_t f=0; f<3; f++) {
+			synth_bgr(in, w, h, f);
+			ip.process(in.data(), w * 3, out.data(), w * 3);
+			for (size_t k=0; k<prev.size(); k++) {
+				const slab::SimpleLSDOutput& o = prev[k];
+				if (!o.valid) continue;
+				bool     swap = abs(o.start_v - o.end_v) > abs(o.start_h - o.end_h);
+				bool     end  = swap ? (o.end_v < o.start_v) : (o.end_h < o.start_h);
+				uint32_t v = end ? o.end_v : o.start_v, u = end ? o.end_h : o.start_h;
+				if (v >= 19 && v <= 40) continue; // memory bar
+				if (out[v * w + u].g != 255) errors++;
+				drawn++;
+			}
+			prev = ip.lsd().outputs();
+		}
+		printf("%4ux%-4u : %s (%llu errors, %llu lines drawn)\n", w, h, errors ? "NG" : "ok",
+				(unsigned long long)errors, (unsigned long long)drawn);
+		if (errors) failed++;
+	}
+	return failed ? -1 : 0;
+}
+
+/* frames per second of image_processor in every mode */
+static int bench_ip(uint32_t frames, unsigned threads) {
+	static const uint32_t sizes[][2] = {{640, 480}, {1280, 720}};
+	static const char *names[] = {"passthrough", "gray", "stretch", "lsd"};
+
+	printf("%-10s %-8s %12s %12s %12s %12s\n", "size", "threads",
+			names[0], names[1], names[2], names[3]);
+	for (size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++) {
+		const uint32_t w = sizes[i][0], h = sizes[i][1];
+		slab::FrameGeometry  g = {w, h, w + 160, h + 45};
+		slab::ImageProcessor ip(slab::image_processor_params(g), threads);
+		std::vector<slab::bgr_t> in, out(w * h);
+		synth_bgr(in, w, h, 1);
+
+		double fps[4];
+		for (uint32_t m=0; m<4; m++) {
+			ip.set_mode(m);
+			ip.process(in.data(), w * 3, out.data(), w * 3);
+			uint64_t start = slab::monotonic_ns();
+			for (uint32_t f=0; f<frames; f++) ip.process(in.data(), w * 3, out.data(), w * 3);
+			fps[m] = frames * 1e9 / (slab::monotonic_ns() - start);
+		}
+		char size[16];
+		snprintf(size, sizeof(size), "%ux%u", w, h);
+		printf("%-10s %-8u %12.1f %12.1f %12.1f %12.1f\n", size, ip.threads(), fps[0], fps[1], fps[2], fps[3]);
+	}
+	return 0;
+}
+
+/* geometry of <width> x <height> in timing[] */
+static bool find_geometry(uint32_t width, uint32_t height, slab::FrameGeometry& geometry) {
+	for (size_t i=0; i<sizeof(slab::timing)/sizeof(slab::timing[0]); i++) {
+		const slab::timing_t& t = slab::timing[i];
+		if (t.h_active == width && t.v_active == height) {
+			geometry.image_width  = width;
+			geometry.image_height = height;
+			geometry.frame_width  = t.h_active + t.h_fp + t.h_sync + t.h_bp;
+			geometry.frame_height = t.v_active + t.v_fp + t.v_sync + t.v_bp;
+			return true;
+		}
+	}
+	fprintf(stderr, "%ux%u: not in timing[]\n", width, height);
+	return false;
+}
+
+/* comma separated values ("16,20,24") */
+template <typename T>
+static std::vector<T> parse_list(const char *arg) {
+	std::vector<T> values;
+	for (const char *p = arg; *p; ) {
+		values.push_back((T)strtoul(p, (char**)&p, 0));
+		if (*p == ',') p++;
+		else break;
+	}
+	return values;
+}
+
+/* parameter sweep of simple_lsd over a corpus (<dir>/NNNN.pgm) */
+static int sweep(const char *dir, int argc, char **argv, unsigned threads) {
+	slab::LSDFrameCache cache;
+	std::vector<std::string> paths;
+	FILE *fp;
+
+	for (uint32_t i=0; (fp = fopen(corpus_path(dir, i, "pgm").c_str(), "r")) != NULL; i++) {
+		fclose(fp);
+		paths.push_back(corpus_path(dir, i, "pgm"));
+	}
+	if (paths.empty()) {
+		fprintf(stderr, "%s: no frames\n", dir);
+		return -1;
+	}
+
+	/* defaults: the parameters of vdma_top at the size of the corpus */
+	slab::FrameGeometry geometry;
+	slab::SimpleLSDParams defaults;
+	{
+		slab::GrayImage image;
+		if (!image.load_pgm(paths[0]) || !find_geometry(image.width(), image.height(), geometry)) return -1;
+		defaults = slab::simple_lsd_params(geometry);
+	}
+	std::vector<uint8_t>  angle(1, defaults.thres.angle), grad(1, defaults.thres.grad), length(1, defaults.thres.length);
+	std::vector<uint32_t> ram_size(1, defaults.ram_size);
+	std::vector<slab::FrameGeometry> sizes(1, geometry);
+	const char *csv = NULL;
+	bool manual = false;
+	for (int i=0; i<argc; i++) {
+		bool value = (i + 1 < argc);
+		if      (value && !strcmp(argv[i], "-a")) angle    = parse_list<uint8_t >(argv[++i]);
+		else if (value && !strcmp(argv[i], "-g")) grad     = parse_list<uint8_t >(argv[++i]);
+		else if (value && !strcmp(argv[i], "-l")) length   = parse_list<uint8_t >(argv[++i]);
+		else if (value && !strcmp(argv[i], "-r")) ram_size = parse_list<uint32_t>(argv[++i]);
+		else if (value && !strcmp(argv[i], "-t")) threads  = atoi(argv[++i]);
+		else if (value && !strcmp(argv[i], "-c")) csv      = argv[++i];
+		else if (value && !strcmp(argv[i], "-s")) {
+			sizes.clear();
+			for (const char *p = argv[++i]; *p; ) {
+				char *q;
+				uint32_t w = strtoul(p, &q, 10), h = (*q == 'x') ? strtoul(q + 1, &q, 10) : 0;
+				if (!find_geometry(w, h, geometry)) return -1;
+				sizes.push_back(geometry);
+				p = (*q == ',') ? q + 1 : q;
+				if (*q != ',') break;
+			}
+		}
+		else if (!strcmp(argv[i], "-m")) manual = true;
+		else {
+			fprintf(stderr, "%s: unknown option\n", argv[i]);
+			return -1;
+		}
+	}
+
+	uint64_t start = slab::monotonic_ns();
+	if (!cache.load(paths, threads)) return -1;
+	printf("%zu frames of %ux%u decoded in %.1f ms\n", cache.size(), cache.width(), cache.height(),
+			(slab::monotonic_ns() - start) / 1e6);
+
+	slab::LSDSweep lsd_sweep(cache, threads);
+	lsd_sweep.set_auto_offset(!manual);
+	lsd_sweep.add_grid(sizes, angle, grad, length, ram_size);
+	start = slab::monotonic_ns();
+	lsd_sweep.run();
+	lsd_sweep.print(stdout);
+	printf("%zu points in %.1f s (%u threads)\n", lsd_sweep.points(), (slab::monotonic_ns() - start) / 1e9,
+			(threads > 0) ? threads : std::thread::hardware_concurrency());
+	if (csv != NULL) {
+		if ((fp = fopen(csv, "w")) == NULL) {
+			perror(csv);
+			return -1;
+		}
+		lsd_sweep.print(fp, true);
+		fclose(fp);
+	}
+	return 0;
+}
+
+static void usage(const char *name) {
+	printf("usage:\n");
+	printf("  %s verify <dir> [threads]          : compare with HDL simulation outputs\n", name);
+	printf("  %s run <file> <pgm> ... [-t threads] : run the model and record line frames\n", name);
+	printf("  %s bench [frames] [threads]        : frames per second for timing[]\n", name);
+	printf("  %s stretch <dir> <pgm> ... [-w range] [-e] : contrast_stretch of frames\n", name);
+	printf("  %s bench-cs [frames] [threads]     : frames per second of contrast_stretch\n", name);
+	printf("  %s verify-ycc                      : rgb2ycbcr kernels for all colors\n", name);
+	printf("  %s bench-ycc [frames]              : rgb2ycbcr throughput per core\n", name);
+	printf("  %s verify-cnn [threads]            : conv_net kernels against scalar\n", name);
+	printf("  %s bench-cnn [frames] [threads]    : frames per second of conv_net\n", name);
+	printf("  %s verify-patch                    : stream_patch pipelines against full frames\n", name);
+	printf("  %s bench-patch [frames]            : full frames and streamed pipeline\n", name);
+	printf("  %s verify-math                     : fixed_math batches against scalar\n", name);
+	printf("  %s bench-math [rounds]             : Melem/s of fixed_math and libm\n", name);
+	printf("  %s verify-ip                       : image_processor against the stages\n", name);
+	printf("  %s bench-ip [frames] [threads]     : frames per second of image_processor\n", name);
+	printf("  %s sweep <dir> [-a list] [-g list] [-l list] [-r list] [-s WxH,...] [-m] [-t threads] [-c csv]\n", name);
+	printf("      : simple_lsd over the corpus for every combination (angle, grad, length, ram_size, size)\n");
+}
+
+int main(int argc, char **argv) {
+	unsigned threads = std::thread::hardware_concurrency();
+
+	if (argc >= 3 && !strcmp(argv[1], "verify")) {
+		if (argc >= 4) threads = atoi(argv[3]);
+		return verify(argv[2], threads);
+	}
+	if (argc >= 4 && !strcmp(argv[1], "run")) {
+		int num = argc - 3;
+		if (num >= 3 && !strcmp(argv[argc - 2], "-t")) {
+			threads = atoi(argv[argc - 1]);
+			num -= 2;
+		}
+		return run(argv[2], num, argv + 3, threads);
+	}
+	if (argc >= 2 && !strcmp(argv[1], "bench")) {
+		uint32_t frames = (argc >= 3) ? atoi(argv[2]) : 30;
+		if (argc >= 4) threads = atoi(argv[3]);
+		return bench(frames, threads);
+	}
+	if (argc >= 4 && !strcmp(argv[1], "stretch")) {
+		uint32_t range = 90;
+		bool     equalize = false;
+		int      num = argc - 3;
+		while (num > 1) {
+			if (!strcmp(argv[2 + num], "-e")) {
+				equalize = true;
+				num -= 1;
+			}
+			else if (num > 2 && !strcmp(argv[1 + num], "-w")) {
+				range = atoi(argv[2 + num]);
+				num -= 2;
+			}
+			else break;
+		}
+		return stretch(argv[2], num, argv + 3, range, equalize);
+	}
+	if (argc >= 2 && !strcmp(argv[1], "bench-cs")) {
+		uint32_t frames = (argc >= 3) ? atoi(argv[2]) : 30;
+		if (argc >= 4) threads = atoi(argv[3]);
+		return bench_cs(frames, threads);
+	}
+	if (argc >= 2 && !strcmp(argv[1], "verify-ycc")) {
+		return verify_ycc();
+	}
+	if (argc >= 2 && !strcmp(argv[1], "bench-ycc")) {
+		return bench_ycc((argc >= 3) ? atoi(argv[2]) : 30);
+	}
+	if (argc >= 2 && !strcmp(argv[1], "verify-cnn")) {
+		if (argc >= 3) threads = atoi(argv[2]);
+		return verify_cnn(threads);
+	}
+	if (argc >= 2 && !strcmp(argv[1], "bench-cnn")) {
+		uint32_t frames = (argc >= 3) ? atoi(argv[2]) : 10;
+		if (argc >= 4) threads = atoi(argv[3]);
+		return bench_cnn(frames, threads);
+	}
+	if (argc >= 2 && !strcmp(argv[1], "verify-patch")) {
+		return verify_patch();
+	}
+	if (argc >= 2 && !strcmp(argv[1], "bench-patch")) {
+		return bench_patch((argc >= 3) ? atoi(argv[2]) : 30);
+	}
+	if (argc >= 2 && !strcmp(argv[1], "verify-math")) {
+		return verify_math();
+	}
+	if (argc >= 2 && !strcmp(argv[1], "bench-math")) {
+		return bench_math((argc >= 3) ? atoi(argv[2]) : 100);
+	}
+	if (argc >= 2 && !strcmp(argv[1], "verify-ip")) {
+		return verify_ip();
+	}
+	if (argc >= 2 && !strcmp(argv[1], "bench-ip")) {
+		uint32_t frames = (argc >= 3) ? atoi(argv[2]) : 30;
+		if (argc >= 4) threads = atoi(argv[3]);
+		return bench_ip(frames, threads);
+	}
+	if (argc >= 3 && !strcmp(argv[1], "sweep")) {
+		return sweep(argv[2], argc - 3, argv + 3, threads);
+	}
+	usage(argv[0]);
+	return 0;
+}
@@ -0,0 +1,240 @@
+//-----------------------------------------------------------------------------
+// <contrast_stretch.cpp>
+//  - Defined functions of slab::ContrastStretch class
+//    - every width, rounding and pipeline stage of the table update follows
+//      contrast_stretch.sv (v1.02) with BIT_WIDTH = 8
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 11, 2020)
+//  - Added definition for functions of slab::ContrastStretch class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 15, 2020)
+//  - Moved sv_round() to fixed_point.hpp
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 16, 2020)
+//  - Split process() into begin_frame(), convert_rows() and end_frame()
+//-----------------------------------------------------------------------------
+// Version 1.03 (Dec. 30, 2020)
+//  - Added simd_supported() (NEON only)
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/imgproc/contrast_stretch.hpp>
+#include "fixed_point.hpp"
+#include "parallel.hpp"
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONTRAST_STRETCH_NEON
+#endif
+
+#define BIT_WIDTH     8
+#define WINDOW_RANGE  90 // default of contrast_stretch.sv
+#define EQUALIZE_HIST 0  // |
+#define SUB_HISTS     4  // histograms per band (consecutive equal pixels)
+
+namespace slab {
+	ContrastStretchParams contrast_stretch_params(const FrameGeometry& geometry) {
+		ContrastStretchParams params;
+		params.geometry      = geometry;
+		params.window_range  = WINDOW_RANGE;
+		params.equalize_hist = EQUALIZE_HIST;
+		return params;
+	}
+
+	ContrastStretch::ContrastStretch(const ContrastStretchParams& params, unsigned threads) :
+		params_  (params                      ),
+		iw_      (params.geometry.image_width ),
+		ih_      (params.geometry.image_height),
+		threads_ (1                           ),
+		simd_    (true                        )
+	{
+		total_pixs_ = iw_ * ih_;
+		count_bitw_ = clog2(total_pixs_);
+		clip_pixs_  = (uint32_t)(((uint64_t)total_pixs_ * (100 - params_.window_range)) / 200);
+
+		for (uint32_t i=0; i<HIST_BINS; i++)
+			inv_table_[i] = sv_round((pow(2.0, BIT_WIDTH) - 1.0) / i * pow(2.0, BIT_WIDTH),
+					BIT_WIDTH * 2);
+		weight_ = sv_round((HIST_BINS - 1.0) / (total_pixs_ - 2.0 * clip_pixs_) *
+				pow(2.0, count_bitw_), BIT_WIDTH + count_bitw_);
+
+		set_threads((threads > 0) ? threads : std::thread::hardware_concurrency());
+		reset();
+	}
+
+	ContrastStretch::~ContrastStretch() {
+	}
+
+	bool ContrastStretch::simd_supported() {
+#if defined(CONTRAST_STRETCH_NEON)
+		return true;
+#else
+		return false; // a 16 x pshufb lookup is slower than the scalar one on x86
+#endif
+	}
+
+	/* state after n_rst (the RAMs and registers hold 0 like a fresh bitstream) */
+	void ContrastStretch::reset() {
+		memset(table_, 0, sizeof(table_));
+		memset(hist_,  0, sizeof(hist_));
+		min_val_ = max_val_ = 0;
+		memset(&snapshot_, 0, sizeof(snapshot_));
+	}
+
+	//-------------------------------------------------------------------------
+	// conversion and histogram
+	//-------------------------------------------------------------------------
+	void ContrastStretch::convert_rows(const uint8_t *in, size_t in_stride,
+			uint8_t *out, size_t out_stride, uint32_t r0, uint32_t r1, unsigned band) {
+		const uint32_t iw   = iw_;
+		uint32_t      *hist = &partial_[(size_t)band * SUB_HISTS * HIST_BINS];
+#if defined(CONTRAST_STRETCH_NEON)
+		uint8x8x4_t tbl[HIST_BINS / 32];
+		for (int k=0; k<HIST_BINS/32; k++) {
+			tbl[k].val[0] = vld1_u8(table_ + k * 32);
+			tbl[k].val[1] = vld1_u8(table_ + k * 32 +  8);
+			tbl[k].val[2] = vld1_u8(table_ + k * 32 + 16);
+			tbl[k].val[3] = vld1_u8(table_ + k * 32 + 24);
+		}
+#endif
+
+		for (uint32_t r=r0; r<r1; r++) {
+			const uint8_t *src = in  + (size_t)r * in_stride;
+			uint8_t       *dst = out + (size_t)r * out_stride;
+			uint32_t       h   = 0;
+
+			/* histogram (before <dst> overwrites <src>) */
+			for (; h+SUB_HISTS<=iw; h+=SUB_HISTS) {
+				hist[src[h    ]                ]++;
+				hist[src[h + 1] + HIST_BINS    ]++;
+				hist[src[h + 2] + HIST_BINS * 2]++;
+				hist[src[h + 3] + HIST_BINS * 3]++;
+			}
+			for (; h<iw; h++) hist[src[h]]++;
+
+			/* table lookup (ctb_ram) */
+			h = 0;
+			if (simd_) {
+#if defined(CONTRAST_STRETCH_NEON)
+				/* 8 x 32 entries: vtbx leaves lanes out of [0, 32) untouched */
+				const uint8x8_t step = vdup_n_u8(32);
+				for (; h+16<=iw; h+=16) {
+					uint8x16_t x  = vld1q_u8(src + h);
+					uint8x8_t  lo = vget_low_u8(x), hi = vget_high_u8(x);
+					uint8x8_t  rl = vtbl4_u8(tbl[0], lo), rh = vtbl4_u8(tbl[0], hi);
+					for (int k=1; k<HIST_BINS/32; k++) {
+						lo = vsub_u8(lo, step);
+						hi = vsub_u8(hi, step);
+						rl = vtbx4_u8(rl, tbl[k], lo);
+						rh = vtbx4_u8(rh, tbl[k], hi);
+					}
+					vst1q_u8(dst + h, vcombine_u8(rl, rh));
+				}
+#endif
+			}
+			for (; h<iw; h++) dst[h] = table_[src[h]];
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// table update (states 1 and 2 of contrast_stretch.sv)
+	//-------------------------------------------------------------------------
+	void ContrastStretch::update() {
+		const uint64_t count_mask = (1ULL << count_bitw_) - 1;
+		const uint64_t prod_mask  = (1ULL << (BIT_WIDTH + count_bitw_)) - 1;
+		uint64_t cum[HIST_BINS], total = 0;
+		bool     min_found = false, max_found = false;
+		uint8_t  min_w = 0, max_w = 0;
+
+		/*
+		 * [1] sweep: current_total of bin k is compared while bin k + 1 is
+		 *     read, so bin 255 is compared in the cycle that takes the weight
+		 *     of cst_linear and publishes the snapshot
+		 */
+		for (uint32_t k=0; k<HIST_BINS; k++) {
+			if (k == HIST_BINS - 1) {
+				min_w = min_val_;
+				max_w = max_val_;
+			}
+			total  = (total + hist_[k]) & count_mask;
+			cum[k] = total;
+			if (!min_found && clip_pixs_ < total) {
+				min_found = true;
+				min_val_  = k;
+			}
+			if (!max_found && total_pixs_ - clip_pixs_ <= total) {
+				max_found = true;
+				max_val_  = k;
+			}
+		}
+
+		/* [2] conversion table */
+		if (!params_.equalize_hist) {
+			const uint32_t weight = inv_table_[(uint8_t)(max_w - min_w)];
+			for (uint32_t t=0; t<HIST_BINS; t++) {
+				uint32_t val  = (t < min_val_) ? 0 : (max_val_ < t) ?
+					(uint32_t)(max_val_ - min_val_) : t - min_val_;
+				uint32_t prod = (val * weight) & 0xffff;
+				table_[t] = (((prod >> (BIT_WIDTH - 1)) + 1) >> 1) & 0xff;
+			}
+		}
+		else {
+			for (uint32_t k=0; k<HIST_BINS; k++) {
+				uint64_t val  = (cum[k] <= clip_pixs_) ? 0 :
+					(total_pixs_ - clip_pixs_ <= cum[k]) ? total_pixs_ - clip_pixs_ * 2 :
+					cum[k] - clip_pixs_;
+				uint64_t prod = ((val & count_mask) * weight_) & prod_mask;
+				table_[k] = (((prod >> (count_bitw_ - 1)) + 1) >> 1) & 0xff;
+			}
+		}
+
+		/* histogram snapshot (out_hst_*) */
+		snapshot_.frame++;
+		snapshot_.timestamp_ns = monotonic_ns();
+		snapshot_.a            = min_w;
+		snapshot_.b            = max_w;
+		snapshot_.total        = 0;
+		for (uint32_t k=0; k<HIST_BINS; k++) {
+			snapshot_.bins[k]  = hist_[k];
+			snapshot_.total   += hist_[k];
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// frame
+	//-------------------------------------------------------------------------
+	void ContrastStretch::begin_frame(unsigned bands) {
+		partial_.assign((size_t)std::max(bands, 1u) * SUB_HISTS * HIST_BINS, 0);
+	}
+
+	void ContrastStretch::end_frame() {
+		const size_t   hists = partial_.size() / HIST_BINS;
+		const uint64_t mask  = (1ULL << count_bitw_) - 1;
+
+		/* hst_ram (counts wrap at COUNT_BITW like the RAM word) */
+		for (uint32_t k=0; k<HIST_BINS; k++) {
+			uint64_t sum = 0;
+			for (size_t i=0; i<hists; i++) sum += partial_[i * HIST_BINS + k];
+			hist_[k] = sum & mask;
+		}
+		update();
+	}
+
+	void ContrastStretch::process(const uint8_t *in, size_t in_stride, uint8_t *out, size_t out_stride) {
+		begin_frame(parallel_bands(threads_, ih_));
+		parallel_rows(threads_, ih_, [this, in, in_stride, out, out_stride]
+				(uint32_t r0, uint32_t r1, unsigned band) {
+			convert_rows(in, in_stride, out, out_stride, r0, r1, band);
+		});
+		end_frame();
+	}
+
+	void ContrastStretch::process(const GrayImage& in, GrayImage& out) {
+		if (&in != &out && (out.width() != iw_ || out.height() != ih_)) out.resize(iw_, ih_);
+		process(in.data(), in.width(), out.data(), out.width());
+	}
+};
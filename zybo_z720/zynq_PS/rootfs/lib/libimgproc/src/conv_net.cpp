@@ -0,0 +1,444 @@
+//-----------------------------------------------------------------------------
+// <conv_net.cpp>
+//  - Defined functions of slab::ConvNet class
+//    - quantization, widths and rounding follow conv_layer_fixed.sv (v1.02),
+//      batch_norm.sv (v1.00) and stream_patch.sv (PADDING = 1)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 13, 2020)
+//  - Added definition for functions of slab::ConvNet class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 15, 2020)
+//  - Moved wrap_s() and sv_fixed() (now sv_round_s()) to fixed_point.hpp
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/imgproc/conv_net.hpp>
+#include "fixed_point.hpp"
+#include "parallel.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CONV_NET_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CONV_NET_SSE2
+#endif
+
+#define BN_EPSILON  2.0e-5 // EPSILON of batch_norm.sv
+#define TAPS_ALIGN  8      // taps per SIMD step (int16 x 8, int8 x 8)
+#define MAX_BITW    32     // widths of values (int32_t feature maps)
+
+namespace slab {
+	ConvLayerParams conv_layer_params(uint32_t in_bitw, uint32_t out_bitw) {
+		ConvLayerParams p;
+		p.in_bitw       = in_bitw;
+		p.out_bitw      = out_bitw;
+		p.in_frac_bitw  = 0;
+		p.wgt_frac_bitw = 0;
+		p.out_frac_bitw = 0;
+		p.in_chs        = 1;
+		p.out_chs       = 1;
+		p.flt_size      = 1;
+		p.lrelu_slope   = -1;
+		p.batch_norm    = false;
+		p.residual      = false;
+		p.weights.assign(1, 0.0);
+		p.biases.assign(1, 0.0);
+		return p;
+	}
+
+	//-------------------------------------------------------------------------
+	// quantization
+	//-------------------------------------------------------------------------
+	static bool quantize(const ConvLayerParams& p, ConvLayer& l) {
+		const uint32_t oc_num = p.out_chs;
+
+		if (p.in_bitw == 0 || p.in_bitw > MAX_BITW || p.out_bitw == 0 || p.out_bitw > MAX_BITW ||
+				p.in_chs == 0 || p.out_chs == 0 || p.flt_size == 0 ||
+				p.out_frac_bitw > p.in_frac_bitw + p.wgt_frac_bitw || p.lrelu_slope > 16) {
+			fprintf(stderr, "conv layer: invalid parameters\n");
+			return false;
+		}
+		l.params     = p;
+		l.res_shift  = p.in_frac_bitw + p.wgt_frac_bitw - p.out_frac_bitw;
+		l.skip_shift = (int32_t)p.out_frac_bitw - (int32_t)p.in_frac_bitw;
+		l.mid_bitw   = p.out_bitw + l.res_shift;
+		l.bn_bitw    = p.out_bitw + p.out_frac_bitw;
+		l.flt_pixs   = p.flt_size * p.flt_size;
+		l.taps       = p.in_chs * l.flt_pixs;
+		l.taps_pad   = (l.taps + TAPS_ALIGN - 1) / TAPS_ALIGN * TAPS_ALIGN;
+		if (l.mid_bitw > 62 || l.bn_bitw > 62) {
+			fprintf(stderr, "conv layer: MID_BITW too wide\n");
+			return false;
+		}
+		if (p.weights.size() != (size_t)oc_num * l.taps || p.biases.size() != oc_num ||
+				(p.batch_norm && (p.avg_means.size() != oc_num || p.avg_vars.size() != oc_num ||
+								  p.gammas.size() != oc_num || p.betas.size() != oc_num))) {
+			fprintf(stderr, "conv layer: wrong number of weights or parameters\n");
+			return false;
+		}
+
+		/* SCALE and OFFSET of conv_layer_fixed */
+		l.scale.resize(p.weights.size());
+		for (size_t i=0; i<p.weights.size(); i++)
+			l.scale[i] = sv_round_s(p.weights[i] * pow(2.0, p.wgt_frac_bitw), l.mid_bitw);
+		l.offset.resize(oc_num);
+		for (uint32_t oc=0; oc<oc_num; oc++)
+			l.offset[oc] = sv_round_s(p.biases[oc] * pow(2.0, p.in_frac_bitw + p.wgt_frac_bitw) +
+					((l.res_shift > 0) ? pow(2.0, l.res_shift - 1) : 0.0), l.mid_bitw);
+
+		/* MULTIPLIER and BIAS of batch_norm */
+		l.bn_mult.assign(oc_num, 0);
+		l.bn_bias.assign(oc_num, 0);
+		for (uint32_t oc=0; p.batch_norm && oc<oc_num; oc++) {
+			double scale = p.gammas[oc] / sqrt(p.avg_vars[oc] + BN_EPSILON);
+			l.bn_mult[oc] = sv_round_s(scale * pow(2.0, p.out_frac_bitw), l.bn_bitw);
+			l.bn_bias[oc] = sv_round_s((p.betas[oc] - p.avg_means[oc] * scale) *
+					pow(2.0, p.out_frac_bitw), p.out_bitw);
+		}
+
+		/* SIMD: sums mod 2^32 are exact if MID_BITW <= 32 */
+		bool fit16 = l.mid_bitw <= 32 && p.in_bitw <= 16;
+		bool fit8  = fit16 && p.in_bitw <= 8;
+		for (size_t i=0; i<l.scale.size(); i++) {
+			fit16 = fit16 && l.scale[i] >= -32768 && l.scale[i] <= 32767;
+			fit8  = fit8  && l.scale[i] >=   -128 && l.scale[i] <=   127;
+		}
+#if defined(CONV_NET_NEON)
+		l.simd = fit8 ? 8 : fit16 ? 16 : 0;
+#elif defined(CONV_NET_SSE2)
+		l.simd = fit16 ? 16 : 0;
+#else
+		l.simd = 0;
+#endif
+		l.wgt16.assign((size_t)(oc_num + 3) / 4 * 4 * l.taps_pad, 0); // zero rows up to 4 channels
+		l.wgt8.assign(l.wgt16.size(), 0);
+		for (uint32_t oc=0; l.simd && oc<oc_num; oc++) {
+			/* (in_ch, flt_v, flt_h) -> (flt_v, flt_h, in_ch) like the im2col of conv_row() */
+			for (uint32_t t=0; t<l.taps; t++) {
+				uint32_t ic = t / l.flt_pixs, f = t % l.flt_pixs;
+				l.wgt16[oc * l.taps_pad + f * p.in_chs + ic] = (int16_t)l.scale[oc * l.taps + t];
+				l.wgt8 [oc * l.taps_pad + f * p.in_chs + ic] = (int8_t) l.scale[oc * l.taps + t];
+			}
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	// epilogue (bias, rounding, batch norm., Leaky ReLU, residual)
+	//-------------------------------------------------------------------------
+	static inline int32_t epilogue(const ConvLayer& l, uint32_t oc, uint64_t acc, int32_t skip) {
+		const ConvLayerParams& p = l.params;
+		const uint32_t ob = p.out_bitw;
+
+		/* biased <= (sum + OFFSET) >>> RES_SHIFT */
+		int64_t sum = wrap_s((int64_t)acc, l.mid_bitw);
+		int64_t val = wrap_s(sum + l.offset[oc], l.mid_bitw) >> l.res_shift;
+
+		if (p.batch_norm) {
+			int64_t prod = wrap_s(val * l.bn_mult[oc], l.bn_bitw);
+			if (p.out_frac_bitw >= 1)
+				val = wrap_s((((prod >> (p.out_frac_bitw - 1)) + 1) >> 1) + l.bn_bias[oc], ob);
+			else
+				val = wrap_s(prod, ob);
+		}
+		if (p.lrelu_slope >= 0 && val < 0) {
+			/* (bn_val * LRELU_SLOPE + 8) / 16 in 32 bits, truncated toward 0 */
+			val = wrap_s(wrap_s(val * p.lrelu_slope + 8, 32) / 16, ob);
+		}
+		if (p.residual && oc < p.in_chs) {
+			if (l.skip_shift >= 0) {
+				int64_t skip_ext = wrap_s(skip, ob);
+				val = wrap_s(val + wrap_s((int64_t)((uint64_t)skip_ext << l.skip_shift), ob), ob);
+			}
+			else {
+				val = wrap_s(val + ((((int64_t)skip >> (-l.skip_shift - 1)) + 1) >> 1), ob);
+			}
+		}
+		return (int32_t)val;
+	}
+
+	//-------------------------------------------------------------------------
+	// dot products (int32 sums mod 2^32)
+	//-------------------------------------------------------------------------
+	/* <x> . <w> for 4 output channels (<w> rows are <kp> apart) */
+	template <uint32_t KP>
+	static inline void dot4_16(const int16_t *x, const int16_t *w, uint32_t kp_rt, int32_t *acc) {
+		const uint32_t kp = KP ? KP : kp_rt;
+#if defined(CONV_NET_SSE2)
+		__m128i a[4];
+		for (int j=0; j<4; j++) a[j] = _mm_setzero_si128();
+		for (uint32_t k=0; k<kp; k+=8) {
+			__m128i xv = _mm_loadu_si128((const __m128i*)(x + k));
+			for (int j=0; j<4; j++)
+				a[j] = _mm_add_epi32(a[j], _mm_madd_epi16(xv,
+							_mm_loadu_si128((const __m128i*)(w + j * kp + k))));
+		}
+		__m128i t0 = _mm_add_epi32(_mm_unpacklo_epi32(a[0], a[1]), _mm_unpackhi_epi32(a[0], a[1]));
+		__m128i t1 = _mm_add_epi32(_mm_unpacklo_epi32(a[2], a[3]), _mm_unpackhi_epi32(a[2], a[3]));
+		_mm_storeu_si128((__m128i*)acc,
+				_mm_add_epi32(_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1)));
+#elif defined(CONV_NET_NEON)
+		int32x4_t a[4];
+		for (int j=0; j<4; j++) a[j] = vdupq_n_s32(0);
+		for (uint32_t k=0; k<kp; k+=8) {
+			int16x8_t xv = vld1q_s16(x + k);
+			for (int j=0; j<4; j++) {
+				int16x8_t wv = vld1q_s16(w + j * kp + k);
+				a[j] = vmlal_s16(a[j], vget_low_s16 (xv), vget_low_s16 (wv));
+				a[j] = vmlal_s16(a[j], vget_high_s16(xv), vget_high_s16(wv));
+			}
+		}
+		int32x2_t s01 = vpadd_s32(vpadd_s32(vget_low_s32(a[0]), vget_high_s32(a[0])),
+				vpadd_s32(vget_low_s32(a[1]), vget_high_s32(a[1])));
+		int32x2_t s23 = vpadd_s32(vpadd_s32(vget_low_s32(a[2]), vget_high_s32(a[2])),
+				vpadd_s32(vget_low_s32(a[3]), vget_high_s32(a[3])));
+		vst1q_s32(acc, vcombine_s32(s01, s23));
+#else
+		for (int j=0; j<4; j++) {
+			uint32_t s = 0;
+			for (uint32_t k=0; k<kp; k++) s += (uint32_t)((int32_t)x[k] * w[j * kp + k]);
+			acc[j] = (int32_t)s;
+		}
+#endif
+	}
+
+#if defined(CONV_NET_NEON)
+	template <uint32_t KP>
+	static inline void dot4_8(const int8_t *x, const int8_t *w, uint32_t kp_rt, int32_t *acc) {
+		const uint32_t kp = KP ? KP : kp_rt;
+		int32x4_t a[4];
+		for (int j=0; j<4; j++) a[j] = vdupq_n_s32(0);
+		for (uint32_t k=0; k<kp; k+=8) {
+			int8x8_t xv = vld1_s8(x + k);
+			for (int j=0; j<4; j++) a[j] = vpadalq_s16(a[j], vmull_s8(xv, vld1_s8(w + j * kp + k)));
+		}
+		int32x2_t s01 = vpadd_s32(vpadd_s32(vget_low_s32(a[0]), vget_high_s32(a[0])),
+				vpadd_s32(vget_low_s32(a[1]), vget_high_s32(a[1])));
+		int32x2_t s23 = vpadd_s32(vpadd_s32(vget_low_s32(a[2]), vget_high_s32(a[2])),
+				vpadd_s32(vget_low_s32(a[3]), vget_high_s32(a[3])));
+		vst1q_s32(acc, vcombine_s32(s01, s23));
+	}
+#endif
+
+	//-------------------------------------------------------------------------
+	// one row of a layer
+	//-------------------------------------------------------------------------
+	/*
+	 * <FLT> and <ICH> are compile-time filter size and input channels
+	 * (0: taken from the layer at run time)
+	 */
+	template <uint32_t FLT, uint32_t ICH>
+	static void conv_row(const ConvLayer& l, const int32_t *const *rows, uint32_t iw,
+			int32_t *dst, bool simd, std::vector<int16_t>& col) {
+		const ConvLayerParams& p = l.params;
+		const uint32_t flt   = FLT ? FLT : p.flt_size;
+		const uint32_t ich   = ICH ? ICH : p.in_chs;
+		const uint32_t fpix  = flt * flt;
+		const uint32_t taps  = ich * fpix;
+		const uint32_t kp    = (taps + TAPS_ALIGN - 1) / TAPS_ALIGN * TAPS_ALIGN;
+		const uint32_t och   = p.out_chs;
+		const uint32_t ctr   = flt / 2;
+		const uint32_t shift = 32 - p.in_bitw;
+		const int32_t *mid   = rows[ctr];
+		const int mode       = simd ? l.simd : 0;
+
+		if (mode == 0) {
+			/* exact 64-bit scalar */
+			for (uint32_t h=0; h<iw; h++) {
+				for (uint32_t oc=0; oc<och; oc++) {
+					const int64_t *s = &l.scale[(size_t)oc * taps];
+					uint64_t acc = 0;
+					for (uint32_t fv=0; fv<flt; fv++) {
+						for (uint32_t fh=0; fh<flt; fh++) {
+							int64_t  cc = (int64_t)h + fh - ctr;
+							uint32_t c  = (cc < 0) ? 0 : (cc >= iw) ? iw - 1 : cc;
+							const int32_t *px = rows[fv] + (size_t)c * ich;
+							for (uint32_t ic=0; ic<ich; ic++) {
+								int32_t x = (int32_t)((uint32_t)px[ic] << shift) >> shift;
+								acc += (uint64_t)(int64_t)x * (uint64_t)s[ic * fpix + fv * flt + fh];
+							}
+						}
+					}
+					int32_t skip = (oc < ich) ? (int32_t)((uint32_t)mid[(size_t)h * ich + oc] << shift) >> shift : 0;
+					dst[(size_t)h * och + oc] = epilogue(l, oc, acc, skip);
+				}
+			}
+			return;
+		}
+
+		/* im2col of the row (int16, taps in (flt_v, flt_h, in_ch) order, zero-padded to <kp>) */
+		col.resize((size_t)iw * kp);
+		int16_t *x16 = col.data();
+		int8_t  *x8  = (int8_t*)col.data();
+		for (uint32_t h=0; h<iw; h++) {
+			int16_t *d16 = x16 + (size_t)h * kp;
+			int8_t  *d8  = x8  + (size_t)h * kp;
+			for (uint32_t fv=0; fv<flt; fv++) {
+				for (uint32_t fh=0; fh<flt; fh++) {
+					int64_t  cc = (int64_t)h + fh - ctr;
+					uint32_t c  = (cc < 0) ? 0 : (cc >= iw) ? iw - 1 : cc;
+					const int32_t *px = rows[fv] + (size_t)c * ich;
+					const uint32_t t  = (fv * flt + fh) * ich;
+					if (mode == 8) {
+						for (uint32_t ic=0; ic<ich; ic++) d8[t + ic] = (int32_t)((uint32_t)px[ic] << shift) >> shift;
+					}
+					else {
+						for (uint32_t ic=0; ic<ich; ic++) d16[t + ic] = (int32_t)((uint32_t)px[ic] << shift) >> shift;
+					}
+				}
+			}
+			for (uint32_t t=taps; t<kp; t++) {
+				if (mode == 8) d8[t] = 0; else d16[t] = 0;
+			}
+		}
+
+		/* dot products, 4 output channels at a time (zero weights past <och>) */
+		int32_t acc[4];
+		for (uint32_t h=0; h<iw; h++) {
+			for (uint32_t oc=0; oc<och; oc+=4) {
+#if defined(CONV_NET_NEON)
+				if (mode == 8) dot4_8<(FLT && ICH) ? ((FLT * FLT * ICH + 7) / 8 * 8) : 0>(
+						x8 + (size_t)h * kp, &l.wgt8[(size_t)oc * kp], kp, acc);
+				else
+#endif
+				dot4_16<(FLT && ICH) ? ((FLT * FLT * ICH + 7) / 8 * 8) : 0>(
+						x16 + (size_t)h * kp, &l.wgt16[(size_t)oc * kp], kp, acc);
+				for (uint32_t j=0; j<4 && oc+j<och; j++) {
+					int32_t skip = (oc + j < ich) ?
+						(int32_t)((uint32_t)mid[(size_t)h * ich + oc + j] << shift) >> shift : 0;
+					dst[(size_t)h * och + oc + j] = epilogue(l, oc + j, (uint64_t)(int64_t)acc[j], skip);
+				}
+			}
+		}
+	}
+
+	typedef void (*conv_row_fn)(const ConvLayer&, const int32_t *const*, uint32_t,
+			int32_t*, bool, std::vector<int16_t>&);
+
+	/* specializations (filter size, input channels) */
+	static conv_row_fn conv_row_for(const ConvLayerParams& p) {
+		static const struct { uint32_t flt, ich; conv_row_fn fn; } table[] = {
+			{1,  1, conv_row<1,  1>}, {1,  3, conv_row<1,  3>},
+			{1,  8, conv_row<1,  8>}, {1, 16, conv_row<1, 16>},
+			{3,  1, conv_row<3,  1>}, {3,  3, conv_row<3,  3>},
+			{3,  8, conv_row<3,  8>}, {3, 16, conv_row<3, 16>},
+			{5,  1, conv_row<5,  1>}, {5,  8, conv_row<5,  8>}
+		};
+		for (size_t i=0; i<sizeof(table)/sizeof(table[0]); i++) {
+			if (table[i].flt == p.flt_size && table[i].ich == p.in_chs) return table[i].fn;
+		}
+		return conv_row<0, 0>;
+	}
+
+	//-------------------------------------------------------------------------
+	// ConvNet
+	//-------------------------------------------------------------------------
+	ConvNet::ConvNet(uint32_t width, uint32_t height, unsigned threads) :
+		iw_        (width ),
+		ih_        (height),
+		threads_   (1     ),
+		simd_      (true  ),
+		tile_rows_ (16    )
+	{
+		set_threads((threads > 0) ? threads : std::thread::hardware_concurrency());
+	}
+
+	ConvNet::~ConvNet() {
+	}
+
+	bool ConvNet::add_layer(const ConvLayerParams& params) {
+		ConvLayer layer;
+
+		if (!layers_.empty()) {
+			const ConvLayerParams& prev = layers_.back().params;
+			if (prev.out_chs != params.in_chs || prev.out_bitw != params.in_bitw) {
+				fprintf(stderr, "conv layer %zu: IN_CHS/IN_BITW differ from the previous layer\n",
+						layers_.size());
+				return false;
+			}
+		}
+		if (!quantize(params, layer)) return false;
+		layers_.push_back(layer);
+		return true;
+	}
+
+	/* rows [<o0>, <o1>) of a layer; <in>/<out> hold rows from <in_row0>/<out_row0> */
+	void ConvNet::run_layer(const ConvLayer& l, const int32_t *in, uint32_t in_row0,
+			int32_t *out, uint32_t out_row0, uint32_t o0, uint32_t o1,
+			std::vector<int16_t>& col) const {
+		const ConvLayerParams& p = l.params;
+		const size_t   in_row  = (size_t)iw_ * p.in_chs;
+		const size_t   out_row = (size_t)iw_ * p.out_chs;
+		const uint32_t ctr     = p.flt_size / 2;
+		conv_row_fn    fn      = conv_row_for(p);
+		std::vector<const int32_t*> rows(p.flt_size);
+
+		for (uint32_t r=o0; r<o1; r++) {
+			for (uint32_t fv=0; fv<p.flt_size; fv++) {
+				int64_t  rr = (int64_t)r + fv - ctr;
+				uint32_t v  = (rr < 0) ? 0 : (rr >= ih_) ? ih_ - 1 : rr;
+				rows[fv] = in + (v - in_row0) * in_row;
+			}
+			fn(l, rows.data(), iw_, out + (r - out_row0) * out_row, simd_, col);
+		}
+	}
+
+	/* rows [<t0>, <t1>) of layer <last> - 1 through layers [<first>, <last>) */
+	void ConvNet::run_tile(size_t first, size_t last, const int32_t *in, int32_t *out,
+			uint32_t t0, uint32_t t1, std::vector<std::vector<int32_t> >& bufs,
+			std::vector<int16_t>& col) const {
+		const size_t n = last - first;
+		std::vector<uint32_t> a(n + 1), b(n + 1);
+
+		/* rows needed by every layer (halos, clipped at the edges) */
+		a[n] = t0;
+		b[n] = t1;
+		for (size_t i=n; i-->0;) {
+			const uint32_t flt = layers_[first + i].params.flt_size, ctr = flt / 2;
+			a[i] = (a[i + 1] > ctr) ? a[i + 1] - ctr : 0;
+			b[i] = std::min(ih_, b[i + 1] + flt - 1 - ctr);
+		}
+
+		const int32_t *src = in;
+		uint32_t       src_row0 = 0;
+		for (size_t i=0; i<n; i++) {
+			const ConvLayer& l = layers_[first + i];
+			int32_t  *dst      = out;
+			uint32_t  dst_row0 = 0;
+			if (i + 1 < n) {
+				bufs[i].resize((size_t)(b[i + 1] - a[i + 1]) * iw_ * l.params.out_chs);
+				dst      = bufs[i].data();
+				dst_row0 = a[i + 1];
+			}
+			run_layer(l, src, src_row0, dst, dst_row0, a[i + 1], b[i + 1], col);
+			src      = dst;
+			src_row0 = dst_row0;
+		}
+	}
+
+	void ConvNet::process(const int32_t *in, int32_t *out, size_t first, size_t last) const {
+		if (first >= last || last > layers_.size()) return;
+		const uint32_t tile = (tile_rows_ > 0) ? tile_rows_ : ih_;
+
+		parallel_rows(threads_, ih_, [this, in, out, first, last, tile]
+				(uint32_t r0, uint32_t r1, unsigned) {
+			std::vector<std::vector<int32_t> > bufs(last - first);
+			std::vector<int16_t>               col;
+			for (uint32_t t=r0; t<r1; t+=tile)
+				run_tile(first, last, in, out, t, std::min(t + tile, r1), bufs, col);
+		});
+	}
+
+	void ConvNet::process(const GrayImage& image, std::vector<int32_t>& out) const {
+		if (layers_.empty() || layers_[0].params.in_chs != 1) return;
+		std::vector<int32_t> in(image.data(), image.data() + (size_t)iw_ * ih_);
+		out.resize((size_t)iw_ * ih_ * layers_.back().params.out_chs);
+		process(in.data(), out.data());
+	}
+};
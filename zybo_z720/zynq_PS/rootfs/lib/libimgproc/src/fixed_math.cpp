@@ -0,0 +1,494 @@
+//-----------------------------------------------------------------------------
+// <fixed_math.cpp>
+//  - Defined functions of slab::ArctanCalc, slab::SinCalc and
+//    slab::DividerIterS classes
+//    - widths and special cases follow arctan_calc.sv (v1.03), sin_calc.sv
+//      (v1.05) and divider_iter_s.sv (v1.03)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 15, 2020)
+//  - Added definition for functions of slab::ArctanCalc, slab::SinCalc and
+//    slab::DividerIterS classes
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/imgproc/fixed_math.hpp>
+#include "fixed_point.hpp"
+
+#include <stdio.h>
+#include <math.h>
+
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FIXED_MATH_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FIXED_MATH_SSE2
+#endif
+
+#define PI         3.1415926535897931 // same literal as the PL
+#define SIMD_LANES 8                  // int16 lanes per step
+#define DIV_LANES  4                  // int32 lanes per step
+#define DIV_SIMD_BITW 24              // TOTAL_BITW exact in float
+
+namespace slab {
+	static uint32_t clamp_param(const char *name, uint32_t val, uint32_t lo, uint32_t hi) {
+		if (val < lo || val > hi) {
+			uint32_t fixed = (val < lo) ? lo : hi;
+			fprintf(stderr, "%s: %u is out of [%u, %u], using %u\n", name, val, lo, hi, fixed);
+			return fixed;
+		}
+		return val;
+	}
+
+	//-------------------------------------------------------------------------
+	// arctan_calc
+	//-------------------------------------------------------------------------
+	ArctanCalc::ArctanCalc(uint32_t in_bitw, uint32_t out_bitw) :
+		simd_ (true)
+	{
+		out_bitw_ = clamp_param("arctan_calc OUT_BITW", out_bitw, 4, 12);
+		in_bitw_  = clamp_param("arctan_calc IN_BITW",  in_bitw,  out_bitw_ - 2, 16);
+
+		/* arctan_table (clip() and [OUT_BITW-4:0] of the ROM word) */
+		const uint32_t steps   = 1u << (out_bitw_ - 2);
+		const double   max_val = (1 << (out_bitw_ - 3)) - 1;
+		rom_.assign((size_t)1 << ((out_bitw_ - 2) * 2 - 1), 0);
+		for (uint32_t x=1; x<steps; x++) {
+			for (uint32_t y=1; y<=x; y++) {
+				double val = atan2((double)y, (double)x) / (PI * 2) * pow(2.0, out_bitw_);
+				rom_[(x * (x - 1)) / 2 + y - 1] = sv_round(std::min(val, max_val), out_bitw_ - 3);
+			}
+		}
+	}
+
+	ArctanCalc::~ArctanCalc() {
+	}
+
+	uint32_t ArctanCalc::operator()(int32_t in_y, int32_t in_x) const {
+		const uint32_t ob    = out_bitw_;
+		const uint32_t steps = 1u << (ob - 2);
+		int64_t  y     = wrap_s(in_y, in_bitw_), x = wrap_s(in_x, in_bitw_);
+		bool     neg_y = y < 0, neg_x = x < 0, swap = false;
+		uint32_t abs_y = neg_y ? -y : y;
+		uint32_t abs_x = neg_x ? -x : x;
+
+		/* [stage 1] */
+		if (abs_y > abs_x) {
+			std::swap(abs_y, abs_x);
+			swap = true;
+		}
+
+		/* [stage 2] bit truncation (the highest 1 of abs_x above bit OUT_BITW - 3) */
+		uint32_t len   = bitlen(abs_x);
+		uint32_t width = (len > ob - 2) ? len - (ob - 2) : 0;
+		uint32_t bias  = (width > 0) ? 1u << (width - 1) : 0;
+		uint32_t ty    = ((abs_y + bias) >> width) & ((1u << (ob - 1)) - 1);
+		uint32_t tx    = ((abs_x + bias) >> width) & ((1u << (ob - 1)) - 1);
+		if (ty >= steps) ty = steps - 1;
+		if (tx >= steps) tx = steps - 1;
+
+		/* [stage 3-5] */
+		uint32_t addr = ((tx * (tx - 1)) / 2 + ty - 1) & (rom_.size() - 1);
+		uint32_t res  = (ty == tx) ? 1u << (ob - 3) : rom_[addr];
+		res = (ty == 0) ? 0 : (tx == 0) ? 1u << (ob - 2) : res;
+		res = swap  ? (1u << (ob - 2)) - res : res;
+		res = neg_x ? (1u << (ob - 1)) - res : res;
+		res = neg_y ? -res : res;
+		return res & ((1u << ob) - 1);
+	}
+
+	void ArctanCalc::process(const int16_t *in_y, const int16_t *in_x, uint16_t *out, size_t n) const {
+		const uint32_t ib = in_bitw_, ob = out_bitw_;
+		const uint32_t trunc_max = ib + 2 - ob; // largest truncation width
+		size_t i = 0;
+
+		if (simd_) {
+			uint32_t addr[SIMD_LANES];
+			uint16_t ang[SIMD_LANES];
+#if defined(FIXED_MATH_SSE2)
+			const __m128i sign  = _mm_set1_epi16((int16_t)0x8000);
+			const __m128i one   = _mm_set1_epi16(1);
+			const __m128i zero  = _mm_setzero_si128();
+			const __m128i tmask = _mm_set1_epi16((1 << (ob - 1)) - 1);
+			const __m128i tsat  = _mm_set1_epi16((1 << (ob - 2)) - 1);
+			const __m128i amask = _mm_set1_epi32(rom_.size() - 1);
+			const __m128i r_eq  = _mm_set1_epi16(1 << (ob - 3));
+			const __m128i r_q   = _mm_set1_epi16(1 << (ob - 2));
+			const __m128i r_h   = _mm_set1_epi16(1 << (ob - 1));
+			const __m128i omask = _mm_set1_epi16((1 << ob) - 1);
+			const __m128i wsh   = _mm_cvtsi32_si128(16 - ib);
+#define SEL(m, a, b) _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+			for (; i+SIMD_LANES<=n; i+=SIMD_LANES) {
+				__m128i y  = _mm_sra_epi16(_mm_sll_epi16(_mm_loadu_si128((const __m128i*)(in_y + i)), wsh), wsh);
+				__m128i x  = _mm_sra_epi16(_mm_sll_epi16(_mm_loadu_si128((const __m128i*)(in_x + i)), wsh), wsh);
+				__m128i ny = _mm_srai_epi16(y, 15), nx = _mm_srai_epi16(x, 15);
+				__m128i ay = _mm_sub_epi16(_mm_xor_si128(y, ny), ny);
+				__m128i ax = _mm_sub_epi16(_mm_xor_si128(x, nx), nx);
+
+				/* [stage 1] (unsigned compare) */
+				__m128i sw = _mm_cmpgt_epi16(_mm_xor_si128(ay, sign), _mm_xor_si128(ax, sign));
+				__m128i lo = SEL(sw, ax, ay), hi = SEL(sw, ay, ax);
+
+				/* [stage 2] */
+				__m128i ty = lo, tx = hi;
+				for (uint32_t k=1; k<=trunc_max; k++) {
+					__m128i thr  = _mm_set1_epi16((int16_t)((1u << (ob - 3 + k)) - 1 - 0x8000));
+					__m128i m    = _mm_cmpgt_epi16(_mm_xor_si128(hi, sign), thr);
+					__m128i bias = _mm_set1_epi16(1 << (k - 1));
+					__m128i cnt  = _mm_cvtsi32_si128(k);
+					ty = SEL(m, _mm_srl_epi16(_mm_add_epi16(lo, bias), cnt), ty);
+					tx = SEL(m, _mm_srl_epi16(_mm_add_epi16(hi, bias), cnt), tx);
+				}
+				ty = _mm_min_epi16(_mm_and_si128(ty, tmask), tsat);
+				tx = _mm_min_epi16(_mm_and_si128(tx, tmask), tsat);
+
+				/* [stage 3] address (32 bits) */
+				__m128i xm1 = _mm_sub_epi16(tx, one);
+				__m128i plo = _mm_mullo_epi16(tx, xm1), phi = _mm_mulhi_epu16(tx, xm1);
+				__m128i a0  = _mm_add_epi32(_mm_srli_epi32(_mm_unpacklo_epi16(plo, phi), 1),
+						_mm_unpacklo_epi16(ty, zero));
+				__m128i a1  = _mm_add_epi32(_mm_srli_epi32(_mm_unpackhi_epi16(plo, phi), 1),
+						_mm_unpackhi_epi16(ty, zero));
+				const __m128i one32 = _mm_set1_epi32(1);
+				_mm_storeu_si128((__m128i*)addr,       _mm_and_si128(_mm_sub_epi32(a0, one32), amask));
+				_mm_storeu_si128((__m128i*)(addr + 4), _mm_and_si128(_mm_sub_epi32(a1, one32), amask));
+
+				/* [stage 4] ROM */
+				for (int j=0; j<SIMD_LANES; j++) ang[j] = rom_[addr[j]];
+
+				/* [stage 5] */
+				__m128i res = SEL(_mm_cmpeq_epi16(ty, tx), r_eq, _mm_loadu_si128((const __m128i*)ang));
+				res = SEL(_mm_cmpeq_epi16(tx, zero), r_q, res);
+				res = _mm_andnot_si128(_mm_cmpeq_epi16(ty, zero), res);
+				res = SEL(sw, _mm_sub_epi16(r_q, res), res);
+				res = SEL(nx, _mm_sub_epi16(r_h, res), res);
+				res = SEL(ny, _mm_sub_epi16(zero, res), res);
+				_mm_storeu_si128((__m128i*)(out + i), _mm_and_si128(res, omask));
+			}
+#undef SEL
+#elif defined(FIXED_MATH_NEON)
+			const int16x8_t  wl    = vdupq_n_s16(16 - ib), wr = vdupq_n_s16(-(int16_t)(16 - ib));
+			const uint16x8_t zero  = vdupq_n_u16(0);
+			const uint16x8_t tmask = vdupq_n_u16((1 << (ob - 1)) - 1);
+			const uint16x8_t tsat  = vdupq_n_u16((1 << (ob - 2)) - 1);
+			const uint32x4_t amask = vdupq_n_u32(rom_.size() - 1);
+			const uint16x8_t r_eq  = vdupq_n_u16(1 << (ob - 3));
+			const uint16x8_t r_q   = vdupq_n_u16(1 << (ob - 2));
+			const uint16x8_t r_h   = vdupq_n_u16(1 << (ob - 1));
+			const uint16x8_t omask = vdupq_n_u16((1 << ob) - 1);
+			for (; i+SIMD_LANES<=n; i+=SIMD_LANES) {
+				int16x8_t  y  = vshlq_s16(vshlq_s16(vld1q_s16(in_y + i), wl), wr);
+				int16x8_t  x  = vshlq_s16(vshlq_s16(vld1q_s16(in_x + i), wl), wr);
+				uint16x8_t ny = vcltq_s16(y, vdupq_n_s16(0)), nx = vcltq_s16(x, vdupq_n_s16(0));
+				uint16x8_t ay = vreinterpretq_u16_s16(vabsq_s16(y));
+				uint16x8_t ax = vreinterpretq_u16_s16(vabsq_s16(x));
+
+				/* [stage 1] */
+				uint16x8_t sw = vcgtq_u16(ay, ax);
+				uint16x8_t lo = vminq_u16(ay, ax), hi = vmaxq_u16(ay, ax);
+
+				/* [stage 2] */
+				uint16x8_t ty = lo, tx = hi;
+				for (uint32_t k=1; k<=trunc_max; k++) {
+					uint16x8_t m    = vcgeq_u16(hi, vdupq_n_u16(1u << (ob - 3 + k)));
+					uint16x8_t bias = vdupq_n_u16(1 << (k - 1));
+					int16x8_t  cnt  = vdupq_n_s16(-(int16_t)k);
+					ty = vbslq_u16(m, vshlq_u16(vaddq_u16(lo, bias), cnt), ty);
+					tx = vbslq_u16(m, vshlq_u16(vaddq_u16(hi, bias), cnt), tx);
+				}
+				ty = vminq_u16(vandq_u16(ty, tmask), tsat);
+				tx = vminq_u16(vandq_u16(tx, tmask), tsat);
+
+				/* [stage 3] address (32 bits) */
+				uint16x8_t xm1 = vsubq_u16(tx, vdupq_n_u16(1));
+				uint32x4_t a0  = vaddw_u16(vshrq_n_u32(vmull_u16(vget_low_u16 (tx), vget_low_u16 (xm1)), 1),
+						vget_low_u16(ty));
+				uint32x4_t a1  = vaddw_u16(vshrq_n_u32(vmull_u16(vget_high_u16(tx), vget_high_u16(xm1)), 1),
+						vget_high_u16(ty));
+				vst1q_u32(addr,     vandq_u32(vsubq_u32(a0, vdupq_n_u32(1)), amask));
+				vst1q_u32(addr + 4, vandq_u32(vsubq_u32(a1, vdupq_n_u32(1)), amask));
+
+				/* [stage 4] ROM */
+				for (int j=0; j<SIMD_LANES; j++) ang[j] = rom_[addr[j]];
+
+				/* [stage 5] */
+				uint16x8_t res = vbslq_u16(vceqq_u16(ty, tx), r_eq, vld1q_u16(ang));
+				res = vbslq_u16(vceqq_u16(tx, zero), r_q, res);
+				res = vbslq_u16(vceqq_u16(ty, zero), zero, res);
+				res = vbslq_u16(sw, vsubq_u16(r_q, res), res);
+				res = vbslq_u16(nx, vsubq_u16(r_h, res), res);
+				res = vbslq_u16(ny, vsubq_u16(zero, res), res);
+				vst1q_u16(out + i, vandq_u16(res, omask));
+			}
+#else
+			(void)addr; (void)ang; (void)trunc_max;
+#endif
+		}
+		for (; i<n; i++) out[i] = (*this)(in_y[i], in_x[i]);
+	}
+
+	//-------------------------------------------------------------------------
+	// sin_calc
+	//-------------------------------------------------------------------------
+	SinCalc::SinCalc(uint32_t in_bitw, uint32_t out_bitw) :
+		simd_ (true)
+	{
+		in_bitw_  = clamp_param("sin_calc IN_BITW",  in_bitw,  3, 16);
+		out_bitw_ = clamp_param("sin_calc OUT_BITW", out_bitw, 3, 16);
+
+		const uint32_t steps = 1u << (in_bitw_ - 2);
+		rom_.resize(steps);
+		for (uint32_t i=0; i<steps; i++)
+			rom_[i] = sv_round_s(sin(i * PI / (steps * 2.0)) * pow(2.0, out_bitw_ - 2), out_bitw_);
+	}
+
+	SinCalc::~SinCalc() {
+	}
+
+	int32_t SinCalc::operator()(uint32_t in_phase) const {
+		const uint32_t q     = 1u << (in_bitw_ - 2);
+		const uint32_t phase = wrap_u(in_phase, in_bitw_);
+		uint32_t addr;
+
+		/* [stage 1] */
+		if      (phase < q    ) addr = phase;
+		else if (phase < q * 2) addr = q * 2 - phase;
+		else if (phase < q * 3) addr = phase - q * 2;
+		else                    addr = q * 4 - phase;
+		bool half = (phase == q) || (phase == q * 3);
+		bool neg  = q * 2 < phase;
+
+		/* [stage 2-3] */
+		int64_t value = half ? (1 << (out_bitw_ - 2)) : rom_[addr & (q - 1)];
+		return wrap_s(neg ? -value : value, out_bitw_);
+	}
+
+	void SinCalc::process(const uint16_t *in_phase, int16_t *out, size_t n) const {
+		const uint32_t ib = in_bitw_, ob = out_bitw_;
+		const uint32_t q  = 1u << (ib - 2);
+		size_t i = 0;
+
+		if (simd_) {
+			uint16_t addr[SIMD_LANES];
+			int16_t  val[SIMD_LANES];
+#if defined(FIXED_MATH_SSE2)
+			const __m128i sign  = _mm_set1_epi16((int16_t)0x8000);
+			const __m128i pmask = _mm_set1_epi16((int16_t)((1u << ib) - 1));
+			const __m128i amask = _mm_set1_epi16((int16_t)(q - 1));
+			const __m128i q1    = _mm_set1_epi16((int16_t)q);
+			const __m128i q2    = _mm_set1_epi16((int16_t)(q * 2));
+			const __m128i q3    = _mm_set1_epi16((int16_t)(q * 3));
+			const __m128i q4    = _mm_set1_epi16((int16_t)(q * 4));
+			const __m128i one   = _mm_set1_epi16((int16_t)(1 << (ob - 2)));
+			const __m128i zero  = _mm_setzero_si128();
+			const __m128i osh   = _mm_cvtsi32_si128(16 - ob);
+#define SEL(m, a, b) _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b))
+#define LT_U(a, b)   _mm_cmplt_epi16(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign))
+			for (; i+SIMD_LANES<=n; i+=SIMD_LANES) {
+				__m128i p = _mm_and_si128(_mm_loadu_si128((const __m128i*)(in_phase + i)), pmask);
+
+				/* [stage 1] */
+				__m128i a = SEL(LT_U(p, q3), _mm_sub_epi16(p, q2), _mm_sub_epi16(q4, p));
+				a = SEL(LT_U(p, q2), _mm_sub_epi16(q2, p), a);
+				a = SEL(LT_U(p, q1), p, a);
+				_mm_storeu_si128((__m128i*)addr, _mm_and_si128(a, amask));
+				__m128i half = _mm_or_si128(_mm_cmpeq_epi16(p, q1), _mm_cmpeq_epi16(p, q3));
+				__m128i neg  = LT_U(q2, p);
+
+				/* [stage 2-3] */
+				for (int j=0; j<SIMD_LANES; j++) val[j] = rom_[addr[j]];
+				__m128i v = SEL(half, one, _mm_loadu_si128((const __m128i*)val));
+				v = SEL(neg, _mm_sub_epi16(zero, v), v);
+				_mm_storeu_si128((__m128i*)(out + i), _mm_sra_epi16(_mm_sll_epi16(v, osh), osh));
+			}
+#undef SEL
+#undef LT_U
+#elif defined(FIXED_MATH_NEON)
+			const uint16x8_t pmask = vdupq_n_u16((1u << ib) - 1);
+			const uint16x8_t amask = vdupq_n_u16(q - 1);
+			const uint16x8_t q1    = vdupq_n_u16(q);
+			const uint16x8_t q2    = vdupq_n_u16(q * 2);
+			const uint16x8_t q3    = vdupq_n_u16(q * 3);
+			const uint16x8_t q4    = vdupq_n_u16(q * 4);
+			const int16x8_t  one   = vdupq_n_s16(1 << (ob - 2));
+			const int16x8_t  ol    = vdupq_n_s16(16 - ob), orr = vdupq_n_s16(-(int16_t)(16 - ob));
+			for (; i+SIMD_LANES<=n; i+=SIMD_LANES) {
+				uint16x8_t p = vandq_u16(vld1q_u16(in_phase + i), pmask);
+
+				/* [stage 1] */
+				uint16x8_t a = vbslq_u16(vcltq_u16(p, q3), vsubq_u16(p, q2), vsubq_u16(q4, p));
+				a = vbslq_u16(vcltq_u16(p, q2), vsubq_u16(q2, p), a);
+				a = vbslq_u16(vcltq_u16(p, q1), p, a);
+				vst1q_u16(addr, vandq_u16(a, amask));
+				uint16x8_t half = vorrq_u16(vceqq_u16(p, q1), vceqq_u16(p, q3));
+				uint16x8_t neg  = vcltq_u16(q2, p);
+
+				/* [stage 2-3] */
+				for (int j=0; j<SIMD_LANES; j++) val[j] = rom_[addr[j]];
+				int16x8_t v = vbslq_s16(half, one, vld1q_s16(val));
+				v = vbslq_s16(neg, vnegq_s16(v), v);
+				vst1q_s16(out + i, vshlq_s16(vshlq_s16(v, ol), orr));
+			}
+#else
+			(void)addr; (void)val; (void)ob; (void)q;
+#endif
+		}
+		for (; i<n; i++) out[i] = (*this)(in_phase[i]);
+	}
+
+	//-------------------------------------------------------------------------
+	// divider_iter_s
+	//-------------------------------------------------------------------------
+	DividerIterS::DividerIterS(uint32_t bit_width, uint32_t out_frac_bitw) :
+		simd_ (true)
+	{
+		bit_width_  = clamp_param("divider_iter_s BIT_WIDTH", bit_width, 2, 62);
+		frac_bitw_  = clamp_param("divider_iter_s OUT_FRAC_BITW", out_frac_bitw, 0, 62 - bit_width_);
+		total_bitw_ = bit_width_ + frac_bitw_;
+	}
+
+	DividerIterS::~DividerIterS() {
+	}
+
+	uint32_t DividerIterS::operator()(int64_t in_a, int64_t in_b, int64_t& out_q, int64_t& out_r) const {
+		const uint32_t tb = total_bitw_;
+		int64_t  a  = wrap_s(in_a, bit_width_), b = wrap_s(in_b, bit_width_);
+		uint64_t r  = wrap_u((uint64_t)((a >= 0) ? a : -a) << frac_bitw_, tb);
+		uint64_t bb = (b >= 0) ? b : -b;
+		uint64_t q  = 0;
+		uint32_t cycles;
+
+		/* [1] top_zero_count() of r and b */
+		uint32_t a_zero = tb - bitlen(r), b_zero = tb - bitlen(bb);
+		if (b_zero >= tb - 1 || b_zero < a_zero) {
+			if (b_zero == tb - 1) { // b == 1
+				q = r;
+				r = 0;
+			}
+			cycles = 3;
+		}
+		/* [2] one bit per cycle from <scale> down to 0 */
+		else {
+			q = r / bb;
+			r = r % bb;
+			cycles = 4 + (b_zero - a_zero);
+		}
+
+		/* [3] signs */
+		bool q_minus = (a < 0) != (b < 0);
+		bool r_minus = a <= 0;
+		out_q = wrap_s(q_minus ? -(int64_t)q : (int64_t)q, tb + 1);
+		out_r = wrap_s(r_minus ? -(int64_t)r : (int64_t)r, tb);
+		return cycles;
+	}
+
+#if defined(FIXED_MATH_SSE2)
+	/* low 32 bits of a * b per lane (no pmulld in SSE2) */
+	static inline __m128i mullo_epi32(__m128i a, __m128i b) {
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+				_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+#endif
+
+	void DividerIterS::process(const int32_t *in_a, const int32_t *in_b,
+			int32_t *out_q, int32_t *out_r, size_t n) const {
+		const uint32_t bw = bit_width_, fb = frac_bitw_, tb = total_bitw_;
+		size_t i = 0;
+
+		/* quotient estimate in float, then exact correction (|error| shrinks by 1 per pass) */
+		if (simd_ && tb <= DIV_SIMD_BITW) {
+#if defined(FIXED_MATH_SSE2)
+			const __m128i wsh  = _mm_cvtsi32_si128(32 - bw);
+			const __m128i fsh  = _mm_cvtsi32_si128(fb);
+			const __m128i qsh  = _mm_cvtsi32_si128(32 - (tb + 1));
+			const __m128i rsh  = _mm_cvtsi32_si128(32 - tb);
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i one  = _mm_set1_epi32(1);
+			for (; i+DIV_LANES<=n; i+=DIV_LANES) {
+				__m128i a  = _mm_sra_epi32(_mm_sll_epi32(_mm_loadu_si128((const __m128i*)(in_a + i)), wsh), wsh);
+				__m128i b  = _mm_sra_epi32(_mm_sll_epi32(_mm_loadu_si128((const __m128i*)(in_b + i)), wsh), wsh);
+				__m128i sa = _mm_srai_epi32(a, 31), sb = _mm_srai_epi32(b, 31);
+				__m128i r  = _mm_sll_epi32(_mm_sub_epi32(_mm_xor_si128(a, sa), sa), fsh);
+				__m128i bb = _mm_sub_epi32(_mm_xor_si128(b, sb), sb);
+				__m128i bz = _mm_cmpeq_epi32(bb, zero);
+				__m128i d  = _mm_or_si128(bb, _mm_and_si128(bz, one)); // b == 0: any divisor
+
+				__m128i q = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(r), _mm_cvtepi32_ps(d)));
+				__m128i m = _mm_sub_epi32(r, mullo_epi32(q, d));
+				for (;;) {
+					__m128i lo = _mm_cmplt_epi32(m, zero);
+					__m128i hi = _mm_cmpgt_epi32(m, _mm_sub_epi32(d, one));
+					if (_mm_movemask_epi8(_mm_or_si128(lo, hi)) == 0) break;
+					q = _mm_add_epi32(_mm_sub_epi32(q, _mm_and_si128(lo, one)), _mm_and_si128(hi, one));
+					m = _mm_sub_epi32(_mm_add_epi32(m, _mm_and_si128(lo, d)), _mm_and_si128(hi, d));
+				}
+				q = _mm_andnot_si128(bz, q);
+				m = _mm_or_si128(_mm_and_si128(bz, r), _mm_andnot_si128(bz, m));
+
+				__m128i qm = _mm_xor_si128(sa, sb);
+				__m128i rm = _mm_cmplt_epi32(a, one);
+				q = _mm_sub_epi32(_mm_xor_si128(q, qm), qm);
+				m = _mm_sub_epi32(_mm_xor_si128(m, rm), rm);
+				_mm_storeu_si128((__m128i*)(out_q + i), _mm_sra_epi32(_mm_sll_epi32(q, qsh), qsh));
+				_mm_storeu_si128((__m128i*)(out_r + i), _mm_sra_epi32(_mm_sll_epi32(m, rsh), rsh));
+			}
+#elif defined(FIXED_MATH_NEON)
+			const int32x4_t  wl  = vdupq_n_s32(32 - bw), wr = vdupq_n_s32(-(int32_t)(32 - bw));
+			const int32x4_t  fsh = vdupq_n_s32(fb);
+			const int32x4_t  ql  = vdupq_n_s32(32 - (tb + 1)), qr = vdupq_n_s32(-(int32_t)(32 - (tb + 1)));
+			const int32x4_t  rl  = vdupq_n_s32(32 - tb), rr = vdupq_n_s32(-(int32_t)(32 - tb));
+			const int32x4_t  zero = vdupq_n_s32(0);
+			const int32x4_t  one  = vdupq_n_s32(1);
+			for (; i+DIV_LANES<=n; i+=DIV_LANES) {
+				int32x4_t  a  = vshlq_s32(vshlq_s32(vld1q_s32(in_a + i), wl), wr);
+				int32x4_t  b  = vshlq_s32(vshlq_s32(vld1q_s32(in_b + i), wl), wr);
+				int32x4_t  r  = vshlq_s32(vabsq_s32(a), fsh);
+				int32x4_t  bb = vabsq_s32(b);
+				uint32x4_t bz = vceqq_s32(bb, zero);
+				int32x4_t  d  = vbslq_s32(bz, one, bb);
+
+				/* reciprocal estimate with two Newton-Raphson steps */
+				float32x4_t df  = vcvtq_f32_s32(d);
+				float32x4_t inv = vrecpeq_f32(df);
+				inv = vmulq_f32(vrecpsq_f32(df, inv), inv);
+				inv = vmulq_f32(vrecpsq_f32(df, inv), inv);
+				int32x4_t q = vcvtq_s32_f32(vmulq_f32(vcvtq_f32_s32(r), inv));
+				int32x4_t m = vsubq_s32(r, vmulq_s32(q, d));
+				for (;;) {
+					uint32x4_t lo = vcltq_s32(m, zero);
+					uint32x4_t hi = vcgeq_s32(m, d);
+					uint32x4_t any = vorrq_u32(lo, hi);
+					uint32x2_t t   = vorr_u32(vget_low_u32(any), vget_high_u32(any));
+					if (vget_lane_u32(vpmax_u32(t, t), 0) == 0) break;
+					q = vaddq_s32(vsubq_s32(q, vandq_s32(vreinterpretq_s32_u32(lo), one)),
+							vandq_s32(vreinterpretq_s32_u32(hi), one));
+					m = vsubq_s32(vaddq_s32(m, vandq_s32(vreinterpretq_s32_u32(lo), d)),
+							vandq_s32(vreinterpretq_s32_u32(hi), d));
+				}
+				q = vbslq_s32(bz, zero, q);
+				m = vbslq_s32(bz, r, m);
+
+				uint32x4_t qm = veorq_u32(vcltq_s32(a, zero), vcltq_s32(b, zero));
+				uint32x4_t rm = vcleq_s32(a, zero);
+				q = vbslq_s32(qm, vnegq_s32(q), q);
+				m = vbslq_s32(rm, vnegq_s32(m), m);
+				vst1q_s32(out_q + i, vshlq_s32(vshlq_s32(q, ql), qr));
+				vst1q_s32(out_r + i, vshlq_s32(vshlq_s32(m, rl), rr));
+			}
+#else
+			(void)bw; (void)fb;
+#endif
+		}
+		for (; i<n; i++) {
+			int64_t q, r;
+			(*this)(in_a[i], in_b[i], q, r);
+			out_q[i] = (int32_t)q;
+			out_r[i] = (int32_t)r;
+		}
+	}
+};
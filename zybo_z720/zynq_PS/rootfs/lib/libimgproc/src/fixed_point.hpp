@@ -0,0 +1,45 @@
+//-----------------------------------------------------------------------------
+// <fixed_point.hpp>
+//  - Bit-width helpers shared by the models of libimgproc (not installed)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 15, 2020)
+//  - Moved wrap_u(), wrap_s(), sv_round() and bitlen() from the models
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_FIXED_POINT_H_
+#define _IMGPROC_FIXED_POINT_H_
+
+#include <stdint.h>
+#include <math.h>
+
+namespace slab {
+	/* number of bits of <x> ($clog2(x + 1)) */
+	static inline uint32_t bitlen(uint64_t x) {
+		return (x == 0) ? 0 : 64 - __builtin_clzll(x);
+	}
+
+	/* <x> as <bitw> bits unsigned */
+	static inline uint64_t wrap_u(uint64_t x, uint32_t bitw) {
+		return (bitw >= 64) ? x : (x & ((1ULL << bitw) - 1));
+	}
+
+	/* <x> as <bitw> bits signed (1 <= bitw <= 64) */
+	static inline int64_t wrap_s(int64_t x, uint32_t bitw) {
+		return (int64_t)((uint64_t)x << (64 - bitw)) >> (64 - bitw);
+	}
+
+	/* real -> <bitw> bits of SystemVerilog (rounds half away from 0) */
+	static inline uint64_t sv_round(double x, uint32_t bitw) {
+		if (!isfinite(x)) return 0; // 1/0 in the tables of the PL (never used)
+		return wrap_u((uint64_t)llround(x), bitw);
+	}
+
+	/* real -> <bitw> bits signed of SystemVerilog */
+	static inline int64_t sv_round_s(double x, uint32_t bitw) {
+		return wrap_s(llround(x), bitw);
+	}
+};
+
+#endif // _IMGPROC_FIXED_POINT_H_
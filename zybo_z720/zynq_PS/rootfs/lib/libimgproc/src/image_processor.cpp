@@ -0,0 +1,298 @@
+//-----------------------------------------------------------------------------
+// <image_processor.cpp>
+//  - Defined functions of slab::ImageProcessor class
+//    - the outputs follow image_processor.sv (v1.03), line_draw.sv (v1.01)
+//      and slsd_mem_overlay.sv (v1.00)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 16, 2020)
+//  - Added definition for functions of slab::ImageProcessor class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/imgproc/image_processor.hpp>
+#include "fixed_point.hpp"
+#include "parallel.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <thread>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_PROCESSOR_NEON
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#define IMAGE_PROCESSOR_X86
+#endif
+
+#define LINE_FRAC_BITW 8  // FRAC_BITW of line_draw.sv
+#define BAR_TOP        20 // TOP_POS of slsd_mem_overlay.sv
+#define BAR_HEIGHT     20
+
+namespace slab {
+	//-------------------------------------------------------------------------
+	// {3{y}} (gray output)
+	//-------------------------------------------------------------------------
+#if defined(IMAGE_PROCESSOR_X86)
+	/* pshufb masks: 16 bytes of Y -> 48 bytes of B, G, R */
+	static const uint8_t gray_mask[3][16] = {
+		{ 0,  0,  0,  1,  1,  1,  2,  2,  2,  3,  3,  3,  4,  4,  4,  5},
+		{ 5,  5,  6,  6,  6,  7,  7,  7,  8,  8,  8,  9,  9,  9, 10, 10},
+		{10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15}
+	};
+
+	__attribute__((target("ssse3")))
+	static uint32_t gray_row_ssse3(const uint8_t *y, uint8_t *out, uint32_t w) {
+		const __m128i m0 = _mm_loadu_si128((const __m128i*)gray_mask[0]);
+		const __m128i m1 = _mm_loadu_si128((const __m128i*)gray_mask[1]);
+		const __m128i m2 = _mm_loadu_si128((const __m128i*)gray_mask[2]);
+		uint32_t h = 0;
+		for (; h+16<=w; h+=16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(y + h));
+			_mm_storeu_si128((__m128i*)(out + h * 3     ), _mm_shuffle_epi8(v, m0));
+			_mm_storeu_si128((__m128i*)(out + h * 3 + 16), _mm_shuffle_epi8(v, m1));
+			_mm_storeu_si128((__m128i*)(out + h * 3 + 32), _mm_shuffle_epi8(v, m2));
+		}
+		return h;
+	}
+#endif
+
+	static void gray_row(const uint8_t *y, bgr_t *out, uint32_t w, bool simd) {
+		uint8_t *o = (uint8_t*)out;
+		uint32_t h = 0;
+		if (simd) {
+#if defined(IMAGE_PROCESSOR_NEON)
+			for (; h+16<=w; h+=16) {
+				uint8x16x3_t v;
+				v.val[0] = v.val[1] = v.val[2] = vld1q_u8(y + h);
+				vst3q_u8(o + h * 3, v);
+			}
+#elif defined(IMAGE_PROCESSOR_X86)
+			static const bool ssse3 = __builtin_cpu_supports("ssse3");
+			if (ssse3) h = gray_row_ssse3(y, o, w);
+#endif
+		}
+		for (; h<w; h++) o[h * 3] = o[h * 3 + 1] = o[h * 3 + 2] = y[h];
+	}
+
+	ImageProcessorParams image_processor_params(const FrameGeometry& geometry) {
+		ImageProcessorParams params;
+		params.geometry = geometry;
+		params.stretch  = contrast_stretch_params(geometry);
+		params.lsd      = simple_lsd_params(geometry);
+		return params;
+	}
+
+	/* COORD_BITW of line_draw.sv */
+	static uint32_t coord_bitw(const FrameGeometry& g) {
+		return std::max(clog2(g.frame_width), clog2(g.frame_height));
+	}
+
+	//-------------------------------------------------------------------------
+	// ImageProcessor
+	//-------------------------------------------------------------------------
+	ImageProcessor::ImageProcessor(const ImageProcessorParams& params, unsigned threads) :
+		params_  (params                                      ),
+		iw_      (params.geometry.image_width                 ),
+		ih_      (params.geometry.image_height                ),
+		threads_ (1                                           ),
+		simd_    (true                                        ),
+		mode_    (IMGPROC_PASSTHROUGH                         ),
+		gray_    (iw_, ih_, 1                                 ),
+		stretch_ (params.stretch, 1                           ),
+		lsd_     (params.lsd, 1                               ),
+		slope_   (coord_bitw(params.geometry) + 1, LINE_FRAC_BITW)
+	{
+		const uint32_t ram = params_.lsd.ram_size;
+		count_bitw_ = clog2(ram);
+		scale_      = (ram <= iw_) ? 0 : clog2((ram - 1) / iw_ + 1);
+
+		set_threads((threads > 0) ? threads : std::thread::hardware_concurrency());
+		reset();
+	}
+
+	ImageProcessor::~ImageProcessor() {
+	}
+
+	void ImageProcessor::reset() {
+		stretch_.reset();
+		lsd_.reset();
+		frame_ = LineFrame();
+		fb_.assign((size_t)iw_ * ih_, 0);
+		total_count_ = valid_count_ = 0;
+	}
+
+	bool ImageProcessor::set_mode(uint32_t sw) {
+		if (sw > IMGPROC_LSD) return false;
+		/* line_draw of the PL never stops; here mode 3 starts with a clean fb_ram_0 */
+		if (sw != (uint32_t)mode_) std::fill(fb_.begin(), fb_.end(), 0);
+		mode_ = (ImageProcessorMode)sw;
+		return true;
+	}
+
+	void ImageProcessor::set_threads(unsigned threads) {
+		threads_ = (threads > 0) ? threads : 1;
+		stretch_.set_threads(threads_);
+		lsd_.set_threads(threads_);
+	}
+
+	void ImageProcessor::set_simd(bool enable) {
+		simd_ = enable;
+		gray_.set_simd(enable);
+		stretch_.set_simd(enable);
+		lsd_.set_simd(enable);
+	}
+
+	//-------------------------------------------------------------------------
+	// one band: rgb2ycbcr -> contrast_stretch -> output, row by row
+	//-------------------------------------------------------------------------
+	void ImageProcessor::process_rows(const bgr_t *in, size_t in_stride, bgr_t *out, size_t out_stride,
+			uint32_t r0, uint32_t r1, unsigned band) {
+		const uint32_t iw = iw_;
+		uint8_t       *y  = &rows_[(size_t)band * iw * 2];
+		uint8_t       *cs = y + iw;
+
+		for (uint32_t r=r0; r<r1; r++) {
+			const bgr_t *src = (const bgr_t*)((const uint8_t*)in + (size_t)r * in_stride);
+			bgr_t       *dst = (bgr_t*)((uint8_t*)out + (size_t)r * out_stride);
+			if (mode_ == IMGPROC_PASSTHROUGH) {
+				if (src != dst) memcpy(dst, src, (size_t)iw * sizeof(bgr_t));
+				continue;
+			}
+
+			gray_.process_row(src, y);
+			if (mode_ == IMGPROC_LSD) cs = &luma_[(size_t)r * iw];
+			stretch_.convert_rows(y, 0, cs, 0, 0, 1, band);
+
+			switch (mode_) {
+				case IMGPROC_GRAY:    gray_row(y,  dst, iw, simd_); break;
+				case IMGPROC_STRETCH: gray_row(cs, dst, iw, simd_); break;
+				default: {
+					/* lsd_visualizer: fb_ram_0 (erased as it is read) and the bar */
+					uint8_t *fb = &fb_[(size_t)r * iw];
+					gray_row(fb, dst, iw, simd_);
+					memset(fb, 0, iw);
+					overlay_row(dst, r);
+					break;
+				}
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// slsd_mem_overlay (row <v>)
+	//-------------------------------------------------------------------------
+	void ImageProcessor::overlay_row(bgr_t *row, uint32_t v) const {
+		const int64_t rel_v = (int64_t)v - BAR_TOP;
+		if (rel_v < 0 || rel_v >= BAR_HEIGHT) return;
+
+		const uint32_t ram    = params_.lsd.ram_size;
+		const int64_t  width  = ram >> scale_;                   // BAR_WIDTH
+		const int64_t  left   = ((int64_t)iw_ - width) / 2;      // LEFT_POS
+		const int64_t  mark   = (int64_t)((ram * 9 / 10) >> scale_);
+		const int64_t  valid  = valid_count_ >> scale_;
+		const int64_t  total  = total_count_ >> scale_;
+		const bool     inside = (1 <= rel_v && rel_v < BAR_HEIGHT - 1);
+		const bool     edge_v = (rel_v == 0 || rel_v == BAR_HEIGHT - 1);
+
+		for (int64_t h=std::max<int64_t>(left, 0); h<std::min<int64_t>(left + width, iw_); h++) {
+			const int64_t rel_h = h - left;
+			bgr_t&        p     = row[h];
+			if (inside && 1 <= rel_h && rel_h < width - 1) {
+				if (rel_h == mark) {
+					p.r = p.g = p.b = 255;
+				}
+				else if (rel_h <= valid) {
+					p.r = 192 + (p.r >> 2); p.g >>= 2; p.b >>= 2;
+				}
+				else if (rel_h <= total) {
+					p.r >>= 2; p.g = 192 + (p.g >> 2); p.b >>= 2;
+				}
+				else {
+					p.r >>= 2; p.g >>= 2; p.b >>= 2;
+				}
+			}
+			else if ((edge_v && 0 < rel_h && rel_h < width - 1) ||
+					((rel_h == 0 || rel_h == width - 1) && inside)) {
+				p.r = p.g = p.b = 255;
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// line_draw: the segments of the frame into fb_ram_0 (shown next frame)
+	//-------------------------------------------------------------------------
+	void ImageProcessor::draw_lines() {
+		const std::vector<SimpleLSDOutput>& outs = lsd_.outputs();
+		const uint32_t cbw    = slope_.bit_width() - 1;
+		const uint64_t cmask  = (1ULL << cbw) - 1;
+		const uint32_t fbw    = cbw + LINE_FRAC_BITW + 2;           // FIXED_BITW
+		const uint32_t abw    = clog2((uint64_t)iw_ * ih_);         // ADDR_BITW
+		const uint64_t pixels = (uint64_t)iw_ * ih_;
+		uint32_t       valid  = 0;
+
+		for (size_t i=0; i<outs.size(); i++) {
+			const SimpleLSDOutput& o = outs[i];
+			valid += o.valid;
+			if (!o.valid) continue;
+
+			/* [stage 1-2] the longer axis becomes x, left to right */
+			int64_t dv = std::abs((int64_t)o.start_v - o.end_v);
+			int64_t dh = std::abs((int64_t)o.start_h - o.end_h);
+			bool    swap = (dv > dh);
+			int64_t sx = swap ? o.start_v : o.start_h, sy = swap ? o.start_h : o.start_v;
+			int64_t ex = swap ? o.end_v   : o.end_h,   ey = swap ? o.end_h   : o.end_v;
+			if (ex < sx) {
+				std::swap(sx, ex);
+				std::swap(sy, ey);
+			}
+
+			/* slope (div_0, FRAC_BITW + 2 bits) and the walk of drw_state 2 */
+			int64_t q, rem;
+			slope_(ey - sy, ex - sx, q, rem);
+			const int64_t slope = wrap_s(q, LINE_FRAC_BITW + 2);
+			int64_t  cy = (sy << LINE_FRAC_BITW) | (1 << (LINE_FRAC_BITW - 1));
+			uint64_t cx = sx;
+			for (;;) {
+				uint64_t y    = (uint64_t)(cy >> LINE_FRAC_BITW) & cmask;
+				uint64_t addr = wrap_u((swap ? cx : y) * iw_ + (swap ? y : cx), abw);
+				if (addr < pixels) fb_[addr] = 255;
+				if (cx == (uint64_t)ex) break;
+				cx = (cx + 1) & cmask;
+				cy = wrap_s(cy + slope, fbw);
+			}
+		}
+
+		/* total_count / valid_count hold the last burst of out_flag */
+		if (!outs.empty()) {
+			total_count_ = wrap_u(outs.size(), count_bitw_);
+			valid_count_ = wrap_u(valid, count_bitw_);
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// frame
+	//-------------------------------------------------------------------------
+	void ImageProcessor::process(const bgr_t *in, size_t in_stride, bgr_t *out, size_t out_stride) {
+		const unsigned bands = parallel_bands(threads_, ih_);
+
+		if (mode_ != IMGPROC_PASSTHROUGH) {
+			rows_.resize((size_t)bands * iw_ * 2);
+			stretch_.begin_frame(bands);
+		}
+		if (mode_ == IMGPROC_LSD) luma_.resize((size_t)iw_ * ih_);
+
+		parallel_rows(threads_, ih_, [this, in, in_stride, out, out_stride]
+				(uint32_t r0, uint32_t r1, unsigned band) {
+			process_rows(in, in_stride, out, out_stride, r0, r1, band);
+		});
+
+		if (mode_ != IMGPROC_PASSTHROUGH) stretch_.end_frame();
+		if (mode_ == IMGPROC_LSD) {
+			lsd_.process(luma_.data(), iw_, frame_);
+			draw_lines();
+		}
+	}
+};
@@ -0,0 +1,102 @@
+//-----------------------------------------------------------------------------
+// <imgproc.cpp>
+//  - Defined functions of slab::GrayImage class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 10, 2020)
+//  - Added definition for functions of slab::GrayImage class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/imgproc.hpp>
+
+#include <stdio.h>
+#include <ctype.h>
+
+namespace slab {
+	uint32_t clog2(uint64_t n) {
+		uint32_t w = 0;
+		while (n > 1 && ((uint64_t)1 << w) < n) w++;
+		return w;
+	}
+
+	GrayImage::GrayImage() :
+		width_  (0),
+		height_ (0)
+	{
+	}
+
+	GrayImage::GrayImage(uint32_t width, uint32_t height, uint8_t fill) :
+		width_  (width ),
+		height_ (height),
+		data_   ((size_t)width * height, fill)
+	{
+	}
+
+	GrayImage::~GrayImage() {
+	}
+
+	void GrayImage::resize(uint32_t width, uint32_t height, uint8_t fill) {
+		width_  = width;
+		height_ = height;
+		data_.assign((size_t)width * height, fill);
+	}
+
+	/* reads one header field of PGM (skips white spaces and comments) */
+	static bool pgm_field(FILE *fp, uint32_t& value) {
+		int c;
+		do {
+			c = fgetc(fp);
+			if (c == '#') {
+				while (c != '\n' && c != EOF) c = fgetc(fp);
+			}
+		} while (c != EOF && isspace(c));
+		if (c == EOF || !isdigit(c)) return false;
+
+		value = 0;
+		while (c != EOF && isdigit(c)) {
+			value = value * 10 + (c - '0');
+			c = fgetc(fp);
+		}
+		return c != EOF && isspace(c); // exactly one white space before data
+	}
+
+	bool GrayImage::load_pgm(const std::string& path) {
+		FILE     *fp;
+		uint32_t  w, h, maxval;
+
+		if ((fp = fopen(path.c_str(), "rb")) == NULL) {
+			perror("cannot open image");
+			return false;
+		}
+		if (fgetc(fp) != 'P' || fgetc(fp) != '5' ||
+				!pgm_field(fp, w) || !pgm_field(fp, h) || !pgm_field(fp, maxval) || maxval != 255) {
+			fprintf(stderr, "%s: not a binary 8-bit PGM\n", path.c_str());
+			fclose(fp);
+			return false;
+		}
+
+		resize(w, h);
+		if (fread(data_.data(), 1, data_.size(), fp) != data_.size()) {
+			fprintf(stderr, "%s: truncated image\n", path.c_str());
+			fclose(fp);
+			return false;
+		}
+		fclose(fp);
+		return true;
+	}
+
+	bool GrayImage::save_pgm(const std::string& path) const {
+		FILE *fp;
+
+		if ((fp = fopen(path.c_str(), "wb")) == NULL) {
+			perror("cannot open image");
+			return false;
+		}
+		fprintf(fp, "P5\n%u %u\n255\n", width_, height_);
+		bool ok = fwrite(data_.data(), 1, data_.size(), fp) == data_.size();
+		if (!ok) perror("cannot write image");
+		fclose(fp);
+		return ok;
+	}
+};
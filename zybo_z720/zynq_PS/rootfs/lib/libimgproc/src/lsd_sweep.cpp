@@ -0,0 +1,257 @@
+//-----------------------------------------------------------------------------
+// <lsd_sweep.cpp>
+//  - Defined functions of slab::LSDFrameCache and slab::LSDSweep classes
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 19, 2020)
+//  - Added definition for functions of slab::LSDFrameCache class
+//  - Added definition for functions of slab::LSDSweep class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 30, 2020)
+//  - Readback estimated from the lines held in RAM_SIZE of the point
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/imgproc/lsd_sweep.hpp>
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <set>
+#include <thread>
+
+/* register accesses of LSDReader::fetch() (liblsd, lsd.cpp) */
+#define FETCH_READS(lines)  (2 + 4 * (uint64_t)(lines)) // ready, line_num, 4 per line
+#define FETCH_WRITES(lines) (2 + (uint64_t)(lines))     // protect, release, raddr per line
+
+namespace slab {
+	static inline uint64_t size_key(uint32_t width, uint32_t height) {
+		return (uint64_t)width << 32 | height;
+	}
+
+	/* bilinear, sampled at the centres of the output pixels (16.16 fixed point) */
+	static void resample(const GrayImage& in, GrayImage& out, uint32_t width, uint32_t height) {
+		const uint32_t iw = in.width(), ih = in.height();
+		out.resize(width, height);
+		std::vector<uint32_t> x0(width), fx(width);
+		for (uint32_t u=0; u<width; u++) {
+			int64_t x = ((2 * (int64_t)u + 1) * iw << 16) / (2 * width) - (1 << 15);
+			x = std::max<int64_t>(0, std::min<int64_t>(x, (int64_t)(iw - 1) << 16));
+			x0[u] = x >> 16;
+			fx[u] = x & 0xffff;
+		}
+		for (uint32_t v=0; v<height; v++) {
+			int64_t y = ((2 * (int64_t)v + 1) * ih << 16) / (2 * height) - (1 << 15);
+			y = std::max<int64_t>(0, std::min<int64_t>(y, (int64_t)(ih - 1) << 16));
+			const uint32_t y0 = y >> 16, fy = y & 0xffff;
+			const uint8_t *r0 = in.row(y0), *r1 = in.row(std::min(y0 + 1, ih - 1));
+			uint8_t *o = out.row(v);
+			for (uint32_t u=0; u<width; u++) {
+				const uint32_t a = x0[u], b = std::min(a + 1, iw - 1), f = fx[u];
+				uint64_t top = (uint64_t)r0[a] * (0x10000 - f) + (uint64_t)r0[b] * f;
+				uint64_t bot = (uint64_t)r1[a] * (0x10000 - f) + (uint64_t)r1[b] * f;
+				o[u] = (uint8_t)((top * (0x10000 - fy) + bot * fy + (1ULL << 31)) >> 32);
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// LSDFrameCache
+	//-------------------------------------------------------------------------
+	LSDFrameCache::LSDFrameCache() {
+	}
+
+	LSDFrameCache::~LSDFrameCache() {
+	}
+
+	bool LSDFrameCache::load(const std::vector<std::string>& paths, unsigned threads) {
+		std::vector<GrayImage> frames(paths.size());
+		std::atomic<bool>      ok(true);
+		if (threads == 0) threads = std::thread::hardware_concurrency();
+
+		parallel_rows(threads, paths.size(), [&](uint32_t r0, uint32_t r1, unsigned) {
+			for (uint32_t i=r0; i<r1; i++) {
+				if (!frames[i].load_pgm(paths[i])) {
+					fprintf(stderr, "%s: cannot load\n", paths[i].c_str());
+					ok = false;
+				}
+			}
+		});
+		if (!ok) return false;
+		for (size_t i=0; i<frames.size(); i++) {
+			if (frames[i].width() != frames[0].width() || frames[i].height() != frames[0].height()) {
+				fprintf(stderr, "%s: size mismatch\n", paths[i].c_str());
+				return false;
+			}
+		}
+		for (size_t i=0; i<frames.size(); i++) add(frames[i]);
+		return true;
+	}
+
+	void LSDFrameCache::add(const GrayImage& image) {
+		source_.push_back(image);
+		scaled_.clear();
+	}
+
+	void LSDFrameCache::prepare(uint32_t width, uint32_t height, unsigned threads) {
+		if ((width == this->width() && height == this->height()) || scaled_.count(size_key(width, height))) return;
+		std::vector<GrayImage>& frames = scaled_[size_key(width, height)];
+		if (threads == 0) threads = std::thread::hardware_concurrency();
+
+		frames.resize(source_.size());
+		parallel_rows(threads, source_.size(), [&](uint32_t r0, uint32_t r1, unsigned) {
+			for (uint32_t i=r0; i<r1; i++) resample(source_[i], frames[i], width, height);
+		});
+	}
+
+	const std::vector<GrayImage>& LSDFrameCache::frames(uint32_t width, uint32_t height) const {
+		std::map<uint64_t, std::vector<GrayImage> >::const_iterator it = scaled_.find(size_key(width, height));
+		return (it != scaled_.end()) ? it->second : source_;
+	}
+
+	//-------------------------------------------------------------------------
+	// LSDSweep
+	//-------------------------------------------------------------------------
+	LSDSweep::LSDSweep(LSDFrameCache& cache, unsigned threads) :
+		cache_       (cache),
+		auto_offset_ (true ),
+		read_ns_     (250.0),
+		write_ns_    (100.0),
+		fps_         (60.0 )
+	{
+		set_threads(threads);
+	}
+
+	LSDSweep::~LSDSweep() {
+	}
+
+	void LSDSweep::set_threads(unsigned threads) {
+		threads_ = (threads > 0) ? threads : std::thread::hardware_concurrency();
+		if (threads_ == 0) threads_ = 1;
+	}
+
+	void LSDSweep::add(const LSDSweepPoint& point) {
+		points_.push_back(point);
+	}
+
+	void LSDSweep::add_grid(const std::vector<FrameGeometry>& geometry, const std::vector<uint8_t>& angle,
+			const std::vector<uint8_t>& grad, const std::vector<uint8_t>& length,
+			const std::vector<uint32_t>& ram_size) {
+		for (size_t g=0; g<geometry.size(); g++)
+		for (size_t r=0; r<ram_size.size(); r++)
+		for (size_t a=0; a<angle.size(); a++)
+		for (size_t d=0; d<grad.size(); d++)
+		for (size_t l=0; l<length.size(); l++) {
+			LSDSweepPoint p;
+			p.geometry     = geometry[g];
+			p.thres.angle  = angle[a];
+			p.thres.grad   = grad[d];
+			p.thres.length = length[l];
+			p.ram_size     = ram_size[r];
+			points_.push_back(p);
+		}
+	}
+
+	void LSDSweep::run_point(const LSDSweepPoint& point, LSDSweepResult& result) const {
+		const FrameGeometry&          g      = point.geometry;
+		const std::vector<GrayImage>& frames = cache_.frames(g.image_width, g.image_height);
+		SimpleLSDParams params;
+		params.geometry = g;
+		params.thres    = point.thres;
+		params.ram_size = point.ram_size;
+
+		SimpleLSD lsd(params, 1);
+		LineFrame frame;
+		LSDThresholds in = {0, 0, 0};
+		lsd.set_thresholds(in, !auto_offset_);
+
+		uint64_t segments = 0, lines = 0;
+		result.point        = point;
+		result.frames       = frames.size();
+		result.segments_max = 0;
+		result.overused     = 0;
+		result.wrapped      = 0;
+		const uint64_t t0 = monotonic_ns();
+		for (size_t i=0; i<frames.size(); i++) {
+			lsd.process(frames[i], frame);
+			const std::vector<SimpleLSDOutput>& out = lsd.outputs();
+			uint32_t valid = 0;
+			for (size_t k=0; k<out.size(); k++) valid += out[k].valid;
+			segments += valid;
+			lines    += std::min(valid, point.ram_size); // frame.count is capped at LSD_BUFSIZE
+			result.segments_max = std::max(result.segments_max, valid);
+			result.overused    += lsd.overused();
+			result.wrapped     += (valid > point.ram_size);
+		}
+		const uint64_t t1 = monotonic_ns();
+
+		const double n = std::max<size_t>(frames.size(), 1);
+		result.segments    = segments / n;
+		result.lines       = lines / n;
+		result.reads       = (FETCH_READS(0)  * frames.size() + 4 * lines) / n;
+		result.writes      = (FETCH_WRITES(0) * frames.size() + lines) / n;
+		result.readback_us = (result.reads * read_ns_ + result.writes * write_ns_) / 1e3;
+		result.model_ms    = (t1 - t0) / 1e6 / n;
+	}
+
+	const std::vector<LSDSweepResult>& LSDSweep::run() {
+		/* frames at every resolution first */
+		std::set<uint64_t> sizes;
+		for (size_t i=0; i<points_.size(); i++) {
+			const FrameGeometry& g = points_[i].geometry;
+			if (sizes.insert(size_key(g.image_width, g.image_height)).second)
+				cache_.prepare(g.image_width, g.image_height, threads_);
+		}
+
+		/* largest frames first, one worker per core */
+		std::vector<size_t> order(points_.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+			const FrameGeometry& ga = points_[a].geometry;
+			const FrameGeometry& gb = points_[b].geometry;
+			return (uint64_t)ga.image_width * ga.image_height > (uint64_t)gb.image_width * gb.image_height;
+		});
+		results_.assign(points_.size(), LSDSweepResult());
+		std::atomic<size_t> next(0);
+		parallel_rows(threads_, points_.size(), [&](uint32_t, uint32_t, unsigned) {
+			for (size_t k; (k = next++) < order.size(); )
+				run_point(points_[order[k]], results_[order[k]]);
+		});
+		return results_;
+	}
+
+	void LSDSweep::print(FILE *fp, bool csv) const {
+		const double frame_us = 1e6 / fps_;
+		if (csv) {
+			fprintf(fp, "width,height,angle,grad,length,ram_size,frames,segments,segments_max,lines,"
+					"overused_rate,wrapped_rate,reads,writes,readback_us,readback_frame,model_ms\n");
+		}
+		else {
+			fprintf(fp, "%u frames, %.0f ns per read, %.0f ns per write, %.0f frames/s, offset control %s\n",
+					(unsigned)cache_.size(), read_ns_, write_ns_, fps_, auto_offset_ ? "on" : "off");
+			fprintf(fp, "resolution  angle grad len  ram  | seg/frame   max   lines | over%%  wrap%% |"
+					"  reads writes readback[us] frame%% | model[ms]\n");
+		}
+		for (size_t i=0; i<results_.size(); i++) {
+			const LSDSweepResult& r = results_[i];
+			const LSDSweepPoint&  p = r.point;
+			const double f = std::max<uint32_t>(r.frames, 1);
+			if (csv) {
+				fprintf(fp, "%u,%u,%u,%u,%u,%u,%u,%.2f,%u,%.2f,%.4f,%.4f,%.1f,%.1f,%.1f,%.4f,%.3f\n",
+						p.geometry.image_width, p.geometry.image_height, p.thres.angle, p.thres.grad,
+						p.thres.length, p.ram_size, r.frames, r.segments, r.segments_max, r.lines,
+						r.overused / f, r.wrapped / f, r.reads, r.writes, r.readback_us,
+						r.readback_us / frame_us, r.model_ms);
+			}
+			else {
+				char res[16];
+				snprintf(res, sizeof(res), "%ux%u", p.geometry.image_width, p.geometry.image_height);
+				fprintf(fp, "%-10s  %5u %4u %3u %5u | %9.1f %5u %7.1f | %5.1f  %5.1f | %6.0f %6.0f %12.1f %6.1f | %9.2f\n",
+						res, p.thres.angle, p.thres.grad, p.thres.length, p.ram_size,
+						r.segments, r.segments_max, r.lines, 100.0 * r.overused / f, 100.0 * r.wrapped / f,
+						r.reads, r.writes, r.readback_us, 100.0 * r.readback_us / frame_us, r.model_ms);
+			}
+		}
+	}
+};
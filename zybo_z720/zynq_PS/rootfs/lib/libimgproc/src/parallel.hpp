@@ -0,0 +1,39 @@
+//-----------------------------------------------------------------------------
+// <parallel.hpp>
+//  - Row-band threading shared by the models of libimgproc (not installed)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 11, 2020)
+//  - Moved parallel_rows() from simple_lsd.cpp
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _IMGPROC_PARALLEL_H_
+#define _IMGPROC_PARALLEL_H_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace slab {
+	/* number of bands parallel_rows() uses for <rows> */
+	static inline unsigned parallel_bands(unsigned threads, uint32_t rows) {
+		return std::max(1u, std::min(threads, rows));
+	}
+
+	/* splits [0, rows) into bands and runs fn(r0, r1, band) for every band */
+	template <class F>
+	static void parallel_rows(unsigned threads, uint32_t rows, F fn) {
+		unsigned n = parallel_bands(threads, rows);
+		std::vector<std::thread> workers;
+		for (unsigned i=1; i<n; i++)
+			workers.emplace_back(fn, (uint32_t)((uint64_t)rows * i / n),
+					(uint32_t)((uint64_t)rows * (i + 1) / n), i);
+		fn(0, (uint32_t)(rows / n), 0u);
+		for (size_t i=0; i<workers.size(); i++) workers[i].join();
+	}
+};
+
+#endif // _IMGPROC_PARALLEL_H_
@@ -0,0 +1,380 @@
+//-----------------------------------------------------------------------------
+// <rgb2ycbcr.cpp>
+//  - Defined functions of slab::RGB2YCbCr class
+//    - the integer weights of rgb2ycbcr.hpp are those of rgb2ycbcr.sv
+//      (v1.05); every kernel gives the same bytes as rgb2y/cb/cr()
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 12, 2020)
+//  - Added definition for functions of slab::RGB2YCbCr class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 16, 2020)
+//  - Added process_row() for fused pipelines
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/imgproc/rgb2ycbcr.hpp>
+#include "parallel.hpp"
+
+#include <mutex>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define YCBCR_NEON
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#define YCBCR_X86
+#endif
+
+namespace slab {
+	//-------------------------------------------------------------------------
+	// scalar
+	//-------------------------------------------------------------------------
+	static void y_row_scalar(const uint8_t *in, uint8_t *y, uint32_t h, uint32_t w) {
+		for (; h<w; h++) {
+			const uint8_t *p = in + h * 3;
+			y[h] = rgb2y(p[2], p[1], p[0]);
+		}
+	}
+
+	static void ycc_row_scalar(const uint8_t *in, uint8_t *out, uint32_t h, uint32_t w) {
+		for (; h<w; h++) {
+			const uint8_t b = in[h * 3], g = in[h * 3 + 1], r = in[h * 3 + 2];
+			out[h * 3    ] = rgb2y (r, g, b);
+			out[h * 3 + 1] = rgb2cb(r, g, b);
+			out[h * 3 + 2] = rgb2cr(r, g, b);
+		}
+	}
+
+#if defined(YCBCR_NEON)
+	//-------------------------------------------------------------------------
+	// NEON (16 pixels for Y, 8 pixels for YCbCr)
+	//-------------------------------------------------------------------------
+	static inline uint8x8_t y8_neon(uint8x8_t b, uint8x8_t g, uint8x8_t r) {
+		uint16x8_t b16 = vmovl_u8(b), g16 = vmovl_u8(g), r16 = vmovl_u8(r);
+		uint32x4_t lo  = vmull_n_u16(vget_low_u16 (r16), 435);
+		uint32x4_t hi  = vmull_n_u16(vget_high_u16(r16), 435);
+		lo = vmlal_n_u16(lo, vget_low_u16 (g16), 1465);
+		hi = vmlal_n_u16(hi, vget_high_u16(g16), 1465);
+		lo = vmlal_n_u16(lo, vget_low_u16 (b16),  148);
+		hi = vmlal_n_u16(hi, vget_high_u16(b16),  148);
+		return vmovn_u16(vcombine_u16(vrshrn_n_u32(lo, 11), vrshrn_n_u32(hi, 11)));
+	}
+
+	/* (wr R + wg G + wb B) >> 11, + 128 */
+	static inline uint8x8_t c8_neon(uint8x8_t b, uint8x8_t g, uint8x8_t r,
+			int16_t wr, int16_t wg, int16_t wb) {
+		int16x8_t b16 = vreinterpretq_s16_u16(vmovl_u8(b));
+		int16x8_t g16 = vreinterpretq_s16_u16(vmovl_u8(g));
+		int16x8_t r16 = vreinterpretq_s16_u16(vmovl_u8(r));
+		int32x4_t lo  = vmull_n_s16(vget_low_s16 (r16), wr);
+		int32x4_t hi  = vmull_n_s16(vget_high_s16(r16), wr);
+		lo = vmlal_n_s16(lo, vget_low_s16 (g16), wg);
+		hi = vmlal_n_s16(hi, vget_high_s16(g16), wg);
+		lo = vmlal_n_s16(lo, vget_low_s16 (b16), wb);
+		hi = vmlal_n_s16(hi, vget_high_s16(b16), wb);
+		int16x8_t s = vcombine_s16(vshrn_n_s32(lo, 11), vshrn_n_s32(hi, 11));
+		return vqmovun_s16(vaddq_s16(s, vdupq_n_s16(128)));
+	}
+
+	static void y_row_neon(const uint8_t *in, uint8_t *y, uint32_t w) {
+		uint32_t h = 0;
+		for (; h+16<=w; h+=16) {
+			uint8x16x3_t p = vld3q_u8(in + h * 3); // B, G, R
+			vst1q_u8(y + h, vcombine_u8(
+					y8_neon(vget_low_u8 (p.val[0]), vget_low_u8 (p.val[1]), vget_low_u8 (p.val[2])),
+					y8_neon(vget_high_u8(p.val[0]), vget_high_u8(p.val[1]), vget_high_u8(p.val[2]))));
+		}
+		y_row_scalar(in, y, h, w);
+	}
+
+	static void ycc_row_neon(const uint8_t *in, uint8_t *out, uint32_t w) {
+		uint32_t h = 0;
+		for (; h+8<=w; h+=8) {
+			uint8x8x3_t p = vld3_u8(in + h * 3), q;
+			q.val[0] = y8_neon(p.val[0], p.val[1], p.val[2]);
+			q.val[1] = c8_neon(p.val[0], p.val[1], p.val[2], -235, -789, 1024);
+			q.val[2] = c8_neon(p.val[0], p.val[1], p.val[2], 1024, -930,  -94);
+			vst3_u8(out + h * 3, q);
+		}
+		ycc_row_scalar(in, out, h, w);
+	}
+#endif
+
+#if defined(YCBCR_X86)
+	//-------------------------------------------------------------------------
+	// SSSE3 (16 pixels) and AVX2 (32 pixels)
+	//-------------------------------------------------------------------------
+	/* pshufb masks: 48 bytes of B, G, R <-> 16 bytes of each channel */
+	static uint8_t deint_mask[3][3][16]; // [channel][source vector]
+	static uint8_t inter_mask[3][3][16]; // [destination vector][channel]
+	static std::once_flag masks_once;
+
+	static void init_masks() {
+		for (int c=0; c<3; c++) {
+			for (int v=0; v<3; v++) {
+				for (int j=0; j<16; j++) {
+					int src = j * 3 + c;     // byte of pixel j, channel c
+					deint_mask[c][v][j] = (src / 16 == v) ? src % 16 : 0x80;
+					int dst = v * 16 + j;    // byte j of destination vector v
+					inter_mask[v][c][j] = (dst % 3 == c) ? dst / 3 : 0x80;
+				}
+			}
+		}
+	}
+
+	/* 8 pixels in 16-bit lanes: (wr R + wg G + wb B + wc C) >> 11 */
+	static inline __m128i dot8_sse(__m128i r, __m128i g, __m128i b,
+			__m128i wrg, __m128i wbc, __m128i c) {
+		__m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r, g), wrg),
+				_mm_madd_epi16(_mm_unpacklo_epi16(b, c), wbc));
+		__m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r, g), wrg),
+				_mm_madd_epi16(_mm_unpackhi_epi16(b, c), wbc));
+		return _mm_packs_epi32(_mm_srai_epi32(lo, 11), _mm_srai_epi32(hi, 11));
+	}
+
+	/* 16 pixels in 8-bit lanes */
+	static inline __m128i dot16_sse(__m128i r, __m128i g, __m128i b,
+			__m128i wrg, __m128i wbc, __m128i c) {
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_packus_epi16(
+				dot8_sse(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero),
+					_mm_unpacklo_epi8(b, zero), wrg, wbc, c),
+				dot8_sse(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero),
+					_mm_unpackhi_epi8(b, zero), wrg, wbc, c));
+	}
+
+	__attribute__((target("ssse3")))
+	static inline void load16_ssse3(const uint8_t *p, __m128i& b, __m128i& g, __m128i& r) {
+		__m128i v[3], ch[3];
+		for (int i=0; i<3; i++) v[i] = _mm_loadu_si128((const __m128i*)(p + i * 16));
+		for (int c=0; c<3; c++) {
+			ch[c] = _mm_or_si128(_mm_or_si128(
+						_mm_shuffle_epi8(v[0], _mm_loadu_si128((const __m128i*)deint_mask[c][0])),
+						_mm_shuffle_epi8(v[1], _mm_loadu_si128((const __m128i*)deint_mask[c][1]))),
+					_mm_shuffle_epi8(v[2], _mm_loadu_si128((const __m128i*)deint_mask[c][2])));
+		}
+		b = ch[0];
+		g = ch[1];
+		r = ch[2];
+	}
+
+	__attribute__((target("ssse3")))
+	static inline void store16_ssse3(uint8_t *p, __m128i y, __m128i cb, __m128i cr) {
+		for (int v=0; v<3; v++) {
+			__m128i o = _mm_or_si128(_mm_or_si128(
+						_mm_shuffle_epi8(y,  _mm_loadu_si128((const __m128i*)inter_mask[v][0])),
+						_mm_shuffle_epi8(cb, _mm_loadu_si128((const __m128i*)inter_mask[v][1]))),
+					_mm_shuffle_epi8(cr, _mm_loadu_si128((const __m128i*)inter_mask[v][2])));
+			_mm_storeu_si128((__m128i*)(p + v * 16), o);
+		}
+	}
+
+	__attribute__((target("ssse3")))
+	static void y_row_ssse3(const uint8_t *in, uint8_t *y, uint32_t w) {
+		const __m128i wrg = _mm_set_epi16(1465, 435, 1465, 435, 1465, 435, 1465, 435);
+		const __m128i wbc = _mm_set_epi16(1024, 148, 1024, 148, 1024, 148, 1024, 148);
+		const __m128i one = _mm_set1_epi16(1);
+		uint32_t h = 0;
+		for (; h+16<=w; h+=16) {
+			__m128i b, g, r;
+			load16_ssse3(in + h * 3, b, g, r);
+			_mm_storeu_si128((__m128i*)(y + h), dot16_sse(r, g, b, wrg, wbc, one));
+		}
+		y_row_scalar(in, y, h, w);
+	}
+
+	__attribute__((target("ssse3")))
+	static void ycc_row_ssse3(const uint8_t *in, uint8_t *out, uint32_t w) {
+		const __m128i wrg_y  = _mm_set_epi16(1465, 435, 1465, 435, 1465, 435, 1465, 435);
+		const __m128i wbc_y  = _mm_set_epi16(1024, 148, 1024, 148, 1024, 148, 1024, 148);
+		const __m128i wrg_cb = _mm_set_epi16(-789, -235, -789, -235, -789, -235, -789, -235);
+		const __m128i wbc_cb = _mm_set1_epi16(1024);
+		const __m128i wrg_cr = _mm_set_epi16(-930, 1024, -930, 1024, -930, 1024, -930, 1024);
+		const __m128i wbc_cr = _mm_set_epi16(1024, -94, 1024, -94, 1024, -94, 1024, -94);
+		const __m128i one = _mm_set1_epi16(1), bias = _mm_set1_epi16(256);
+		uint32_t h = 0;
+		for (; h+16<=w; h+=16) {
+			__m128i b, g, r;
+			load16_ssse3(in + h * 3, b, g, r);
+			store16_ssse3(out + h * 3,
+					dot16_sse(r, g, b, wrg_y,  wbc_y,  one ),
+					dot16_sse(r, g, b, wrg_cb, wbc_cb, bias),
+					dot16_sse(r, g, b, wrg_cr, wbc_cr, bias));
+		}
+		ycc_row_scalar(in, out, h, w);
+	}
+
+	/* 16 pixels of two 128-bit halves in 16-bit lanes (lane order is kept) */
+	__attribute__((target("avx2")))
+	static inline __m256i dot32_avx2(__m256i r, __m256i g, __m256i b,
+			__m256i wrg, __m256i wbc, __m256i c) {
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i res[2];
+		for (int i=0; i<2; i++) {
+			__m256i r16 = i ? _mm256_unpackhi_epi8(r, zero) : _mm256_unpacklo_epi8(r, zero);
+			__m256i g16 = i ? _mm256_unpackhi_epi8(g, zero) : _mm256_unpacklo_epi8(g, zero);
+			__m256i b16 = i ? _mm256_unpackhi_epi8(b, zero) : _mm256_unpacklo_epi8(b, zero);
+			__m256i lo  = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(r16, g16), wrg),
+					_mm256_madd_epi16(_mm256_unpacklo_epi16(b16, c), wbc));
+			__m256i hi  = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(r16, g16), wrg),
+					_mm256_madd_epi16(_mm256_unpackhi_epi16(b16, c), wbc));
+			res[i] = _mm256_packs_epi32(_mm256_srai_epi32(lo, 11), _mm256_srai_epi32(hi, 11));
+		}
+		return _mm256_packus_epi16(res[0], res[1]);
+	}
+
+	__attribute__((target("avx2")))
+	static inline void load32_avx2(const uint8_t *p, __m256i& b, __m256i& g, __m256i& r) {
+		__m128i b0, g0, r0, b1, g1, r1;
+		load16_ssse3(p,      b0, g0, r0);
+		load16_ssse3(p + 48, b1, g1, r1);
+		b = _mm256_inserti128_si256(_mm256_castsi128_si256(b0), b1, 1);
+		g = _mm256_inserti128_si256(_mm256_castsi128_si256(g0), g1, 1);
+		r = _mm256_inserti128_si256(_mm256_castsi128_si256(r0), r1, 1);
+	}
+
+	__attribute__((target("avx2")))
+	static void y_row_avx2(const uint8_t *in, uint8_t *y, uint32_t w) {
+		const __m256i wrg = _mm256_set1_epi32((1465 << 16) | 435);
+		const __m256i wbc = _mm256_set1_epi32((1024 << 16) | 148);
+		const __m256i one = _mm256_set1_epi16(1);
+		uint32_t h = 0;
+		for (; h+32<=w; h+=32) {
+			__m256i b, g, r;
+			load32_avx2(in + h * 3, b, g, r);
+			_mm256_storeu_si256((__m256i*)(y + h), dot32_avx2(r, g, b, wrg, wbc, one));
+		}
+		y_row_scalar(in, y, h, w);
+	}
+
+	__attribute__((target("avx2")))
+	static void ycc_row_avx2(const uint8_t *in, uint8_t *out, uint32_t w) {
+		const __m256i wrg_y  = _mm256_set1_epi32((1465 << 16) | 435);
+		const __m256i wbc_y  = _mm256_set1_epi32((1024 << 16) | 148);
+		const __m256i wrg_cb = _mm256_set1_epi32((int32_t)(((uint32_t)(uint16_t)-789 << 16) | (uint16_t)-235));
+		const __m256i wbc_cb = _mm256_set1_epi16(1024);
+		const __m256i wrg_cr = _mm256_set1_epi32((int32_t)(((uint32_t)(uint16_t)-930 << 16) | 1024));
+		const __m256i wbc_cr = _mm256_set1_epi32((int32_t)((1024u << 16) | (uint16_t)-94));
+		const __m256i one = _mm256_set1_epi16(1), bias = _mm256_set1_epi16(256);
+		uint32_t h = 0;
+		for (; h+32<=w; h+=32) {
+			__m256i b, g, r;
+			load32_avx2(in + h * 3, b, g, r);
+			__m256i y  = dot32_avx2(r, g, b, wrg_y,  wbc_y,  one );
+			__m256i cb = dot32_avx2(r, g, b, wrg_cb, wbc_cb, bias);
+			__m256i cr = dot32_avx2(r, g, b, wrg_cr, wbc_cr, bias);
+			store16_ssse3(out + h * 3,      _mm256_castsi256_si128(y),
+					_mm256_castsi256_si128(cb), _mm256_castsi256_si128(cr));
+			store16_ssse3(out + h * 3 + 48, _mm256_extracti128_si256(y, 1),
+					_mm256_extracti128_si256(cb, 1), _mm256_extracti128_si256(cr, 1));
+		}
+		ycc_row_scalar(in, out, h, w);
+	}
+#endif
+
+	//-------------------------------------------------------------------------
+	// RGB2YCbCr
+	//-------------------------------------------------------------------------
+	RGB2YCbCr::RGB2YCbCr(uint32_t width, uint32_t height, unsigned threads) :
+		iw_      (width           ),
+		ih_      (height          ),
+		threads_ (1               ),
+		kernel_  (RGB2YCBCR_SCALAR)
+	{
+#if defined(YCBCR_X86)
+		std::call_once(masks_once, init_masks);
+#endif
+		set_threads((threads > 0) ? threads : std::thread::hardware_concurrency());
+		set_simd(true);
+	}
+
+	RGB2YCbCr::~RGB2YCbCr() {
+	}
+
+	bool RGB2YCbCr::supported(RGB2YCbCrKernel kernel) {
+		switch (kernel) {
+			case RGB2YCBCR_SCALAR: return true;
+#if defined(YCBCR_NEON)
+			case RGB2YCBCR_NEON:   return true;
+#endif
+#if defined(YCBCR_X86)
+			case RGB2YCBCR_SSSE3:  return __builtin_cpu_supports("ssse3");
+			case RGB2YCBCR_AVX2:   return __builtin_cpu_supports("avx2");
+#endif
+			default:               return false;
+		}
+	}
+
+	void RGB2YCbCr::set_simd(bool enable) {
+		static const RGB2YCbCrKernel order[] = {RGB2YCBCR_NEON, RGB2YCBCR_AVX2, RGB2YCBCR_SSSE3};
+		kernel_ = RGB2YCBCR_SCALAR;
+		for (size_t i=0; enable && i<sizeof(order)/sizeof(order[0]); i++) {
+			if (supported(order[i])) {
+				kernel_ = order[i];
+				break;
+			}
+		}
+	}
+
+	bool RGB2YCbCr::set_kernel(RGB2YCbCrKernel kernel) {
+		if (!supported(kernel)) return false;
+		kernel_ = kernel;
+		return true;
+	}
+
+	const char *RGB2YCbCr::kernel_name() const {
+		static const char *names[] = {"scalar", "ssse3", "avx2", "neon"};
+		return names[kernel_];
+	}
+
+	void RGB2YCbCr::process_row(const bgr_t *in, uint8_t *y) const {
+		const uint8_t *p = (const uint8_t*)in;
+		switch (kernel_) {
+#if defined(YCBCR_NEON)
+			case RGB2YCBCR_NEON:  y_row_neon (p, y, iw_); break;
+#endif
+#if defined(YCBCR_X86)
+			case RGB2YCBCR_SSSE3: y_row_ssse3(p, y, iw_); break;
+			case RGB2YCBCR_AVX2:  y_row_avx2 (p, y, iw_); break;
+#endif
+			default:              y_row_scalar(p, y, 0, iw_); break;
+		}
+	}
+
+	void RGB2YCbCr::process(const bgr_t *in, size_t in_stride, uint8_t *y, size_t y_stride) {
+		const uint8_t *src = (const uint8_t*)in;
+		parallel_rows(threads_, ih_, [this, src, in_stride, y, y_stride]
+				(uint32_t r0, uint32_t r1, unsigned) {
+			for (uint32_t r=r0; r<r1; r++)
+				process_row((const bgr_t*)(src + (size_t)r * in_stride), y + (size_t)r * y_stride);
+		});
+	}
+
+	void RGB2YCbCr::process(const bgr_t *in, size_t in_stride, GrayImage& y) {
+		if (y.width() != iw_ || y.height() != ih_) y.resize(iw_, ih_);
+		process(in, in_stride, y.data(), y.width());
+	}
+
+	void RGB2YCbCr::process(const bgr_t *in, size_t in_stride, ycbcr_t *out, size_t out_stride) {
+		const uint8_t *src = (const uint8_t*)in;
+		uint8_t       *dst = (uint8_t*)out;
+		parallel_rows(threads_, ih_, [this, src, in_stride, dst, out_stride]
+				(uint32_t r0, uint32_t r1, unsigned) {
+			for (uint32_t r=r0; r<r1; r++) {
+				const uint8_t *p = src + (size_t)r * in_stride;
+				uint8_t       *q = dst + (size_t)r * out_stride;
+				switch (kernel_) {
+#if defined(YCBCR_NEON)
+					case RGB2YCBCR_NEON:  ycc_row_neon (p, q, iw_); break;
+#endif
+#if defined(YCBCR_X86)
+					case RGB2YCBCR_SSSE3: ycc_row_ssse3(p, q, iw_); break;
+					case RGB2YCBCR_AVX2:  ycc_row_avx2 (p, q, iw_); break;
+#endif
+					default:              ycc_row_scalar(p, q, 0, iw_); break;
+				}
+			}
+		});
+	}
+};
@@ -0,0 +1,639 @@
+//-----------------------------------------------------------------------------
+// <simple_lsd.cpp>
+//  - Defined functions of slab::SimpleLSD class
+//    - every width, rounding and wrap-around follows simple_lsd.sv (v1.11),
+//      arctan_calc.sv, sin_calc.sv and conv_layer_fixed.sv
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 10, 2020)
+//  - Added definition for functions of slab::SimpleLSD class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 11, 2020)
+//  - Moved parallel_rows() to parallel.hpp
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 15, 2020)
+//  - Used slab::ArctanCalc and slab::SinCalc, and the helpers of
+//    fixed_point.hpp
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/imgproc/simple_lsd.hpp>
+#include <slab/imgproc/fixed_math.hpp>
+#include "fixed_point.hpp"
+#include "parallel.hpp"
+
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SIMPLE_LSD_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMPLE_LSD_SSE2
+#endif
+
+#define ANGLE_BITW  8
+#define TUNING_STEP 16
+#define TABLE_BITW  9  // reciprocal table of the output stage
+#define MULT_BITW   17
+#define FRAC_BITW   10
+
+namespace slab {
+	//-------------------------------------------------------------------------
+	// tables (same contents as the ROMs of the PL)
+	//-------------------------------------------------------------------------
+	static uint8_t  atan_lut[512 * 512];          // [(gx + 256) * 512 + (gy + 256)]
+	static uint8_t  inv_table_s[64];              // average angle (6 bits)
+	static uint32_t inv_table[1 << TABLE_BITW];   // output stage (MULT_BITW bits)
+	static std::once_flag tables_once;
+
+	static void init_tables() {
+		/* arctan_calc (IN_BITW = 9, OUT_BITW = 8) for every gradient */
+		ArctanCalc arctan(ANGLE_BITW + 1, ANGLE_BITW);
+		int16_t    gx[512], gy[512];
+		uint16_t   angle[512];
+		for (int i=0; i<512; i++) gy[i] = i - 256;
+		for (int x=-256; x<256; x++) {
+			std::fill(gx, gx + 512, x);
+			arctan.process(gx, gy, angle, 512);
+			std::copy(angle, angle + 512, &atan_lut[(x + 256) * 512]);
+		}
+
+		/* reciprocals */
+		for (uint32_t i=0; i<64; i++)
+			inv_table_s[i] = sv_round(pow(2.0, bitlen(i) + 4) / i, 6);
+		for (uint32_t i=0; i<(1 << TABLE_BITW); i++)
+			inv_table[i] = sv_round(pow(2.0, bitlen(i) + MULT_BITW - 2) / i, MULT_BITW);
+	}
+
+	/* sin_calc (IN_BITW = 8, OUT_BITW = 12) */
+	static inline int32_t sin_calc(uint32_t phase) {
+		static const SinCalc calc(ANGLE_BITW, FRAC_BITW + 2);
+		return calc(phase);
+	}
+
+	/* angle_check() of simple_lsd */
+	static inline bool angle_check(uint8_t a, uint8_t b, uint8_t thres) {
+		uint32_t diff = (a > b) ? a - b : b - a;
+		return ((diff * 2 < 256) ? diff : 256 - diff) < thres;
+	}
+
+	/* relative_angle() of simple_lsd */
+	static inline int64_t relative_angle(uint8_t base, uint8_t a) {
+		return (int8_t)(uint8_t)(a - (base << 6));
+	}
+
+	SimpleLSDParams simple_lsd_params(const FrameGeometry& geometry) {
+		SimpleLSDParams params;
+		params.geometry     = geometry;
+		params.thres.angle  = LSD_ANGLE_THRES;
+		params.thres.grad   = LSD_GRAD_THRES;
+		params.thres.length = LSD_LENGTH_THRES;
+		params.ram_size     = LSD_BUFSIZE;
+		return params;
+	}
+
+	//-------------------------------------------------------------------------
+	// SimpleLSD
+	//-------------------------------------------------------------------------
+	SimpleLSD::SimpleLSD(const SimpleLSDParams& params, unsigned threads) :
+		params_    (params                        ),
+		iw_        (params.geometry.image_width   ),
+		ih_        (params.geometry.image_height  ),
+		threads_   (1                             ),
+		simd_      (true                          ),
+		gstride_   ((params.geometry.image_width + 16 + 15) & ~(size_t)15),
+		gauss_     (gstride_ * (ih_ + 1), 0       ),
+		valid_     ((size_t)iw_ * ih_, 0          ),
+		angle_     ((size_t)iw_ * ih_, 0          ),
+		ram_       (params.ram_size               ),
+		ids_prev_  (iw_ + 2                       ),
+		ids_cur_   (iw_ + 2                       ),
+		sequence_  (0                             ),
+		lines_     (params.ram_size               )
+	{
+		const FrameGeometry& g = params_.geometry;
+		const uint64_t max_pixs = ((uint64_t)g.image_height + g.image_width) * 2;
+
+		std::call_once(tables_once, init_tables);
+
+		v_bitw_     = clog2(g.frame_height);
+		h_bitw_     = clog2(g.frame_width);
+		addr_bitw_  = clog2(params_.ram_size);
+		pixs_bitw_  = clog2(max_pixs);
+		v_sum_bitw_ = clog2(g.image_height * max_pixs);
+		h_sum_bitw_ = clog2(g.image_width  * max_pixs);
+		a_sum_bitw_ = ANGLE_BITW + pixs_bitw_;
+		id_none_    = (1u << (addr_bitw_ + 1)) - 1; // -1 of segment ids
+		addr_mask_  = (1u << addr_bitw_) - 1;
+		over_thres_ = (params_.ram_size * 9) / 10;
+
+		set_threads((threads > 0) ? threads : std::thread::hardware_concurrency());
+		in_thres_.angle = in_thres_.grad = in_thres_.length = 0;
+		in_manual_ = false;
+		reset();
+	}
+
+	SimpleLSD::~SimpleLSD() {
+	}
+
+	/* state after n_rst (the RAM is cleared like a fresh bitstream) */
+	void SimpleLSD::reset() {
+		const LSDThresholds& t = params_.thres;
+
+		memset(&cur_, 0, sizeof(cur_));
+		std::fill(ram_.begin(), ram_.end(), cur_);
+		last_     = false;
+		merging_  = false;
+		overused_ = false;
+		seg_num_  = 0;
+		segid_    = 0;
+		alias_id_ = id_none_;
+
+		angle_thres_   = t.angle;
+		grad_thres2_   = (uint32_t)t.grad * t.grad;
+		length_thres_  = t.length;
+		length_thres2_ = (uint32_t)t.length * t.length;
+		manual_        = false;
+		offset_        = 0;
+		out_overused_  = false;
+		out_offset_    = 0;
+
+		sequence_ = 0;
+		outputs_.clear();
+		lines_.assign(params_.ram_size, LineSegment());
+		line_num_ = 0;
+	}
+
+	void SimpleLSD::set_thresholds(const LSDThresholds& thres, bool manual) {
+		in_thres_  = thres;
+		in_manual_ = manual;
+	}
+
+	//-------------------------------------------------------------------------
+	// front end
+	//-------------------------------------------------------------------------
+	/* 3x3 gaussian of rows [<r0>, <r1>) (conv_layer_fixed, replicate padding) */
+	void SimpleLSD::gauss_rows(const uint8_t *y, size_t stride, uint32_t r0, uint32_t r1) {
+		const uint32_t iw = iw_;
+		std::vector<uint16_t> vsum(iw + 2 + 16);
+
+		for (uint32_t r=r0; r<r1; r++) {
+			const uint8_t *ym = y + (size_t)((r > 0) ? r - 1 : 0) * stride;
+			const uint8_t *y0 = y + (size_t)r * stride;
+			const uint8_t *yp = y + (size_t)((r + 1 < ih_) ? r + 1 : r) * stride;
+			uint8_t       *g  = &gauss_[r * gstride_];
+			uint16_t      *vs = vsum.data() + 1;
+			uint32_t       h  = 0;
+
+			/* vertical [1 2 1] */
+			if (simd_) {
+#if defined(SIMPLE_LSD_SSE2)
+				const __m128i zero = _mm_setzero_si128();
+				for (; h+16<=iw; h+=16) {
+					__m128i a = _mm_loadu_si128((const __m128i*)(ym + h));
+					__m128i b = _mm_loadu_si128((const __m128i*)(y0 + h));
+					__m128i c = _mm_loadu_si128((const __m128i*)(yp + h));
+					__m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+								_mm_unpacklo_epi8(c, zero)),
+							_mm_slli_epi16(_mm_unpacklo_epi8(b, zero), 1));
+					__m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+								_mm_unpackhi_epi8(c, zero)),
+							_mm_slli_epi16(_mm_unpackhi_epi8(b, zero), 1));
+					_mm_storeu_si128((__m128i*)(vs + h),     lo);
+					_mm_storeu_si128((__m128i*)(vs + h + 8), hi);
+				}
+#elif defined(SIMPLE_LSD_NEON)
+				for (; h+16<=iw; h+=16) {
+					uint8x16_t a = vld1q_u8(ym + h);
+					uint8x16_t b = vld1q_u8(y0 + h);
+					uint8x16_t c = vld1q_u8(yp + h);
+					uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(c)),
+							vshlq_n_u16(vmovl_u8(vget_low_u8(b)), 1));
+					uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(c)),
+							vshlq_n_u16(vmovl_u8(vget_high_u8(b)), 1));
+					vst1q_u16(vs + h,     lo);
+					vst1q_u16(vs + h + 8, hi);
+				}
+#endif
+			}
+			for (; h<iw; h++) vs[h] = ym[h] + 2 * y0[h] + yp[h];
+			vs[-1] = vs[0];
+			vs[iw] = vs[iw - 1];
+
+			/* horizontal [1 2 1], (sum + 8) >>> 4 */
+			h = 0;
+			if (simd_) {
+#if defined(SIMPLE_LSD_SSE2)
+				const __m128i eight = _mm_set1_epi16(8);
+				for (; h+8<=iw; h+=8) {
+					__m128i a = _mm_loadu_si128((const __m128i*)(vs + h - 1));
+					__m128i b = _mm_loadu_si128((const __m128i*)(vs + h));
+					__m128i c = _mm_loadu_si128((const __m128i*)(vs + h + 1));
+					__m128i s = _mm_add_epi16(_mm_add_epi16(a, c), _mm_slli_epi16(b, 1));
+					s = _mm_srli_epi16(_mm_add_epi16(s, eight), 4);
+					_mm_storel_epi64((__m128i*)(g + h), _mm_packus_epi16(s, s));
+				}
+#elif defined(SIMPLE_LSD_NEON)
+				for (; h+8<=iw; h+=8) {
+					uint16x8_t a = vld1q_u16(vs + h - 1);
+					uint16x8_t b = vld1q_u16(vs + h);
+					uint16x8_t c = vld1q_u16(vs + h + 1);
+					uint16x8_t s = vaddq_u16(vaddq_u16(a, c), vshlq_n_u16(b, 1));
+					vst1_u8(g + h, vmovn_u16(vrshrq_n_u16(s, 4)));
+				}
+#endif
+			}
+			for (; h<iw; h++) g[h] = (*(vs + h - 1) + 2 * vs[h] + vs[h + 1] + 8) >> 4;
+			g[iw] = g[iw - 1]; // replicate padding of the 2x2 window
+		}
+	}
+
+	/* gradient, threshold and angle of one pixel */
+	static inline void grad_pixel(const uint8_t *g0, const uint8_t *g1, uint32_t h,
+			uint32_t thres, uint8_t& valid, uint8_t& angle) {
+		int gx = ((g0[h + 1] + g1[h + 1]) - (g0[h] + g1[h])) >> 1;
+		int gy = ((g1[h] + g1[h + 1]) - (g0[h] + g0[h + 1])) >> 1;
+		valid = (uint32_t)(gx * gx + gy * gy) >= thres;
+		angle = valid ? atan_lut[(gx + 256) * 512 + (gy + 256)] : 0;
+	}
+
+	/*
+	 * 2x2 difference, gradient threshold and angle of rows [<r0>, <r1>)
+	 *  - the first FRAME_WIDTH + 7 pixels of a frame are compared before
+	 *    the new threshold is latched (<thres_old>)
+	 *  - angles of invalid pixels never reach the result, so they are
+	 *    left 0 instead of reading the (cache-unfriendly) table
+	 */
+	void SimpleLSD::grad_rows(uint32_t thres_old, uint32_t thres_new, uint32_t r0, uint32_t r1) {
+		const uint32_t iw  = iw_;
+		const uint64_t lag = (uint64_t)params_.geometry.frame_width + 7;
+
+		for (uint32_t r=r0; r<r1; r++) {
+			const uint8_t *g0 = &gauss_[r * gstride_];
+			const uint8_t *g1 = &gauss_[(r + 1) * gstride_]; // row IH is replicated
+			uint8_t       *vr = &valid_[(size_t)r * iw];
+			uint8_t       *ar = &angle_[(size_t)r * iw];
+			uint64_t       pos = (uint64_t)r * params_.geometry.frame_width;
+			uint32_t       old = (pos < lag) ? (uint32_t)std::min<uint64_t>(iw, lag - pos) : 0;
+			uint32_t       thres = (old == iw) ? thres_old : thres_new;
+			uint32_t       h = 0;
+
+			if (simd_) {
+#if defined(SIMPLE_LSD_SSE2)
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i one  = _mm_set1_epi8(1);
+				const __m128i thr  = _mm_set1_epi32((int32_t)thres);
+				int16_t gx[8], gy[8];
+				for (; h+8<=iw; h+=8) {
+					__m128i p00 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(g0 + h)),     zero);
+					__m128i p01 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(g0 + h + 1)), zero);
+					__m128i p10 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(g1 + h)),     zero);
+					__m128i p11 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(g1 + h + 1)), zero);
+					__m128i vx  = _mm_srai_epi16(_mm_sub_epi16(_mm_add_epi16(p01, p11),
+								_mm_add_epi16(p00, p10)), 1);
+					__m128i vy  = _mm_srai_epi16(_mm_sub_epi16(_mm_add_epi16(p10, p11),
+								_mm_add_epi16(p00, p01)), 1);
+					__m128i lo  = _mm_unpacklo_epi16(vx, vy);
+					__m128i hi  = _mm_unpackhi_epi16(vx, vy);
+					__m128i ltl = _mm_cmplt_epi32(_mm_madd_epi16(lo, lo), thr);
+					__m128i lth = _mm_cmplt_epi32(_mm_madd_epi16(hi, hi), thr);
+					__m128i lt  = _mm_packs_epi16(_mm_packs_epi32(ltl, lth), zero);
+					_mm_storel_epi64((__m128i*)(vr + h), _mm_andnot_si128(lt, one));
+					_mm_storeu_si128((__m128i*)gx, vx);
+					_mm_storeu_si128((__m128i*)gy, vy);
+					for (int i=0; i<8; i++)
+						ar[h + i] = vr[h + i] ? atan_lut[(gx[i] + 256) * 512 + (gy[i] + 256)] : 0;
+				}
+#elif defined(SIMPLE_LSD_NEON)
+				const int32x4_t thr = vdupq_n_s32((int32_t)thres);
+				int16_t gx[8], gy[8];
+				for (; h+8<=iw; h+=8) {
+					int16x8_t p00 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(g0 + h)));
+					int16x8_t p01 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(g0 + h + 1)));
+					int16x8_t p10 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(g1 + h)));
+					int16x8_t p11 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(g1 + h + 1)));
+					int16x8_t vx  = vshrq_n_s16(vsubq_s16(vaddq_s16(p01, p11), vaddq_s16(p00, p10)), 1);
+					int16x8_t vy  = vshrq_n_s16(vsubq_s16(vaddq_s16(p10, p11), vaddq_s16(p00, p01)), 1);
+					int32x4_t ml  = vmlal_s16(vmull_s16(vget_low_s16(vx), vget_low_s16(vx)),
+							vget_low_s16(vy), vget_low_s16(vy));
+					int32x4_t mh  = vmlal_s16(vmull_s16(vget_high_s16(vx), vget_high_s16(vx)),
+							vget_high_s16(vy), vget_high_s16(vy));
+					uint16x8_t ge = vcombine_u16(vmovn_u32(vcgeq_s32(ml, thr)),
+							vmovn_u32(vcgeq_s32(mh, thr)));
+					vst1_u8(vr + h, vand_u8(vmovn_u16(ge), vdup_n_u8(1)));
+					vst1q_s16(gx, vx);
+					vst1q_s16(gy, vy);
+					for (int i=0; i<8; i++)
+						ar[h + i] = vr[h + i] ? atan_lut[(gx[i] + 256) * 512 + (gy[i] + 256)] : 0;
+				}
+#endif
+			}
+			for (; h<iw; h++) grad_pixel(g0, g1, h, thres, vr[h], ar[h]);
+			for (h=0; thres != thres_old && h<old; h++) grad_pixel(g0, g1, h, thres_old, vr[h], ar[h]);
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// region growing
+	//-------------------------------------------------------------------------
+	/* approximate average angle (s2_avg_angle) */
+	uint8_t SimpleLSD::avg_angle(uint32_t total, int64_t angle_sum, uint8_t base) const {
+		uint32_t w  = bitlen(total);
+		uint32_t w1 = (w > 6) ? w - 6 : 0;
+		uint32_t w2 = (w > 6) ? 10 : w + 4;
+		int64_t  a  = angle_sum >> w1;
+		int64_t  p  = wrap_s(a * inv_table_s[total >> w1], a_sum_bitw_ + 5);
+		return (uint8_t)((p >> w2) + (base << 6));
+	}
+
+	/* cond_save: writes the current region and counts it as a new segment */
+	void SimpleLSD::save() {
+		Region& word = ram_[segid_ & addr_mask_];
+		word       = cur_;
+		word.exist = true;
+		if (segid_ == seg_num_ &&
+				(!last_ || (uint32_t)((cur_.end_v - cur_.start_v) + (cur_.end_h - cur_.start_h))
+				 >= length_thres_)) {
+			seg_num_ = (seg_num_ + 1) & id_none_;
+			if (seg_num_ > over_thres_) overused_ = true;
+		}
+		merging_ = false;
+	}
+
+	/* one row of the search state (state == 1), hcnt = 0 .. IMAGE_WIDTH */
+	void SimpleLSD::grow_row(uint32_t r) {
+		const uint32_t  iw   = iw_;
+		const uint8_t   athr = angle_thres_;
+		const uint8_t  *val  = &valid_[(size_t)r * iw];
+		const uint8_t  *ang  = &angle_[(size_t)r * iw];
+		const uint8_t  *pang = (r > 0) ? ang - iw : NULL;
+		const bool      next = r + 1 < ih_;
+		const uint8_t  *nval = next ? val + iw : NULL;
+		const uint8_t  *nang = next ? ang + iw : NULL;
+		const uint32_t *pids = ids_prev_.data();
+		uint32_t       *ids  = ids_cur_.data();
+
+		for (uint32_t c=0; c<=iw; c++) {
+			/* nothing happens until the next valid pixel while not merging */
+			if (!merging_) {
+				const uint8_t *p = (const uint8_t*)memchr(val + c, 1, iw - c);
+				const uint32_t n = (p != NULL) ? (uint32_t)(p - val) : iw;
+				std::fill(ids + c, ids + n, id_none_);
+				if ((c = n) == iw) {
+					ids[iw] = id_none_;
+					break;
+				}
+			}
+
+			const bool valid = (c < iw) && val[c];
+
+			const uint8_t a11 = valid ? ang[c] : 0;
+			if (merging_ && !(valid && angle_check(a11, cur_.avg_angle, athr) &&
+						angle_check(a11, ang[c - 1], athr))) {
+				save();
+				ids[c] = id_none_;
+				continue;
+			}
+
+			/*
+			 * candidate in the previous line (searched one cycle before)
+			 *  - vcnt of that cycle is 0 for the first line and for the
+			 *    first pixel of the second line, so they never find one
+			 */
+			uint32_t p_segid = id_none_;
+			if (pang != NULL) {
+				if (c > 0 && pids[c - 1] != id_none_ && angle_check(pang[c - 1], a11, athr))
+					p_segid = pids[c - 1];
+				else if (pids[c] != id_none_ && angle_check(pang[c], a11, athr))
+					p_segid = pids[c];
+				else if (c != iw - 1 && pids[c + 1] != id_none_ && angle_check(pang[c + 1], a11, athr))
+					p_segid = pids[c + 1];
+			}
+			const bool   p_found = (p_segid != id_none_) && !(r == 1 && c == 0);
+			const Region p       = ram_[p_segid & addr_mask_];
+
+			/* candidate in the next line */
+			const bool n_found = next &&
+				((c != 0 && nval[c - 1] && angle_check(nang[c - 1], a11, athr)) ||
+				 (nval[c] && angle_check(nang[c], a11, athr)) ||
+				 (c != iw - 1 && nval[c + 1] && angle_check(nang[c + 1], a11, athr)));
+
+			/* [stage 1] */
+			const bool cond_continue = merging_ ||
+				(p_found && alias_id_ == p_segid && angle_check(a11, cur_.avg_angle, athr));
+			Region   s1;
+			bool     s1_last;
+			uint32_t s1_segid, s1_alias_id;
+			const uint8_t tmp_b = (uint8_t)(a11 + 32) >> 6;
+			if (cond_continue) {
+				s1            = cur_;
+				s1_last       = last_;
+				s1.total_pixs = wrap_u(cur_.total_pixs + 1, pixs_bitw_);
+				s1.end_h      = std::max(cur_.end_h, c);
+				s1.v_sum      = wrap_u(cur_.v_sum + r, v_sum_bitw_);
+				s1.h_sum      = wrap_u(cur_.h_sum + c, h_sum_bitw_);
+				s1.angle_sum  = wrap_s(cur_.angle_sum + relative_angle(cur_.base_angle, a11), a_sum_bitw_);
+				s1_segid      = segid_;
+				s1_alias_id   = alias_id_;
+			}
+			else {
+				s1.exist      = false;
+				s1.total_pixs = 1;
+				s1.start_v    = s1.end_v = r;
+				s1.start_h    = s1.end_h = c;
+				s1.v_sum      = r;
+				s1.h_sum      = c;
+				s1.base_angle = tmp_b;
+				s1.angle_sum  = relative_angle(tmp_b, a11);
+				s1.avg_angle  = a11;
+				s1_last       = true;
+				s1_segid      = seg_num_;
+				s1_alias_id   = id_none_;
+			}
+
+			/* [stage 2] */
+			const bool cond_merge = p_found && p.exist && p_segid != s1_segid &&
+				angle_check(p.avg_angle, s1.avg_angle, athr);
+			Region s2 = s1;
+			if (cond_merge) {
+				const uint32_t type = (s1.base_angle - p.base_angle) & 3;
+				const int64_t  bias = (int64_t)p.total_pixs << 6;
+				const int64_t  asum = (type == 1) ? p.angle_sum - bias :
+					(type == 3) ? p.angle_sum + bias : p.angle_sum;
+				s2.total_pixs = wrap_u(s1.total_pixs + p.total_pixs, pixs_bitw_);
+				s2.start_v    = std::min(p.start_v, s1.start_v);
+				s2.start_h    = std::min(p.start_h, s1.start_h);
+				s2.end_v      = std::max(p.end_v, s1.end_v);
+				s2.end_h      = std::max(p.end_h, s1.end_h);
+				s2.v_sum      = wrap_u(s1.v_sum + p.v_sum, v_sum_bitw_);
+				s2.h_sum      = wrap_u(s1.h_sum + p.h_sum, h_sum_bitw_);
+				s2.angle_sum  = wrap_s(asum + s1.angle_sum, a_sum_bitw_);
+			}
+			s2.avg_angle = avg_angle(s2.total_pixs, s2.angle_sum, s2.base_angle);
+			const uint32_t s2_segid    = (cond_merge && !merging_) ? p_segid : s1_segid;
+			const uint32_t s2_alias_id = (cond_merge &&  merging_) ? p_segid : s1_alias_id;
+
+			/* cond_inval: the merged candidate is removed from the RAM */
+			if (cond_merge && merging_) {
+				memset(&ram_[p_segid & addr_mask_], 0, sizeof(Region));
+			}
+
+			cur_      = s2;
+			last_     = n_found ? false : s1_last;
+			segid_    = s2_segid;
+			alias_id_ = s2_alias_id;
+			merging_  = true;
+			ids[c]    = s2_segid;
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// output
+	//-------------------------------------------------------------------------
+	/* state == 3: end points of every segment (rd_segid = 1 .. seg_num) */
+	void SimpleLSD::emit() {
+		const int64_t ih = ih_, iw = iw_;
+
+		outputs_.clear();
+		for (uint32_t k=0; k!=seg_num_; k++) {
+			const Region& e = ram_[k & addr_mask_];
+
+			/* [stage 1-4] centroid and average angle */
+			uint32_t w  = bitlen(e.total_pixs);
+			uint32_t w1 = (w > TABLE_BITW) ? w - TABLE_BITW : 0;
+			uint32_t w2 = (w > TABLE_BITW) ? TABLE_BITW + MULT_BITW - 2 : w + MULT_BITW - 2;
+			uint32_t total;
+			uint64_t v_sum, h_sum;
+			int64_t  a_sum = e.angle_sum * 2;
+			if (w1 == 0) {
+				total = e.total_pixs;
+				v_sum = e.v_sum;
+				h_sum = e.h_sum;
+			}
+			else {
+				total = wrap_u(((e.total_pixs >> (w1 - 1)) + 1) >> 1, TABLE_BITW);
+				v_sum = wrap_u(((e.v_sum >> (w1 - 1)) + 1) >> 1, v_sum_bitw_);
+				h_sum = wrap_u(((e.h_sum >> (w1 - 1)) + 1) >> 1, h_sum_bitw_);
+				a_sum = wrap_s(((a_sum >> (w1 - 1)) + 1) >> 1, a_sum_bitw_ + 1);
+			}
+			uint64_t weight = inv_table[total];
+			uint64_t v_prod = wrap_u(v_sum * weight, v_sum_bitw_ + MULT_BITW - 1);
+			uint64_t h_prod = wrap_u(h_sum * weight, h_sum_bitw_ + MULT_BITW - 1);
+			int64_t  a_prod = a_sum * (int64_t)weight;
+			int64_t  gv = wrap_u(((v_prod >> (w2 - 1)) + 1) >> 1, v_bitw_);
+			int64_t  gh = wrap_u(((h_prod >> (w2 - 1)) + 1) >> 1, h_bitw_);
+			int64_t  aa = wrap_s(((a_prod >> (w2 - 1)) + 1) >> 1, ANGLE_BITW + 1);
+
+			/* [stage 6-9] end points along the average angle */
+			uint32_t angle = (uint32_t)(aa + (e.base_angle << 7)) & 0x1ff;
+			uint32_t phase = angle & 0xff;
+			int64_t  a  = (angle & 0x80) ? e.end_h : e.start_h;
+			int64_t  b  = (angle & 0x80) ? e.start_h : e.end_h;
+			int64_t  w1s = sin_calc(phase);
+			int64_t  w2s = 1024 - sin_calc((phase + 64) & 0xff);
+			int64_t  d1 = wrap_s(gh - a,       h_bitw_ + 1);
+			int64_t  d2 = wrap_s(gv - e.end_v,   v_bitw_ + 1);
+			int64_t  d3 = wrap_s(gh - b,       h_bitw_ + 1);
+			int64_t  d4 = wrap_s(gv - e.start_v, v_bitw_ + 1);
+			int64_t  v1 = wrap_s(((((w1s * d1 - w2s * d2) >> FRAC_BITW) + 1) >> 1) + gv, v_bitw_ + 2);
+			int64_t  v2 = wrap_s(((((w1s * d3 - w2s * d4) >> FRAC_BITW) + 1) >> 1) + gv, v_bitw_ + 2);
+			int64_t  h1 = wrap_s(((((w1s * d2 + w2s * d1) >> FRAC_BITW) + 1) >> 1) + a,  h_bitw_ + 2);
+			int64_t  h2 = wrap_s(((((w1s * d4 + w2s * d3) >> FRAC_BITW) + 1) >> 1) + b,  h_bitw_ + 2);
+
+			/* [stage 10-12] clipping and length */
+			v1 = (v1 < 0) ? 0 : (v1 >= ih) ? ih - 1 : v1;
+			v2 = (v2 < 0) ? 0 : (v2 >= ih) ? ih - 1 : v2;
+			h1 = (h1 < 0) ? 0 : (h1 >= iw) ? iw - 1 : h1;
+			h2 = (h2 < 0) ? 0 : (h2 >= iw) ? iw - 1 : h2;
+			uint64_t len = (uint64_t)((v1 - v2) * (v1 - v2)) + (uint64_t)((h1 - h2) * (h1 - h2));
+
+			SimpleLSDOutput out;
+			if (angle < 256) {
+				out.start_v = v1; out.start_h = h1; out.end_v = v2; out.end_h = h2;
+			}
+			else {
+				out.start_v = v2; out.start_h = h2; out.end_v = v1; out.end_h = h1;
+			}
+			out.angle = ((angle + 1) >> 1) & 0xff;
+			out.valid = e.exist && len >= length_thres2_;
+			outputs_.push_back(out);
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// frame
+	//-------------------------------------------------------------------------
+	void SimpleLSD::process(const uint8_t *y, size_t stride, LineFrame& frame) {
+		const LSDThresholds& t  = params_.thres;
+		const uint32_t g        = (in_thres_.grad != 0) ? in_thres_.grad : t.grad;
+		const uint32_t thres_old = grad_thres2_ + offset_;
+		const uint32_t thres_new = g * g + offset_;
+
+		/* front end (row bands) */
+		parallel_rows(threads_, ih_, [this, y, stride](uint32_t r0, uint32_t r1, unsigned) {
+			gauss_rows(y, stride, r0, r1);
+		});
+		memcpy(&gauss_[ih_ * gstride_], &gauss_[(ih_ - 1) * gstride_], gstride_);
+		parallel_rows(threads_, ih_, [this, thres_old, thres_new](uint32_t r0, uint32_t r1, unsigned) {
+			grad_rows(thres_old, thres_new, r0, r1);
+		});
+
+		/* frame_start */
+		angle_thres_   = (in_thres_.angle  != 0) ? in_thres_.angle  : t.angle;
+		grad_thres2_   = g * g;
+		length_thres_  = (in_thres_.length != 0) ? in_thres_.length : t.length;
+		length_thres2_ = (uint32_t)length_thres_ * length_thres_;
+		manual_        = in_manual_;
+		seg_num_       = 0;
+		merging_       = false;
+		alias_id_      = id_none_;
+
+		/* search (the last line of the blanking never has a valid pixel) */
+		std::fill(ids_prev_.begin(), ids_prev_.end(), id_none_);
+		for (uint32_t r=0; r<ih_; r++) {
+			grow_row(r);
+			ids_cur_[iw_] = ids_cur_[iw_ + 1] = id_none_;
+			ids_prev_.swap(ids_cur_);
+		}
+
+		/* automatic threshold control at (IMAGE_HEIGHT, 0) */
+		out_overused_ = overused_;
+		out_offset_   = offset_;
+		if (manual_)                     offset_ = 0;
+		else if (overused_)              offset_ = (offset_ + TUNING_STEP) & 0x1ffff;
+		else if (offset_ >= TUNING_STEP) offset_ -= TUNING_STEP;
+		overused_ = false;
+
+		/* output and lsd_output_buffer_wp (the count is kept if nothing is stored) */
+		emit();
+		uint32_t stored = 0;
+		for (size_t i=0; i<outputs_.size(); i++) {
+			const SimpleLSDOutput& o = outputs_[i];
+			if (!o.valid) continue;
+			LineSegment& l = lines_[stored % params_.ram_size];
+			l.start_h = o.start_h;
+			l.start_v = o.start_v;
+			l.end_h   = o.end_h;
+			l.end_v   = o.end_v;
+			stored++;
+		}
+		if (stored > 0) line_num_ = (stored - 1) % params_.ram_size + 1;
+
+		frame.sequence     = sequence_++;
+		frame.timestamp_ns = monotonic_ns();
+		frame.count        = std::min<uint32_t>(line_num_, LSD_BUFSIZE);
+		frame.flags        = 0;
+		if (frame.count >= LSD_OVER_THRES) frame.flags |= LINE_FRAME_OVERFLOW;
+		frame.lines        = lines_.data();
+	}
+
+	void SimpleLSD::process(const GrayImage& image, LineFrame& frame) {
+		process(image.data(), image.width(), frame);
+	}
+};
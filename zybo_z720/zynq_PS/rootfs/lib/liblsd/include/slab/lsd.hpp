@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+// <lsd.hpp>
+//  - Header of the PS-side interface to <simple_lsd>
+//    - Declared register map of <zynq_interface> (LSD buffer)
+//    - Declared slab::LineSegment and slab::LineFrame
+//    - Declared slab::LineSource interface
+//    - Declared slab::LSDReader class (live readback via slab::UIO)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 5, 2020)
+//  - Moved the LSD buffer readback out of sample/lsd_test.cpp
+//  - Added slab::LineSource so that live and recorded frames are
+//    consumed through the same interface
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 7, 2020)
+//  - Added registers of runtime thresholds and status (simple_lsd v1.11)
+//  - Added registers of performance counters
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 9, 2020)
+//  - Added registers of the histogram of contrast_stretch
+//-----------------------------------------------------------------------------
+// Version 1.03 (Dec. 30, 2020)
+//  - Added register of the board switches (output of image_processor)
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _LSD_H_
+#define _LSD_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include <vector>
+
+#include <slab/uio.hpp>
+
+/* index of slave register (PS <- PL) */
+#define READ_LSDBUF_LINE_NUM      0
+#define READ_LSDBUF_READY         1
+#define READ_LSDBUF_START_H       2
+#define READ_LSDBUF_START_V       3
+#define READ_LSDBUF_END_H         4
+#define READ_LSDBUF_END_V         5
+#define READ_LSD_STATUS           6 // [24:8] threshold offset, [0] overused
+#define READ_PERF_FRAMES          7 // performance counters (perf_counter.sv)
+#define READ_PERF_FRAME_CYCLES    8
+#define READ_PERF_SEG_EMITTED     9
+#define READ_PERF_DROP_PROTECT   10
+#define READ_PERF_DROP_OVERFLOW  11
+#define READ_PERF_PROTECT_CYCLES 12
+#define READ_PERF_UNDERFLOW      13
+#define READ_HIST_DATA           14 // bin of WRITE_HIST_RADDR
+#define READ_HIST_STATUS         15 // [23:16] b, [15:8] a, [0] ready
+#define READ_HIST_FRAMES         16 // frame number of the snapshot
+#define READ_SW                  31 // [3:0] sw: HDMI output of image_processor
+
+/* index of slave register (PS -> PL) */
+#define WRITE_LSDBUF_PROTECT   0
+#define WRITE_LSDBUF_RADDR     1
+#define WRITE_LSD_ANGLE_THRES  2 // 0: ANGLE_THRES  in simple_lsd.sv
+#define WRITE_LSD_GRAD_THRES   3 // 0: GRAD_THRES   in simple_lsd.sv
+#define WRITE_LSD_LENGTH_THRES 4 // 0: LENGTH_THRES in simple_lsd.sv
+#define WRITE_LSD_MANUAL_THRES 5 // 1: disables automatic threshold control
+#define WRITE_HIST_RADDR       6
+#define WRITE_HIST_FREEZE      7 // 1: holds the snapshot of the histogram
+
+/* size of line segments RAM (LSD_BUFSIZE in vdma_top.sv) */
+#define LSD_BUFSIZE    4096
+#define LSD_OVER_THRES ((LSD_BUFSIZE * 9) / 10) // OVER_THRES in simple_lsd.sv
+
+/* default thresholds of simple_lsd */
+#define LSD_ANGLE_THRES  16
+#define LSD_GRAD_THRES   22
+#define LSD_LENGTH_THRES  8
+
+namespace slab {
+	/* one line segment, packed as it is stored on disk */
+	typedef struct LineSegment {
+		uint16_t start_h, start_v, end_h, end_v;
+	} LineSegment;
+
+	/* flags of slab::LineFrame */
+	enum LineFrameFlag : uint32_t {
+		LINE_FRAME_OVERFLOW = 0x1 // line count reached OVER_THRES
+	};
+
+	/*
+	 * one frame of detector output
+	 *  - <lines> points into storage owned by the source and
+	 *    stays valid until the next call of LineSource::fetch()
+	 */
+	typedef struct LineFrame {
+		uint64_t           sequence;
+		uint64_t           timestamp_ns; // CLOCK_MONOTONIC
+		uint32_t           count;
+		uint32_t           flags;
+		const LineSegment *lines;
+
+		bool overflow() const { return flags & LINE_FRAME_OVERFLOW; }
+	} LineFrame;
+
+	/* common interface of live readback and replay */
+	class LineSource {
+		public:
+			virtual ~LineSource() {}
+			/* returns false when no more frames are available */
+			virtual bool fetch(LineFrame&) = 0;
+	};
+
+	/* reads line frames from LSDBUF(PL) through /dev/uio */
+	class LSDReader : public LineSource {
+		private:
+			UIO                      &uio_;
+			uint64_t                 sequence_;
+			std::vector<LineSegment> lines_;
+		protected:
+		public:
+			LSDReader(UIO&);
+			~LSDReader();
+			bool fetch(LineFrame&);
+	};
+
+	uint64_t monotonic_ns();
+};
+
+#endif // _LSD_H_
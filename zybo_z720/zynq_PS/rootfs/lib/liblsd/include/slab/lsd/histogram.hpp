@@ -0,0 +1,54 @@
+//-----------------------------------------------------------------------------
+// <histogram.hpp>
+//  - Header of slab::HistogramReader class
+//    - reads the luma histogram that contrast_stretch.sv builds every
+//      frame, together with its window points [a, b]
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 9, 2020)
+//  - Added declaration of slab::HistogramReader class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _LSD_HISTOGRAM_H_
+#define _LSD_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <slab/uio.hpp>
+#include <slab/lsd.hpp>
+
+/* number of bins (2^BIT_WIDTH of contrast_stretch) */
+#define HIST_BINS 256
+
+namespace slab {
+	typedef struct LumaHistogram {
+		uint32_t frame;            // frame number counted by the PL
+		uint64_t timestamp_ns;     // CLOCK_MONOTONIC when read
+		uint8_t  a, b;             // window points of contrast_stretch
+		uint64_t total;            // sum of bins
+		uint32_t bins[HIST_BINS];
+
+		/* value below which <p> (0.0 - 1.0) of pixels fall */
+		uint8_t percentile(double p) const;
+		double  mean() const;
+	} LumaHistogram;
+
+	/*
+	 * reader of the histogram snapshot
+	 *  - the PL keeps two banks; fetch() freezes the published one,
+	 *    reads every bin and releases it, so the frame is never torn
+	 */
+	class HistogramReader {
+		private:
+			UIO      &uio_;
+			uint32_t last_frame_;
+		protected:
+		public:
+			HistogramReader(UIO&);
+			~HistogramReader();
+			bool fetch(LumaHistogram&);
+			bool fetch_new(LumaHistogram&);
+	};
+};
+
+#endif // _LSD_HISTOGRAM_H_
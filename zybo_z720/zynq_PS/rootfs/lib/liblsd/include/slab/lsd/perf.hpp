@@ -0,0 +1,65 @@
+//-----------------------------------------------------------------------------
+// <perf.hpp>
+//  - Header of slab::PerfCounters class
+//    - reads the performance counters of the PL (perf_counter.sv)
+//      and computes deltas and rates between two snapshots
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 8, 2020)
+//  - Added declaration of slab::PerfCounters class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _LSD_PERF_H_
+#define _LSD_PERF_H_
+
+#include <stdint.h>
+#include <slab/uio.hpp>
+#include <slab/lsd.hpp>
+
+/* pixel clock of 640x480 @ 60 fps (counters run on PixelClk) */
+#define PERF_PIXEL_CLK_HZ 25000000
+
+namespace slab {
+	/* raw counters (free running, wrap around at 2^32) */
+	typedef struct PerfSnapshot {
+		uint64_t timestamp_ns;   // CLOCK_MONOTONIC when read
+		uint32_t frames;
+		uint32_t frame_cycles;   // cycles of the last frame
+		uint32_t seg_emitted;
+		uint32_t drop_protect;
+		uint32_t drop_overflow;
+		uint32_t protect_cycles;
+		uint32_t underflow;
+	} PerfSnapshot;
+
+	/* difference between two snapshots */
+	typedef struct PerfStats {
+		double   seconds;        // wall time (PS)
+		uint32_t frames;
+		double   fps;
+		double   frame_ms;       // length of the last frame (PL)
+		uint32_t seg_emitted, drop_protect, drop_overflow, underflow;
+		double   seg_per_frame;
+		double   drop_ratio;     // dropped / emitted
+		double   protect_ratio;  // write_protect cycles / all cycles
+	} PerfStats;
+
+	class PerfCounters {
+		private:
+			UIO          &uio_;
+			double       pixel_clk_hz_;
+			PerfSnapshot prev_;
+		protected:
+		public:
+			PerfCounters(UIO&, double pixel_clk_hz = PERF_PIXEL_CLK_HZ);
+			~PerfCounters();
+			void      snapshot(PerfSnapshot&);
+			PerfStats update();
+			PerfStats delta(const PerfSnapshot&, const PerfSnapshot&) const;
+	};
+
+	void print_perf(const PerfStats&);
+};
+
+#endif // _LSD_PERF_H_
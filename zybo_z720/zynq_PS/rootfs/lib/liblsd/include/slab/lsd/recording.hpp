@@ -0,0 +1,171 @@
+//-----------------------------------------------------------------------------
+// <recording.hpp>
+//  - Header of the LSD line frame recording format
+//    - Declared slab::LineRecorder class (background writer)
+//    - Declared slab::LineRecording class (mmap reader)
+//    - Declared slab::LineReplay class (slab::LineSource over a recording)
+//-----------------------------------------------------------------------------
+// File layout (little endian, every record is 8-byte aligned)
+//
+//   +---------------------+
+//   | RecordingHeader     |  magic "SLSDREC1", image size, RAM size
+//   +---------------------+
+//   | RecordFrameHeader   |  sequence, timestamp, count, flags
+//   | LineSegment x count |
+//   +---------------------+
+//   | ...                 |  (append-only)
+//   +---------------------+
+//   | uint64_t x frames   |  file offset of every RecordFrameHeader
+//   | RecordingFooter     |  offset of the index and number of frames
+//   +---------------------+
+//
+//  - The index and the footer are written by LineRecorder::close().
+//    If they are missing (e.g. power loss in the field, or a write that
+//    failed, after which nothing more is written), LineRecording rebuilds
+//    the index by walking the frame headers.
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 5, 2020)
+//  - Added declaration of slab::LineRecorder class
+//  - Added declaration of slab::LineRecording class
+//  - Added declaration of slab::LineReplay class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 30, 2020)
+//  - LineRecording::frame() returns false out of range
+//  - No index after a failed write (the reader rebuilds it)
+//  - Frame magic checked by LineRecording::frame() and find()
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _LSD_RECORDING_H_
+#define _LSD_RECORDING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include <slab/lsd.hpp>
+
+#define LSD_RECORDING_MAGIC   "SLSDREC1"
+#define LSD_RECORDING_VERSION 1
+#define LSD_FRAME_MAGIC       0x4D52464CU // "LFRM"
+#define LSD_INDEX_MAGIC       0x5844494CU // "LIDX"
+
+namespace slab {
+	typedef struct RecordingHeader {
+		char     magic[8];
+		uint32_t version;
+		uint32_t header_size;
+		uint16_t width, height;
+		uint32_t ram_size;
+		uint64_t reserved;
+	} RecordingHeader;
+
+	typedef struct RecordFrameHeader {
+		uint32_t magic;
+		uint32_t count;
+		uint64_t sequence;
+		uint64_t timestamp_ns;
+		uint32_t flags;
+		uint32_t reserved;
+	} RecordFrameHeader;
+
+	typedef struct RecordingFooter {
+		uint64_t index_offset;
+		uint64_t frames;
+		uint32_t magic;
+		uint32_t reserved;
+	} RecordingFooter;
+
+	/*
+	 * appends line frames to a file from a background thread
+	 *  - push() only copies the frame into a preallocated chunk and
+	 *    never waits for the disk. If every chunk is still queued for
+	 *    writing, the frame is dropped and counted in dropped()
+	 */
+	class LineRecorder {
+		private:
+			typedef std::vector<uint8_t> Chunk;
+
+			int                      fd_;
+			size_t                   chunk_size_;
+			uint64_t                 offset_;   // file offset of the next chunk (writer thread)
+			std::vector<uint64_t>    index_;    // writer thread
+			Chunk                   *current_;
+			std::vector<Chunk*>      free_;
+			std::deque<Chunk*>       queue_;
+			std::vector<Chunk>       chunks_;
+			std::mutex               mtx_;
+			std::condition_variable  cv_;
+			std::thread              writer_;
+			bool                     stop_;
+			std::atomic<uint64_t>    pushed_, dropped_, written_bytes_;
+			std::atomic<bool>        error_;
+
+			void writer_loop();
+			bool handoff();
+		protected:
+		public:
+			LineRecorder(const std::string&, uint16_t, uint16_t,
+					size_t chunk_size = 4 << 20, size_t chunks = 8);
+			~LineRecorder();
+			bool push(const LineFrame&);
+			void flush();
+			void close();
+			uint64_t pushed()  const { return pushed_;  }
+			uint64_t dropped() const { return dropped_; }
+			uint64_t written_bytes() const { return written_bytes_; }
+			bool     error()   const { return error_;   }
+	};
+
+	/* read-only view of a recording mapped with mmap() */
+	class LineRecording {
+		private:
+			int                    fd_;
+			const uint8_t         *map_;
+			size_t                 size_;
+			const uint64_t        *index_;
+			uint64_t               frames_;
+			std::vector<uint64_t>  rebuilt_;
+			const RecordingHeader *header_;
+
+			bool load_index();
+			void rebuild_index();
+			const RecordFrameHeader* entry(uint64_t) const;
+		protected:
+		public:
+			LineRecording(const std::string&);
+			~LineRecording();
+			bool     is_open() const { return map_ != NULL; }
+			uint64_t size()    const { return frames_; }
+			uint16_t width()   const { return header_->width;  }
+			uint16_t height()  const { return header_->height; }
+			bool     frame(uint64_t, LineFrame&) const;
+			uint64_t find(uint64_t timestamp_ns) const;
+	};
+
+	/* presents a recording through the same interface as LSDReader */
+	class LineReplay : public LineSource {
+		private:
+			const LineRecording &rec_;
+			uint64_t            pos_;
+			bool                loop_, realtime_;
+			uint64_t            base_rec_ns_, base_wall_ns_;
+		protected:
+		public:
+			LineReplay(const LineRecording&, bool loop = false, bool realtime = false);
+			~LineReplay();
+			void     seek(uint64_t);
+			uint64_t tell() const { return pos_; }
+			bool     fetch(LineFrame&);
+	};
+};
+
+#endif // _LSD_RECORDING_H_
@@ -0,0 +1,60 @@
+//-----------------------------------------------------------------------------
+// <threshold.hpp>
+//  - Header of slab::LSDThresholdController class
+//    - keeps the number of lines per frame within a target band by
+//      adjusting the runtime thresholds of simple_lsd every frame
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 7, 2020)
+//  - Added declaration of slab::LSDThresholdController class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _LSD_THRESHOLD_H_
+#define _LSD_THRESHOLD_H_
+
+#include <stdint.h>
+#include <slab/uio.hpp>
+#include <slab/lsd.hpp>
+
+namespace slab {
+	typedef struct LSDThresholds {
+		uint8_t angle;  // (tau) max. angle difference
+		uint8_t grad;   // (rho) min. gradient magnitude
+		uint8_t length; //       min. length of line segments
+	} LSDThresholds;
+
+	/*
+	 * frame-to-frame threshold controller
+	 *  - too many lines (or RAM overflow): raises the gradient threshold,
+	 *    then the length threshold once the gradient one saturates
+	 *  - too few lines: undoes the length threshold first, then lowers
+	 *    the gradient threshold
+	 *  - the automatic offset of simple_lsd is disabled while the
+	 *    controller is alive, and the parameters of simple_lsd are
+	 *    restored by the destructor
+	 */
+	class LSDThresholdController {
+		private:
+			UIO           &uio_;
+			uint32_t      low_, high_;
+			LSDThresholds min_, max_, cur_;
+			uint32_t      settle_, hold_;
+
+			void apply();
+		protected:
+		public:
+			LSDThresholdController(UIO&, uint32_t low, uint32_t high);
+			~LSDThresholdController();
+			void set_band(uint32_t low, uint32_t high);
+			void set_range(const LSDThresholds& min, const LSDThresholds& max);
+			void set_settle(uint32_t frames) { settle_ = frames; }
+			void set(const LSDThresholds&);
+			const LSDThresholds& get() const { return cur_; }
+			bool update(const LineFrame&);
+			bool overused();
+			uint32_t offset();
+	};
+};
+
+#endif // _LSD_THRESHOLD_H_
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string>
+#include <slab/uio.hpp>
+#include <slab/lsd.hpp>
+#include <slab/lsd/recording.hpp>
+
+#define WIDTH  640
+#define HEIGHT 480
+
+static volatile sig_atomic_t exit_flag = 0;
+static void on_signal(int) { exit_flag = 1; }
+
+static void usage(const char *name) {
+	printf("usage:\n");
+	printf("  %s record <file> [frames]       : record line frames from /dev/uio0\n", name);
+	printf("  %s replay <file> [loop] [real]  : print line frames of a recording\n", name);
+	printf("  %s info   <file>                : print summary of a recording\n", name);
+}
+
+static int record(const char *path, uint64_t frames) {
+	slab::UIO          fpga("/dev/uio0");
+	slab::LSDReader    reader(fpga);
+	slab::LineRecorder recorder(path, WIDTH, HEIGHT);
+	slab::LineFrame    frame;
+
+	signal(SIGINT, on_signal);
+	while (!exit_flag && (frames == 0 || recorder.pushed() + recorder.dropped() < frames)) {
+		reader.fetch(frame);
+		recorder.push(frame);
+		printf("  frame : %llu, lines : %u, dropped : %llu\r",
+				(unsigned long long)frame.sequence, frame.count,
+				(unsigned long long)recorder.dropped());
+		fflush(stdout);
+	}
+	recorder.close();
+	printf("\nrecorded %llu frames (%llu dropped)\n",
+			(unsigned long long)recorder.pushed(), (unsigned long long)recorder.dropped());
+	return recorder.error() ? -1 : 0;
+}
+
+static int replay(const char *path, bool loop, bool realtime) {
+	slab::LineRecording rec(path);
+	if (!rec.is_open()) return -1;
+
+	slab::LineReplay replay(rec, loop, realtime);
+	slab::LineFrame  frame;
+
+	signal(SIGINT, on_signal);
+	while (!exit_flag && replay.fetch(frame)) {
+		printf("frame %llu (%llu ns) : %u lines%s\n",
+				(unsigned long long)frame.sequence, (unsigned long long)frame.timestamp_ns,
+				frame.count, frame.overflow() ? " [overflow]" : "");
+		for (uint32_t i=0; i<frame.count; i++) {
+			printf("  (%u, %u) - (%u, %u)\n",
+					frame.lines[i].start_h, frame.lines[i].start_v,
+					frame.lines[i].end_h,   frame.lines[i].end_v);
+		}
+	}
+	return 0;
+}
+
+static int info(const char *path) {
+	slab::LineRecording rec(path);
+	if (!rec.is_open()) return -1;
+
+	slab::LineFrame first, last;
+	printf("image  : %u x %u\n", rec.width(), rec.height());
+	printf("frames : %llu\n", (unsigned long long)rec.size());
+	if (rec.size() > 0 && rec.frame(0, first) && rec.frame(rec.size() - 1, last)) {
+		double sec = (last.timestamp_ns - first.timestamp_ns) / 1000000000.0;
+		printf("length : %lf [s], fps : %lf [fps]\n", sec,
+				(sec > 0) ? (rec.size() - 1) / sec : 0.0);
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3) {
+		usage(argv[0]);
+		return -1;
+	}
+
+	std::string cmd(argv[1]);
+	if (!cmd.compare("record")) {
+		return record(argv[2], (argc > 3) ? strtoull(argv[3], NULL, 0) : 0);
+	}
+	else if (!cmd.compare("replay")) {
+		bool loop = false, realtime = false;
+		for (int i=3; i<argc; i++) {
+			if (!std::string(argv[i]).compare("loop")) loop     = true;
+			if (!std::string(argv[i]).compare("real")) realtime = true;
+		}
+		return replay(argv[2], loop, realtime);
+	}
+	else if (!cmd.compare("info")) {
+		return info(argv[2]);
+	}
+	usage(argv[0]);
+	return -1;
+}
@@ -0,0 +1,67 @@
+//-----------------------------------------------------------------------------
+// <histogram.cpp>
+//  - Defined functions of slab::HistogramReader class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 9, 2020)
+//  - Added definition for functions of slab::HistogramReader class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/lsd/histogram.hpp>
+
+namespace slab {
+	uint8_t LumaHistogram::percentile(double p) const {
+		uint64_t target = (uint64_t)(p * total), sum = 0;
+		for (int i=0; i<HIST_BINS; i++) {
+			sum += bins[i];
+			if (sum > target) return i;
+		}
+		return HIST_BINS - 1;
+	}
+
+	double LumaHistogram::mean() const {
+		uint64_t sum = 0;
+		if (total == 0) return 0.0;
+		for (int i=0; i<HIST_BINS; i++) sum += (uint64_t)bins[i] * i;
+		return (double)sum / total;
+	}
+
+	HistogramReader::HistogramReader(UIO& uio) :
+		uio_        (uio),
+		last_frame_ (0  )
+	{
+	}
+
+	HistogramReader::~HistogramReader() {
+		uio_.write(WRITE_HIST_FREEZE, 0x0);
+	}
+
+	bool HistogramReader::fetch(LumaHistogram& hist) {
+		uint32_t status;
+
+		uio_.write(WRITE_HIST_FREEZE, 0x1);                     // hold snapshot
+		while (!((status = uio_.read(READ_HIST_STATUS)) & 0x1)); // wait ready
+		hist.timestamp_ns = monotonic_ns();
+		hist.frame        = uio_.read(READ_HIST_FRAMES);
+		hist.a            = (status >>  8) & 0xff;
+		hist.b            = (status >> 16) & 0xff;
+		hist.total        = 0;
+		for (int i=0; i<HIST_BINS; i++) {
+			uio_.write(WRITE_HIST_RADDR, i);                    // set read-address
+			hist.bins[i]  = uio_.read(READ_HIST_DATA);
+			hist.total   += hist.bins[i];
+		}
+		uio_.write(WRITE_HIST_FREEZE, 0x0);                     // release snapshot
+		while (uio_.read(READ_HIST_STATUS) & 0x1);              // wait release
+
+		last_frame_ = hist.frame;
+		return hist.total > 0;
+	}
+
+	/* returns false when the PL has not published a new frame yet */
+	bool HistogramReader::fetch_new(LumaHistogram& hist) {
+		if ((uint32_t)uio_.read(READ_HIST_FRAMES) == last_frame_) return false;
+		return fetch(hist);
+	}
+};
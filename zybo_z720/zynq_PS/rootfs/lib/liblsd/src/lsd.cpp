@@ -0,0 +1,55 @@
+//-----------------------------------------------------------------------------
+// <lsd.cpp>
+//  - Defined functions of slab::LSDReader class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 5, 2020)
+//  - Added definition for functions of slab::LSDReader class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/lsd.hpp>
+
+namespace slab {
+	uint64_t monotonic_ns() {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+
+	LSDReader::LSDReader(UIO& uio) :
+		uio_      (uio),
+		sequence_ (0  ),
+		lines_    (LSD_BUFSIZE)
+	{
+	}
+
+	LSDReader::~LSDReader() {
+	}
+
+	bool LSDReader::fetch(LineFrame& frame) {
+		uint32_t num_of_lines;
+
+		uio_.write(WRITE_LSDBUF_PROTECT, 0x1);          // set write_protect
+		while (!uio_.read(READ_LSDBUF_READY));          // wait buffer-ready
+		frame.timestamp_ns = monotonic_ns();
+		num_of_lines = uio_.read(READ_LSDBUF_LINE_NUM); // get number of lines
+		if (num_of_lines > LSD_BUFSIZE) num_of_lines = LSD_BUFSIZE;
+
+		for (uint32_t i=0; i<num_of_lines; i++) {
+			uio_.write(WRITE_LSDBUF_RADDR, i);          // set read-address
+			lines_[i].start_h = uio_.read(READ_LSDBUF_START_H);
+			lines_[i].start_v = uio_.read(READ_LSDBUF_START_V);
+			lines_[i].end_h   = uio_.read(READ_LSDBUF_END_H);
+			lines_[i].end_v   = uio_.read(READ_LSDBUF_END_V);
+		}
+		uio_.write(WRITE_LSDBUF_PROTECT, 0x0);          // unset write_protect
+
+		frame.sequence = sequence_++;
+		frame.count    = num_of_lines;
+		frame.flags    = 0;
+		if (num_of_lines >= LSD_OVER_THRES) frame.flags |= LINE_FRAME_OVERFLOW;
+		frame.lines    = lines_.data();
+		return true;
+	}
+};
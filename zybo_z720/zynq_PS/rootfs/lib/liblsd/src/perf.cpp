@@ -0,0 +1,86 @@
+//-----------------------------------------------------------------------------
+// <perf.cpp>
+//  - Defined functions of slab::PerfCounters class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 8, 2020)
+//  - Added definition for functions of slab::PerfCounters class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/lsd/perf.hpp>
+
+#include <stdio.h>
+
+namespace slab {
+	PerfCounters::PerfCounters(UIO& uio, double pixel_clk_hz) :
+		uio_          (uio         ),
+		pixel_clk_hz_ (pixel_clk_hz)
+	{
+		snapshot(prev_);
+	}
+
+	PerfCounters::~PerfCounters() {
+	}
+
+	/*
+	 * reads every counter
+	 *  - the PL updates them all at once, once per frame; reading again
+	 *    when <frames> changed in between gives a consistent snapshot
+	 */
+	void PerfCounters::snapshot(PerfSnapshot& snap) {
+		uint32_t frames;
+
+		do {
+			frames              = uio_.read(READ_PERF_FRAMES);
+			snap.timestamp_ns   = monotonic_ns();
+			snap.frame_cycles   = uio_.read(READ_PERF_FRAME_CYCLES);
+			snap.seg_emitted    = uio_.read(READ_PERF_SEG_EMITTED);
+			snap.drop_protect   = uio_.read(READ_PERF_DROP_PROTECT);
+			snap.drop_overflow  = uio_.read(READ_PERF_DROP_OVERFLOW);
+			snap.protect_cycles = uio_.read(READ_PERF_PROTECT_CYCLES);
+			snap.underflow      = uio_.read(READ_PERF_UNDERFLOW);
+			snap.frames         = uio_.read(READ_PERF_FRAMES);
+		} while (snap.frames != frames);
+	}
+
+	/* statistics since the previous call (or construction) */
+	PerfStats PerfCounters::update() {
+		PerfSnapshot now;
+		snapshot(now);
+		PerfStats stats = delta(prev_, now);
+		prev_ = now;
+		return stats;
+	}
+
+	PerfStats PerfCounters::delta(const PerfSnapshot& a, const PerfSnapshot& b) const {
+		PerfStats s;
+		uint32_t cycles;
+
+		/* unsigned subtraction handles wrap-around */
+		s.seconds       = (b.timestamp_ns - a.timestamp_ns) / 1000000000.0;
+		s.frames        = b.frames        - a.frames;
+		s.seg_emitted   = b.seg_emitted   - a.seg_emitted;
+		s.drop_protect  = b.drop_protect  - a.drop_protect;
+		s.drop_overflow = b.drop_overflow - a.drop_overflow;
+		s.underflow     = b.underflow     - a.underflow;
+		cycles          = b.protect_cycles - a.protect_cycles;
+
+		s.fps           = (s.seconds > 0) ? s.frames / s.seconds : 0.0;
+		s.frame_ms      = b.frame_cycles * 1000.0 / pixel_clk_hz_;
+		s.seg_per_frame = (s.frames > 0) ? (double)s.seg_emitted / s.frames : 0.0;
+		s.drop_ratio    = (s.seg_emitted > 0) ?
+			(double)(s.drop_protect + s.drop_overflow) / s.seg_emitted : 0.0;
+		s.protect_ratio = (s.frames > 0 && b.frame_cycles > 0) ?
+			(double)cycles / ((double)s.frames * b.frame_cycles) : 0.0;
+		return s;
+	}
+
+	void print_perf(const PerfStats& s) {
+		printf("PL  : %u frames, %.2lf [fps], %.3lf [ms/frame], underflow %u [px]\n",
+				s.frames, s.fps, s.frame_ms, s.underflow);
+		printf("LSD : %.1lf [lines/frame], drop %u (protect) + %u (overflow) = %.1lf [%%]\n",
+				s.seg_per_frame, s.drop_protect, s.drop_overflow, s.drop_ratio * 100.0);
+		printf("PS  : write_protect %.1lf [%%] of cycles\n", s.protect_ratio * 100.0);
+	}
+};
@@ -0,0 +1,391 @@
+//-----------------------------------------------------------------------------
+// <recording.cpp>
+//  - Defined functions of slab::LineRecorder, slab::LineRecording and
+//    slab::LineReplay class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 5, 2020)
+//  - Added definition for functions of slab::LineRecorder class
+//  - Added definition for functions of slab::LineRecording class
+//  - Added definition for functions of slab::LineReplay class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 30, 2020)
+//  - The frame index is built by the writer thread (push() never grows it)
+//  - Bounds checks of LineRecording::frame() and of the trailing index
+//  - After a failed write the writer drops the rest and close() writes no
+//    index, so the file ends at a frame boundary or in a cut frame
+//  - LineRecording::frame() and find() check each entry and its magic
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/lsd/recording.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace slab {
+	/* writes whole buffer, retrying on partial writes */
+	static bool write_all(int fd, const void *buf, size_t len) {
+		const uint8_t *p = (const uint8_t*)buf;
+		while (len > 0) {
+			ssize_t n = ::write(fd, p, len);
+			if (n < 0) {
+				if (errno == EINTR) continue;
+				return false;
+			}
+			p   += n;
+			len -= n;
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	// LineRecorder
+	//-------------------------------------------------------------------------
+	LineRecorder::LineRecorder(const std::string& path, uint16_t width, uint16_t height,
+			size_t chunk_size, size_t chunks) :
+		fd_            (-1        ),
+		chunk_size_    (chunk_size),
+		offset_        (0         ),
+		current_       (NULL      ),
+		chunks_        (chunks    ),
+		stop_          (false     ),
+		pushed_        (0         ),
+		dropped_       (0         ),
+		written_bytes_ (0         ),
+		error_         (false     )
+	{
+		if ((fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+			perror("cannot open recording");
+			error_ = true;
+			return;
+		}
+
+		RecordingHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, LSD_RECORDING_MAGIC, sizeof(header.magic));
+		header.version     = LSD_RECORDING_VERSION;
+		header.header_size = sizeof(RecordingHeader);
+		header.width       = width;
+		header.height      = height;
+		header.ram_size    = LSD_BUFSIZE;
+		if (!write_all(fd_, &header, sizeof(header))) {
+			perror("cannot write recording header");
+			error_ = true;
+		}
+		offset_ = sizeof(header);
+
+		/* preallocate every chunk so that push() never allocates */
+		for (size_t i=0; i<chunks_.size(); i++) {
+			chunks_[i].reserve(chunk_size_);
+			free_.push_back(&chunks_[i]);
+		}
+		current_ = free_.back();
+		free_.pop_back();
+		index_.reserve(1 << 16);
+
+		writer_ = std::thread(&LineRecorder::writer_loop, this);
+	}
+
+	LineRecorder::~LineRecorder() {
+		close();
+	}
+
+	/* queues the current chunk and takes a free one (called by producer) */
+	bool LineRecorder::handoff() {
+		std::lock_guard<std::mutex> lock(mtx_);
+		if (current_ != NULL && !current_->empty()) {
+			queue_.push_back(current_);
+			current_ = NULL;
+			cv_.notify_one();
+		}
+		if (current_ == NULL && !free_.empty()) {
+			current_ = free_.back();
+			free_.pop_back();
+		}
+		return current_ != NULL;
+	}
+
+	bool LineRecorder::push(const LineFrame& frame) {
+		if (fd_ < 0 || stop_ || error_) return false;
+
+		const size_t lines_bytes = (size_t)frame.count * sizeof(LineSegment);
+		const size_t need        = sizeof(RecordFrameHeader) + lines_bytes;
+
+		if (current_ == NULL || current_->size() + need > chunk_size_) {
+			if (!handoff()) {
+				dropped_++;
+				return false;
+			}
+		}
+
+		RecordFrameHeader header;
+		header.magic        = LSD_FRAME_MAGIC;
+		header.count        = frame.count;
+		header.sequence     = frame.sequence;
+		header.timestamp_ns = frame.timestamp_ns;
+		header.flags        = frame.flags;
+		header.reserved     = 0;
+
+		const uint8_t *h = (const uint8_t*)&header;
+		const uint8_t *l = (const uint8_t*)frame.lines;
+		current_->insert(current_->end(), h, h + sizeof(header));
+		current_->insert(current_->end(), l, l + lines_bytes);
+
+		pushed_++;
+		return true;
+	}
+
+	void LineRecorder::flush() {
+		if (fd_ < 0) return;
+		handoff();
+	}
+
+	void LineRecorder::close() {
+		if (fd_ < 0) return;
+
+		/* drain the queue and stop the writer */
+		flush();
+		{
+			std::lock_guard<std::mutex> lock(mtx_);
+			stop_ = true;
+			cv_.notify_one();
+		}
+		if (writer_.joinable()) writer_.join();
+
+		/* trailing index (not after a failed write: it would not match the file) */
+		if (error_) {
+			::close(fd_);
+			fd_ = -1;
+			return;
+		}
+		RecordingFooter footer;
+		footer.index_offset = offset_;
+		footer.frames       = index_.size();
+		footer.magic        = LSD_INDEX_MAGIC;
+		footer.reserved     = 0;
+		if (!write_all(fd_, index_.data(), index_.size() * sizeof(uint64_t)) ||
+				!write_all(fd_, &footer, sizeof(footer))) {
+			perror("cannot write recording index");
+			error_ = true;
+		}
+		::close(fd_);
+		fd_ = -1;
+	}
+
+	void LineRecorder::writer_loop() {
+		while (true) {
+			Chunk *chunk;
+			{
+				std::unique_lock<std::mutex> lock(mtx_);
+				cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+				if (queue_.empty()) break; // stopped and drained
+				chunk = queue_.front();
+				queue_.pop_front();
+			}
+
+			/* once a write has failed, the remaining chunks are dropped */
+			if (!error_) {
+				if (!write_all(fd_, chunk->data(), chunk->size())) {
+					perror("cannot write recording");
+					error_ = true;
+				}
+				else {
+					written_bytes_ += chunk->size();
+
+					/* index of the frames in the chunk (kept off the producer) */
+					for (size_t pos = 0; pos + sizeof(RecordFrameHeader) <= chunk->size(); ) {
+						RecordFrameHeader h;
+						memcpy(&h, chunk->data() + pos, sizeof(h));
+						index_.push_back(offset_ + pos);
+						pos += sizeof(RecordFrameHeader) + (size_t)h.count * sizeof(LineSegment);
+					}
+					offset_ += chunk->size();
+				}
+			}
+			chunk->clear();
+
+			{
+				std::lock_guard<std::mutex> lock(mtx_);
+				free_.push_back(chunk);
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// LineRecording
+	//-------------------------------------------------------------------------
+	LineRecording::LineRecording(const std::string& path) :
+		fd_     (-1  ),
+		map_    (NULL),
+		size_   (0   ),
+		index_  (NULL),
+		frames_ (0   ),
+		header_ (NULL)
+	{
+		struct stat st;
+
+		if ((fd_ = open(path.c_str(), O_RDONLY)) < 0) {
+			perror("cannot open recording");
+			return;
+		}
+		if (fstat(fd_, &st) < 0 || (size_t)st.st_size < sizeof(RecordingHeader)) {
+			fprintf(stderr, "%s: not a recording\n", path.c_str());
+			::close(fd_);
+			fd_ = -1;
+			return;
+		}
+		size_ = st.st_size;
+
+		void *map = mmap(NULL, size_, PROT_READ, MAP_SHARED, fd_, 0);
+		if (map == MAP_FAILED) {
+			perror("cannot mmap recording");
+			::close(fd_);
+			fd_ = -1;
+			return;
+		}
+		madvise(map, size_, MADV_SEQUENTIAL);
+		map_    = (const uint8_t*)map;
+		header_ = (const RecordingHeader*)map_;
+
+		if (memcmp(header_->magic, LSD_RECORDING_MAGIC, sizeof(header_->magic)) ||
+				header_->version != LSD_RECORDING_VERSION) {
+			fprintf(stderr, "%s: unsupported recording\n", path.c_str());
+			munmap((void*)map_, size_);
+			::close(fd_);
+			map_ = NULL;
+			fd_  = -1;
+			return;
+		}
+
+		if (!load_index()) {
+			fprintf(stderr, "%s: index not found, scanning frames...\n", path.c_str());
+			rebuild_index();
+		}
+	}
+
+	LineRecording::~LineRecording() {
+		if (map_ != NULL) munmap((void*)map_, size_);
+		if (fd_ >= 0) ::close(fd_);
+	}
+
+	bool LineRecording::load_index() {
+		if (size_ < header_->header_size + sizeof(RecordingFooter)) return false;
+
+		const RecordingFooter *footer =
+			(const RecordingFooter*)(map_ + size_ - sizeof(RecordingFooter));
+		if (footer->magic != LSD_INDEX_MAGIC) return false;
+
+		/* a corrupt footer must not point the index outside the map */
+		const uint64_t end = size_ - sizeof(RecordingFooter);
+		if (footer->index_offset < header_->header_size || footer->index_offset > end ||
+				footer->index_offset % sizeof(uint64_t) != 0) return false;
+		if (footer->frames > (end - footer->index_offset) / sizeof(uint64_t)) return false;
+		if (footer->index_offset + footer->frames * sizeof(uint64_t) != end) return false;
+
+		index_  = (const uint64_t*)(map_ + footer->index_offset);
+		frames_ = footer->frames;
+		return true;
+	}
+
+	void LineRecording::rebuild_index() {
+		uint64_t off = header_->header_size;
+
+		rebuilt_.clear();
+		while (off + sizeof(RecordFrameHeader) <= size_) {
+			const RecordFrameHeader *h = (const RecordFrameHeader*)(map_ + off);
+			uint64_t next = off + sizeof(RecordFrameHeader) +
+				(uint64_t)h->count * sizeof(LineSegment);
+			if (h->magic != LSD_FRAME_MAGIC || next > size_) break;
+			rebuilt_.push_back(off);
+			off = next;
+		}
+		index_  = rebuilt_.data();
+		frames_ = rebuilt_.size();
+	}
+
+	/* header of frame <i>; NULL when out of range, not a frame or not fitting in the file */
+	const RecordFrameHeader* LineRecording::entry(uint64_t i) const {
+		if (i >= frames_ || index_[i] > size_ - sizeof(RecordFrameHeader)) return NULL;
+		const RecordFrameHeader *h = (const RecordFrameHeader*)(map_ + index_[i]);
+		if (h->magic != LSD_FRAME_MAGIC) return NULL;
+		if ((uint64_t)h->count * sizeof(LineSegment) > size_ - sizeof(RecordFrameHeader) - index_[i]) return NULL;
+		return h;
+	}
+
+	/* false when <i> is out of range or not a valid frame */
+	bool LineRecording::frame(uint64_t i, LineFrame& frame) const {
+		const RecordFrameHeader *h = entry(i);
+		if (h == NULL) return false;
+		frame.sequence     = h->sequence;
+		frame.timestamp_ns = h->timestamp_ns;
+		frame.count        = h->count;
+		frame.flags        = h->flags;
+		frame.lines        = (const LineSegment*)(h + 1);
+		return true;
+	}
+
+	/* index of the first frame whose timestamp is >= <timestamp_ns> (an invalid one counts as later) */
+	uint64_t LineRecording::find(uint64_t timestamp_ns) const {
+		uint64_t lo = 0, hi = frames_;
+		while (lo < hi) {
+			uint64_t mid = (lo + hi) / 2;
+			const RecordFrameHeader *h = entry(mid);
+			if (h != NULL && h->timestamp_ns < timestamp_ns) lo = mid + 1;
+			else                                hi = mid;
+		}
+		return lo;
+	}
+
+	//-------------------------------------------------------------------------
+	// LineReplay
+	//-------------------------------------------------------------------------
+	LineReplay::LineReplay(const LineRecording& rec, bool loop, bool realtime) :
+		rec_          (rec     ),
+		pos_          (0       ),
+		loop_         (loop    ),
+		realtime_     (realtime),
+		base_rec_ns_  (0       ),
+		base_wall_ns_ (0       )
+	{
+	}
+
+	LineReplay::~LineReplay() {
+	}
+
+	void LineReplay::seek(uint64_t pos) {
+		pos_          = std::min(pos, rec_.size());
+		base_wall_ns_ = 0;
+	}
+
+	bool LineReplay::fetch(LineFrame& frame) {
+		if (pos_ >= rec_.size()) {
+			if (!loop_ || rec_.size() == 0) return false;
+			seek(0);
+		}
+		if (!rec_.frame(pos_++, frame)) return false;
+
+		/* paces frames according to the recorded timestamps */
+		if (realtime_) {
+			if (base_wall_ns_ == 0) {
+				base_wall_ns_ = monotonic_ns();
+				base_rec_ns_  = frame.timestamp_ns;
+			}
+			else {
+				uint64_t due = base_wall_ns_ + (frame.timestamp_ns - base_rec_ns_);
+				uint64_t now = monotonic_ns();
+				if (due > now)
+					std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+			}
+		}
+		return true;
+	}
+};
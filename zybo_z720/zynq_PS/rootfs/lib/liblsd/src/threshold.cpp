@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+// <threshold.cpp>
+//  - Defined functions of slab::LSDThresholdController class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 7, 2020)
+//  - Added definition for functions of slab::LSDThresholdController class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/lsd/threshold.hpp>
+
+#include <algorithm>
+
+#define MAX_GRAD_STEP 8
+
+namespace slab {
+	/* proportional step of the gradient threshold (1 - MAX_GRAD_STEP) */
+	static uint32_t grad_step(uint32_t grad, uint32_t diff, uint32_t ref) {
+		uint32_t step = (ref > 0) ? (grad * diff) / (ref * 2) : MAX_GRAD_STEP;
+		return std::min<uint32_t>(std::max<uint32_t>(step, 1), MAX_GRAD_STEP);
+	}
+
+	LSDThresholdController::LSDThresholdController(UIO& uio, uint32_t low, uint32_t high) :
+		uio_    (uio ),
+		low_    (low ),
+		high_   (high),
+		settle_ (2   ), // applied at the next frame start, then read back
+		hold_   (0   )
+	{
+		cur_.angle  = LSD_ANGLE_THRES;
+		cur_.grad   = LSD_GRAD_THRES;
+		cur_.length = LSD_LENGTH_THRES;
+		min_.angle  = 1;
+		min_.grad   = LSD_GRAD_THRES / 2;
+		min_.length = LSD_LENGTH_THRES;
+		max_.angle  = 255;
+		max_.grad   = 255;
+		max_.length = 255;
+
+		uio_.write(WRITE_LSD_MANUAL_THRES, 0x1);
+		apply();
+	}
+
+	LSDThresholdController::~LSDThresholdController() {
+		/* back to the parameters of simple_lsd */
+		uio_.write(WRITE_LSD_ANGLE_THRES,  0);
+		uio_.write(WRITE_LSD_GRAD_THRES,   0);
+		uio_.write(WRITE_LSD_LENGTH_THRES, 0);
+		uio_.write(WRITE_LSD_MANUAL_THRES, 0);
+	}
+
+	void LSDThresholdController::apply() {
+		uio_.write(WRITE_LSD_ANGLE_THRES,  cur_.angle );
+		uio_.write(WRITE_LSD_GRAD_THRES,   cur_.grad  );
+		uio_.write(WRITE_LSD_LENGTH_THRES, cur_.length);
+		hold_ = settle_;
+	}
+
+	void LSDThresholdController::set_band(uint32_t low, uint32_t high) {
+		low_  = low;
+		high_ = high;
+	}
+
+	void LSDThresholdController::set_range(const LSDThresholds& min, const LSDThresholds& max) {
+		min_ = min;
+		max_ = max;
+		set(cur_);
+	}
+
+	/* set thresholds directly (clipped to the range) */
+	void LSDThresholdController::set(const LSDThresholds& thres) {
+		cur_.angle  = std::min(std::max(thres.angle,  min_.angle ), max_.angle );
+		cur_.grad   = std::min(std::max(thres.grad,   min_.grad  ), max_.grad  );
+		cur_.length = std::min(std::max(thres.length, min_.length), max_.length);
+		apply();
+	}
+
+	/*
+	 * feeds the number of lines of the latest frame
+	 *  - returns true when the thresholds were changed
+	 */
+	bool LSDThresholdController::update(const LineFrame& frame) {
+		LSDThresholds next = cur_;
+
+		/* wait until the previous change shows up in the line count */
+		if (hold_ > 0) {
+			hold_--;
+			return false;
+		}
+
+		if (frame.overflow() || frame.count > high_) {
+			if (next.grad < max_.grad) {
+				uint32_t grad = next.grad + grad_step(next.grad, frame.count - std::min(frame.count, high_), high_);
+				next.grad = std::min<uint32_t>(grad, max_.grad);
+			}
+			else if (next.length < max_.length) {
+				next.length++;
+			}
+		}
+		else if (frame.count < low_) {
+			if (next.length > min_.length) {
+				next.length--;
+			}
+			else if (next.grad > min_.grad) {
+				uint32_t step = grad_step(next.grad, low_ - frame.count, low_);
+				next.grad = (next.grad > min_.grad + step) ? next.grad - step : min_.grad;
+			}
+		}
+
+		if (next.grad == cur_.grad && next.length == cur_.length) return false;
+		cur_ = next;
+		apply();
+		return true;
+	}
+
+	/* simple_lsd exceeded OVER_THRES in the last frame */
+	bool LSDThresholdController::overused() {
+		return uio_.read(READ_LSD_STATUS) & 0x1;
+	}
+
+	/* automatic offset of the squared gradient threshold */
+	uint32_t LSDThresholdController::offset() {
+		return (uio_.read(READ_LSD_STATUS) >> 8) & 0x1FFFF;
+	}
+};
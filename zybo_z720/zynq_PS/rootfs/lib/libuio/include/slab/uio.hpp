@@ -8,6 +8,9 @@
 //  - Added declaration of slab::UIO class
 //  - Added declaration of slab::mutex class
 //-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 18, 2020)
+//  - Added the register simulator (SLAB_UIO_SIM, see slab/uio/sim.hpp)
+//-----------------------------------------------------------------------------
 // (C) 2020 Naofumi Yoshinaga. All rights reserved.
 //-----------------------------------------------------------------------------
 
@@ -23,6 +26,9 @@
 #include <stdint.h>
 
 #include <string>
+#include <mutex>
+
+#include <slab/uio/sim.hpp>
 
 #define WRITE_ADDR   0x0
 #define WRITE_VALUE  0x1
@@ -52,6 +58,12 @@ namespace slab {
 			bool open_flag_;
 			mutex mtx_w_;
 			mutex mtx_r_;
+
+			/* register simulator (SLAB_UIO_SIM) instead of the device */
+			UIOSimMailbox *sim_;
+			std::mutex     sim_mtx_;
+			bool open_sim(const char*);
+			uint32_t sim_access(uint32_t addr, uint32_t data, bool write);
 		protected:
 		public:
 			UIO();
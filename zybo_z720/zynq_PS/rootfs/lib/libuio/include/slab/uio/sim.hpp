@@ -0,0 +1,54 @@
+//-----------------------------------------------------------------------------
+// <sim.hpp>
+//  - Mailbox of the register simulator
+//    - shared memory between slab::UIO and the Verilated vdma_top
+//      (zynq_PL/sim/verilator, sim_uio_<MODE>)
+//    - slab::UIO uses it instead of /dev/uio0 when SLAB_UIO_SIM names the
+//      shared memory (e.g. SLAB_UIO_SIM=/slab_uio)
+//-----------------------------------------------------------------------------
+// Protocol
+//  - ring of UIO_SIM_SLOTS register accesses with one producer (slab::UIO)
+//    and one consumer (simulator); <head> counts the posted accesses and
+//    <done> the accesses done, in order
+//  - write() posts its access and returns, read() posts and waits until
+//    <done> has passed it, so writes go in batches and only reads pay the
+//    round trip (like posted AXI writes before a read)
+//  - the simulator does one access every few cycles of ps_clk: writes go
+//    to slv_wireNN, reads return reg_data_out of zynq_ps_interface
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 18, 2020)
+//  - Added slab::UIOSimMailbox
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _UIO_SIM_H_
+#define _UIO_SIM_H_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#define UIO_SIM_ENV     "SLAB_UIO_SIM" // name of the shared memory
+#define UIO_SIM_MAGIC   0x534C4142     // "SLAB"
+#define UIO_SIM_VERSION 1
+#define UIO_SIM_SLOTS   1024           // power of 2
+
+namespace slab {
+	typedef struct UIOSimAccess {
+		uint32_t addr;
+		uint32_t data;   // value to write / value read
+		uint32_t write;  // 1: write, 0: read
+		uint32_t reserved;
+	} UIOSimAccess;
+
+	typedef struct UIOSimMailbox {
+		uint32_t magic, version;
+		std::atomic<uint32_t> alive;  // the simulator serves accesses
+		alignas(64) std::atomic<uint32_t> head; // accesses posted (slab::UIO)
+		alignas(64) std::atomic<uint32_t> done; // accesses done (simulator)
+		alignas(64) UIOSimAccess slot[UIO_SIM_SLOTS];
+	} UIOSimMailbox;
+};
+
+#endif // _UIO_SIM_H_
@@ -6,12 +6,23 @@
 //  - Added definition for functions of slab::UIO class
 //  - Added definition for functions of slab::mutex class
 //-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 18, 2020)
+//  - Added the register simulator (SLAB_UIO_SIM)
+//-----------------------------------------------------------------------------
 // (C) 2020 Naofumi Yoshinaga. All rights reserved.
 //-----------------------------------------------------------------------------
 
 
+#include <time.h>
+#include <sys/stat.h>
+
 #include <slab/uio.hpp>
 
+/* spins of a waiting access before sleeping / before checking the simulator */
+#define UIO_SIM_SPINS      256
+#define UIO_SIM_ALIVE_POLL (1 << 12)
+#define UIO_SIM_SLEEP_NS   2000
+
 namespace slab {
 	mutex::mutex() {
 		mtx = false;
@@ -32,10 +43,12 @@ namespace slab {
 
 	UIO::UIO() {
 		open_flag_ = false;
+		sim_       = NULL;
 	}
 
 	UIO::UIO(const char *dev) {
 		open_flag_ = false;
+		sim_       = NULL;
 		if (!open_flag_) {
 			printf("openning %s...\n", dev);
 			open_device(dev);
@@ -45,6 +58,7 @@ namespace slab {
 
 	UIO::UIO(std::string dev) {
 		open_flag_ = false;
+		sim_       = NULL;
 		if (!open_flag_) {
 			printf("openning %s...\n", dev.c_str());
 			open_device(dev.c_str());
@@ -62,6 +76,12 @@ namespace slab {
 
 	bool UIO::open_device(const char* dev) {
 		if (!open_flag_) {
+			/* registers of the simulator instead of <dev> */
+			const char *sim = getenv(UIO_SIM_ENV);
+			if (sim != NULL && sim[0] != '\0') {
+				return open_sim(sim);
+			}
+
 			/* open device */
 			if ((uiofd_ = open(dev, O_RDWR | O_SYNC)) < 0) {
 				perror("cannot open device\n");
@@ -84,16 +104,99 @@ namespace slab {
 
 	bool UIO::close_device() {
 		if (open_flag_) {
-			munmap((void*)reg_, 0x1000);
-			close(uiofd_);
+			if (sim_ != NULL) {
+				munmap((void*)sim_, sizeof(UIOSimMailbox));
+				sim_ = NULL;
+			}
+			else {
+				munmap((void*)reg_, 0x1000);
+				close(uiofd_);
+			}
 			open_flag_ = false;
 		}
 		return true;
 	}
 
+	bool UIO::open_sim(const char *name) {
+		int         fd;
+		struct stat st;
+
+		/* shared memory of the simulator (created by sim_uio_<MODE>) */
+		if ((fd = shm_open(name, O_RDWR, 0)) < 0) {
+			perror("cannot open simulator");
+			return false;
+		}
+		if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(UIOSimMailbox)) {
+			fprintf(stderr, "%s: not a mailbox of the simulator\n", name);
+			close(fd);
+			return false;
+		}
+		sim_ = (UIOSimMailbox *)mmap(NULL, sizeof(UIOSimMailbox), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (sim_ == MAP_FAILED) {
+			perror("cannot mmap simulator");
+			sim_ = NULL;
+			return false;
+		}
+		if (sim_->magic != UIO_SIM_MAGIC || sim_->version != UIO_SIM_VERSION) {
+			fprintf(stderr, "%s: mailbox version %u (expected %u)\n", name, sim_->version, UIO_SIM_VERSION);
+			munmap((void*)sim_, sizeof(UIOSimMailbox));
+			sim_ = NULL;
+			return false;
+		}
+		printf("simulator %s\n", name);
+
+		/* change flag */
+		open_flag_ = true;
+		return true;
+	}
+
+	/* gives the CPU to the simulator (which may share it) */
+	static void sim_wait() {
+		struct timespec ts = {0, UIO_SIM_SLEEP_NS};
+		nanosleep(&ts, NULL);
+	}
+
+	uint32_t UIO::sim_access(uint32_t addr, uint32_t data, bool write) {
+		std::lock_guard<std::mutex> lock(sim_mtx_);
+		uint32_t head = sim_->head.load(std::memory_order_relaxed);
+		uint32_t spin;
+
+		if (!sim_->alive.load(std::memory_order_relaxed)) return 0;
+
+		/* wait for a free slot, post the access */
+		for (spin=1; head - sim_->done.load(std::memory_order_acquire) >= UIO_SIM_SLOTS; spin++) {
+			if (spin % UIO_SIM_SPINS == 0) sim_wait();
+			if (spin % UIO_SIM_ALIVE_POLL == 0 && !sim_->alive.load(std::memory_order_relaxed)) {
+				fprintf(stderr, "UIO: the simulator has stopped\n");
+				return 0;
+			}
+		}
+		UIOSimAccess& slot = sim_->slot[head % UIO_SIM_SLOTS];
+		slot.addr  = addr;
+		slot.data  = data;
+		slot.write = write;
+		sim_->head.store(head + 1, std::memory_order_release);
+		if (write) return 0;
+
+		/* wait until the simulator has done every access up to the read */
+		for (spin=1; (int32_t)(sim_->done.load(std::memory_order_acquire) - (head + 1)) < 0; spin++) {
+			if (spin % UIO_SIM_SPINS == 0) sim_wait();
+			if (spin % UIO_SIM_ALIVE_POLL == 0 && !sim_->alive.load(std::memory_order_relaxed)) {
+				fprintf(stderr, "UIO: the simulator has stopped\n");
+				return 0;
+			}
+		}
+		return slot.data;
+	}
+
 	int UIO::read(int addr) {
 		int data;
 
+		if (sim_ != NULL) {
+			return sim_access(addr, 0, false);
+		}
+
 		mtx_r_.lock();
 		data = reg_[addr];
 		mtx_r_.unlock();
@@ -102,6 +205,11 @@ namespace slab {
 	}
 
 	void UIO::write(int addr, int data) {
+		if (sim_ != NULL) {
+			sim_access(addr, data, true);
+			return;
+		}
+
 		mtx_w_.lock();
 		reg_[addr] = data;
 		mtx_w_.unlock();
@@ -6,36 +6,124 @@
 #include <slab/video/AXI_VDMA.hpp>
 #include <slab/video/ScuGicInterruptController.hpp>
 #include <slab/video/VideoOutput.hpp>
+#include <slab/video/PixelFormat.hpp>
+#include <slab/video/CopyEngine.hpp>
+#include <slab/video/FrameMemory.hpp>
+#include <vector>
+#include <mutex>
 #include <slab/bsp/xparameters.h>
 #include <slab/bsp/xaxivdma.h>
 
+/* frame stores needed by zero-copy views (one scanned out / filled, one pending, one held) */
+#define VDMA_ZERO_COPY_FSTORES 3
+
 namespace slab {
-	typedef struct bgr_t {
-		uint8_t b, g, r;
-	} bgr_t;
+	/* pixels of the frame stores (stream width of each direction) */
+	typedef stream_pixel<XPAR_AXI_VDMA_0_M_AXIS_MM2S_TDATA_WIDTH>::type mm2s_pixel_t; // bgr_t
+	typedef stream_pixel<XPAR_AXI_VDMA_0_S_AXIS_S2MM_TDATA_WIDTH>::type s2mm_pixel_t; // xbgr_t
+
+	typedef BasicFrameView<mm2s_pixel_t> FrameView;   // MM2S (display)
+	typedef BasicFrameView<s2mm_pixel_t> CaptureView; // S2MM (capture)
+
+	/*
+	 * frames of one channel inside its frame stores
+	 *  - each frame store is a canvas of <canvas_width> x <canvas_height>
+	 *    pixels; the VDMA transfers <width> x <height> pixels at (<x>, <y>)
+	 *  - MM2S: the size is that of the video timing (embedding in a canvas)
+	 *  - S2MM: a smaller size captures the top-left <width> x <height> of
+	 *    the incoming video (ROI), the rest of each line / frame is dropped
+	 */
+	typedef struct DmaRegion {
+		uint32_t width, height;
+		uint32_t x, y;
+		uint32_t canvas_width, canvas_height;
+	} DmaRegion;
+
+	/* changed area of a frame (pixels) */
+	typedef struct DirtyRect {
+		uint32_t x, y, width, height;
+	} DirtyRect;
 
 	class VDMA {
 		public:
 			VDMA(uint32_t, uint32_t, Resolution);
+			VDMA(FrameMemory&, FrameMemory&, Resolution); // e.g. u-dma-buf (cached)
 			~VDMA();
 			void init();
 			void Vdma_StartRead();
 			void Vdma_StartWrite();
+			bool set_read_region(const DmaRegion&);  // before Vdma_StartRead()
+			bool set_write_region(const DmaRegion&); // before Vdma_StartWrite()
+			const DmaRegion& read_region() const  { return region_r_; }
+			const DmaRegion& write_region() const { return region_w_; }
 			void set_framebuffer(const bgr_t*, const uint8_t);
+			void set_framebuffer(const bgr_t*);
+			uint8_t update_framebuffer(const bgr_t*, const std::vector<DirtyRect>&);
 			void get_framebuffer(bgr_t*, const uint8_t);
+			mm2s_pixel_t *read_framebuffer(const uint8_t);
+			void park_read(const uint8_t);
+			uint8_t current_read_frame();
+			uint8_t acquire_read_frame();
+			FrameView read_view(const uint8_t);
+			CaptureView write_view(const uint8_t);
+			FrameView begin_present();
+			void end_present(const FrameView&);
+			CaptureView begin_capture();
+			void end_capture(const CaptureView&);
+			uint8_t current_write_frame();
+			void park_write(const uint8_t);
+			void circulate_write();
+			bool write_frame_done();
+			void invalidate_write_frame(const uint8_t);
+			void submit_read_frame(const uint8_t);
+			bool read_frame_done();
+			double frame_rate() const;
+			uint64_t submitted() const  { return submitted_;  }
+			uint64_t dropped() const    { return dropped_;    }
+			uint64_t updated_bytes() const { return updated_bytes_; }
+			uint32_t width() const      { return width_;      }
+			uint32_t height() const     { return height_;     }
+			uint32_t num_frames() const { return num_frames_; }
+			bool zero_copy() const      { return num_frames_ >= VDMA_ZERO_COPY_FSTORES; }
+			CopyEngine& copy_engine()   { calibrate_copy(); return copy_; }
+			FrameMemory& read_memory()  { return *mem_r_;     }
+			FrameMemory& write_memory() { return *mem_w_;     }
 		protected:
 		private:
 			ScuGicInterruptController           irpt_ctl_;
 			AXI_VDMA<ScuGicInterruptController> vdma_driver_;
 			VideoOutput                         vid_;
 			Resolution                          res_;
-			uint32_t                            base_addr_r_, base_addr_w_, width_, height_, pixels_, frameBytes_;
-			off_t                               fd_;
-			bgr_t                               *frame_buf_r_, *frame_buf_w_; 
+			uint32_t                            base_addr_r_, base_addr_w_, width_, height_, pixels_, num_frames_;
+			uint32_t                            frameBytes_r_, frameBytes_w_; // per direction (canvas)
+			DmaRegion                           region_r_, region_w_;
+			FrameMemory                         *mem_r_, *mem_w_;
+			bool                                own_mem_;         // /dev/mem regions made by the constructor
+			mm2s_pixel_t                        *frame_buf_r_;
+			s2mm_pixel_t                        *frame_buf_w_;
+			int                                 front_, pending_; // MM2S frame ring
+			int                                 capture_;         // S2MM store held by begin_capture()
+			uint64_t                            submitted_, dropped_;
+			std::vector<std::vector<DirtyRect>> stale_;           // per MM2S store: not yet copied by update_framebuffer()
+			uint64_t                            updated_bytes_;
+			CopyEngine                          copy_;
+			bool                                calibrated_;      // copy_ (on the first copy)
+			std::vector<s2mm_pixel_t>           bounce_;          // cached rows for get_framebuffer()
+			std::mutex                          park_mtx_;        // park pointer register of both channels (slab::Capture thread)
+			void                                put_frame(const bgr_t*, const FrameView&);
+			void                                retire_read_frame(const uint8_t);
+			void                                flip_read_frame(const uint8_t);
+			void                                put_rect(const bgr_t*, const FrameView&, const DirtyRect&);
+			void                                mark_stale(const int, const std::vector<DirtyRect>&);
+			                                    VDMA(uint32_t, uint32_t, Resolution, FrameMemory*, FrameMemory*);
+			bool                                fit_region(const DmaRegion&, uint32_t, uint32_t, FrameMemory*&);
+			void                                flush_read_frame(const uint8_t);
+			void                                calibrate_copy();
 			void                                map_framebuffer();
 			void                                unmap_framebuffer();
 	};
 
+	void coalesce_rects(std::vector<DirtyRect>&, const uint32_t, const uint32_t);
 	void generate_rgb(bgr_t *, const uint32_t , const uint32_t, uint8_t);
 	void read_ppm(bgr_t *, const uint32_t, const char *);
 	void write_ppm(const bgr_t *, const uint32_t, const uint32_t);
@@ -135,12 +135,21 @@ public:
 		}
 	}
 
-	void configureRead(uint16_t h_res, uint16_t v_res)
+	// Lines of h_res pixels (v_res lines) are <stride> bytes apart and start
+	// <offset> bytes into each frame store; frame stores are <frame_size>
+	// bytes apart. 0 packs them (stride = line, no offset, frame = v_res lines).
+	void configureRead(uint16_t h_res, uint16_t v_res, uint32_t stride = 0, uint32_t offset = 0, uint32_t frame_size = 0)
 	{
 		XStatus status;
 		context_.ReadCfg.HoriSizeInput = h_res * drv_inst_.ReadChannel.StreamWidth;
 		context_.ReadCfg.VertSizeInput = v_res;
-		context_.ReadCfg.Stride = context_.ReadCfg.HoriSizeInput;
+		context_.ReadCfg.Stride = stride ? stride : context_.ReadCfg.HoriSizeInput;
+		if (!frame_size) frame_size = context_.ReadCfg.Stride * context_.ReadCfg.VertSizeInput;
+		if (context_.ReadCfg.Stride < context_.ReadCfg.HoriSizeInput ||
+				offset + (v_res - 1) * context_.ReadCfg.Stride + context_.ReadCfg.HoriSizeInput > frame_size)
+		{
+			throw std::runtime_error(__FILE__ ":" LINE_STRING);
+		}
 		context_.ReadCfg.FrameDelay = 1;
 		context_.ReadCfg.EnableCircularBuf = 1;
 		context_.ReadCfg.EnableSync = 1;
@@ -152,12 +161,12 @@ public:
 		{
 			throw std::runtime_error(__FILE__ ":" LINE_STRING);
 		}
-		uint32_t addr = frame_read_buf_base_addr_;
+		uint32_t addr = frame_read_buf_base_addr_ + offset;
 		for (int iFrm=0; iFrm<drv_inst_.MaxNumFrames; ++iFrm) {
 			context_.ReadCfg.FrameStoreStartAddr[iFrm] = addr;
 			printf("VDMA Frame %d Addr: 0x%08x\r\n", iFrm, addr);
 			//memset((void*)addr,0,context_.ReadCfg.HoriSizeInput * context_.ReadCfg.VertSizeInput);
-			addr += context_.ReadCfg.HoriSizeInput * context_.ReadCfg.VertSizeInput;
+			addr += frame_size;
 		}
 		status = XAxiVdma_DmaSetBufferAddr(&drv_inst_, XAXIVDMA_READ, context_.ReadCfg.FrameStoreStartAddr);
 		if (XST_SUCCESS != status)
@@ -182,14 +191,24 @@ public:
 			throw std::runtime_error(__FILE__ ":" LINE_STRING);
 		}
 	}
-	void configureWrite(uint16_t h_res, uint16_t v_res)
+	// Same layout as configureRead(). With <roi>, h_res x v_res may be smaller
+	// than the incoming video: the VDMA writes the first h_res pixels of the
+	// first v_res lines and drops the rest, so the late EOL / late SOF errors
+	// this raises are masked.
+	void configureWrite(uint16_t h_res, uint16_t v_res, uint32_t stride = 0, uint32_t offset = 0, uint32_t frame_size = 0, bool roi = false)
 	{
 		XAxiVdma_ClearDmaChannelErrors(&drv_inst_, XAXIVDMA_WRITE, XAXIVDMA_SR_ERR_ALL_MASK);
 
 		XStatus status;
 		context_.WriteCfg.HoriSizeInput = h_res * drv_inst_.WriteChannel.StreamWidth;
 		context_.WriteCfg.VertSizeInput = v_res;
-		context_.WriteCfg.Stride = context_.WriteCfg.HoriSizeInput;
+		context_.WriteCfg.Stride = stride ? stride : context_.WriteCfg.HoriSizeInput;
+		if (!frame_size) frame_size = context_.WriteCfg.Stride * context_.WriteCfg.VertSizeInput;
+		if (context_.WriteCfg.Stride < context_.WriteCfg.HoriSizeInput ||
+				offset + (v_res - 1) * context_.WriteCfg.Stride + context_.WriteCfg.HoriSizeInput > frame_size)
+		{
+			throw std::runtime_error(__FILE__ ":" LINE_STRING);
+		}
 		context_.WriteCfg.FrameDelay = 0;
 		context_.WriteCfg.EnableCircularBuf = 1;
 		context_.WriteCfg.EnableSync = 1; //Gen-Lock
@@ -201,11 +220,11 @@ public:
 		{
 			throw std::runtime_error(__FILE__ ":" LINE_STRING);
 		}
-		uint32_t addr = frame_write_buf_base_addr_;
+		uint32_t addr = frame_write_buf_base_addr_ + offset;
 		for (int iFrm=0; iFrm<drv_inst_.MaxNumFrames; ++iFrm) {
 			context_.WriteCfg.FrameStoreStartAddr[iFrm] = addr;
 			printf("VDMA Frame %d Addr: 0x%08x\r\n", iFrm, addr);
-			addr += context_.WriteCfg.HoriSizeInput * context_.WriteCfg.VertSizeInput;
+			addr += frame_size;
 		}
 		status = XAxiVdma_DmaSetBufferAddr(&drv_inst_, XAXIVDMA_WRITE, context_.WriteCfg.FrameStoreStartAddr);
 		if (XST_SUCCESS != status)
@@ -214,8 +233,10 @@ public:
 		}
 		//Clear errors in SR
 		XAxiVdma_ClearChannelErrors(&drv_inst_.WriteChannel, XAXIVDMA_SR_ERR_ALL_MASK);
-		//Unmask error interrupts
-		XAxiVdma_MaskS2MMErrIntr(&drv_inst_, ~XAXIVDMA_S2MM_IRQ_ERR_ALL_MASK, XAXIVDMA_WRITE);
+		//Unmask error interrupts (but those of the cut-off part of an ROI)
+		XAxiVdma_MaskS2MMErrIntr(&drv_inst_,
+				roi ? (XAXIVDMA_S2MM_IRQ_LSZMORE_EOL_LATE_MASK | XAXIVDMA_S2MM_IRQ_FSZMORE_SOF_LATE_MASK) : ~XAXIVDMA_S2MM_IRQ_ERR_ALL_MASK,
+				XAXIVDMA_WRITE);
 		//Enable write channel error and frame count interrupts
 		XAxiVdma_IntrEnable(&drv_inst_, XAXIVDMA_IXR_ERROR_MASK, XAXIVDMA_WRITE);
 	}
@@ -229,6 +250,67 @@ public:
 			throw std::runtime_error(__FILE__ ":" LINE_STRING);
 		}
 	}
+	// Park the read channel on one frame store. The new store is picked up at
+	// the next frame start, so a store that is not parked can be redrawn
+	// without tearing.
+	void parkRead(int frame)
+	{
+		XStatus status;
+		status = XAxiVdma_StartParking(&drv_inst_, frame, XAXIVDMA_READ);
+		if (XST_SUCCESS != status)
+		{
+			throw std::runtime_error(__FILE__ ":" LINE_STRING);
+		}
+	}
+	// Frame store the read channel is currently scanning out
+	int currentReadFrame()
+	{
+		return XAxiVdma_CurrFrameStore(&drv_inst_, XAXIVDMA_READ);
+	}
+	// Park the write channel (S2MM keeps overwriting one frame store) and
+	// go back to circulating
+	void parkWrite(int frame)
+	{
+		XStatus status;
+		status = XAxiVdma_StartParking(&drv_inst_, frame, XAXIVDMA_WRITE);
+		if (XST_SUCCESS != status)
+		{
+			throw std::runtime_error(__FILE__ ":" LINE_STRING);
+		}
+	}
+	void circulateWrite()
+	{
+		XAxiVdma_StopParking(&drv_inst_, XAXIVDMA_WRITE);
+	}
+	// Frame store the write channel is currently filling
+	int currentWriteFrame()
+	{
+		return XAxiVdma_CurrFrameStore(&drv_inst_, XAXIVDMA_WRITE);
+	}
+	// True once the read channel completed a frame since the last call. The
+	// frame count status bit is set at every frame (IRQFrameCount is 1 after
+	// reset) whether or not its interrupt is enabled, so it can be polled.
+	bool readFrameDone()
+	{
+		if (!(XAxiVdma_IntrGetPending(&drv_inst_, XAXIVDMA_READ) & XAXIVDMA_IXR_FRMCNT_MASK)) {
+			return false;
+		}
+		XAxiVdma_IntrClear(&drv_inst_, XAXIVDMA_IXR_FRMCNT_MASK, XAXIVDMA_READ);
+		return true;
+	}
+	// Same for the write channel (a frame was written)
+	bool writeFrameDone()
+	{
+		if (!(XAxiVdma_IntrGetPending(&drv_inst_, XAXIVDMA_WRITE) & XAXIVDMA_IXR_FRMCNT_MASK)) {
+			return false;
+		}
+		XAxiVdma_IntrClear(&drv_inst_, XAXIVDMA_IXR_FRMCNT_MASK, XAXIVDMA_WRITE);
+		return true;
+	}
+	int numFrames() const
+	{
+		return drv_inst_.MaxNumFrames;
+	}
 	void readHandler(uint32_t irq_types)
 	{
 		std::cout << "VDMA:read complete" << std::endl;
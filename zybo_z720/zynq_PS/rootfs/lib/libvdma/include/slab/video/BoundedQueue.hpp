@@ -0,0 +1,103 @@
+//-----------------------------------------------------------------------------
+// <BoundedQueue.hpp>
+//  - Header of slab::BoundedQueue class
+//    - bounded lock-free queue (any number of producers and consumers)
+//-----------------------------------------------------------------------------
+// Algorithm
+//  - D. Vyukov's bounded MPMC queue: every cell has a sequence number, which
+//    tells whether it is free for the push at a position or holds the value
+//    for the pop at it; head and tail are claimed with compare-and-swap
+//  - the capacity need not be a power of two (positions wrap with %)
+//  - there are at least 2 cells: with one, a full cell and a cell free for
+//    the next push have the same sequence number. A smaller capacity is
+//    kept by comparing the push position with head
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 29, 2020)
+//  - Added declaration of slab::BoundedQueue class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 30, 2020)
+//  - Fixed a capacity of 1 (two pushes went into the same cell)
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _BOUNDED_QUEUE_H_
+#define _BOUNDED_QUEUE_H_
+
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+
+namespace slab {
+	template <typename T>
+	class BoundedQueue {
+		private:
+			struct Cell {
+				std::atomic<size_t> seq;
+				T                   value;
+			};
+
+			std::unique_ptr<Cell[]> cells_;
+			const size_t            size_;        // cells
+			const size_t            capacity_;
+			std::atomic<size_t>     head_, tail_; // next pop, next push
+		protected:
+		public:
+			BoundedQueue(size_t capacity) :
+				cells_    (new Cell[(capacity > 2) ? capacity : 2]),
+				size_     ((capacity > 2) ? capacity : 2          ),
+				capacity_ (capacity ? capacity : 1                ),
+				head_     (0                                      ),
+				tail_     (0                                      )
+			{
+				for (size_t i=0; i<size_; i++) cells_[i].seq.store(i, std::memory_order_relaxed);
+			}
+
+			/* false when full */
+			bool try_push(const T& value) {
+				size_t pos = tail_.load(std::memory_order_relaxed);
+				for (;;) {
+					Cell&  cell = cells_[pos % size_];
+					size_t seq  = cell.seq.load(std::memory_order_acquire);
+					if (seq == pos) {
+						if (pos - head_.load(std::memory_order_acquire) >= capacity_) return false;
+						if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+							cell.value = value;
+							cell.seq.store(pos + 1, std::memory_order_release);
+							return true;
+						}
+					}
+					else if ((ptrdiff_t)(seq - pos) < 0) return false;
+					else                                 pos = tail_.load(std::memory_order_relaxed);
+				}
+			}
+
+			/* false when empty */
+			bool try_pop(T& value) {
+				size_t pos = head_.load(std::memory_order_relaxed);
+				for (;;) {
+					Cell&  cell = cells_[pos % size_];
+					size_t seq  = cell.seq.load(std::memory_order_acquire);
+					if (seq == pos + 1) {
+						if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+							value = cell.value;
+							cell.seq.store(pos + size_, std::memory_order_release);
+							return true;
+						}
+					}
+					else if ((ptrdiff_t)(seq - (pos + 1)) < 0) return false;
+					else                                       pos = head_.load(std::memory_order_relaxed);
+				}
+			}
+
+			/* approximate while other threads push or pop */
+			size_t size() const {
+				const size_t tail = tail_.load(std::memory_order_relaxed);
+				const size_t head = head_.load(std::memory_order_relaxed);
+				return (tail > head) ? tail - head : 0;
+			}
+			size_t capacity() const { return capacity_; }
+	};
+};
+
+#endif // _BOUNDED_QUEUE_H_
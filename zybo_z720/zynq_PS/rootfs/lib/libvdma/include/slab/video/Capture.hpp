@@ -0,0 +1,113 @@
+//-----------------------------------------------------------------------------
+// <Capture.hpp>
+//  - Header of slab::Capture class
+//    - continuous S2MM capture on a thread, completed frames handed out
+//      in place (no copy) through a bounded lock-free queue
+//-----------------------------------------------------------------------------
+// Frame stores
+//  - the write channel is always parked: on the store it is filling and,
+//    as soon as that one has started, on the next free one. The switch
+//    happens at a frame start, so the filling store is complete once
+//    current_write_frame() moves on (a late poll only delays it)
+//  - a completed store is queued, then held by the consumer until
+//    release(); the VDMA is never parked on a queued or held store
+//  - no free store: CAPTURE_LATEST takes the oldest queued (not held) one
+//    if a newer one stays queued, otherwise the write channel stays on the
+//    filling store, which is written again (overruns())
+// Modes
+//  - CAPTURE_LATEST  : at most <depth> frames queued; a new one replaces
+//                      the oldest (dropped()); overruns while the
+//                      consumer holds all but two stores (e.g. 1 of 3)
+//  - CAPTURE_NO_DROP : every completed frame is queued; a slow consumer
+//                      stalls the capture instead (overruns())
+// Use
+//  - VDMA::Vdma_StartWrite() first; the capture thread owns the write
+//    channel (no begin_capture() meanwhile)
+//  - one consumer thread: pop(), read the view, release()
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 29, 2020)
+//  - Added declaration of slab::Capture class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 30, 2020)
+//  - release() frees a store only for the frame that is out in it (<id>):
+//    a second or late release (from before stop()) is ignored
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <slab/vdma.hpp>
+#include <slab/video/BoundedQueue.hpp>
+
+namespace slab {
+	typedef enum CaptureMode {
+		CAPTURE_LATEST = 0,
+		CAPTURE_NO_DROP
+	} CaptureMode;
+
+	/* completed S2MM frame (read only, valid until release()) */
+	typedef struct CaptureFrame {
+		BasicFrameView<const s2mm_pixel_t> view;
+		uint64_t                           seq;  // completed frames before this one
+		double                             time; // completion seen [s] from start()
+		uint64_t                           id;   // for release() (unique per Capture, never reused)
+	} CaptureFrame;
+
+	class Capture {
+		private:
+			typedef std::chrono::steady_clock clock;
+			typedef enum StoreState {
+				STORE_FREE = 0,
+				STORE_FILLING, // written by the VDMA
+				STORE_NEXT,    // parked, written from the next frame start
+				STORE_OUT      // queued or held by the consumer
+			} StoreState;
+			typedef struct Released {
+				int      index;
+				uint64_t id;
+			} Released;
+
+			VDMA                       &vdma_;
+			const CaptureMode          mode_;
+			BoundedQueue<CaptureFrame> ready_;    // capture thread -> consumer
+			BoundedQueue<Released>     released_; // consumer -> capture thread
+			std::vector<StoreState>    state_;    // capture thread only
+			std::vector<uint64_t>      out_id_;   // per store: id of the frame out in it
+			uint64_t                   next_id_;  // not reset by start()
+			int                        filling_;
+			std::thread                thread_;
+			std::atomic<bool>          running_;
+			clock::time_point          start_;
+			std::atomic<uint64_t>      captured_, dropped_, overruns_;
+
+			int  free_store() const;
+			void reclaim();
+			void publish(int);
+			void run();
+		protected:
+		public:
+			/* <depth>: queued frames of CAPTURE_LATEST */
+			Capture(VDMA&, CaptureMode mode = CAPTURE_LATEST, uint32_t depth = 1);
+			~Capture();
+			void start();
+			void stop();
+			bool try_pop(CaptureFrame&);
+			/* <timeout_ms> < 0: wait for ever */
+			bool pop(CaptureFrame&, int timeout_ms = -1);
+			void release(const CaptureFrame&);
+			bool running() const       { return running_;  }
+			uint64_t captured() const  { return captured_; }
+			uint64_t dropped() const   { return dropped_;  }
+			uint64_t overruns() const  { return overruns_; }
+			size_t queued() const      { return ready_.size(); }
+	};
+};
+
+#endif // _CAPTURE_H_
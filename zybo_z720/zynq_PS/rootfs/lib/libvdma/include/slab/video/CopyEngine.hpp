@@ -0,0 +1,71 @@
+//-----------------------------------------------------------------------------
+// <CopyEngine.hpp>
+//  - Header of slab::CopyEngine class
+//    - copies between cached memory and the frame stores (/dev/mem,
+//      O_SYNC: uncached) with the fastest of several kernels
+//-----------------------------------------------------------------------------
+// Kernels
+//  - COPY_MEMCPY : memcpy()
+//  - COPY_WIDE   : 64 bytes per step (NEON / SSE2) with prefetch
+//  - COPY_STREAM : non-temporal stores (x86 only; ARMv7 has none)
+//  - COPY_SPLIT  : COPY_WIDE split into one part per core
+// Selection
+//  - calibrate() times every kernel on the mapping itself in both
+//    directions (to the device: cached -> frame store, from the device:
+//    frame store -> cached) and keeps the fastest of each
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 24, 2020)
+//  - Added declaration of slab::CopyEngine class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _COPY_ENGINE_H_
+#define _COPY_ENGINE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace slab {
+	typedef enum CopyKernel {
+		COPY_MEMCPY = 0,
+		COPY_WIDE,
+		COPY_STREAM,
+		COPY_SPLIT,
+		COPY_KERNELS
+	} CopyKernel;
+
+	typedef enum CopyDirection {
+		COPY_TO_DEVICE = 0,
+		COPY_FROM_DEVICE
+	} CopyDirection;
+
+	class CopyEngine {
+		private:
+			CopyKernel kernel_[2];
+			double     mbps_[2][COPY_KERNELS]; // 0: not measured
+			unsigned   threads_;
+
+			void run(CopyKernel, void*, const void*, size_t) const;
+		protected:
+		public:
+			CopyEngine(unsigned threads = 0);
+			~CopyEngine();
+			static bool supported(CopyKernel);
+			static const char *kernel_name(CopyKernel);
+			void set_threads(unsigned threads);
+			/* times every kernel on <bytes> of the mapping, keeps the fastest */
+			void calibrate(void *device_dst, const void *device_src, size_t bytes, int rounds = 3);
+			bool set_kernel(CopyDirection, CopyKernel);
+			CopyKernel kernel(CopyDirection dir) const           { return kernel_[dir];    }
+			double mbps(CopyDirection dir, CopyKernel k) const   { return mbps_[dir][k];   }
+			unsigned threads() const                             { return threads_;        }
+			void to_device(void *dst, const void *src, size_t n) const   { run(kernel_[COPY_TO_DEVICE],   dst, src, n); }
+			void from_device(void *dst, const void *src, size_t n) const { run(kernel_[COPY_FROM_DEVICE], dst, src, n); }
+			/* MB/s of every kernel (after calibrate()) */
+			void print(FILE*) const;
+	};
+};
+
+#endif // _COPY_ENGINE_H_
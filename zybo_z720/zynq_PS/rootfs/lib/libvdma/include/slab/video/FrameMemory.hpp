@@ -0,0 +1,103 @@
+//-----------------------------------------------------------------------------
+// <FrameMemory.hpp>
+//  - Header of slab::FrameMemory classes
+//    - physically contiguous memory of the frame stores
+//-----------------------------------------------------------------------------
+// Backends
+//  - DevMemFrameMemory  : fixed physical address through /dev/mem (O_SYNC,
+//                         uncached, no cache maintenance)
+//  - UDmaBufFrameMemory : u-dma-buf (CMA) device /dev/<name>, cached; the
+//                         physical address comes from sysfs, and
+//                         sync_for_device()/sync_for_cpu() clean/invalidate
+//                         the given range through sync_offset, sync_size,
+//                         sync_direction and sync_for_device/sync_for_cpu
+//  - MemfdFrameMemory   : memfd stand-in with a made-up physical address;
+//                         cached, syncs are only counted and range-checked
+// Ownership
+//  - the CPU writes, then sync_for_device() before the VDMA reads (MM2S)
+//  - the VDMA writes, then sync_for_cpu() before the CPU reads (S2MM)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 25, 2020)
+//  - Added declaration of slab::FrameMemory classes
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _FRAME_MEMORY_H_
+#define _FRAME_MEMORY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+namespace slab {
+	class FrameMemory {
+		private:
+			uint64_t flushes_, invalidates_, flushed_bytes_, invalidated_bytes_;
+			bool     clip(size_t&, size_t&) const;
+		protected:
+			uint8_t  *data_;
+			uint32_t phys_;
+			size_t   size_;
+			bool     cached_;
+
+			/* cache maintenance of [offset, offset + size) */
+			virtual void sync(size_t, size_t, bool) {}
+		public:
+			FrameMemory();
+			virtual ~FrameMemory();
+			void sync_for_device(size_t offset, size_t size);
+			void sync_for_cpu(size_t offset, size_t size);
+			bool     valid() const             { return data_ != NULL;      }
+			uint8_t  *data() const             { return data_;              }
+			uint32_t phys() const              { return phys_;              }
+			size_t   size() const              { return size_;              }
+			bool     cached() const            { return cached_;            }
+			uint64_t flushes() const           { return flushes_;           }
+			uint64_t invalidates() const       { return invalidates_;       }
+			uint64_t flushed_bytes() const     { return flushed_bytes_;     }
+			uint64_t invalidated_bytes() const { return invalidated_bytes_; }
+	};
+
+	class DevMemFrameMemory : public FrameMemory {
+		private:
+			int fd_;
+		public:
+			DevMemFrameMemory(uint32_t phys, size_t size);
+			~DevMemFrameMemory();
+	};
+
+	class UDmaBufFrameMemory : public FrameMemory {
+		private:
+			int         fd_;
+			std::string sysfs_;
+			bool        write_attr(const char*, unsigned long);
+			bool        read_attr(const char*, unsigned long&);
+		protected:
+			void sync(size_t offset, size_t size, bool for_device);
+		public:
+			UDmaBufFrameMemory(const std::string& name = "udmabuf0");
+			~UDmaBufFrameMemory();
+	};
+
+	class MemfdFrameMemory : public FrameMemory {
+		private:
+			int fd_;
+		public:
+			MemfdFrameMemory(size_t size, uint32_t phys = 0);
+			~MemfdFrameMemory();
+			/* another mapping of the same pages (e.g. a simulated device) */
+			int fd() const { return fd_; }
+	};
+
+	/*
+	 * backend by name
+	 *  - "devmem" (or "") : DevMemFrameMemory(phys, size)
+	 *  - "memfd"          : MemfdFrameMemory(size, phys)
+	 *  - anything else    : UDmaBufFrameMemory(name), e.g. "udmabuf0"
+	 */
+	FrameMemory *open_frame_memory(const std::string& name, uint32_t phys, size_t size);
+};
+
+#endif // _FRAME_MEMORY_H_
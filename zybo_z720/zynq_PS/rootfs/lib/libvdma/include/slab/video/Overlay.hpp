@@ -0,0 +1,86 @@
+//-----------------------------------------------------------------------------
+// <Overlay.hpp>
+//  - Header of slab::Overlay class
+//    - draws line segments and text into a MM2S frame store and
+//      flips it to HDMI with the VDMA park pointer (no X server)
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 6, 2020)
+//  - Added declaration of slab::Overlay class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 20, 2020)
+//  - present() takes its frame store from the frame ring of slab::VDMA
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 22, 2020)
+//  - Added begin(): drawing goes straight into a free frame store
+//-----------------------------------------------------------------------------
+// Version 1.03 (Dec. 27, 2020)
+//  - present() copies into frame stores of any stride
+//-----------------------------------------------------------------------------
+// Version 1.04 (Dec. 28, 2020)
+//  - Drawing into the back buffer records dirty rectangles; present()
+//    copies only those (VDMA::update_framebuffer())
+//-----------------------------------------------------------------------------
+// Version 1.05 (Dec. 30, 2020)
+//  - begin() gives the back buffer when there is no free frame store
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _OVERLAY_H_
+#define _OVERLAY_H_
+
+#include <stdint.h>
+#include <vector>
+#include <slab/vdma.hpp>
+
+#define OVERLAY_FONT_W 5
+#define OVERLAY_FONT_H 7
+
+namespace slab {
+	/*
+	 * frame compositor on top of slab::VDMA
+	 *  - drawing goes to a cached back buffer; present() copies what was
+	 *    drawn since the last present() (dirty rectangles) into a frame
+	 *    store that is neither scanned out nor pending, then parks the read
+	 *    channel on it. The switch happens at the next frame start, so the
+	 *    output never tears.
+	 *  - after begin(), drawing goes straight into the free frame store
+	 *    (e.g. after decoding into it) and present() flips it without a
+	 *    copy
+	 *  - MM2S also feeds <image_processor>, so whatever is drawn is also
+	 *    the input of simple_lsd: detected lines drawn here are detected
+	 *    again. Show them with <lsd_visualizer> (sw = 3) instead, and
+	 *    draw here only for debugging.
+	 */
+	class Overlay {
+		private:
+			VDMA                   &vdma_;
+			uint32_t               width_, height_;
+			std::vector<bgr_t>     back_;
+			FrameView              target_; // back buffer or frame store
+			uint64_t               presented_;
+			std::vector<DirtyRect> dirty_;  // back buffer since the last present()
+
+			void touch(int, int, int, int);
+			void fill(int, int, int, int, const bgr_t&);
+			void put(int, int, const bgr_t&);
+			void glyph(int, int, char, const bgr_t&, int);
+		protected:
+		public:
+			Overlay(VDMA&);
+			~Overlay();
+			void clear(const bgr_t&);
+			void blit(const bgr_t*);
+			void line(int, int, int, int, const bgr_t&);
+			void rect(int, int, int, int, const bgr_t&);
+			void text(int, int, const char*, const bgr_t&, int scale = 1);
+			const FrameView& begin();
+			uint8_t present();
+			bgr_t    *data()           { return target_.data; }
+			uint32_t width() const     { return width_;       }
+			uint32_t height() const    { return height_;      }
+			uint64_t presented() const { return presented_;   }
+	};
+};
+
+#endif // _OVERLAY_H_
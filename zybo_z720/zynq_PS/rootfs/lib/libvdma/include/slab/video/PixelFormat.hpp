@@ -0,0 +1,115 @@
+//-----------------------------------------------------------------------------
+// <PixelFormat.hpp>
+//  - Pixel formats of the frame stores and conversions between them
+//-----------------------------------------------------------------------------
+// Formats (bytes in memory order, byte 0 is tdata[7:0] of the stream)
+//  - BGR888   : b, g, r     (bgr_t)  MM2S, M_AXIS_MM2S_TDATA_WIDTH = 24,
+//                                    same as cv::Mat CV_8UC3 (BGR)
+//  - XBGR8888 : b, g, r, x  (xbgr_t) S2MM, S_AXIS_S2MM_TDATA_WIDTH = 32,
+//                                    the 24-bit video padded by the VDMA
+//  - Y8       : y           (y8_t)   luma, same weights as <rgb2ycbcr>
+//                                    (Y = (435 R + 1465 G + 148 B + 1024) >> 11)
+// Conversion
+//  - convert_row() for every pair, NEON / SSSE3 (chosen at run time) with a
+//    scalar fallback; the swizzle is fused with the copy, so converting a
+//    frame store reads and writes each byte once
+//  - convert() works on two BasicFrameView of any format and stride
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 23, 2020)
+//  - Added pixel formats, slab::BasicFrameView and converters
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _PIXEL_FORMAT_H_
+#define _PIXEL_FORMAT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace slab {
+	typedef enum PixelFormat {
+		PIXEL_BGR888 = 0,
+		PIXEL_XBGR8888,
+		PIXEL_Y8
+	} PixelFormat;
+
+	typedef struct bgr_t {
+		uint8_t b, g, r;
+		static const PixelFormat format = PIXEL_BGR888;
+	} bgr_t;
+
+	typedef struct xbgr_t {
+		uint8_t b, g, r, x;
+		static const PixelFormat format = PIXEL_XBGR8888;
+	} xbgr_t;
+
+	typedef struct y8_t {
+		uint8_t y;
+		static const PixelFormat format = PIXEL_Y8;
+	} y8_t;
+
+	/* pixel of an AXI4-Stream video of <TDATA_WIDTH> bits in memory */
+	template <uint32_t TDATA_WIDTH> struct stream_pixel;
+	template <> struct stream_pixel< 8> { typedef y8_t   type; };
+	template <> struct stream_pixel<24> { typedef bgr_t  type; };
+	template <> struct stream_pixel<32> { typedef xbgr_t type; };
+
+	static inline uint32_t pixel_bytes(PixelFormat format) {
+		static const uint32_t bytes[] = {3, 4, 1};
+		return bytes[format];
+	}
+
+	static inline const char *pixel_format_name(PixelFormat format) {
+		static const char *names[] = {"BGR888", "XBGR8888", "Y8"};
+		return names[format];
+	}
+
+	/*
+	 * view of one frame (no copy)
+	 *  - <step> is in bytes, so cv::Mat(height, width, CV_8UC3 (bgr_t) or
+	 *    CV_8UC4 (xbgr_t) or CV_8UC1 (y8_t), data, step) wraps it
+	 *  - <index> is the frame store, -1 for an empty view
+	 */
+	template <typename Pixel>
+	struct BasicFrameView {
+		typedef Pixel pixel_type;
+
+		Pixel    *data;
+		uint32_t width, height, step;
+		int      index;
+
+		Pixel *row(uint32_t v) const { return (Pixel*)((uint8_t*)data + v * step); }
+		bool valid() const           { return data != NULL;                        }
+		PixelFormat format() const   { return Pixel::format;                       }
+	};
+
+	/* <n> pixels of one row */
+	void convert_row(const xbgr_t*, bgr_t*,  uint32_t n);
+	void convert_row(const bgr_t*,  xbgr_t*, uint32_t n);
+	void convert_row(const xbgr_t*, y8_t*,   uint32_t n);
+	void convert_row(const bgr_t*,  y8_t*,   uint32_t n);
+	void convert_row(const y8_t*,   bgr_t*,  uint32_t n);
+	void convert_row(const y8_t*,   xbgr_t*, uint32_t n);
+
+	template <typename Pixel>
+	static inline void convert_row(const Pixel *src, Pixel *dst, uint32_t n) {
+		memcpy(dst, src, (size_t)n * sizeof(Pixel));
+	}
+
+	/* converts the common area of <src> and <dst> */
+	template <typename S, typename D>
+	void convert(const BasicFrameView<S>& src, const BasicFrameView<D>& dst) {
+		const uint32_t w = std::min(src.width, dst.width), h = std::min(src.height, dst.height);
+		for (uint32_t v=0; v<h; v++) convert_row(src.row(v), dst.row(v), w);
+	}
+
+	/* kernel of convert_row() ("neon", "ssse3" or "scalar") */
+	const char *pixel_convert_kernel();
+	void pixel_convert_simd(bool enable);
+};
+
+#endif // _PIXEL_FORMAT_H_
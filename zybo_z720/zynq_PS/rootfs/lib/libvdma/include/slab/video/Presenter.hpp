@@ -0,0 +1,90 @@
+//-----------------------------------------------------------------------------
+// <Presenter.hpp>
+//  - Header of slab::Presenter class
+//    - paces frame submissions of a source (e.g. a video file) to the
+//      frame rate of the display
+//-----------------------------------------------------------------------------
+// Vsync
+//  - the frame count status bit of the read channel (VDMA::read_frame_done())
+//    is polled; frames missed between two polls are counted from the time
+//    since the last one. Without the status bit (no frame within 4 frame
+//    periods from start()) the display frames are counted by the clock.
+//  - the frame store being scanned out (VDMA::current_read_frame(),
+//    XAxiVdma_CurrFrameStore) tells when a submitted frame is on screen
+// Rate conversion
+//  - source frame n is due at display frame n * display_rate / source_fps
+//    (rounded) after start(): frames of a slower source are repeated (the
+//    read channel stays parked), those of a faster one are dropped by
+//    next() before they are decoded
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 26, 2020)
+//  - Added declaration of slab::Presenter class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _PRESENTER_H_
+#define _PRESENTER_H_
+
+#include <stdint.h>
+#include <chrono>
+#include <slab/vdma.hpp>
+#include <slab/video/Overlay.hpp>
+
+namespace slab {
+	/* times in seconds from start() */
+	typedef struct PresentStamp {
+		uint64_t frame;     // source frame
+		uint64_t due;       // display frame it is due at
+		uint64_t vsync;     // display frame it was first scanned out at
+		double   submitted; // submit_read_frame()
+		double   shown;     // first seen on screen (current_read_frame())
+	} PresentStamp;
+
+	class Presenter {
+		private:
+			typedef std::chrono::steady_clock clock;
+
+			VDMA              &vdma_;
+			double            display_rate_, source_fps_, period_;
+			clock::time_point start_;
+			bool              started_, by_clock_, seen_status_;
+			uint64_t          vsync_;           // display frames since start()
+			double            last_vsync_;      // time of vsync_
+			uint64_t          base_, frame_;    // display frame of source frame 0, next source frame
+			uint64_t          presented_, dropped_, late_;
+			PresentStamp      pending_, last_;  // submitted, last shown
+			int               pending_store_;
+
+			double   now() const;
+			uint64_t due(uint64_t frame) const;
+			void     poll();
+			void     wait_until(uint64_t vsync);
+			void     submitted(uint8_t store);
+		protected:
+		public:
+			/* <source_fps> 0: one source frame per display frame */
+			Presenter(VDMA&, double source_fps = 0);
+			~Presenter();
+			void start();
+			/* source frames to drop (already past due) before the next one */
+			uint32_t next();
+			/* wait until the next source frame is due, then flip to it */
+			uint8_t present(Overlay&);
+			void present(const FrameView&);
+			/* blocks until the next display frame starts, returns its number */
+			uint64_t wait_vsync();
+			const PresentStamp& last() const { return last_;         }
+			uint64_t vsync() const           { return vsync_;        }
+			uint64_t presented() const       { return presented_;    }
+			uint64_t dropped() const         { return dropped_;      }
+			uint64_t late() const            { return late_;         }
+			/* display frames that showed the previous source frame again */
+			uint64_t repeated() const        { return (vsync_ > base_ + presented_) ? vsync_ - base_ - presented_ : 0; }
+			double display_rate() const      { return display_rate_; }
+			double source_fps() const        { return source_fps_;   }
+			bool by_clock() const            { return by_clock_;     }
+	};
+};
+
+#endif // _PRESENTER_H_
@@ -5,22 +5,93 @@
 // Version 1.00 (Nov. 22, 2020)
 //  - Added definition for functions of slab::VDMA class
 //-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 6, 2020)
+//  - Mapped every frame store (XPAR_AXI_VDMA_0_NUM_FSTORES) so that
+//    <frame_index> of set_framebuffer()/get_framebuffer() is in range
+//  - Added read_framebuffer(), park_read() and current_read_frame()
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 20, 2020)
+//  - Added the MM2S frame ring (acquire_read_frame(), submit_read_frame())
+//    over every frame store; the read channel is parked from
+//    Vdma_StartRead() on instead of circulating
+//  - set_framebuffer() without <frame_index> goes through the ring
+//-----------------------------------------------------------------------------
+// Version 1.03 (Dec. 21, 2020)
+//  - Added slab::FrameView over the mapped frame stores (read_view(),
+//    write_view()) and the access scopes begin_present()/end_present()
+//    and begin_capture()/end_capture(), so frames need no memcpy
+//-----------------------------------------------------------------------------
+// Version 1.04 (Dec. 23, 2020)
+//  - Sized and mapped the frame stores per direction (mm2s_pixel_t,
+//    s2mm_pixel_t from the TDATA widths); S2MM stores are XBGR8888
+//  - get_framebuffer() converts the capture into bgr_t
+//-----------------------------------------------------------------------------
+// Version 1.05 (Dec. 24, 2020)
+//  - Copies to and from the frame stores go through slab::CopyEngine,
+//    calibrated on the mapping when it is made
+//  - get_framebuffer() reads the S2MM store in blocks of rows into a
+//    cached buffer before converting them
+//-----------------------------------------------------------------------------
+// Version 1.06 (Dec. 25, 2020)
+//  - The frame stores live in slab::FrameMemory: /dev/mem as before, or a
+//    cached u-dma-buf (CMA) region given to VDMA(FrameMemory&, ...), whose
+//    physical addresses are handed to the VDMA
+//  - Cache maintenance of one frame store at each change of ownership:
+//    flushed by submit_read_frame() and set_framebuffer(img, index),
+//    invalidated by begin_capture() and get_framebuffer()
+//-----------------------------------------------------------------------------
+// Version 1.07 (Dec. 26, 2020)
+//  - Added read_frame_done() (frame count status of the read channel) and
+//    frame_rate() for pacing submissions to the display (slab::Presenter)
+//-----------------------------------------------------------------------------
+// Version 1.08 (Dec. 27, 2020)
+//  - Added set_read_region()/set_write_region(): stride, size and start of
+//    the frames in their frame stores per channel (canvas, S2MM ROI)
+//  - Views, copies and cache maintenance cover the region only
+//-----------------------------------------------------------------------------
+// Version 1.09 (Dec. 28, 2020)
+//  - Added update_framebuffer(): only the dirty rectangles (coalesced) are
+//    copied and flushed; each MM2S store keeps the rectangles it missed,
+//    so it is brought up to date when it is used again
+//-----------------------------------------------------------------------------
+// Version 1.10 (Dec. 29, 2020)
+//  - Added park_write(), circulate_write() and write_frame_done(), and made
+//    invalidate_write_frame() public for slab::Capture; parking of both
+//    channels is serialized (they share the park pointer register)
+//-----------------------------------------------------------------------------
+// Version 1.11 (Dec. 30, 2020)
+//  - coalesce_rects() merges touching rectangles only when their bounding
+//    box wastes at most VDMA_DIRTY_SLACK pixels
+//  - begin_present() and begin_capture() need VDMA_ZERO_COPY_FSTORES frame
+//    stores (no view of a store the VDMA may still switch to)
+//  - The copy engine is calibrated on the first copy, in a free MM2S store
+//    that is restored afterwards, instead of in MM2S store 0 by the
+//    constructor
+//-----------------------------------------------------------------------------
 // (C) 2020 Naofumi Yoshinaga. All rights reserved.
 //-----------------------------------------------------------------------------
 
 #include <slab/vdma.hpp>
+#include <type_traits>
+#include <stdexcept>
+#include <string.h>
+
+#define VDMA_BOUNCE_BYTES (64 * 1024) // rows read at a time by get_framebuffer()
+#define VDMA_DIRTY_MAX    16          // rectangles kept per frame store (more: bounding box)
+#define VDMA_DIRTY_SLACK  1024        // pixels two rectangles may waste when merged
 
 namespace slab {
 	VDMA::VDMA(uint32_t base_addr_r, uint32_t base_addr_w, Resolution res) :
-		base_addr_r_ (base_addr_r                                    ),
-		base_addr_w_ (base_addr_w                                    ),
-		res_         (res                                            ),
-		width_       (timing[static_cast<int>(res_)].h_active        ),
-		height_      (timing[static_cast<int>(res_)].v_active        ),
-		pixels_      (width_ * height_                               ),
-		frameBytes_  (pixels_ * sizeof(bgr_t)                        ),
+		VDMA(base_addr_r, base_addr_w, res, NULL, NULL) {
+	}
+
+	/* frame stores in <mem_r>/<mem_w> (from their start, kept by the caller) */
+	VDMA::VDMA(FrameMemory& mem_r, FrameMemory& mem_w, Resolution res) :
+		VDMA(mem_r.phys(), mem_w.phys(), res, &mem_r, &mem_w) {
+	}
+
+	VDMA::VDMA(uint32_t base_addr_r, uint32_t base_addr_w, Resolution res, FrameMemory *mem_r, FrameMemory *mem_w) :
 		irpt_ctl_    (XPAR_PS7_SCUGIC_0_DEVICE_ID                    ),
-		vid_         (XPAR_VTC_DEVICE_ID, XPAR_VIDEO_DYNCLK_DEVICE_ID),
 		vdma_driver_ (
 				XPAR_AXIVDMA_0_DEVICE_ID,
 				base_addr_w, // write
@@ -28,10 +99,33 @@ namespace slab {
 				irpt_ctl_,
 				XPAR_FABRIC_AXI_VDMA_0_MM2S_INTROUT_INTR,
 				XPAR_FABRIC_AXI_VDMA_0_S2MM_INTROUT_INTR
-				)
+				),
+		vid_         (XPAR_VTC_DEVICE_ID, XPAR_VIDEO_DYNCLK_DEVICE_ID),
+		res_         (res                                            ),
+		base_addr_r_ (base_addr_r                                    ),
+		base_addr_w_ (base_addr_w                                    ),
+		width_       (timing[static_cast<int>(res_)].h_active        ),
+		height_      (timing[static_cast<int>(res_)].v_active        ),
+		pixels_      (width_ * height_                               ),
+		num_frames_  (XPAR_AXI_VDMA_0_NUM_FSTORES                    ),
+		frameBytes_r_(pixels_ * sizeof(mm2s_pixel_t)                 ),
+		frameBytes_w_(pixels_ * sizeof(s2mm_pixel_t)                 ),
+		region_r_    {width_, height_, 0, 0, width_, height_         },
+		region_w_    {width_, height_, 0, 0, width_, height_         },
+		mem_r_       (mem_r                                          ),
+		mem_w_       (mem_w                                          ),
+		own_mem_     (mem_r == NULL                                  ),
+		front_       (0                                              ),
+		pending_     (-1                                             ),
+		capture_     (-1                                             ),
+		submitted_   (0                                              ),
+		dropped_     (0                                              ),
+		updated_bytes_(0                                             ),
+		calibrated_  (false                                          )
 	{
 		/* map frame-buffer region to memory */
 		map_framebuffer();
+		mark_stale(-1, std::vector<DirtyRect>());
 	}
 
 	VDMA::~VDMA() {
@@ -53,7 +147,8 @@ namespace slab {
 		{
 			std::cout << "[VDMA Read]  : stage 2" << std::endl;
 			vid_.configure(res_);
-			vdma_driver_.configureRead(width_, height_);
+			vdma_driver_.configureRead(width_, height_, region_r_.canvas_width * sizeof(mm2s_pixel_t),
+					(region_r_.y * region_r_.canvas_width + region_r_.x) * sizeof(mm2s_pixel_t), frameBytes_r_);
 		}
 
 		{
@@ -61,6 +156,11 @@ namespace slab {
 			vid_.enable();
 			vdma_driver_.enableRead();
 		}
+
+		/* stop circulating: store 0 until the first submit_read_frame() */
+		front_   = current_read_frame();
+		pending_ = 0;
+		park_read(0);
 	}
 
 	void VDMA::Vdma_StartWrite() {
@@ -71,7 +171,9 @@ namespace slab {
 
 		{
 			std::cout << "[VDMA Write] : stage 2" << std::endl;
-			vdma_driver_.configureWrite(width_, height_);
+			vdma_driver_.configureWrite(region_w_.width, region_w_.height, region_w_.canvas_width * sizeof(s2mm_pixel_t),
+					(region_w_.y * region_w_.canvas_width + region_w_.x) * sizeof(s2mm_pixel_t), frameBytes_w_,
+					region_w_.width < width_ || region_w_.height < height_);
 		}
 
 		{
@@ -80,25 +182,418 @@ namespace slab {
 		}
 	}
 
+	/*
+	 * frame stores of <region> (<bpp> bytes per pixel) in <mem>
+	 *  - a /dev/mem region made by the constructor is remapped when the
+	 *    canvas is larger; memory given by the caller has to be large enough
+	 */
+	bool VDMA::fit_region(const DmaRegion& region, uint32_t bpp, uint32_t base_addr, FrameMemory*& mem) {
+		if (region.width == 0 || region.height == 0 ||
+				region.x + region.width > region.canvas_width || region.y + region.height > region.canvas_height) {
+			return false;
+		}
+		const size_t bytes = (size_t)region.canvas_width * region.canvas_height * bpp * num_frames_;
+		if (mem->size() < bytes) {
+			if (!own_mem_) return false;
+			FrameMemory *remapped = new DevMemFrameMemory(base_addr, bytes);
+			delete mem;
+			mem = remapped;
+		}
+		return true;
+	}
+
+	/* MM2S: the window scanned out of each canvas (size of the video timing) */
+	bool VDMA::set_read_region(const DmaRegion& region) {
+		if (region.width != width_ || region.height != height_) return false;
+		if (!fit_region(region, sizeof(mm2s_pixel_t), base_addr_r_, mem_r_)) return false;
+		region_r_     = region;
+		frameBytes_r_ = region.canvas_width * region.canvas_height * sizeof(mm2s_pixel_t);
+		frame_buf_r_  = (mm2s_pixel_t*)mem_r_->data();
+		mark_stale(-1, std::vector<DirtyRect>());
+		return true;
+	}
+
+	/* S2MM: the top-left <width> x <height> of the video into each canvas */
+	bool VDMA::set_write_region(const DmaRegion& region) {
+		if (region.width > width_ || region.height > height_ || capture_ >= 0) return false;
+		if (!fit_region(region, sizeof(s2mm_pixel_t), base_addr_w_, mem_w_)) return false;
+		region_w_     = region;
+		frameBytes_w_ = region.canvas_width * region.canvas_height * sizeof(s2mm_pixel_t);
+		frame_buf_w_  = (s2mm_pixel_t*)mem_w_->data();
+		return true;
+	}
+
 	void VDMA::map_framebuffer() {
-		if((fd_ = open("/dev/mem", O_RDWR | O_SYNC)) == -1) FATAL;
-		frame_buf_r_ = (bgr_t*)mmap(0, frameBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, base_addr_r_ & ~MAP_MASK);
-		frame_buf_w_ = (bgr_t*)mmap(0, frameBytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, base_addr_w_ & ~MAP_MASK);
+		if (own_mem_) {
+			mem_r_ = new DevMemFrameMemory(base_addr_r_, (size_t)frameBytes_r_ * num_frames_);
+			mem_w_ = new DevMemFrameMemory(base_addr_w_, (size_t)frameBytes_w_ * num_frames_);
+		}
+		if (mem_r_->size() < (size_t)frameBytes_r_ * num_frames_ || mem_w_->size() < (size_t)frameBytes_w_ * num_frames_) {
+			unmap_framebuffer();
+			throw std::runtime_error("VDMA: frame memory is smaller than the frame stores");
+		}
+		frame_buf_r_ = (mm2s_pixel_t*)mem_r_->data();
+		frame_buf_w_ = (s2mm_pixel_t*)mem_w_->data();
 	}
 
 	void VDMA::unmap_framebuffer() {
 		/* close memory */
-		if(munmap(frame_buf_r_, frameBytes_) == -1) FATAL;
-		if(munmap(frame_buf_w_, frameBytes_) == -1) FATAL;
-		close(fd_);
+		if (own_mem_) {
+			delete mem_r_;
+			delete mem_w_;
+		}
+	}
+
+	/*
+	 * cache maintenance (no-op on /dev/mem)
+	 *  - the region of the store: from its first pixel to its last one
+	 */
+	void VDMA::flush_read_frame(const uint8_t frame_index) {
+		const FrameView view = read_view(frame_index);
+		mem_r_->sync_for_device((uint8_t*)view.data - (uint8_t*)frame_buf_r_,
+				(size_t)(view.height - 1) * view.step + view.width * sizeof(mm2s_pixel_t));
+	}
+
+	void VDMA::invalidate_write_frame(const uint8_t frame_index) {
+		const CaptureView view = write_view(frame_index);
+		mem_w_->sync_for_cpu((uint8_t*)view.data - (uint8_t*)frame_buf_w_,
+				(size_t)(view.height - 1) * view.step + view.width * sizeof(s2mm_pixel_t));
 	}
 
+	/*
+	 * fastest copy for this mapping, once (before the first copy)
+	 *  - written: a MM2S store that is neither scanned out nor pending, saved
+	 *    before and restored after, so nothing of it reaches HDMI / simple_lsd
+	 *  - read: S2MM store 0 (reading does not disturb the capture)
+	 */
+	void VDMA::calibrate_copy() {
+		if (calibrated_) return;
+		calibrated_ = true;
+
+		const uint8_t        scratch = acquire_read_frame();
+		uint8_t              *store  = (uint8_t*)frame_buf_r_ + (size_t)frameBytes_r_ * scratch;
+		const size_t         bytes   = std::min(frameBytes_r_, frameBytes_w_);
+		std::vector<uint8_t> saved(bytes);
+		memcpy(saved.data(), store, bytes);
+		copy_.calibrate(store, frame_buf_w_, bytes);
+		memcpy(store, saved.data(), bytes);
+		mem_r_->sync_for_device((size_t)frameBytes_r_ * scratch, bytes);
+	}
+
+	/* <img> (width x height, packed) into a MM2S store */
+	void VDMA::put_frame(const bgr_t* img, const FrameView& view) {
+		calibrate_copy();
+		if (std::is_same<mm2s_pixel_t, bgr_t>::value && view.step == width_ * sizeof(bgr_t)) {
+			copy_.to_device(view.data, img, (size_t)pixels_ * sizeof(bgr_t));
+		}
+		else {
+			BasicFrameView<const bgr_t> src = {img, width_, height_, width_ * (uint32_t)sizeof(bgr_t), -1};
+			convert(src, view);
+		}
+	}
+
+	/* copies of a frame store (read_view()/write_view() avoid the copy) */
 	void VDMA::set_framebuffer(const bgr_t* img, const uint8_t frame_index) {
-		memcpy(frame_buf_r_ + (pixels_ * frame_index), img, frameBytes_);
+		put_frame(img, read_view(frame_index));
+		flush_read_frame(frame_index);
+		mark_stale(-1, std::vector<DirtyRect>());
 	}
 
+	/* <img>: width x height of write_region(), packed */
 	void VDMA::get_framebuffer(bgr_t* img, const uint8_t frame_index) {
-		memcpy(img, frame_buf_w_ + (pixels_ * frame_index), frameBytes_);
+		const CaptureView src   = write_view(frame_index);
+		const uint32_t    rows  = std::max<uint32_t>(1, VDMA_BOUNCE_BYTES / src.step);
+		const uint32_t    pitch = src.step / sizeof(s2mm_pixel_t);
+		calibrate_copy();
+		invalidate_write_frame(frame_index);
+		bounce_.resize((size_t)rows * pitch);
+		for (uint32_t v=0; v<src.height; v+=rows) {
+			const uint32_t n = std::min(rows, src.height - v);
+			/* whole lines at once; the last one ends at the region */
+			copy_.from_device(bounce_.data(), src.row(v), (size_t)(n - 1) * src.step + src.width * sizeof(s2mm_pixel_t));
+			for (uint32_t i=0; i<n; i++) convert_row(bounce_.data() + i * pitch, img + (size_t)(v + i) * src.width, src.width);
+		}
+	}
+
+	/* first pixel of MM2S frame store <frame_index> (no cache maintenance, see FrameMemory) */
+	mm2s_pixel_t *VDMA::read_framebuffer(const uint8_t frame_index) {
+		return (mm2s_pixel_t*)((uint8_t*)frame_buf_r_ + (size_t)frameBytes_r_ * frame_index) +
+			region_r_.y * region_r_.canvas_width + region_r_.x;
+	}
+
+	/* scan out MM2S frame store <frame_index> from the next frame */
+	void VDMA::park_read(const uint8_t frame_index) {
+		std::lock_guard<std::mutex> lock(park_mtx_);
+		vdma_driver_.parkRead(frame_index);
+	}
+
+	uint8_t VDMA::current_read_frame() {
+		return vdma_driver_.currentReadFrame();
+	}
+
+	/*
+	 * MM2S frame ring
+	 *  - <front_> is scanned out, <pending_> is parked and is picked up at
+	 *    the next frame start, any other store is free
+	 *  - a store is only written while free, so flips never tear; a submit
+	 *    replaces the pending store instead of waiting for it, so it never
+	 *    blocks and a frame is on screen at most one frame after its submit
+	 *  - one producer (acquire, fill, submit from the same thread)
+	 */
+	void VDMA::retire_read_frame(const uint8_t current) {
+		if (pending_ >= 0 && current == pending_) {
+			front_   = pending_;
+			pending_ = -1;
+		}
+	}
+
+	/* frame store that is neither scanned out nor pending (fill it, then submit) */
+	uint8_t VDMA::acquire_read_frame() {
+		const uint8_t current = current_read_frame();
+		retire_read_frame(current);
+		for (uint32_t i=0; i<num_frames_; i++) {
+			if (i != current && (int)i != front_ && (int)i != pending_) return i;
+		}
+		/* less than 3 frame stores: the pending one may still be replaced */
+		for (uint32_t i=0; i<num_frames_; i++) {
+			if (i != current) return i;
+		}
+		return current;
+	}
+
+	/*
+	 * park the read channel on <frame_index> (shown from the next frame start)
+	 *  - the store was written some other way than update_framebuffer(), so
+	 *    no store is known to match its image any more
+	 */
+	void VDMA::submit_read_frame(const uint8_t frame_index) {
+		flush_read_frame(frame_index);
+		mark_stale(-1, std::vector<DirtyRect>());
+		flip_read_frame(frame_index);
+	}
+
+	void VDMA::flip_read_frame(const uint8_t frame_index) {
+		park_read(frame_index);
+		/* the pending store was either picked up already or is never shown */
+		const uint8_t current = current_read_frame();
+		if (pending_ >= 0 && pending_ != frame_index) {
+			if (current == pending_) front_ = pending_;
+			else                     dropped_++;
+		}
+		pending_ = frame_index;
+		retire_read_frame(current);
+		submitted_++;
+	}
+
+	/* a frame was scanned out since the last call (polled, no interrupt) */
+	bool VDMA::read_frame_done() {
+		return vdma_driver_.readFrameDone();
+	}
+
+	/* frames per second of the video timing */
+	double VDMA::frame_rate() const {
+		const timing_t& t = timing[static_cast<int>(res_)];
+		const double h = t.h_active + t.h_fp + t.h_sync + t.h_bp;
+		const double v = t.v_active + t.v_fp + t.v_sync + t.v_bp;
+		return t.pclk_freq_Hz / (h * v);
+	}
+
+	/*
+	 * per-store staleness for update_framebuffer()
+	 *  - <dirty> is added to every store but <except>
+	 *  - <except> -1 and no <dirty>: every store is stale as a whole
+	 */
+	void VDMA::mark_stale(const int except, const std::vector<DirtyRect>& dirty) {
+		stale_.resize(num_frames_);
+		for (uint32_t i=0; i<num_frames_; i++) {
+			if ((int)i == except) continue;
+			if (dirty.empty() && except < 0) {
+				stale_[i].assign(1, DirtyRect{0, 0, width_, height_});
+				continue;
+			}
+			stale_[i].insert(stale_[i].end(), dirty.begin(), dirty.end());
+			coalesce_rects(stale_[i], width_, height_);
+		}
+	}
+
+	/* <r> of <img> (width x height, packed) into <view>, then flushed */
+	void VDMA::put_rect(const bgr_t* img, const FrameView& view, const DirtyRect& r) {
+		const size_t bytes = (size_t)r.width * sizeof(mm2s_pixel_t);
+		if (std::is_same<mm2s_pixel_t, bgr_t>::value && r.x == 0 && r.width == width_ && view.step == bytes) {
+			/* whole lines: one block */
+			copy_.to_device(view.row(r.y), img + (size_t)r.y * width_, bytes * r.height);
+		}
+		else {
+			for (uint32_t v=r.y; v<r.y+r.height; v++) {
+				if (std::is_same<mm2s_pixel_t, bgr_t>::value) copy_.to_device(view.row(v) + r.x, img + (size_t)v * width_ + r.x, bytes);
+				else                                          convert_row(img + (size_t)v * width_ + r.x, view.row(v) + r.x, r.width);
+			}
+		}
+		mem_r_->sync_for_device((uint8_t*)(view.row(r.y) + r.x) - (uint8_t*)frame_buf_r_, (size_t)(r.height - 1) * view.step + bytes);
+		updated_bytes_ += bytes * r.height;
+	}
+
+	/*
+	 * bring a free frame store up to <img> (width x height, packed) and flip
+	 * to it
+	 *  - <dirty>: what changed in <img> since the previous call
+	 *  - copied: <dirty> and what the store missed while others were shown
+	 *    (all of it on the first use of each store)
+	 *  - returns the index of the frame store that was parked
+	 */
+	uint8_t VDMA::update_framebuffer(const bgr_t* img, const std::vector<DirtyRect>& dirty) {
+		std::vector<DirtyRect> rects(dirty);
+		coalesce_rects(rects, width_, height_);
+
+		calibrate_copy();
+		const uint8_t    next  = acquire_read_frame();
+		const FrameView  view  = read_view(next);
+		std::vector<DirtyRect>& stale = stale_[next];
+		stale.insert(stale.end(), rects.begin(), rects.end());
+		coalesce_rects(stale, width_, height_);
+		for (size_t i=0; i<stale.size(); i++) put_rect(img, view, stale[i]);
+		stale.clear();
+
+		mark_stale(next, rects);
+		flip_read_frame(next);
+		return next;
+	}
+
+	/* copy <img> into a free frame store and flip to it (any number of stores) */
+	void VDMA::set_framebuffer(const bgr_t* img) {
+		const uint8_t next = acquire_read_frame();
+		put_frame(img, read_view(next));
+		submit_read_frame(next);
+	}
+
+	/* MM2S frame store <frame_index> in place (submit_read_frame() flushes it) */
+	FrameView VDMA::read_view(const uint8_t frame_index) {
+		FrameView view = {read_framebuffer(frame_index), width_, height_, region_r_.canvas_width * (uint32_t)sizeof(mm2s_pixel_t), frame_index};
+		return view;
+	}
+
+	/* S2MM frame store <frame_index> in place (begin_capture() invalidates it first) */
+	CaptureView VDMA::write_view(const uint8_t frame_index) {
+		s2mm_pixel_t *data = (s2mm_pixel_t*)((uint8_t*)frame_buf_w_ + (size_t)frameBytes_w_ * frame_index) +
+			region_w_.y * region_w_.canvas_width + region_w_.x;
+		CaptureView view = {data, region_w_.width, region_w_.height, region_w_.canvas_width * (uint32_t)sizeof(s2mm_pixel_t), frame_index};
+		return view;
+	}
+
+	/* free MM2S frame store to render into; end_present() flips to it */
+	FrameView VDMA::begin_present() {
+		if (!zero_copy()) {
+			FrameView none = {NULL, 0, 0, 0, -1};
+			return none;
+		}
+		return read_view(acquire_read_frame());
+	}
+
+	void VDMA::end_present(const FrameView& view) {
+		if (view.valid()) submit_read_frame(view.index);
+	}
+
+	/*
+	 * latest complete S2MM frame, held until end_capture()
+	 *  - the write channel is parked on the store it is filling, so it keeps
+	 *    overwriting that one and leaves the others alone
+	 *  - with 2 stores, a frame start between current_write_frame() and the
+	 *    park would switch the VDMA to the held one: no view then
+	 */
+	CaptureView VDMA::begin_capture() {
+		const uint8_t current = current_write_frame();
+		if (capture_ >= 0 || !zero_copy()) {
+			CaptureView none = {NULL, 0, 0, 0, -1};
+			return none;
+		}
+		park_write(current);
+		capture_ = (current + num_frames_ - 1) % num_frames_;
+		invalidate_write_frame(capture_);
+		return write_view(capture_);
+	}
+
+	/* the write channel circulates again */
+	void VDMA::end_capture(const CaptureView& view) {
+		if (!view.valid() || view.index != capture_) return;
+		circulate_write();
+		capture_ = -1;
+	}
+
+	uint8_t VDMA::current_write_frame() {
+		return vdma_driver_.currentWriteFrame();
+	}
+
+	/* S2MM keeps writing frame store <frame_index> from the next frame */
+	void VDMA::park_write(const uint8_t frame_index) {
+		std::lock_guard<std::mutex> lock(park_mtx_);
+		vdma_driver_.parkWrite(frame_index);
+	}
+
+	void VDMA::circulate_write() {
+		std::lock_guard<std::mutex> lock(park_mtx_);
+		vdma_driver_.circulateWrite();
+	}
+
+	/* a frame was written since the last call (polled, no interrupt) */
+	bool VDMA::write_frame_done() {
+		return vdma_driver_.writeFrameDone();
+	}
+
+	/*
+	 * clip <rects> to <width> x <height> and merge them
+	 *  - a rectangle inside another one, and two whose bounding box wastes
+	 *    at most VDMA_DIRTY_SLACK pixels, are merged; touching is not
+	 *    enough (two bars along the edges of the frame stay apart)
+	 *  - more than VDMA_DIRTY_MAX rectangles: their bounding box
+	 *  - half of the frame or more: the whole frame
+	 */
+	void coalesce_rects(std::vector<DirtyRect>& rects, const uint32_t width, const uint32_t height) {
+		size_t n = 0;
+		for (size_t i=0; i<rects.size(); i++) {
+			DirtyRect r = rects[i];
+			if (r.x >= width || r.y >= height) continue;
+			r.width  = std::min(r.width,  width  - r.x);
+			r.height = std::min(r.height, height - r.y);
+			if (r.width && r.height) rects[n++] = r;
+		}
+		rects.resize(n);
+
+		for (bool merged=true; merged; ) {
+			merged = false;
+			for (size_t i=0; i<rects.size() && !merged; i++) {
+				for (size_t j=i+1; j<rects.size() && !merged; j++) {
+					const DirtyRect& a = rects[i];
+					const DirtyRect& b = rects[j];
+					const uint32_t x0 = std::min(a.x, b.x), x1 = std::max(a.x + a.width,  b.x + b.width);
+					const uint32_t y0 = std::min(a.y, b.y), y1 = std::max(a.y + a.height, b.y + b.height);
+					const uint64_t box    = (uint64_t)(x1 - x0) * (y1 - y0);
+					const uint64_t area_a = (uint64_t)a.width * a.height, area_b = (uint64_t)b.width * b.height;
+					if (box == area_a || box == area_b || box <= area_a + area_b + VDMA_DIRTY_SLACK) {
+						rects[i] = DirtyRect{x0, y0, x1 - x0, y1 - y0};
+						rects.erase(rects.begin() + j);
+						merged = true;
+					}
+				}
+			}
+		}
+
+		uint64_t area = 0;
+		for (size_t i=0; i<rects.size(); i++) area += (uint64_t)rects[i].width * rects[i].height;
+		if (area * 2 >= (uint64_t)width * height) {
+			rects.assign(1, DirtyRect{0, 0, width, height});
+		}
+		else if (rects.size() > VDMA_DIRTY_MAX) {
+			DirtyRect box = rects[0];
+			for (size_t i=1; i<rects.size(); i++) {
+				const uint32_t x1 = std::max(box.x + box.width,  rects[i].x + rects[i].width);
+				const uint32_t y1 = std::max(box.y + box.height, rects[i].y + rects[i].height);
+				box.x      = std::min(box.x, rects[i].x);
+				box.y      = std::min(box.y, rects[i].y);
+				box.width  = x1 - box.x;
+				box.height = y1 - box.y;
+			}
+			rects.assign(1, box);
+		}
 	}
 
 	/* generate rgb pixel */
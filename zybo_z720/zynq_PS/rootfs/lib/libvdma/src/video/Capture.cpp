@@ -0,0 +1,172 @@
+//-----------------------------------------------------------------------------
+// <Capture.cpp>
+//  - Defined functions of slab::Capture class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 29, 2020)
+//  - Added definition for functions of slab::Capture class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 30, 2020)
+//  - start() needs VDMA::zero_copy() (filling, next and a held store)
+//  - Releases carry the id of the frame; reclaim() ignores any other
+//  - No free store: a queued frame is taken back only while a newer one
+//    stays queued
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/video/Capture.hpp>
+#include <algorithm>
+
+#define CAPTURE_POLL_US 500 // polling interval of the capture thread and pop()
+
+namespace slab {
+	Capture::Capture(VDMA& vdma, CaptureMode mode, uint32_t depth) :
+		vdma_     (vdma                                                    ),
+		mode_     (mode                                                    ),
+		ready_    ((mode == CAPTURE_NO_DROP) ? vdma.num_frames() : depth   ),
+		released_ (vdma.num_frames()                                       ),
+		state_    (vdma.num_frames(), STORE_FREE                           ),
+		out_id_   (vdma.num_frames(), 0                                    ),
+		next_id_  (1                                                       ),
+		filling_  (-1                                                      ),
+		running_  (false                                                   ),
+		captured_ (0                                                       ),
+		dropped_  (0                                                       ),
+		overruns_ (0                                                       )
+	{
+	}
+
+	Capture::~Capture() {
+		stop();
+	}
+
+	int Capture::free_store() const {
+		for (size_t i=0; i<state_.size(); i++) {
+			if (state_[i] == STORE_FREE) return i;
+		}
+		return -1;
+	}
+
+	/* stores given back by release() (only by the frame that is out in them) */
+	void Capture::reclaim() {
+		Released r;
+		while (released_.try_pop(r)) {
+			if (r.index >= 0 && r.index < (int)state_.size() && state_[r.index] == STORE_OUT &&
+					out_id_[r.index] == r.id) state_[r.index] = STORE_FREE;
+		}
+	}
+
+	/* hand the complete store <index> to the consumer */
+	void Capture::publish(int index) {
+		vdma_.invalidate_write_frame(index);
+		const CaptureView  v = vdma_.write_view(index);
+		const CaptureFrame f = {
+			{v.data, v.width, v.height, v.step, v.index},
+			captured_++,
+			std::chrono::duration<double>(clock::now() - start_).count(),
+			next_id_++
+		};
+		state_[index]  = STORE_OUT;
+		out_id_[index] = f.id;
+
+		while (!ready_.try_push(f)) {
+			/* CAPTURE_LATEST: the oldest queued frame makes room (a held one is never taken back) */
+			CaptureFrame old;
+			if (mode_ == CAPTURE_LATEST && ready_.try_pop(old)) {
+				state_[old.view.index] = STORE_FREE;
+				dropped_++;
+			}
+		}
+	}
+
+	void Capture::run() {
+		int next = -1; // store the write channel is parked on for the next frame
+		while (running_) {
+			reclaim();
+
+			/* filling store done: it is complete once the next one has started */
+			const int  current = vdma_.current_write_frame();
+			const bool done    = vdma_.write_frame_done();
+			if (current != filling_) {
+				const int complete = filling_;
+				filling_         = current;
+				state_[filling_] = STORE_FILLING;
+				next             = -1;
+				publish(complete);
+			}
+			else if (done && next < 0) {
+				/* nowhere to go: the filling store is being written again */
+				overruns_++;
+			}
+
+			/* park ahead on a free store as soon as there is one */
+			if (next < 0) {
+				CaptureFrame old;
+				next = free_store();
+				if (next < 0 && mode_ == CAPTURE_LATEST && ready_.size() > 1 && ready_.try_pop(old)) {
+					/* the oldest queued frame gives way while a newer one stays queued */
+					next = old.view.index;
+					dropped_++;
+				}
+				if (next >= 0) {
+					state_[next] = STORE_NEXT;
+					vdma_.park_write(next);
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(CAPTURE_POLL_US));
+		}
+	}
+
+	/*
+	 * park on the store being filled, then ahead on a free one; the store
+	 * filled at start() is the first one published
+	 */
+	void Capture::start() {
+		if (running_ || !vdma_.zero_copy()) return;
+		std::fill(state_.begin(), state_.end(), STORE_FREE);
+		CaptureFrame f;
+		Released     r;
+		while (ready_.try_pop(f))    ;
+		while (released_.try_pop(r)) ;
+		captured_ = dropped_ = overruns_ = 0;
+		start_    = clock::now();
+
+		filling_         = vdma_.current_write_frame();
+		state_[filling_] = STORE_FILLING;
+		vdma_.park_write(filling_);
+		vdma_.write_frame_done(); // stale status
+
+		running_ = true;
+		thread_  = std::thread(&Capture::run, this);
+	}
+
+	/* the write channel circulates again; frames still held are not valid any more */
+	void Capture::stop() {
+		if (!running_) return;
+		running_ = false;
+		if (thread_.joinable()) thread_.join();
+		vdma_.circulate_write();
+	}
+
+	bool Capture::try_pop(CaptureFrame& frame) {
+		return ready_.try_pop(frame);
+	}
+
+	bool Capture::pop(CaptureFrame& frame, int timeout_ms) {
+		const clock::time_point end = clock::now() + std::chrono::milliseconds(timeout_ms);
+		while (!ready_.try_pop(frame)) {
+			if (!running_ || (timeout_ms >= 0 && clock::now() >= end)) return false;
+			std::this_thread::sleep_for(std::chrono::microseconds(CAPTURE_POLL_US));
+		}
+		return true;
+	}
+
+	/* waits while the capture thread has not taken earlier releases yet */
+	void Capture::release(const CaptureFrame& frame) {
+		if (!frame.view.valid()) return;
+		const Released r = {frame.view.index, frame.id};
+		while (!released_.try_push(r) && running_) {
+			std::this_thread::sleep_for(std::chrono::microseconds(CAPTURE_POLL_US));
+		}
+	}
+};
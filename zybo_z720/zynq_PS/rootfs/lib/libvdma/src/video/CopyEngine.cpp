@@ -0,0 +1,187 @@
+//-----------------------------------------------------------------------------
+// <CopyEngine.cpp>
+//  - Defined functions of slab::CopyEngine class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 24, 2020)
+//  - Added definition for functions of slab::CopyEngine class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/video/CopyEngine.hpp>
+#include <string.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define COPY_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define COPY_X86
+#endif
+
+#define COPY_PREFETCH 256 // bytes ahead of the loads
+
+namespace slab {
+	//-------------------------------------------------------------------------
+	// kernels
+	//-------------------------------------------------------------------------
+	static void copy_wide(void *dst, const void *src, size_t n) {
+		uint8_t       *d = (uint8_t*)dst;
+		const uint8_t *s = (const uint8_t*)src;
+#if defined(COPY_NEON)
+		for (; n>=64; n-=64, s+=64, d+=64) {
+			__builtin_prefetch(s + COPY_PREFETCH);
+			uint8x16_t a = vld1q_u8(s), b = vld1q_u8(s + 16), c = vld1q_u8(s + 32), e = vld1q_u8(s + 48);
+			vst1q_u8(d, a);
+			vst1q_u8(d + 16, b);
+			vst1q_u8(d + 32, c);
+			vst1q_u8(d + 48, e);
+		}
+#elif defined(COPY_X86)
+		for (; n>=64; n-=64, s+=64, d+=64) {
+			__builtin_prefetch(s + COPY_PREFETCH);
+			__m128i a = _mm_loadu_si128((const __m128i*)s);
+			__m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+			__m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+			__m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+			_mm_storeu_si128((__m128i*)d, a);
+			_mm_storeu_si128((__m128i*)(d + 16), b);
+			_mm_storeu_si128((__m128i*)(d + 32), c);
+			_mm_storeu_si128((__m128i*)(d + 48), e);
+		}
+#endif
+		memcpy(d, s, n);
+	}
+
+	static void copy_stream(void *dst, const void *src, size_t n) {
+#if defined(COPY_X86)
+		uint8_t       *d = (uint8_t*)dst;
+		const uint8_t *s = (const uint8_t*)src;
+		/* head up to the 16-byte alignment of <dst> */
+		size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+		if (head > n) head = n;
+		memcpy(d, s, head);
+		d += head; s += head; n -= head;
+		for (; n>=64; n-=64, s+=64, d+=64) {
+			__builtin_prefetch(s + COPY_PREFETCH);
+			__m128i a = _mm_loadu_si128((const __m128i*)s);
+			__m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+			__m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+			__m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+			_mm_stream_si128((__m128i*)d, a);
+			_mm_stream_si128((__m128i*)(d + 16), b);
+			_mm_stream_si128((__m128i*)(d + 32), c);
+			_mm_stream_si128((__m128i*)(d + 48), e);
+		}
+		_mm_sfence();
+		memcpy(d, s, n);
+#else
+		copy_wide(dst, src, n);
+#endif
+	}
+
+	//-------------------------------------------------------------------------
+	// CopyEngine
+	//-------------------------------------------------------------------------
+	CopyEngine::CopyEngine(unsigned threads) {
+		kernel_[COPY_TO_DEVICE]   = COPY_MEMCPY;
+		kernel_[COPY_FROM_DEVICE] = COPY_MEMCPY;
+		memset(mbps_, 0, sizeof(mbps_));
+		set_threads(threads);
+	}
+
+	CopyEngine::~CopyEngine() {
+	}
+
+	bool CopyEngine::supported(CopyKernel kernel) {
+		switch (kernel) {
+			case COPY_MEMCPY: return true;
+			case COPY_WIDE:   return true;
+#if defined(COPY_X86)
+			case COPY_STREAM: return true;
+#endif
+			case COPY_SPLIT:  return std::thread::hardware_concurrency() > 1;
+			default:          return false;
+		}
+	}
+
+	const char *CopyEngine::kernel_name(CopyKernel kernel) {
+		static const char *names[] = {"memcpy", "wide", "stream", "split"};
+		return (kernel < COPY_KERNELS) ? names[kernel] : "?";
+	}
+
+	void CopyEngine::set_threads(unsigned threads) {
+		threads_ = (threads > 0) ? threads : std::thread::hardware_concurrency();
+		if (threads_ == 0) threads_ = 1;
+	}
+
+	bool CopyEngine::set_kernel(CopyDirection dir, CopyKernel kernel) {
+		if (!supported(kernel)) return false;
+		kernel_[dir] = kernel;
+		return true;
+	}
+
+	void CopyEngine::run(CopyKernel kernel, void *dst, const void *src, size_t n) const {
+		switch (kernel) {
+			case COPY_WIDE:   copy_wide  (dst, src, n); break;
+			case COPY_STREAM: copy_stream(dst, src, n); break;
+			case COPY_SPLIT: {
+				/* parts on 64-byte boundaries, the last one on this thread */
+				const unsigned parts = (n >= 65536) ? threads_ : 1;
+				const size_t   part  = (n / parts) & ~(size_t)63;
+				std::vector<std::thread> th;
+				for (unsigned i=0; i+1<parts; i++) {
+					th.emplace_back(copy_wide, (uint8_t*)dst + i * part, (const uint8_t*)src + i * part, part);
+				}
+				copy_wide((uint8_t*)dst + (parts - 1) * part, (const uint8_t*)src + (parts - 1) * part,
+						n - (parts - 1) * part);
+				for (size_t i=0; i<th.size(); i++) th[i].join();
+				break;
+			}
+			default:          memcpy(dst, src, n); break;
+		}
+	}
+
+	void CopyEngine::calibrate(void *device_dst, const void *device_src, size_t bytes, int rounds) {
+		std::vector<uint8_t> host(bytes);
+		for (size_t i=0; i<bytes; i++) host[i] = (uint8_t)i;
+
+		for (int dir=COPY_TO_DEVICE; dir<=COPY_FROM_DEVICE; dir++) {
+			kernel_[dir] = COPY_MEMCPY;
+			for (int k=0; k<COPY_KERNELS; k++) {
+				mbps_[dir][k] = 0;
+				if (!supported((CopyKernel)k) || bytes == 0) continue;
+				double best = 1e30;
+				for (int r=0; r<rounds; r++) {
+					std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+					if (dir == COPY_TO_DEVICE) run((CopyKernel)k, device_dst, host.data(), bytes);
+					else                       run((CopyKernel)k, host.data(), device_src, bytes);
+					double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+					if (s < best) best = s;
+				}
+				mbps_[dir][k] = bytes / best / 1e6;
+				if (mbps_[dir][k] > mbps_[dir][kernel_[dir]]) kernel_[dir] = (CopyKernel)k;
+			}
+		}
+	}
+
+	void CopyEngine::print(FILE *fp) const {
+		static const char *dirs[] = {"to device  ", "from device"};
+		fprintf(fp, "             ");
+		for (int k=0; k<COPY_KERNELS; k++) fprintf(fp, " %9s", kernel_name((CopyKernel)k));
+		fprintf(fp, "   [MB/s]\n");
+		for (int dir=COPY_TO_DEVICE; dir<=COPY_FROM_DEVICE; dir++) {
+			fprintf(fp, "  %s", dirs[dir]);
+			for (int k=0; k<COPY_KERNELS; k++) {
+				if (mbps_[dir][k] > 0) fprintf(fp, " %9.1f", mbps_[dir][k]);
+				else                   fprintf(fp, " %9s", "-");
+			}
+			fprintf(fp, "   -> %s\n", kernel_name(kernel_[dir]));
+		}
+	}
+};
@@ -0,0 +1,188 @@
+//-----------------------------------------------------------------------------
+// <FrameMemory.cpp>
+//  - Defined functions of slab::FrameMemory classes
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 25, 2020)
+//  - Added definition for functions of slab::FrameMemory classes
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/video/FrameMemory.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <stdexcept>
+
+#define SYNC_DIRECTION_TO_DEVICE   1 // u-dma-buf: DMA_TO_DEVICE   (clean)
+#define SYNC_DIRECTION_FROM_DEVICE 2 // u-dma-buf: DMA_FROM_DEVICE (invalidate)
+
+namespace slab {
+	//-------------------------------------------------------------------------
+	// FrameMemory
+	//-------------------------------------------------------------------------
+	FrameMemory::FrameMemory() :
+		flushes_(0), invalidates_(0), flushed_bytes_(0), invalidated_bytes_(0),
+		data_(NULL), phys_(0), size_(0), cached_(false) {
+	}
+
+	FrameMemory::~FrameMemory() {
+	}
+
+	bool FrameMemory::clip(size_t& offset, size_t& size) const {
+		if (offset >= size_ || size == 0) return false;
+		if (size > size_ - offset) size = size_ - offset;
+		return true;
+	}
+
+	void FrameMemory::sync_for_device(size_t offset, size_t size) {
+		if (!cached_ || !clip(offset, size)) return;
+		sync(offset, size, true);
+		flushes_++;
+		flushed_bytes_ += size;
+	}
+
+	void FrameMemory::sync_for_cpu(size_t offset, size_t size) {
+		if (!cached_ || !clip(offset, size)) return;
+		sync(offset, size, false);
+		invalidates_++;
+		invalidated_bytes_ += size;
+	}
+
+	//-------------------------------------------------------------------------
+	// DevMemFrameMemory
+	//-------------------------------------------------------------------------
+	DevMemFrameMemory::DevMemFrameMemory(uint32_t phys, size_t size) : fd_(-1) {
+		const long page = sysconf(_SC_PAGESIZE);
+		if (phys & (page - 1)) {
+			throw std::runtime_error("DevMemFrameMemory: physical address is not page aligned");
+		}
+		if ((fd_ = open("/dev/mem", O_RDWR | O_SYNC)) == -1) {
+			throw std::runtime_error("DevMemFrameMemory: cannot open /dev/mem");
+		}
+		void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, phys);
+		if (p == MAP_FAILED) {
+			close(fd_);
+			throw std::runtime_error("DevMemFrameMemory: mmap failed");
+		}
+		data_   = (uint8_t*)p;
+		phys_   = phys;
+		size_   = size;
+		cached_ = false;
+	}
+
+	DevMemFrameMemory::~DevMemFrameMemory() {
+		munmap(data_, size_);
+		close(fd_);
+	}
+
+	//-------------------------------------------------------------------------
+	// UDmaBufFrameMemory
+	//-------------------------------------------------------------------------
+	UDmaBufFrameMemory::UDmaBufFrameMemory(const std::string& name) : fd_(-1) {
+		/* class name of u-dma-buf v3 ("u-dma-buf") and earlier ("udmabuf") */
+		static const char *classes[] = {"/sys/class/u-dma-buf/", "/sys/class/udmabuf/"};
+		unsigned long phys = 0, size = 0;
+		for (int i=0; i<2 && size==0; i++) {
+			sysfs_ = std::string(classes[i]) + name + "/";
+			if (!read_attr("phys_addr", phys) || !read_attr("size", size)) size = 0;
+		}
+		if (size == 0) {
+			throw std::runtime_error("UDmaBufFrameMemory: no sysfs entry of " + name);
+		}
+
+		/* without O_SYNC: cached mapping, coherency by sync_for_*() */
+		if ((fd_ = open(("/dev/" + name).c_str(), O_RDWR)) == -1) {
+			throw std::runtime_error("UDmaBufFrameMemory: cannot open /dev/" + name);
+		}
+		void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+		if (p == MAP_FAILED) {
+			close(fd_);
+			throw std::runtime_error("UDmaBufFrameMemory: mmap failed");
+		}
+		data_   = (uint8_t*)p;
+		phys_   = (uint32_t)phys;
+		size_   = size;
+		cached_ = true;
+
+		/* manual sync mode: the driver does nothing on its own */
+		write_attr("sync_mode", 0);
+	}
+
+	UDmaBufFrameMemory::~UDmaBufFrameMemory() {
+		munmap(data_, size_);
+		close(fd_);
+	}
+
+	bool UDmaBufFrameMemory::read_attr(const char *attr, unsigned long& value) {
+		char buf[64];
+		int fd = open((sysfs_ + attr).c_str(), O_RDONLY);
+		if (fd == -1) return false;
+		ssize_t n = read(fd, buf, sizeof(buf) - 1);
+		close(fd);
+		if (n <= 0) return false;
+		buf[n] = '\0';
+		value = strtoul(buf, NULL, 0);
+		return true;
+	}
+
+	bool UDmaBufFrameMemory::write_attr(const char *attr, unsigned long value) {
+		char buf[32];
+		int  len = snprintf(buf, sizeof(buf), "%lu", value);
+		int  fd  = open((sysfs_ + attr).c_str(), O_WRONLY);
+		if (fd == -1) return false;
+		bool ok = (write(fd, buf, len) == len);
+		close(fd);
+		return ok;
+	}
+
+	void UDmaBufFrameMemory::sync(size_t offset, size_t size, bool for_device) {
+		write_attr("sync_offset", offset);
+		write_attr("sync_size", size);
+		write_attr("sync_direction", for_device ? SYNC_DIRECTION_TO_DEVICE : SYNC_DIRECTION_FROM_DEVICE);
+		if (!write_attr(for_device ? "sync_for_device" : "sync_for_cpu", 1)) {
+			fprintf(stderr, "UDmaBufFrameMemory: %s failed\n", for_device ? "sync_for_device" : "sync_for_cpu");
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	// MemfdFrameMemory
+	//-------------------------------------------------------------------------
+	MemfdFrameMemory::MemfdFrameMemory(size_t size, uint32_t phys) : fd_(-1) {
+		if ((fd_ = syscall(SYS_memfd_create, "slab-frame-memory", 0)) == -1) {
+			throw std::runtime_error("MemfdFrameMemory: memfd_create failed");
+		}
+		if (ftruncate(fd_, size) == -1) {
+			close(fd_);
+			throw std::runtime_error("MemfdFrameMemory: ftruncate failed");
+		}
+		void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+		if (p == MAP_FAILED) {
+			close(fd_);
+			throw std::runtime_error("MemfdFrameMemory: mmap failed");
+		}
+		data_   = (uint8_t*)p;
+		phys_   = phys;
+		size_   = size;
+		cached_ = true;
+	}
+
+	MemfdFrameMemory::~MemfdFrameMemory() {
+		munmap(data_, size_);
+		close(fd_);
+	}
+
+	//-------------------------------------------------------------------------
+	// open_frame_memory
+	//-------------------------------------------------------------------------
+	FrameMemory *open_frame_memory(const std::string& name, uint32_t phys, size_t size) {
+		if (name.empty() || name == "devmem") return new DevMemFrameMemory(phys, size);
+		if (name == "memfd")                  return new MemfdFrameMemory(size, phys);
+		return new UDmaBufFrameMemory(name);
+	}
+};
@@ -0,0 +1,276 @@
+//-----------------------------------------------------------------------------
+// <Overlay.cpp>
+//  - Defined functions of slab::Overlay class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 6, 2020)
+//  - Added definition for functions of slab::Overlay class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 20, 2020)
+//  - present() takes its frame store from the frame ring of slab::VDMA
+//-----------------------------------------------------------------------------
+// Version 1.02 (Dec. 22, 2020)
+//  - Drawing goes to <target_>: the back buffer, or the frame store given
+//    by begin(), which present() flips without a copy
+//  - The back buffer is copied with the copy engine of slab::VDMA
+//-----------------------------------------------------------------------------
+// Version 1.03 (Dec. 27, 2020)
+//  - The back buffer is copied line by line into a frame store whose lines
+//    are not packed (VDMA::set_read_region())
+//-----------------------------------------------------------------------------
+// Version 1.04 (Dec. 28, 2020)
+//  - Drawing into the back buffer records dirty rectangles, which present()
+//    hands to VDMA::update_framebuffer() instead of copying the whole frame
+//-----------------------------------------------------------------------------
+// Version 1.05 (Dec. 30, 2020)
+//  - begin() falls back to the back buffer without a free frame store
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/video/Overlay.hpp>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace slab {
+	/* 5x7 font (ASCII 0x20 - 0x7E), one byte per column, LSB is the top row */
+	static const uint8_t font5x7[95][OVERLAY_FONT_W] = {
+		{0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+		{0x00, 0x00, 0x5F, 0x00, 0x00}, // '!'
+		{0x00, 0x07, 0x00, 0x07, 0x00}, // '"'
+		{0x14, 0x7F, 0x14, 0x7F, 0x14}, // '#'
+		{0x24, 0x2A, 0x7F, 0x2A, 0x12}, // '$'
+		{0x23, 0x13, 0x08, 0x64, 0x62}, // '%'
+		{0x36, 0x49, 0x55, 0x22, 0x50}, // '&'
+		{0x00, 0x05, 0x03, 0x00, 0x00}, // '\''
+		{0x00, 0x1C, 0x22, 0x41, 0x00}, // '('
+		{0x00, 0x41, 0x22, 0x1C, 0x00}, // ')'
+		{0x08, 0x2A, 0x1C, 0x2A, 0x08}, // '*'
+		{0x08, 0x08, 0x3E, 0x08, 0x08}, // '+'
+		{0x00, 0x50, 0x30, 0x00, 0x00}, // ','
+		{0x08, 0x08, 0x08, 0x08, 0x08}, // '-'
+		{0x00, 0x60, 0x60, 0x00, 0x00}, // '.'
+		{0x20, 0x10, 0x08, 0x04, 0x02}, // '/'
+		{0x3E, 0x51, 0x49, 0x45, 0x3E}, // '0'
+		{0x00, 0x42, 0x7F, 0x40, 0x00}, // '1'
+		{0x42, 0x61, 0x51, 0x49, 0x46}, // '2'
+		{0x21, 0x41, 0x45, 0x4B, 0x31}, // '3'
+		{0x18, 0x14, 0x12, 0x7F, 0x10}, // '4'
+		{0x27, 0x45, 0x45, 0x45, 0x39}, // '5'
+		{0x3C, 0x4A, 0x49, 0x49, 0x30}, // '6'
+		{0x01, 0x71, 0x09, 0x05, 0x03}, // '7'
+		{0x36, 0x49, 0x49, 0x49, 0x36}, // '8'
+		{0x06, 0x49, 0x49, 0x29, 0x1E}, // '9'
+		{0x00, 0x36, 0x36, 0x00, 0x00}, // ':'
+		{0x00, 0x56, 0x36, 0x00, 0x00}, // ';'
+		{0x08, 0x14, 0x22, 0x41, 0x00}, // '<'
+		{0x14, 0x14, 0x14, 0x14, 0x14}, // '='
+		{0x00, 0x41, 0x22, 0x14, 0x08}, // '>'
+		{0x02, 0x01, 0x51, 0x09, 0x06}, // '?'
+		{0x32, 0x49, 0x79, 0x41, 0x3E}, // '@'
+		{0x7E, 0x11, 0x11, 0x11, 0x7E}, // 'A'
+		{0x7F, 0x49, 0x49, 0x49, 0x36}, // 'B'
+		{0x3E, 0x41, 0x41, 0x41, 0x22}, // 'C'
+		{0x7F, 0x41, 0x41, 0x22, 0x1C}, // 'D'
+		{0x7F, 0x49, 0x49, 0x49, 0x41}, // 'E'
+		{0x7F, 0x09, 0x09, 0x01, 0x01}, // 'F'
+		{0x3E, 0x41, 0x41, 0x51, 0x32}, // 'G'
+		{0x7F, 0x08, 0x08, 0x08, 0x7F}, // 'H'
+		{0x00, 0x41, 0x7F, 0x41, 0x00}, // 'I'
+		{0x20, 0x40, 0x41, 0x3F, 0x01}, // 'J'
+		{0x7F, 0x08, 0x14, 0x22, 0x41}, // 'K'
+		{0x7F, 0x40, 0x40, 0x40, 0x40}, // 'L'
+		{0x7F, 0x02, 0x04, 0x02, 0x7F}, // 'M'
+		{0x7F, 0x04, 0x08, 0x10, 0x7F}, // 'N'
+		{0x3E, 0x41, 0x41, 0x41, 0x3E}, // 'O'
+		{0x7F, 0x09, 0x09, 0x09, 0x06}, // 'P'
+		{0x3E, 0x41, 0x51, 0x21, 0x5E}, // 'Q'
+		{0x7F, 0x09, 0x19, 0x29, 0x46}, // 'R'
+		{0x46, 0x49, 0x49, 0x49, 0x31}, // 'S'
+		{0x01, 0x01, 0x7F, 0x01, 0x01}, // 'T'
+		{0x3F, 0x40, 0x40, 0x40, 0x3F}, // 'U'
+		{0x1F, 0x20, 0x40, 0x20, 0x1F}, // 'V'
+		{0x7F, 0x20, 0x18, 0x20, 0x7F}, // 'W'
+		{0x63, 0x14, 0x08, 0x14, 0x63}, // 'X'
+		{0x03, 0x04, 0x78, 0x04, 0x03}, // 'Y'
+		{0x61, 0x51, 0x49, 0x45, 0x43}, // 'Z'
+		{0x00, 0x7F, 0x41, 0x41, 0x00}, // '['
+		{0x02, 0x04, 0x08, 0x10, 0x20}, // backslash
+		{0x00, 0x41, 0x41, 0x7F, 0x00}, // ']'
+		{0x04, 0x02, 0x01, 0x02, 0x04}, // '^'
+		{0x40, 0x40, 0x40, 0x40, 0x40}, // '_'
+		{0x00, 0x01, 0x02, 0x04, 0x00}, // '`'
+		{0x20, 0x54, 0x54, 0x54, 0x78}, // 'a'
+		{0x7F, 0x48, 0x44, 0x44, 0x38}, // 'b'
+		{0x38, 0x44, 0x44, 0x44, 0x20}, // 'c'
+		{0x38, 0x44, 0x44, 0x48, 0x7F}, // 'd'
+		{0x38, 0x54, 0x54, 0x54, 0x18}, // 'e'
+		{0x08, 0x7E, 0x09, 0x01, 0x02}, // 'f'
+		{0x08, 0x14, 0x54, 0x54, 0x3C}, // 'g'
+		{0x7F, 0x08, 0x04, 0x04, 0x78}, // 'h'
+		{0x00, 0x44, 0x7D, 0x40, 0x00}, // 'i'
+		{0x20, 0x40, 0x44, 0x3D, 0x00}, // 'j'
+		{0x00, 0x7F, 0x10, 0x28, 0x44}, // 'k'
+		{0x00, 0x41, 0x7F, 0x40, 0x00}, // 'l'
+		{0x7C, 0x04, 0x18, 0x04, 0x78}, // 'm'
+		{0x7C, 0x08, 0x04, 0x04, 0x78}, // 'n'
+		{0x38, 0x44, 0x44, 0x44, 0x38}, // 'o'
+		{0x7C, 0x14, 0x14, 0x14, 0x08}, // 'p'
+		{0x08, 0x14, 0x14, 0x18, 0x7C}, // 'q'
+		{0x7C, 0x08, 0x04, 0x04, 0x08}, // 'r'
+		{0x48, 0x54, 0x54, 0x54, 0x20}, // 's'
+		{0x04, 0x3F, 0x44, 0x40, 0x20}, // 't'
+		{0x3C, 0x40, 0x40, 0x20, 0x7C}, // 'u'
+		{0x1C, 0x20, 0x40, 0x20, 0x1C}, // 'v'
+		{0x3C, 0x40, 0x30, 0x40, 0x3C}, // 'w'
+		{0x44, 0x28, 0x10, 0x28, 0x44}, // 'x'
+		{0x0C, 0x50, 0x50, 0x50, 0x3C}, // 'y'
+		{0x44, 0x64, 0x54, 0x4C, 0x44}, // 'z'
+		{0x00, 0x08, 0x36, 0x41, 0x00}, // '{'
+		{0x00, 0x00, 0x7F, 0x00, 0x00}, // '|'
+		{0x00, 0x41, 0x36, 0x08, 0x00}, // '}'
+		{0x02, 0x01, 0x02, 0x04, 0x02}, // '~'
+	};
+
+	Overlay::Overlay(VDMA& vdma) :
+		vdma_      (vdma                           ),
+		width_     (vdma.width()                   ),
+		height_    (vdma.height()                  ),
+		back_      (vdma.width() * vdma.height()   ),
+		presented_ (0                              )
+	{
+		target_.data   = back_.data();
+		target_.width  = width_;
+		target_.height = height_;
+		target_.step   = width_ * sizeof(bgr_t);
+		target_.index  = -1;
+	}
+
+	Overlay::~Overlay() {
+	}
+
+	/* (x, y, w, h) of the back buffer changed (frame stores are flipped as a whole) */
+	void Overlay::touch(int x, int y, int w, int h) {
+		if (target_.index >= 0) return;
+		int x0 = std::max(x, 0), x1 = std::min(x + w, (int)width_);
+		int y0 = std::max(y, 0), y1 = std::min(y + h, (int)height_);
+		if (x0 >= x1 || y0 >= y1) return;
+		DirtyRect r = {(uint32_t)x0, (uint32_t)y0, (uint32_t)(x1 - x0), (uint32_t)(y1 - y0)};
+		dirty_.push_back(r);
+		if (dirty_.size() > 64) coalesce_rects(dirty_, width_, height_);
+	}
+
+	inline void Overlay::put(int x, int y, const bgr_t& color) {
+		if (x < 0 || y < 0 || x >= (int)width_ || y >= (int)height_) return;
+		target_.row(y)[x] = color;
+	}
+
+	void Overlay::clear(const bgr_t& color) {
+		touch(0, 0, width_, height_);
+		for (uint32_t i=0; i<height_; i++) std::fill(target_.row(i), target_.row(i) + width_, color);
+	}
+
+	/* copy a background image (width x height) into the target */
+	void Overlay::blit(const bgr_t *img) {
+		touch(0, 0, width_, height_);
+		for (uint32_t i=0; i<height_; i++) memcpy(target_.row(i), img + i * width_, width_ * sizeof(bgr_t));
+	}
+
+	/* Bresenham's line, clipped per pixel */
+	void Overlay::line(int x0, int y0, int x1, int y1, const bgr_t& color) {
+		int dx =  abs(x1 - x0), sx = (x0 < x1) ? 1 : -1;
+		int dy = -abs(y1 - y0), sy = (y0 < y1) ? 1 : -1;
+		int err = dx + dy;
+		touch(std::min(x0, x1), std::min(y0, y1), dx + 1, 1 - dy);
+
+		while (true) {
+			put(x0, y0, color);
+			if (x0 == x1 && y0 == y1) break;
+			int e2 = 2 * err;
+			if (e2 >= dy) { err += dy; x0 += sx; }
+			if (e2 <= dx) { err += dx; y0 += sy; }
+		}
+	}
+
+	/* filled rectangle */
+	void Overlay::rect(int x, int y, int w, int h, const bgr_t& color) {
+		touch(x, y, w, h);
+		fill(x, y, w, h, color);
+	}
+
+	void Overlay::fill(int x, int y, int w, int h, const bgr_t& color) {
+		int x0 = std::max(x, 0), x1 = std::min(x + w, (int)width_);
+		int y0 = std::max(y, 0), y1 = std::min(y + h, (int)height_);
+		for (int i=y0; i<y1; i++) {
+			bgr_t *row = target_.row(i);
+			for (int j=x0; j<x1; j++) {
+				row[j] = color;
+			}
+		}
+	}
+
+	void Overlay::glyph(int x, int y, char c, const bgr_t& color, int scale) {
+		if (c < 0x20 || c > 0x7E) c = '?';
+		const uint8_t *cols = font5x7[c - 0x20];
+		touch(x, y, OVERLAY_FONT_W * scale, OVERLAY_FONT_H * scale);
+		for (int j=0; j<OVERLAY_FONT_W; j++) {
+			for (int i=0; i<OVERLAY_FONT_H; i++) {
+				if (cols[j] & (1 << i)) {
+					fill(x + j * scale, y + i * scale, scale, scale, color);
+				}
+			}
+		}
+	}
+
+	/* draw <str> with its top-left corner at (x, y); '\n' starts a new line */
+	void Overlay::text(int x, int y, const char *str, const bgr_t& color, int scale) {
+		int cx = x;
+		for (; *str != '\0'; str++) {
+			if (*str == '\n') {
+				cx  = x;
+				y  += (OVERLAY_FONT_H + 1) * scale;
+				continue;
+			}
+			glyph(cx, y, *str, color, scale);
+			cx += (OVERLAY_FONT_W + 1) * scale;
+		}
+	}
+
+	/*
+	 * draw into a free frame store until present()
+	 *  - the view can be filled first (decoder output, blit) and drawn over
+	 *  - too few frame stores (VDMA::zero_copy()): the back buffer, which
+	 *    present() copies as a whole
+	 */
+	const FrameView& Overlay::begin() {
+		if (target_.index < 0) {
+			const FrameView view = vdma_.begin_present();
+			if (view.valid()) target_ = view;
+			else              touch(0, 0, width_, height_);
+		}
+		return target_;
+	}
+
+	/*
+	 * flip to the frame store of begin(), or bring an idle frame store up to
+	 * the back buffer (dirty rectangles only) and flip to it
+	 *  - returns the index of the frame store that was parked
+	 */
+	uint8_t Overlay::present() {
+		uint8_t next;
+
+		if (target_.index >= 0) {
+			next = target_.index;
+			vdma_.end_present(target_);
+			target_.data  = back_.data();
+			target_.step  = width_ * sizeof(bgr_t);
+			target_.index = -1;
+		}
+		else {
+			next = vdma_.update_framebuffer(back_.data(), dirty_);
+			dirty_.clear();
+		}
+		presented_++;
+		return next;
+	}
+};
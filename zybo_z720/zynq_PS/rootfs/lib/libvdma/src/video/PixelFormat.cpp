@@ -0,0 +1,347 @@
+//-----------------------------------------------------------------------------
+// <PixelFormat.cpp>
+//  - Defined converters between the pixel formats of PixelFormat.hpp
+//    - every kernel gives the same bytes as the scalar one
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 23, 2020)
+//  - Added definition for convert_row()
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/video/PixelFormat.hpp>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXEL_NEON
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#define PIXEL_X86
+#endif
+
+namespace slab {
+	typedef enum PixelKernel {
+		PIXEL_SCALAR = 0,
+		PIXEL_SSSE3,
+		PIXEL_NEON_KERNEL
+	} PixelKernel;
+
+	static PixelKernel select_kernel(bool enable) {
+#if defined(PIXEL_NEON)
+		if (enable) return PIXEL_NEON_KERNEL;
+#elif defined(PIXEL_X86)
+		if (enable && __builtin_cpu_supports("ssse3")) return PIXEL_SSSE3;
+#endif
+		return PIXEL_SCALAR;
+	}
+
+	static PixelKernel kernel = select_kernel(true);
+
+	void pixel_convert_simd(bool enable) {
+		kernel = select_kernel(enable);
+	}
+
+	const char *pixel_convert_kernel() {
+		static const char *names[] = {"scalar", "ssse3", "neon"};
+		return names[kernel];
+	}
+
+	/* <rgb2ycbcr> (FRAC_BITW = 11) */
+	static inline uint8_t luma(int r, int g, int b) {
+		return (435 * r + 1465 * g + 148 * b + 1024) >> 11;
+	}
+
+	//-------------------------------------------------------------------------
+	// scalar (from pixel <i>)
+	//-------------------------------------------------------------------------
+	static void xbgr2bgr_scalar(const xbgr_t *s, bgr_t *d, uint32_t i, uint32_t n) {
+		for (; i<n; i++) {
+			d[i].b = s[i].b;
+			d[i].g = s[i].g;
+			d[i].r = s[i].r;
+		}
+	}
+
+	static void bgr2xbgr_scalar(const bgr_t *s, xbgr_t *d, uint32_t i, uint32_t n) {
+		for (; i<n; i++) {
+			d[i].b = s[i].b;
+			d[i].g = s[i].g;
+			d[i].r = s[i].r;
+			d[i].x = 0;
+		}
+	}
+
+	template <typename Pixel>
+	static void luma_scalar(const Pixel *s, y8_t *d, uint32_t i, uint32_t n) {
+		for (; i<n; i++) d[i].y = luma(s[i].r, s[i].g, s[i].b);
+	}
+
+	static void y2bgr_scalar(const y8_t *s, bgr_t *d, uint32_t i, uint32_t n) {
+		for (; i<n; i++) d[i].b = d[i].g = d[i].r = s[i].y;
+	}
+
+	static void y2xbgr_scalar(const y8_t *s, xbgr_t *d, uint32_t i, uint32_t n) {
+		for (; i<n; i++) {
+			d[i].b = d[i].g = d[i].r = s[i].y;
+			d[i].x = 0;
+		}
+	}
+
+#if defined(PIXEL_NEON)
+	//-------------------------------------------------------------------------
+	// NEON (16 pixels)
+	//-------------------------------------------------------------------------
+	static inline uint8x8_t luma8_neon(uint8x8_t b, uint8x8_t g, uint8x8_t r) {
+		uint16x8_t b16 = vmovl_u8(b), g16 = vmovl_u8(g), r16 = vmovl_u8(r);
+		uint32x4_t lo  = vmull_n_u16(vget_low_u16 (r16), 435);
+		uint32x4_t hi  = vmull_n_u16(vget_high_u16(r16), 435);
+		lo = vmlal_n_u16(lo, vget_low_u16 (g16), 1465);
+		hi = vmlal_n_u16(hi, vget_high_u16(g16), 1465);
+		lo = vmlal_n_u16(lo, vget_low_u16 (b16),  148);
+		hi = vmlal_n_u16(hi, vget_high_u16(b16),  148);
+		return vmovn_u16(vcombine_u16(vrshrn_n_u32(lo, 11), vrshrn_n_u32(hi, 11)));
+	}
+
+	static inline uint8x16_t luma16_neon(uint8x16_t b, uint8x16_t g, uint8x16_t r) {
+		return vcombine_u8(
+				luma8_neon(vget_low_u8 (b), vget_low_u8 (g), vget_low_u8 (r)),
+				luma8_neon(vget_high_u8(b), vget_high_u8(g), vget_high_u8(r)));
+	}
+
+	static void xbgr2bgr_neon(const xbgr_t *s, bgr_t *d, uint32_t n) {
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			uint8x16x4_t p = vld4q_u8((const uint8_t*)(s + i));
+			uint8x16x3_t q = {{p.val[0], p.val[1], p.val[2]}};
+			vst3q_u8((uint8_t*)(d + i), q);
+		}
+		xbgr2bgr_scalar(s, d, i, n);
+	}
+
+	static void bgr2xbgr_neon(const bgr_t *s, xbgr_t *d, uint32_t n) {
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			uint8x16x3_t p = vld3q_u8((const uint8_t*)(s + i));
+			uint8x16x4_t q = {{p.val[0], p.val[1], p.val[2], vdupq_n_u8(0)}};
+			vst4q_u8((uint8_t*)(d + i), q);
+		}
+		bgr2xbgr_scalar(s, d, i, n);
+	}
+
+	static void xbgr2y_neon(const xbgr_t *s, y8_t *d, uint32_t n) {
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			uint8x16x4_t p = vld4q_u8((const uint8_t*)(s + i));
+			vst1q_u8((uint8_t*)(d + i), luma16_neon(p.val[0], p.val[1], p.val[2]));
+		}
+		luma_scalar(s, d, i, n);
+	}
+
+	static void bgr2y_neon(const bgr_t *s, y8_t *d, uint32_t n) {
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			uint8x16x3_t p = vld3q_u8((const uint8_t*)(s + i));
+			vst1q_u8((uint8_t*)(d + i), luma16_neon(p.val[0], p.val[1], p.val[2]));
+		}
+		luma_scalar(s, d, i, n);
+	}
+
+	static void y2bgr_neon(const y8_t *s, bgr_t *d, uint32_t n) {
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			uint8x16_t   y = vld1q_u8((const uint8_t*)(s + i));
+			uint8x16x3_t q = {{y, y, y}};
+			vst3q_u8((uint8_t*)(d + i), q);
+		}
+		y2bgr_scalar(s, d, i, n);
+	}
+
+	static void y2xbgr_neon(const y8_t *s, xbgr_t *d, uint32_t n) {
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			uint8x16_t   y = vld1q_u8((const uint8_t*)(s + i));
+			uint8x16x4_t q = {{y, y, y, vdupq_n_u8(0)}};
+			vst4q_u8((uint8_t*)(d + i), q);
+		}
+		y2xbgr_scalar(s, d, i, n);
+	}
+#endif
+
+#if defined(PIXEL_X86)
+	//-------------------------------------------------------------------------
+	// SSSE3 (16 pixels)
+	//-------------------------------------------------------------------------
+	/* 8 pixels in 16-bit lanes: (435 R + 1465 G + 148 B + 1024) >> 11 */
+	static inline __m128i luma8_sse(__m128i r, __m128i g, __m128i b) {
+		const __m128i wrg = _mm_set_epi16(1465, 435, 1465, 435, 1465, 435, 1465, 435);
+		const __m128i wbc = _mm_set_epi16(1024, 148, 1024, 148, 1024, 148, 1024, 148);
+		const __m128i one = _mm_set1_epi16(1);
+		__m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(r, g), wrg),
+				_mm_madd_epi16(_mm_unpacklo_epi16(b, one), wbc));
+		__m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(r, g), wrg),
+				_mm_madd_epi16(_mm_unpackhi_epi16(b, one), wbc));
+		return _mm_packs_epi32(_mm_srai_epi32(lo, 11), _mm_srai_epi32(hi, 11));
+	}
+
+	static inline __m128i luma16_sse(__m128i r, __m128i g, __m128i b) {
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_packus_epi16(
+				luma8_sse(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(b, zero)),
+				luma8_sse(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(b, zero)));
+	}
+
+	__attribute__((target("ssse3")))
+	static void xbgr2bgr_ssse3(const xbgr_t *s, bgr_t *d, uint32_t n) {
+		const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			const __m128i *p = (const __m128i*)(s + i);
+			__m128i a = _mm_shuffle_epi8(_mm_loadu_si128(p    ), pack); // 12 bytes each
+			__m128i b = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), pack);
+			__m128i c = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), pack);
+			__m128i e = _mm_shuffle_epi8(_mm_loadu_si128(p + 3), pack);
+			__m128i *q = (__m128i*)(d + i);
+			_mm_storeu_si128(q    , _mm_or_si128(a, _mm_slli_si128(b, 12)));
+			_mm_storeu_si128(q + 1, _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+			_mm_storeu_si128(q + 2, _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(e, 4)));
+		}
+		xbgr2bgr_scalar(s, d, i, n);
+	}
+
+	__attribute__((target("ssse3")))
+	static void bgr2xbgr_ssse3(const bgr_t *s, xbgr_t *d, uint32_t n) {
+		const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			const __m128i *p = (const __m128i*)(s + i);
+			__m128i a = _mm_loadu_si128(p), b = _mm_loadu_si128(p + 1), c = _mm_loadu_si128(p + 2);
+			__m128i *q = (__m128i*)(d + i);
+			_mm_storeu_si128(q    , _mm_shuffle_epi8(a, expand));
+			_mm_storeu_si128(q + 1, _mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), expand));
+			_mm_storeu_si128(q + 2, _mm_shuffle_epi8(_mm_alignr_epi8(c, b,  8), expand));
+			_mm_storeu_si128(q + 3, _mm_shuffle_epi8(_mm_srli_si128(c, 4), expand));
+		}
+		bgr2xbgr_scalar(s, d, i, n);
+	}
+
+	__attribute__((target("ssse3")))
+	static void xbgr2y_ssse3(const xbgr_t *s, y8_t *d, uint32_t n) {
+		const __m128i planes = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			const __m128i *p = (const __m128i*)(s + i);
+			__m128i t0 = _mm_shuffle_epi8(_mm_loadu_si128(p    ), planes); // b0-3 g0-3 r0-3 x0-3
+			__m128i t1 = _mm_shuffle_epi8(_mm_loadu_si128(p + 1), planes);
+			__m128i t2 = _mm_shuffle_epi8(_mm_loadu_si128(p + 2), planes);
+			__m128i t3 = _mm_shuffle_epi8(_mm_loadu_si128(p + 3), planes);
+			__m128i bg01 = _mm_unpacklo_epi32(t0, t1), rx01 = _mm_unpackhi_epi32(t0, t1);
+			__m128i bg23 = _mm_unpacklo_epi32(t2, t3), rx23 = _mm_unpackhi_epi32(t2, t3);
+			__m128i b = _mm_unpacklo_epi64(bg01, bg23);
+			__m128i g = _mm_unpackhi_epi64(bg01, bg23);
+			__m128i r = _mm_unpacklo_epi64(rx01, rx23);
+			_mm_storeu_si128((__m128i*)(d + i), luma16_sse(r, g, b));
+		}
+		luma_scalar(s, d, i, n);
+	}
+
+	/* through XBGR8888 on the stack (16 pixels at a time) */
+	__attribute__((target("ssse3")))
+	static void bgr2y_ssse3(const bgr_t *s, y8_t *d, uint32_t n) {
+		xbgr_t tmp[16];
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			bgr2xbgr_ssse3(s + i, tmp, 16);
+			xbgr2y_ssse3(tmp, d + i, 16);
+		}
+		luma_scalar(s, d, i, n);
+	}
+
+	__attribute__((target("ssse3")))
+	static void y2bgr_ssse3(const y8_t *s, bgr_t *d, uint32_t n) {
+		const __m128i m0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+		const __m128i m1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+		const __m128i m2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			__m128i y = _mm_loadu_si128((const __m128i*)(s + i));
+			__m128i *q = (__m128i*)(d + i);
+			_mm_storeu_si128(q    , _mm_shuffle_epi8(y, m0));
+			_mm_storeu_si128(q + 1, _mm_shuffle_epi8(y, m1));
+			_mm_storeu_si128(q + 2, _mm_shuffle_epi8(y, m2));
+		}
+		y2bgr_scalar(s, d, i, n);
+	}
+
+	static void y2xbgr_sse2(const y8_t *s, xbgr_t *d, uint32_t n) {
+		const __m128i mask = _mm_set1_epi32(0x00ffffff);
+		uint32_t i = 0;
+		for (; i+16<=n; i+=16) {
+			__m128i y  = _mm_loadu_si128((const __m128i*)(s + i));
+			__m128i lo = _mm_unpacklo_epi8(y, y), hi = _mm_unpackhi_epi8(y, y);
+			__m128i *q = (__m128i*)(d + i);
+			_mm_storeu_si128(q    , _mm_and_si128(_mm_unpacklo_epi16(lo, lo), mask));
+			_mm_storeu_si128(q + 1, _mm_and_si128(_mm_unpackhi_epi16(lo, lo), mask));
+			_mm_storeu_si128(q + 2, _mm_and_si128(_mm_unpacklo_epi16(hi, hi), mask));
+			_mm_storeu_si128(q + 3, _mm_and_si128(_mm_unpackhi_epi16(hi, hi), mask));
+		}
+		y2xbgr_scalar(s, d, i, n);
+	}
+#endif
+
+	//-------------------------------------------------------------------------
+	// convert_row
+	//-------------------------------------------------------------------------
+	void convert_row(const xbgr_t *s, bgr_t *d, uint32_t n) {
+#if defined(PIXEL_NEON)
+		if (kernel == PIXEL_NEON_KERNEL) return xbgr2bgr_neon(s, d, n);
+#elif defined(PIXEL_X86)
+		if (kernel == PIXEL_SSSE3) return xbgr2bgr_ssse3(s, d, n);
+#endif
+		xbgr2bgr_scalar(s, d, 0, n);
+	}
+
+	void convert_row(const bgr_t *s, xbgr_t *d, uint32_t n) {
+#if defined(PIXEL_NEON)
+		if (kernel == PIXEL_NEON_KERNEL) return bgr2xbgr_neon(s, d, n);
+#elif defined(PIXEL_X86)
+		if (kernel == PIXEL_SSSE3) return bgr2xbgr_ssse3(s, d, n);
+#endif
+		bgr2xbgr_scalar(s, d, 0, n);
+	}
+
+	void convert_row(const y8_t *s, bgr_t *d, uint32_t n) {
+#if defined(PIXEL_NEON)
+		if (kernel == PIXEL_NEON_KERNEL) return y2bgr_neon(s, d, n);
+#elif defined(PIXEL_X86)
+		if (kernel == PIXEL_SSSE3) return y2bgr_ssse3(s, d, n);
+#endif
+		y2bgr_scalar(s, d, 0, n);
+	}
+
+	void convert_row(const xbgr_t *s, y8_t *d, uint32_t n) {
+#if defined(PIXEL_NEON)
+		if (kernel == PIXEL_NEON_KERNEL) return xbgr2y_neon(s, d, n);
+#elif defined(PIXEL_X86)
+		if (kernel == PIXEL_SSSE3) return xbgr2y_ssse3(s, d, n);
+#endif
+		luma_scalar(s, d, 0, n);
+	}
+
+	void convert_row(const bgr_t *s, y8_t *d, uint32_t n) {
+#if defined(PIXEL_NEON)
+		if (kernel == PIXEL_NEON_KERNEL) return bgr2y_neon(s, d, n);
+#elif defined(PIXEL_X86)
+		if (kernel == PIXEL_SSSE3) return bgr2y_ssse3(s, d, n);
+#endif
+		luma_scalar(s, d, 0, n);
+	}
+
+	void convert_row(const y8_t *s, xbgr_t *d, uint32_t n) {
+#if defined(PIXEL_NEON)
+		if (kernel == PIXEL_NEON_KERNEL) return y2xbgr_neon(s, d, n);
+#elif defined(PIXEL_X86)
+		if (kernel != PIXEL_SCALAR) return y2xbgr_sse2(s, d, n);
+#endif
+		y2xbgr_scalar(s, d, 0, n);
+	}
+};
@@ -0,0 +1,166 @@
+//-----------------------------------------------------------------------------
+// <Presenter.cpp>
+//  - Defined functions of slab::Presenter class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 26, 2020)
+//  - Added definition for functions of slab::Presenter class
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include <slab/video/Presenter.hpp>
+#include <thread>
+#include <algorithm>
+
+#define PRESENT_STATUS_TIMEOUT 4      // frame periods without the status bit -> by the clock
+#define PRESENT_SPIN_US        200    // polling interval near the frame start
+#define PRESENT_MARGIN_S       0.001  // wake up this early from a long sleep
+
+namespace slab {
+	Presenter::Presenter(VDMA& vdma, double source_fps) :
+		vdma_         (vdma                                          ),
+		display_rate_ (vdma.frame_rate()                             ),
+		source_fps_   ((source_fps > 0) ? source_fps : display_rate_ ),
+		period_       (1.0 / display_rate_                           ),
+		started_      (false                                         ),
+		by_clock_     (false                                         ),
+		seen_status_  (false                                         ),
+		vsync_        (0                                             ),
+		last_vsync_   (0                                             ),
+		base_         (0                                             ),
+		frame_        (0                                             ),
+		presented_    (0                                             ),
+		dropped_      (0                                             ),
+		late_         (0                                             ),
+		pending_store_(-1                                            )
+	{
+		pending_ = last_ = PresentStamp();
+	}
+
+	Presenter::~Presenter() {
+	}
+
+	double Presenter::now() const {
+		return std::chrono::duration<double>(clock::now() - start_).count();
+	}
+
+	/* display frame source frame <frame> is shown from */
+	uint64_t Presenter::due(uint64_t frame) const {
+		return base_ + (uint64_t)(frame * display_rate_ / source_fps_ + 0.5);
+	}
+
+	/* source frame 0 is due at the next display frame */
+	void Presenter::start() {
+		start_         = clock::now();
+		started_       = true;
+		by_clock_      = false;
+		seen_status_   = false;
+		vsync_         = 0;
+		last_vsync_    = 0;
+		base_          = 1;
+		frame_         = 0;
+		presented_     = 0;
+		dropped_       = 0;
+		late_          = 0;
+		pending_store_ = -1;
+		pending_ = last_ = PresentStamp();
+		vdma_.read_frame_done(); // stale status
+	}
+
+	/* count display frames, time stamp the submitted frame once it is on screen */
+	void Presenter::poll() {
+		const double t = now();
+
+		if (!by_clock_) {
+			if (vdma_.read_frame_done()) {
+				/* one or more frames since the last poll */
+				const double   e = t - last_vsync_;
+				const uint64_t n = (seen_status_ && e > 1.5 * period_) ? (uint64_t)(e / period_ + 0.5) : 1;
+				vsync_       += n;
+				last_vsync_   = t;
+				seen_status_  = true;
+			}
+			else if (!seen_status_ && t > PRESENT_STATUS_TIMEOUT * period_) {
+				by_clock_ = true;
+			}
+		}
+		if (by_clock_) {
+			const uint64_t n = (uint64_t)((t - last_vsync_) / period_);
+			vsync_      += n;
+			last_vsync_ += n * period_;
+		}
+
+		if (pending_store_ >= 0 && vdma_.current_read_frame() == pending_store_) {
+			pending_.vsync = vsync_;
+			pending_.shown = t;
+			last_          = pending_;
+			pending_store_ = -1;
+		}
+	}
+
+	/* sleep most of the way, then poll until display frame <vsync> has started */
+	void Presenter::wait_until(uint64_t vsync) {
+		for (poll(); vsync_ < vsync; poll()) {
+			const double left = last_vsync_ + (vsync - vsync_) * period_ - now();
+			if (left > 2 * PRESENT_MARGIN_S) std::this_thread::sleep_for(std::chrono::duration<double>(left - PRESENT_MARGIN_S));
+			else                             std::this_thread::sleep_for(std::chrono::microseconds(PRESENT_SPIN_US));
+		}
+	}
+
+	uint64_t Presenter::wait_vsync() {
+		if (!started_) start();
+		poll();
+		wait_until(vsync_ + 1);
+		return vsync_;
+	}
+
+	uint32_t Presenter::next() {
+		if (!started_) start();
+		poll();
+		/*
+		 * the earliest display frame the next flip can reach is vsync_ + 1; a
+		 * source frame is dropped when the one after it is also due by then
+		 * (late, or more source frames than display frames)
+		 */
+		const uint64_t slot = std::max(vsync_ + 1, due(frame_));
+		uint64_t n = frame_;
+		while (due(n + 1) <= slot) n++;
+		const uint32_t drop = n - frame_;
+		frame_    = n;
+		dropped_ += drop;
+		return drop;
+	}
+
+	void Presenter::submitted(uint8_t store) {
+		pending_.frame     = frame_;
+		pending_.due       = due(frame_);
+		pending_.vsync     = 0;
+		pending_.submitted = now();
+		pending_.shown     = 0;
+		pending_store_     = store;
+		presented_++;
+		frame_++;
+	}
+
+	/*
+	 * the read channel picks up a parked store at the next frame start, so
+	 * the flip is made once the display frame before the due one has started
+	 */
+	uint8_t Presenter::present(Overlay& overlay) {
+		if (!started_) start();
+		wait_until(due(frame_) - 1);
+		if (vsync_ >= due(frame_)) late_++;
+		const uint8_t store = overlay.present();
+		submitted(store);
+		return store;
+	}
+
+	void Presenter::present(const FrameView& view) {
+		if (!view.valid()) return;
+		if (!started_) start();
+		wait_until(due(frame_) - 1);
+		if (vsync_ >= due(frame_)) late_++;
+		vdma_.end_present(view);
+		submitted(view.index);
+	}
+};
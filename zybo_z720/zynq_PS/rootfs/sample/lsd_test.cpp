@@ -2,15 +2,29 @@
 #include <opencv4/opencv2/opencv.hpp>
 #include <string>
 #include <chrono>
+#include <mutex>
+#include <vector>
 #include <slab/vdma.hpp>
+#include <slab/video/Overlay.hpp>
+#include <slab/video/Presenter.hpp>
 #include <slab/uio.hpp>
+#include <slab/lsd.hpp>
+#include <slab/lsd/recording.hpp>
+#include <slab/lsd/threshold.hpp>
+#include <slab/lsd/perf.hpp>
+#include <slab/lsd/histogram.hpp>
 #include <slab/bsp/xparameters.h>
 #include "lsd_test.hpp"
+#include "video_source.hpp"
 
 namespace slab {
 	bool thread_flag = true;
 	UIO uio("/dev/uio0");
 
+	/* latest line frame (UIO_LSD -> Video_VDMA) */
+	std::mutex               lines_mtx;
+	std::vector<LineSegment> latest_lines;
+
 	void draw_lines(cv::Mat& img, const int W, const int H, const int line_num, Line_t *lines) {
 		img = cv::Scalar(0,0,0);
 		for (int i=0; i<line_num; i++) {
@@ -18,111 +32,143 @@ namespace slab {
 		}
 	}
 
-	void UIO_LSD() {
+	void UIO_LSD(std::string record_path) {
 		/* initialize */
-		cv::Mat line_img(cv::Size(WIDTH, HEIGHT), CV_8UC1);
-		std::chrono::system_clock::time_point  start, end;
-		Line_t line; 
-		uint32_t num_of_lines;
-
-		cv::namedWindow("line frame buffer", cv::WINDOW_AUTOSIZE | cv::WINDOW_FREERATIO);
+		LSDReader reader(uio);
+		LineFrame frame;
+
+		/* keep the number of lines within [LINES_LOW, LINES_HIGH] */
+		LSDThresholdController threshold(uio, LINES_LOW, LINES_HIGH);
+
+		/* hardware counters, printed every PERF_INTERVAL_MS */
+		PerfCounters perf(uio);
+		HistogramReader hist_reader(uio);
+		LumaHistogram hist;
+		uint64_t perf_last_ns = monotonic_ns();
+
+		/* record line frames when <record_path> is given */
+		LineRecorder *recorder = NULL;
+		if (!record_path.empty()) {
+			recorder = new LineRecorder(record_path, WIDTH, HEIGHT);
+		}
 
 		printf("LSDBUF (result)\n");
 		while (thread_flag) {
 
 			/* fetch line-frame from LSDBUF(PL) */
-			line_img = cv::Scalar(0,0,0);
-
-			uio.write(WRITE_LSDBUF_PROTECT, 0x1);           // set write_protect
-			while (!uio.read(READ_LSDBUF_READY));           // wait buffer-ready
-			num_of_lines = uio.read(READ_LSDBUF_LINE_NUM);  // get number of lines
-			for (int i=0; i<num_of_lines; i++) {
-				//start = std::chrono::system_clock::now();
-
-				uio.write(WRITE_LSDBUF_RADDR, i);              // set read-address
-				line.start_h = uio.read(READ_LSDBUF_START_H); // read line-information
-				line.start_v = uio.read(READ_LSDBUF_START_V);
-				line.end_h   = uio.read(READ_LSDBUF_END_H);
-				line.end_v   = uio.read(READ_LSDBUF_END_V);
-
-				//end = std::chrono::system_clock::now();
-				//printf("  frame_time : %lf [s]\r", std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1000000000.0);
-				//fflush(stdout);
-
-				cv::line(line_img, cv::Point(line.start_h, line.start_v), cv::Point(line.end_h, line.end_v), cv::Scalar(255,255,225), 1);
+			reader.fetch(frame);
+			if (recorder != NULL) recorder->push(frame);
+			threshold.update(frame);
+
+			if (frame.timestamp_ns - perf_last_ns >= PERF_INTERVAL_MS * 1000000ULL) {
+				print_perf(perf.update());
+				if (hist_reader.fetch(hist)) {
+					printf("HIST: frame %u, [a, b] = [%u, %u], mean %.1lf\n",
+							hist.frame, hist.a, hist.b, hist.mean());
+				}
+				perf_last_ns = frame.timestamp_ns;
 			}
 
-			uio.write(WRITE_LSDBUF_PROTECT, 0x0);           // unset write_protect
-
-
-			/* display window */
-			//draw_lines(line_img, WIDTH, HEIGHT, num_of_lines, lines);
-			cv::imshow("line frame buffer", line_img);
-			char key = cv::waitKey(150);
-			switch (key) {
-				case 'n': // n : get number of lines
-					printf("num of lines: %d\n", num_of_lines);
-					break;
-				case 's': // s : Stop
-					while (true) {
-						if (cv::waitKey(0)) {
-							break;
-						}
-					}
-					break;
-				case 'q': // q : Quit
-					thread_flag = false;
-					break;
-				default: break;
+			/* hand the latest lines to the overlay (Video_VDMA) */
+			{
+				std::lock_guard<std::mutex> lock(lines_mtx);
+				latest_lines.assign(frame.lines, frame.lines + frame.count);
 			}
-
 		}
-		cv::destroyAllWindows();
 		printf("\n");
-	}
 
-	void Video_VDMA(std::string filename, Resolution resolution) {
-		/* information of image */
-		uint32_t width      = timing[static_cast<int>(resolution)].h_active;
-		uint32_t height     = timing[static_cast<int>(resolution)].v_active;
-		uint32_t pixels     = width * height;
-		uint32_t frameBytes = width * height * sizeof(bgr_t);
+		if (recorder != NULL) {
+			recorder->close();
+			printf("recorded %llu frames (%llu dropped) : %s\n",
+					(unsigned long long)recorder->pushed(), (unsigned long long)recorder->dropped(),
+					record_path.c_str());
+			delete recorder;
+		}
+	}
 
+	/*
+	 * <draw_overlay>: lines drawn over the frame store by the PS (debug)
+	 *  - the MM2S frame is also the input of simple_lsd, so the drawn lines
+	 *    are detected again in the next frames. By default the frames are
+	 *    presented as decoded and the lines are shown by <lsd_visualizer>
+	 *    (sw = SW_LSD_VISUALIZER)
+	 */
+	void Video_VDMA(std::string filename, Resolution resolution, bool draw_overlay) {
 		/* read image from FrameBuffer(DRAM) to PL-device */
 		VDMA vdma(MEM_BASE_ADDR_R, MEM_BASE_ADDR_W, resolution);
 		vdma.Vdma_StartRead();
 
-		/* OpenCV */
-		cv::Mat frame;
-		cv::VideoCapture cap;
-		cap.open(filename);
-		if (!cap.isOpened()) {
+		/* frames are flipped to HDMI (and simple_lsd) */
+		Overlay overlay(vdma);
+		std::vector<LineSegment> lines;
+		const bgr_t line_color = {0, 255, 0};
+		const uint32_t sw = uio.read(READ_SW) & 0xF;
+		if (draw_overlay) {
+			printf("overlay : lines drawn into the frame store (also detected by simple_lsd)\n");
+		}
+		else if (sw != SW_LSD_VISUALIZER) {
+			printf("sw : %u (set sw to %u to see the lines on HDMI)\n", sw, SW_LSD_VISUALIZER);
+		}
+
+		/* OpenCV (decodes into the frame store) */
+		VideoSource source(filename);
+		if (!source.opened()) {
 			printf("could not open %s\n", filename.c_str());
 			return ;
 		}
 		uint32_t frames, fps;
-		frames = cap.get(cv::CAP_PROP_FRAME_COUNT);
-		fps    = cap.get(cv::CAP_PROP_FPS);
+		frames = source.frames();
+		fps    = source.fps();
 		printf("Frames : %d, fps : %d\n", frames, fps);
 
-		/* set frame to RAM (vid-file -> RAM) */
+		/* flips paced to the display: frames repeated or dropped to match its rate */
+		Presenter presenter(vdma, source.fps());
+		printf("display : %.2lf [Hz]\n", presenter.display_rate());
+
+		/* decode and draw in a free frame store, then flip (vid-file -> DRAM_framebuffer) */
 		std::chrono::system_clock::time_point  start, end;
 
 		start = std::chrono::system_clock::now();
+		presenter.start();
 		for (int i=0; i<frames; i++) {
-			/* capture frame from video */
-			cap >> frame;
-			if (frame.empty()) break;
+			/* frames already past due are not decoded into a frame store */
+			const uint32_t drop = presenter.next();
+			if (!source.skip(drop)) break;
+			i += drop;
 
-			/* set frame to DRAM_framebuffer */
-			vdma.set_framebuffer((bgr_t*)frame.data, 0);
+			/* capture frame from video */
+			if (!source.read(overlay.begin())) break;
+
+			/* lines over the frame (--overlay), then flip */
+			if (draw_overlay) {
+				{
+					std::lock_guard<std::mutex> lock(lines_mtx);
+					lines = latest_lines;
+				}
+				for (uint32_t j=0; j<lines.size(); j++) {
+					overlay.line(lines[j].start_h, lines[j].start_v, lines[j].end_h, lines[j].end_v, line_color);
+				}
+			}
+			presenter.present(overlay);
 		}
 		end  = std::chrono::system_clock::now();
 		thread_flag = false;
 
 		double time = (double)std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() / 1000.0;
+		frames = source.decoded();
 		printf("VDMA\n");
-		printf("  total time : %lf [s], spf : %lf [s], fps : %lf [fps]\n", time, (time/frames),  (frames / time));
+		printf("  total time : %lf [s], spf : %lf [s], fps : %lf [fps] (decode to display)\n", time, (time/frames),  (frames / time));
+		printf("  frames : %u decoded, %llu copied (size / format mismatch), %llu flipped, %llu dropped\n",
+				frames, (unsigned long long)source.copied(), (unsigned long long)vdma.submitted(),
+				(unsigned long long)vdma.dropped());
+		printf("  display : %llu frames, %llu shown, %llu repeated, %llu skipped (not decoded), %llu late%s\n",
+				(unsigned long long)presenter.vsync(), (unsigned long long)presenter.presented(),
+				(unsigned long long)presenter.repeated(), (unsigned long long)source.skipped(),
+				(unsigned long long)presenter.late(), presenter.by_clock() ? " (by the clock)" : "");
+		const PresentStamp& last = presenter.last();
+		printf("  last shown : frame %llu due at %llu, shown at %llu (submitted %.4lf [s], shown %.4lf [s])\n",
+				(unsigned long long)last.frame, (unsigned long long)last.due, (unsigned long long)last.vsync,
+				last.submitted, last.shown);
 	}
 };
 
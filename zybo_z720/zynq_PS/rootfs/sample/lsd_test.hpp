@@ -6,20 +6,21 @@
 #include <string>
 #include <slab/vdma.hpp>
 #include <slab/uio.hpp>
+#include <slab/lsd.hpp>
 
 #define WIDTH  640
 #define HEIGHT 480
-#define MAXNUM_OF_LINES 4096
-
-/* index of slave register */
-#define READ_LSDBUF_LINE_NUM 0
-#define READ_LSDBUF_READY    1
-#define READ_LSDBUF_START_H  2
-#define READ_LSDBUF_START_V  3
-#define READ_LSDBUF_END_H    4
-#define READ_LSDBUF_END_V    5
-#define WRITE_LSDBUF_PROTECT 0
-#define WRITE_LSDBUF_RADDR   1
+#define MAXNUM_OF_LINES LSD_BUFSIZE
+
+/* target band of lines per frame (LSDThresholdController) */
+#define LINES_LOW  200
+#define LINES_HIGH 1500
+
+/* sw of the board: lines drawn by <lsd_visualizer> on HDMI */
+#define SW_LSD_VISUALIZER 3
+
+/* interval of printing performance counters */
+#define PERF_INTERVAL_MS 5000
 
 /* FrameBuffer(DRAM) BASE_ADDR */
 #define MEM_BASE_ADDR_R (XPAR_DDR_MEM_BASEADDR + 0x0A000000)
@@ -31,8 +32,8 @@ namespace slab {
 	} Line_t;
 
 	void draw_lines(cv::Mat&, const int, const int, const int, Line_t*);
-	void UIO_LSD();
-	void Video_VDMA(std::string, slab::Resolution);
+	void UIO_LSD(std::string);
+	void Video_VDMA(std::string, slab::Resolution, bool);
 };
 
 #endif // _LSD_TEST_H_
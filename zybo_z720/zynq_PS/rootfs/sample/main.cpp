@@ -1,7 +1,60 @@
 #include "lsd_test.hpp"
 #include <slab/vdma.hpp>
+#include <slab/video/Capture.hpp>
 #include <slab/bsp/xparameters.h>
 #include <thread>
+#include <chrono>
+#include <string.h>
+
+/* time for the first S2MM frame before --capture gives up [ms] */
+#define CAPTURE_PROBE_MS 200
+
+/* pixels copied for <rects> */
+static uint64_t rects_area(const std::vector<slab::DirtyRect>& rects) {
+	uint64_t area = 0;
+	for (size_t i=0; i<rects.size(); i++) area += (uint64_t)rects[i].width * rects[i].height;
+	return area;
+}
+
+/* slab::coalesce_rects() on a 640x480 frame (no hardware needed) */
+static int verify_rects() {
+	typedef std::vector<slab::DirtyRect> Rects;
+	int fail = 0;
+
+	/* two bars along the edges that touch at a corner: kept apart */
+	Rects bars = {{0, 0, 8, 480}, {8, 0, 632, 8}};
+	slab::coalesce_rects(bars, 640, 480);
+	const bool bars_ok = (bars.size() == 2 && rects_area(bars) == 8 * 480 + 632 * 8);
+	printf("touching bars    : %zu rects, %llu pixels : %s\n", bars.size(),
+			(unsigned long long)rects_area(bars), bars_ok ? "OK" : "NG");
+	fail += !bars_ok;
+
+	/* a rectangle inside another one: merged */
+	Rects inner = {{100, 100, 200, 50}, {120, 110, 20, 10}};
+	slab::coalesce_rects(inner, 640, 480);
+	const bool inner_ok = (inner.size() == 1 && rects_area(inner) == 200 * 50);
+	printf("contained        : %zu rects, %llu pixels : %s\n", inner.size(),
+			(unsigned long long)rects_area(inner), inner_ok ? "OK" : "NG");
+	fail += !inner_ok;
+
+	/* two lines of status text side by side: merged (little waste) */
+	Rects text = {{4, 4, 60, 8}, {66, 4, 60, 8}};
+	slab::coalesce_rects(text, 640, 480);
+	const bool text_ok = (text.size() == 1 && rects_area(text) == 122 * 8);
+	printf("adjacent text    : %zu rects, %llu pixels : %s\n", text.size(),
+			(unsigned long long)rects_area(text), text_ok ? "OK" : "NG");
+	fail += !text_ok;
+
+	/* half of the frame or more: the whole frame */
+	Rects half = {{0, 0, 640, 240}};
+	slab::coalesce_rects(half, 640, 480);
+	const bool half_ok = (half.size() == 1 && rects_area(half) == 640 * 480);
+	printf("half of the frame: %zu rects, %llu pixels : %s\n", half.size(),
+			(unsigned long long)rects_area(half), half_ok ? "OK" : "NG");
+	fail += !half_ok;
+
+	return fail ? -1 : 0;
+}
 
 int main(int argc, char *argv[]) {
 	/* check argument */
@@ -10,12 +63,85 @@ int main(int argc, char *argv[]) {
 		return -1;
 	}
 
+	/* merging of dirty rectangles (VDMA::update_framebuffer()) */
+	if (!strcmp(argv[1], "--verify-rects")) {
+		return verify_rects();
+	}
+
+	/*
+	 * MB/s of every copy kernel on the frame stores (each resolution)
+	 *  - /dev/mem (uncached), or two u-dma-buf devices (cached) if given
+	 */
+	if (!strcmp(argv[1], "--copy-bench")) {
+		slab::FrameMemory *mem_r = NULL, *mem_w = NULL;
+		if (argc > 3) {
+			mem_r = new slab::UDmaBufFrameMemory(argv[2]);
+			mem_w = new slab::UDmaBufFrameMemory(argv[3]);
+		}
+		for (size_t i=0; i<sizeof(slab::timing)/sizeof(slab::timing[0]); i++) {
+			slab::VDMA *vdma = (mem_r != NULL) ? new slab::VDMA(*mem_r, *mem_w, slab::timing[i].res)
+			                                   : new slab::VDMA(MEM_BASE_ADDR_R, MEM_BASE_ADDR_W, slab::timing[i].res);
+			printf("%ux%u (%u threads, %s)\n", vdma->width(), vdma->height(), vdma->copy_engine().threads(),
+					vdma->read_memory().cached() ? "cached" : "uncached");
+			vdma->copy_engine().print(stdout);
+			delete vdma;
+		}
+		delete mem_r;
+		delete mem_w;
+		return 0;
+	}
+
+	/*
+	 * S2MM capture thread for 5 s (latest frame, or every frame with "no-drop")
+	 *  - frames captured / handed out / dropped / overruns
+	 *  - needs a bitstream whose S2MM stream is connected: in the current
+	 *    vdma_top.sv the vid_in_* ports are commented out, so no frame is
+	 *    ever written and the mode stops here
+	 */
+	if (!strcmp(argv[1], "--capture")) {
+		const bool    no_drop = (argc > 2 && !strcmp(argv[2], "no-drop"));
+		slab::VDMA    vdma(MEM_BASE_ADDR_R, MEM_BASE_ADDR_W, slab::Resolution::R640_480_60_NN);
+		vdma.Vdma_StartWrite();
+		bool written = false;
+		for (int i=0; i<CAPTURE_PROBE_MS && !written; i++) {
+			written = vdma.write_frame_done();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if (!written) {
+			printf("no S2MM frame within %d [ms]: the bitstream has no video input (vid_in_* of vdma_top.sv)\n", CAPTURE_PROBE_MS);
+			return -1;
+		}
+		slab::Capture capture(vdma, no_drop ? slab::CAPTURE_NO_DROP : slab::CAPTURE_LATEST);
+		slab::CaptureFrame frame;
+		uint64_t      popped = 0;
+		capture.start();
+		while (capture.pop(frame, 1000) && frame.time < 5.0) {
+			popped++;
+			capture.release(frame);
+		}
+		capture.stop();
+		printf("captured %llu, popped %llu, dropped %llu, overruns %llu\n",
+				(unsigned long long)capture.captured(), (unsigned long long)popped,
+				(unsigned long long)capture.dropped(), (unsigned long long)capture.overruns());
+		return 0;
+	}
+
+	/* register simulator (SLAB_UIO_SIM): the simulator plays the video */
+	if (getenv(UIO_SIM_ENV) != NULL) {
+		slab::UIO_LSD((argc > 2) ? argv[2] : "");
+		return 0;
+	}
+
 	/* set resolution and framerate */
 	slab::Resolution resolution = slab::Resolution::R640_480_60_NN; // 640x480, 60 fps
 
+	/* --overlay (last argument): lines drawn into the frame store instead of by the PL */
+	const bool overlay = (argc > 2 && !strcmp(argv[argc - 1], "--overlay"));
+	if (overlay) argc--;
+
 	/* generate threads */
-	std::thread th1(slab::Video_VDMA, argv[1], resolution);
-	std::thread th2(slab::UIO_LSD);
+	std::thread th1(slab::Video_VDMA, argv[1], resolution, overlay);
+	std::thread th2(slab::UIO_LSD, (argc > 2) ? argv[2] : "");
 
 	/* join threads */
 	th1.join();
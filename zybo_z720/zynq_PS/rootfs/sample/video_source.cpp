@@ -0,0 +1,61 @@
+//-----------------------------------------------------------------------------
+// <video_source.cpp>
+//  - Defined functions of slab::VideoSource class
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 22, 2020)
+//  - Added definition for functions of slab::VideoSource class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 26, 2020)
+//  - Added skip()
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#include "video_source.hpp"
+
+namespace slab {
+	VideoSource::VideoSource(const std::string& filename) :
+		decoded_ (0),
+		copied_  (0),
+		skipped_ (0)
+	{
+		cap_.open(filename);
+	}
+
+	VideoSource::~VideoSource() {
+	}
+
+	/* decode the next frame into <view> */
+	bool VideoSource::read(const FrameView& view) {
+		cv::Mat dst(view.height, view.width, CV_8UC3, view.data, view.step);
+		cv::Mat out = dst;
+
+		/* same size and type: the decoder writes into the frame store */
+		if (!cap_.read(out) || out.empty()) return false;
+		decoded_++;
+		if (out.data == dst.data) return true;
+
+		/* fallback: convert and resize into the frame store */
+		if (out.channels() == 1) {
+			cv::cvtColor(out, tmp_, cv::COLOR_GRAY2BGR);
+			out = tmp_;
+		}
+		else if (out.channels() == 4) {
+			cv::cvtColor(out, tmp_, cv::COLOR_BGRA2BGR);
+			out = tmp_;
+		}
+		if (out.size() != dst.size()) cv::resize(out, dst, dst.size(), 0, 0, cv::INTER_LINEAR);
+		else                          out.copyTo(dst);
+		copied_++;
+		return true;
+	}
+
+	/* drop <n> frames (grab() only: no color conversion, no copy) */
+	bool VideoSource::skip(uint32_t n) {
+		for (uint32_t i=0; i<n; i++) {
+			if (!cap_.grab()) return false;
+			skipped_++;
+		}
+		return true;
+	}
+};
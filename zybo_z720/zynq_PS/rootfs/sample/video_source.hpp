@@ -0,0 +1,51 @@
+//-----------------------------------------------------------------------------
+// <video_source.hpp>
+//  - Header of slab::VideoSource class
+//    - decodes a video file (cv::VideoCapture) straight into a frame store
+//-----------------------------------------------------------------------------
+// Version 1.00 (Dec. 22, 2020)
+//  - Added declaration of slab::VideoSource class
+//-----------------------------------------------------------------------------
+// Version 1.01 (Dec. 26, 2020)
+//  - Added skip(): frames dropped by slab::Presenter are not converted
+//-----------------------------------------------------------------------------
+// (C) 2020 Naofumi Yoshinaga. All rights reserved.
+//-----------------------------------------------------------------------------
+
+#ifndef _VIDEO_SOURCE_H_
+#define _VIDEO_SOURCE_H_
+
+#include <opencv4/opencv2/opencv.hpp>
+#include <stdint.h>
+#include <string>
+#include <slab/vdma.hpp>
+
+namespace slab {
+	/*
+	 * video decoder with the frame store as its output
+	 *  - read() hands the decoder a cv::Mat header over the FrameView, so a
+	 *    frame of the same size and format (BGR) is written in place
+	 *  - otherwise (other size, gray or BGRA) the decoder allocates its own
+	 *    frame, which is converted / resized into the view (copied())
+	 */
+	class VideoSource {
+		private:
+			cv::VideoCapture cap_;
+			cv::Mat          tmp_;
+			uint64_t         decoded_, copied_, skipped_;
+		protected:
+		public:
+			VideoSource(const std::string&);
+			~VideoSource();
+			bool read(const FrameView&);
+			bool skip(uint32_t);
+			bool     opened()        { return cap_.isOpened(); }
+			uint32_t frames()        { return cap_.get(cv::CAP_PROP_FRAME_COUNT); }
+			double   fps()           { return cap_.get(cv::CAP_PROP_FPS); }
+			uint64_t decoded() const { return decoded_; }
+			uint64_t copied() const  { return copied_;  }
+			uint64_t skipped() const { return skipped_; }
+	};
+};
+
+#endif // _VIDEO_SOURCE_H_